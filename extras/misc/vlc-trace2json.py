@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+#
+# Converts a trace file written by the binary tracer module
+# (--tracer=binary) to the Chrome trace event JSON format, which can be
+# loaded in chrome://tracing or https://ui.perfetto.dev
+#
+# Usage: vlc-trace2json.py vlc-trace.bin [output.json]
+#
+# Copyright (C) 2024 VLC authors and VideoLAN
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or
+# (at your option) any later version.
+
+import json
+import struct
+import sys
+
+RECORD_THREAD = 1
+RECORD_STRING = 2
+RECORD_DROPPED = 3
+RECORD_EVENT = 4
+
+TRACER_INT = 0
+TRACER_STRING = 1
+
+
+class Ring:
+    def __init__(self, serial):
+        self.tid = serial
+        self.strings = {}
+        self.ts = 0
+        self.data = b''
+
+
+def varint(data, pos):
+    value = shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def string(ring, data, pos):
+    sid, pos = varint(data, pos)
+    if sid != 0:
+        return ring.strings[sid], pos
+    length, pos = varint(data, pos)
+    return data[pos:pos + length].decode('utf-8', 'replace'), pos + length
+
+
+def parse_records(ring, data, tick_rate, events):
+    pos = 0
+    while pos < len(data):
+        tag = data[pos]
+        pos += 1
+        if tag == RECORD_THREAD:
+            ring.tid, pos = varint(data, pos)
+            events.append({'name': 'thread_name', 'ph': 'M', 'pid': 1,
+                           'tid': ring.tid,
+                           'args': {'name': 'thread %d' % ring.tid}})
+        elif tag == RECORD_STRING:
+            sid, pos = varint(data, pos)
+            length, pos = varint(data, pos)
+            ring.strings[sid] = data[pos:pos + length].decode('utf-8',
+                                                              'replace')
+            pos += length
+        elif tag == RECORD_DROPPED:
+            count, pos = varint(data, pos)
+            events.append({'name': 'dropped', 'ph': 'i', 's': 't', 'pid': 1,
+                           'tid': ring.tid,
+                           'ts': ring.ts * 1000000 / tick_rate,
+                           'args': {'count': count}})
+        elif tag == RECORD_EVENT:
+            delta, pos = varint(data, pos)
+            ring.ts += delta
+            count = data[pos]
+            pos += 1
+            args = {}
+            for _ in range(count):
+                key, pos = string(ring, data, pos)
+                vtype = data[pos]
+                pos += 1
+                if vtype == TRACER_INT:
+                    value, pos = varint(data, pos)
+                    args[key] = (value >> 1) ^ -(value & 1)
+                else:
+                    args[key], pos = string(ring, data, pos)
+            events.append(make_event(ring, tick_rate, args))
+        else:
+            raise ValueError('unknown record %d' % tag)
+
+
+def make_event(ring, tick_rate, args):
+    event = {'pid': 1, 'tid': ring.tid,
+             'ts': ring.ts * 1000000 / tick_rate, 'args': args}
+    if 'begin' in args:
+        event['ph'] = 'B'
+        event['name'] = args['begin']
+    elif 'end' in args:
+        event['ph'] = 'E'
+        event['name'] = args['end']
+    else:
+        event['ph'] = 'i'
+        event['s'] = 't'
+        event['name'] = ' '.join(str(args[k]) for k in ('type', 'stream')
+                                 if k in args) or 'trace'
+    if 'type' in args:
+        event['cat'] = args['type']
+    return event
+
+
+def convert(path):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'VLCTRACE':
+        raise ValueError('not a VLC binary trace')
+    version, tick_rate = struct.unpack_from('<II', data, 8)
+    if version != 1:
+        raise ValueError('unsupported version %d' % version)
+
+    rings = {}
+    events = []
+    pos = 16
+    while pos + 8 <= len(data):
+        serial, length = struct.unpack_from('<II', data, pos)
+        pos += 8
+        ring = rings.setdefault(serial, Ring(serial))
+        parse_records(ring, data[pos:pos + length], tick_rate, events)
+        pos += length
+
+    events.sort(key=lambda e: e.get('ts', 0))
+    return {'traceEvents': events, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.stderr.write('usage: %s vlc-trace.bin [output.json]\n'
+                         % sys.argv[0])
+        return 1
+    trace = convert(sys.argv[1])
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], 'w') as f:
+            json.dump(trace, f)
+    else:
+        json.dump(trace, sys.stdout)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
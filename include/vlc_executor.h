@@ -31,6 +31,25 @@ extern "C" {
 /** Executor type (opaque) */
 typedef struct vlc_executor vlc_executor_t;
 
+/**
+ * Runnable priorities.
+ *
+ * Queued runnables of a higher priority are always started before queued
+ * runnables of a lower priority. Runnables of the same priority are started
+ * in submission order (as far as the threads are concerned).
+ */
+enum vlc_executor_priority
+{
+    /** Background work, e.g. preparsing a whole media library */
+    VLC_EXECUTOR_PRIORITY_LOW,
+    /** Default priority, used by vlc_executor_Submit() */
+    VLC_EXECUTOR_PRIORITY_NORMAL,
+    /** Interactive work, that the user is waiting for */
+    VLC_EXECUTOR_PRIORITY_HIGH,
+};
+
+#define VLC_EXECUTOR_PRIORITY_COUNT (VLC_EXECUTOR_PRIORITY_HIGH + 1)
+
 /**
  * A Runnable encapsulates a task to be run from an executor thread.
  */
@@ -60,6 +79,35 @@ struct vlc_runnable {
 
     /* Private data used by the vlc_executor_t (do not touch) */
     struct vlc_list node;
+    void *queue;
+    vlc_tick_t submitted;
+    enum vlc_executor_priority priority;
+};
+
+/**
+ * Executor statistics, see vlc_executor_GetStats().
+ */
+struct vlc_executor_stats
+{
+    /** Number of threads currently spawned */
+    unsigned threads;
+    /** Number of runnables submitted but not finished (queued or running) */
+    unsigned unfinished;
+    /** Number of runnables started by another thread than the one they were
+     * queued to */
+    uint64_t stolen;
+
+    struct
+    {
+        /** Number of queued runnables (the queue depth) */
+        size_t queued;
+        /** Number of runnables started so far */
+        uint64_t started;
+        /** Average delay between submission and start of the runnables */
+        vlc_tick_t latency_avg;
+        /** Maximum delay between submission and start of the runnables */
+        vlc_tick_t latency_max;
+    } priorities[VLC_EXECUTOR_PRIORITY_COUNT];
 };
 
 /**
@@ -145,6 +193,21 @@ vlc_executor_Delete(vlc_executor_t *executor);
 VLC_API void
 vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable);
 
+/**
+ * Submit a runnable for execution with a given priority.
+ *
+ * This is the same as vlc_executor_Submit(), except that the runnable is
+ * started before any queued runnable of a lower priority.
+ *
+ * \param executor the executor
+ * \param runnable the task to run
+ * \param priority the priority of the task
+ */
+VLC_API void
+vlc_executor_SubmitWithPriority(vlc_executor_t *executor,
+                                struct vlc_runnable *runnable,
+                                enum vlc_executor_priority priority);
+
 /**
  * Cancel a runnable previously submitted.
  *
@@ -176,6 +239,20 @@ vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable);
 VLC_API void
 vlc_executor_WaitIdle(vlc_executor_t *executor);
 
+/**
+ * Get the executor statistics.
+ *
+ * The queue depths are a snapshot, that may be outdated as soon as this
+ * function returns. The latencies account for all the runnables started since
+ * the executor creation.
+ *
+ * \param executor the executor
+ * \param stats the statistics to fill
+ */
+VLC_API void
+vlc_executor_GetStats(vlc_executor_t *executor,
+                      struct vlc_executor_stats *stats);
+
 # ifdef __cplusplus
 }
 # endif
@@ -172,6 +172,29 @@ VLC_API vlc_frame_t *vlc_frame_Init(vlc_frame_t *frame,
  */
 VLC_API vlc_frame_t *vlc_frame_Alloc(size_t size) VLC_USED VLC_MALLOC;
 
+/**
+ * Frame allocation cache statistics.
+ *
+ * Frames allocated with vlc_frame_Alloc() are recycled through per-thread
+ * caches of size classes, while a LibVLC instance created with the
+ * "frame-cache" option (the default, except with address sanitizers) exists.
+ * The caches are freed when the last such instance is cleaned up.
+ */
+struct vlc_frame_cache_stats
+{
+    bool enabled; /**< whether frames are currently recycled */
+    uint64_t hits; /**< allocations served from the cache */
+    uint64_t misses; /**< cacheable allocations that had to use the heap */
+    size_t bytes_cached; /**< bytes held by the caches */
+};
+
+/**
+ * Gets frame allocation cache statistics.
+ *
+ * Values are updated in batches by each thread, thus approximate.
+ */
+VLC_API void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *stats);
+
 VLC_API vlc_frame_t *vlc_frame_TryRealloc(vlc_frame_t *, ssize_t pre, size_t body) VLC_USED;
 
 /**
@@ -569,6 +592,23 @@ static inline vlc_frame_t *vlc_frame_ChainGather( vlc_frame_t *p_list )
  */
 VLC_API vlc_fifo_t *vlc_fifo_New(void) VLC_USED VLC_MALLOC;
 
+/**
+ * Creates a thread-safe FIFO queue of blocks with a single producer.
+ *
+ * This is the same as vlc_fifo_New(), except that the FIFO also has a ring
+ * of (at least) \p slots entries, into which vlc_fifo_Push() queues blocks
+ * without locking. The FIFO lock is then only taken by the producer if the
+ * ring is full or if a consumer waits in vlc_fifo_Wait().
+ *
+ * All other functions work as with any other FIFO, and account for the
+ * blocks in the ring.
+ *
+ * @param slots minimum number of blocks in the lock-free ring
+ * @return the FIFO or NULL on memory error
+ */
+VLC_API vlc_fifo_t *vlc_fifo_NewSingleProducer(size_t slots)
+VLC_USED VLC_MALLOC;
+
 /**
  * Destroys a FIFO created by vlc_fifo_New().
  *
@@ -659,10 +699,7 @@ static inline void vlc_fifo_Signal(vlc_fifo_t *fifo)
  * @note This function is a cancellation point. In case of cancellation, the
  * the FIFO will be locked before cancellation cleanup handlers are processed.
  */
-static inline void vlc_fifo_Wait(vlc_fifo_t *fifo)
-{
-    vlc_queue_Wait(vlc_fifo_queue(fifo));
-}
+VLC_API void vlc_fifo_Wait(vlc_fifo_t *fifo);
 
 static inline void vlc_fifo_WaitCond(vlc_fifo_t *fifo, vlc_cond_t *condvar)
 {
@@ -743,9 +780,23 @@ VLC_API size_t vlc_fifo_GetCount(const vlc_fifo_t *) VLC_USED;
  */
 VLC_API size_t vlc_fifo_GetBytes(const vlc_fifo_t *) VLC_USED;
 
+/**
+ * Counts bytes in a FIFO without locking.
+ *
+ * This is the same as vlc_fifo_GetBytes() but can be called without the
+ * FIFO lock, typically by the producer of a FIFO created with
+ * vlc_fifo_NewSingleProducer(). The value may be outdated as soon as it is
+ * returned if another thread queues or dequeues blocks concurrently.
+ *
+ * @note This function is not cancellation point.
+ *
+ * @return the total number of bytes
+ */
+VLC_API size_t vlc_fifo_GetBytesRelaxed(const vlc_fifo_t *) VLC_USED;
+
 VLC_USED static inline bool vlc_fifo_IsEmpty(const vlc_fifo_t *fifo)
 {
-    return vlc_queue_IsEmpty(vlc_fifo_queue(fifo));
+    return vlc_fifo_GetCount(fifo) == 0;
 }
 
 static inline void vlc_fifo_Cleanup(void *fifo)
@@ -780,6 +831,24 @@ static inline void vlc_fifo_Put(vlc_fifo_t *fifo, vlc_frame_t *block)
     vlc_fifo_Unlock(fifo);
 }
 
+/**
+ * Queues a linked-list of blocks into a FIFO from its producer thread.
+ *
+ * With a FIFO created by vlc_fifo_NewSingleProducer(), the blocks are queued
+ * into the lock-free ring if there is room, and the FIFO is only locked if
+ * the ring is full or a consumer is waiting. Otherwise, this is the same as
+ * vlc_fifo_Put().
+ *
+ * @warning Only one thread may push blocks into a given FIFO, and it must not
+ * hold the FIFO lock. Other functions can still be used to queue blocks from
+ * other threads, but they will also force the producer to lock the FIFO until
+ * the consumer catches up.
+ *
+ * @param fifo queue
+ * @param block head of a block list to queue (may be NULL)
+ */
+VLC_API void vlc_fifo_Push(vlc_fifo_t *fifo, vlc_frame_t *block);
+
 /* FIXME: not (really) thread-safe */
 VLC_USED VLC_DEPRECATED
 static inline size_t vlc_fifo_Size (vlc_fifo_t *fifo)
@@ -516,6 +516,142 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+
+/** Number of buckets of a latency histogram */
+#define VLC_LATENCY_BUCKETS 16
+/** Upper bound of the first latency histogram bucket */
+#define VLC_LATENCY_BUCKET_BASE VLC_TICK_FROM_US(128)
+
+/**
+ * Latency histogram
+ *
+ * Bucket 0 counts samples below VLC_LATENCY_BUCKET_BASE, bucket i counts
+ * samples in [BASE << (i - 1), BASE << i) and the last bucket counts all
+ * samples above. Samples are classified by magnitude, but the total, min and
+ * max keep their sign, so that early and late values can be told apart.
+ */
+struct vlc_latency_histogram
+{
+    uint64_t buckets[VLC_LATENCY_BUCKETS];
+    uint64_t count;
+    vlc_tick_t total;
+    vlc_tick_t min;
+    vlc_tick_t max;
+};
+
+static inline void vlc_latency_histogram_Init(struct vlc_latency_histogram *h)
+{
+    memset(h, 0, sizeof (*h));
+}
+
+/**
+ * Returns the exclusive upper bound of a histogram bucket, or VLC_TICK_MAX
+ * for the last one.
+ */
+static inline vlc_tick_t vlc_latency_histogram_Bound(unsigned bucket)
+{
+    if (bucket >= VLC_LATENCY_BUCKETS - 1)
+        return VLC_TICK_MAX;
+    return VLC_LATENCY_BUCKET_BASE << bucket;
+}
+
+static inline void vlc_latency_histogram_Add(struct vlc_latency_histogram *h,
+                                             vlc_tick_t value)
+{
+    vlc_tick_t mag = value < 0 ? -value : value;
+    unsigned bucket = 0;
+    while (mag >= vlc_latency_histogram_Bound(bucket))
+        bucket++;
+
+    h->buckets[bucket]++;
+    if (h->count == 0 || value < h->min)
+        h->min = value;
+    if (h->count == 0 || value > h->max)
+        h->max = value;
+    h->count++;
+    h->total += value;
+}
+
+static inline void vlc_latency_histogram_Merge(struct vlc_latency_histogram *dst,
+                                    const struct vlc_latency_histogram *src)
+{
+    if (src->count == 0)
+        return;
+    for (unsigned i = 0; i < VLC_LATENCY_BUCKETS; i++)
+        dst->buckets[i] += src->buckets[i];
+    if (dst->count == 0 || src->min < dst->min)
+        dst->min = src->min;
+    if (dst->count == 0 || src->max > dst->max)
+        dst->max = src->max;
+    dst->count += src->count;
+    dst->total += src->total;
+}
+
+/**
+ * Estimates a percentile of the magnitude of the samples
+ *
+ * \param h histogram
+ * \param percent percentile to compute, between 0 and 100
+ * \return the upper bound of the bucket holding the percentile (clamped to
+ * the largest magnitude seen), or 0 if the histogram is empty
+ */
+static inline vlc_tick_t
+vlc_latency_histogram_Percentile(const struct vlc_latency_histogram *h,
+                                 unsigned percent)
+{
+    if (h->count == 0)
+        return 0;
+
+    uint64_t rank = (h->count * percent + 99) / 100;
+    if (rank == 0)
+        rank = 1;
+
+    vlc_tick_t maxmag = h->max;
+    if (-h->min > maxmag)
+        maxmag = -h->min;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < VLC_LATENCY_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen >= rank)
+        {
+            vlc_tick_t bound = vlc_latency_histogram_Bound(i);
+            return bound < maxmag ? bound : maxmag;
+        }
+    }
+    return maxmag;
+}
+
+/**
+ * Video output per-stage latencies
+ */
+struct vlc_vout_latency
+{
+    struct vlc_latency_histogram filter;  /**< filter chain runs */
+    struct vlc_latency_histogram spu;     /**< subpicture rendering */
+    struct vlc_latency_histogram prepare; /**< display prepare */
+    /** Display time minus the display deadline (negative if early) */
+    struct vlc_latency_histogram display_error;
+};
+
+static inline void vlc_vout_latency_Init(struct vlc_vout_latency *l)
+{
+    vlc_latency_histogram_Init(&l->filter);
+    vlc_latency_histogram_Init(&l->spu);
+    vlc_latency_histogram_Init(&l->prepare);
+    vlc_latency_histogram_Init(&l->display_error);
+}
+
+static inline void vlc_vout_latency_Merge(struct vlc_vout_latency *dst,
+                                          const struct vlc_vout_latency *src)
+{
+    vlc_latency_histogram_Merge(&dst->filter, &src->filter);
+    vlc_latency_histogram_Merge(&dst->spu, &src->spu);
+    vlc_latency_histogram_Merge(&dst->prepare, &src->prepare);
+    vlc_latency_histogram_Merge(&dst->display_error, &src->display_error);
+}
+
 struct input_stats_t
 {
     /* Input */
@@ -539,6 +675,9 @@ struct input_stats_t
     int64_t i_late_pictures;
     int64_t i_lost_pictures;
 
+    /* Vout stage latencies */
+    struct vlc_vout_latency vout_latency;
+
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
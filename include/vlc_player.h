@@ -903,6 +903,9 @@ vlc_player_GetSignal(vlc_player_t *player, float *quality, float *strength);
  * @warning The returned pointer becomes invalid when the player is unlocked.
  * The referenced structure can be safely copied.
  *
+ * The vout_latency member holds the per-stage video output timings, see
+ * vlc_latency_histogram_Percentile() to summarize them.
+ *
  * @see vlc_player_cbs.on_statistics_changed
  *
  * @param player locked player instance
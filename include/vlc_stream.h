@@ -160,6 +160,7 @@ enum stream_query_e
     STREAM_GET_SIGNAL,      /**< arg1=double *pf_quality, arg2=double *pf_strength   res=can fail */
     STREAM_GET_TAGS,        /**< arg1=const block_t ** res=can fail */
     STREAM_GET_TYPE,        /**< arg1=int*             res=can fail */
+    STREAM_GET_ARRIVAL_TIME, /**< arg1= vlc_tick_t*, reception date of the latest data (vlc_tick_now() base) res=can fail */
 
     STREAM_SET_PAUSE_STATE = 0x200, /**< arg1= bool        res=can fail */
     STREAM_SET_TITLE,       /**< arg1= int          res=can fail */
@@ -168,6 +169,8 @@ enum stream_query_e
     /* XXX only data read through vlc_stream_Read/Block will be recorded */
     STREAM_SET_RECORD_STATE,     /**< arg1=bool, arg2=const char *psz_ext (if arg1 is true)  res=can fail */
 
+    STREAM_SET_SEEK_HINT,   /**< arg1= uint64_t     res=can fail */
+
     STREAM_SET_PRIVATE_ID_STATE = 0x1000, /* arg1= int i_private_data, bool b_selected    res=can fail */
     STREAM_SET_PRIVATE_ID_CA,             /* arg1= void * */
     STREAM_GET_PRIVATE_ID_STATE,          /* arg1=int i_private_data arg2=bool *          res=can fail */
@@ -332,6 +335,18 @@ VLC_USED static inline int vlc_stream_GetSize( stream_t *s, uint64_t *size )
     return vlc_stream_Control( s, STREAM_GET_SIZE, size );
 }
 
+/**
+ * Hints the offset of an upcoming seek.
+ *
+ * This lets the stream abandon the read-ahead at the current position and
+ * start fetching data from the given offset instead. The current position is
+ * not changed. This is only a hint, and it can be ignored.
+ */
+static inline int vlc_stream_SeekHint( stream_t *s, uint64_t offset )
+{
+    return vlc_stream_Control( s, STREAM_SET_SEEK_HINT, offset );
+}
+
 static inline int64_t stream_Size( stream_t *s )
 {
     uint64_t i_pos;
@@ -179,6 +179,33 @@ static inline void vlc_tracer_TracePCR( struct vlc_tracer *tracer, const char *t
                      VLC_TRACE("pcr", NS_FROM_VLC_TICK(pcr)), VLC_TRACE_END);
 }
 
+static inline void vlc_tracer_TraceStreamSize(struct vlc_tracer *tracer, const char *type,
+                                const char *id, const char *stream,
+                                int64_t size)
+{
+    vlc_tracer_Trace(tracer, VLC_TRACE("type", type), VLC_TRACE("id", id),
+                     VLC_TRACE("stream", stream), VLC_TRACE("size", size),
+                     VLC_TRACE_END);
+}
+
+/**
+ * Traces the beginning of a span, which ends with vlc_tracer_TraceEnd() with
+ * the same name, from the same thread.
+ */
+static inline void vlc_tracer_TraceBegin(struct vlc_tracer *tracer, const char *type,
+                                const char *id, const char *name)
+{
+    vlc_tracer_Trace(tracer, VLC_TRACE("type", type), VLC_TRACE("id", id),
+                     VLC_TRACE("begin", name), VLC_TRACE_END);
+}
+
+static inline void vlc_tracer_TraceEnd(struct vlc_tracer *tracer, const char *type,
+                                const char *id, const char *name)
+{
+    vlc_tracer_Trace(tracer, VLC_TRACE("type", type), VLC_TRACE("id", id),
+                     VLC_TRACE("end", name), VLC_TRACE_END);
+}
+
 /**
  * @}
  */
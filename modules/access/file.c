@@ -68,6 +68,12 @@ typedef struct
     int fd;
 
     bool b_pace_control;
+#ifdef HAVE_IO_URING
+    struct file_uring *uring;
+#endif
+#ifdef HAVE_MMAP
+    struct file_mmap *mmap;
+#endif
 } access_sys_t;
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -127,6 +133,9 @@ static bool IsRemote (const char *path)
 #endif
 
 static ssize_t Read (stream_t *, void *, size_t);
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *, bool *);
+#endif
 static int FileSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
 
@@ -213,11 +222,35 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+#ifdef HAVE_IO_URING
+    p_sys->uring = NULL;
+#endif
+#ifdef HAVE_MMAP
+    p_sys->mmap = NULL;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
         p_access->pf_seek = FileSeek;
         p_sys->b_pace_control = true;
+#ifdef HAVE_MMAP
+        /* Remote files can vanish or be truncated at any time, and page
+         * faults would then block the reading thread without interruption */
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-mmap")
+         && !IsRemote (fd, p_access->psz_filepath))
+            p_sys->mmap = FileMmapNew (p_access, fd);
+        if (p_sys->mmap != NULL)
+        {
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+        }
+        else
+#endif
+#ifdef HAVE_IO_URING
+        if (S_ISREG (st.st_mode) && var_InheritBool (p_access, "file-uring"))
+            p_sys->uring = FileUringNew (p_access, fd, st.st_size);
+        /* Otherwise, fall back to synchronous reads */
+#endif
 
         /* Demuxers will need the beginning of the file for probing. */
         posix_fadvise (fd, 0, 4096, POSIX_FADV_WILLNEED);
@@ -253,7 +286,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_read == NULL && p_access->pf_block == NULL)
     {
         DirClose (p_this);
         return;
@@ -261,6 +294,14 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_MMAP
+    if (p_sys->mmap != NULL)
+        FileMmapDelete (p_access, p_sys->mmap);
+#endif
+#ifdef HAVE_IO_URING
+    if (p_sys->uring != NULL)
+        FileUringDelete (p_access, p_sys->uring);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -270,6 +311,11 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     access_sys_t *p_sys = p_access->p_sys;
     int fd = p_sys->fd;
 
+#ifdef HAVE_IO_URING
+    if (p_sys->uring != NULL)
+        return FileUringRead (p_access, p_sys->uring, p_buffer, i_len);
+#endif
+
     ssize_t val = vlc_read_i11e (fd, p_buffer, i_len);
     if (val < 0)
     {
@@ -287,6 +333,15 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
     return val;
 }
 
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    return FileMmapBlock (p_access, p_sys->mmap, eof);
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -294,6 +349,17 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
 {
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_MMAP
+    if (sys->mmap != NULL)
+    {
+        FileMmapSeek (sys->mmap, i_pos);
+        return VLC_SUCCESS;
+    }
+#endif
+#ifdef HAVE_IO_URING
+    if (sys->uring != NULL)
+        return FileUringSeek (sys->uring, i_pos);
+#endif
     if (lseek(sys->fd, i_pos, SEEK_SET) == (off_t)-1)
         return VLC_EGENERIC;
     return VLC_SUCCESS;
@@ -346,6 +412,22 @@ static int FileControl( stream_t *p_access, int i_query, va_list args )
             /* Nothing to do */
             break;
 
+        case STREAM_SET_SEEK_HINT:
+        {
+            uint64_t offset = va_arg( args, uint64_t );
+#ifdef HAVE_IO_URING
+            if (p_sys->uring != NULL)
+            {
+                FileUringHint (p_sys->uring, offset);
+                break;
+            }
+#endif
+            if (p_access->pf_seek == NULL)
+                return VLC_EGENERIC;
+            posix_fadvise (p_sys->fd, offset, 1 << 20, POSIX_FADV_WILLNEED);
+            break;
+        }
+
         default:
             return VLC_EGENERIC;
 
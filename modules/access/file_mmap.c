@@ -0,0 +1,207 @@
+/*****************************************************************************
+ * file_mmap.c: zero-copy file blocks with mmap()
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <vlc_common.h>
+#include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include "fs.h"
+
+/* Each block maps a window of the file. The mappings are private and
+ * writable, so that demuxers and decoders can modify the data in place
+ * (copy-on-write) as with any other block.
+ *
+ * If the file is truncated while a window is mapped, accessing the pages
+ * past the new end raises SIGBUS. That cannot be handled safely from a
+ * plugin, so the file is only mapped if it cannot shrink: either sealed
+ * against it, or writable by nobody. As the mode can change, it is checked
+ * again with the size before mapping each window, and the data is read
+ * otherwise. */
+static bool MmapCanShrink(int fd, const struct stat *st)
+{
+#ifdef F_GET_SEALS
+    int seals = fcntl(fd, F_GET_SEALS);
+
+    if (seals != -1 && (seals & F_SEAL_SHRINK))
+        return false;
+#else
+    (void) fd;
+#endif
+    return (st->st_mode & (S_IWUSR | S_IWGRP | S_IWOTH)) != 0;
+}
+
+struct file_mmap
+{
+    int fd;
+    uint64_t pos;
+    size_t window;
+    size_t page_size;
+};
+
+struct file_mmap_block
+{
+    block_t self;
+    void *base;
+    size_t length;
+};
+
+static void MmapBlockRelease(block_t *block)
+{
+    struct file_mmap_block *mb =
+        container_of(block, struct file_mmap_block, self);
+
+    munmap(mb->base, mb->length);
+    free(mb);
+}
+
+static const struct vlc_block_callbacks MmapBlockCallbacks =
+{
+    MmapBlockRelease,
+};
+
+/* Fallback for when the file cannot be mapped */
+static block_t *MmapBlockRead(stream_t *access, struct file_mmap *m,
+                              size_t length, bool *restrict eof)
+{
+    block_t *block = block_Alloc(length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    ssize_t val = pread(m->fd, block->p_buffer, length, m->pos);
+    if (val <= 0)
+    {
+        if (val == 0)
+            *eof = true;
+        else if (errno != EINTR && errno != EAGAIN)
+        {
+            msg_Err(access, "read error: %s", vlc_strerror_c(errno));
+            *eof = true;
+        }
+        block_Release(block);
+        return NULL;
+    }
+
+    block->i_buffer = val;
+    m->pos += val;
+    return block;
+}
+
+block_t *FileMmapBlock(stream_t *access, struct file_mmap *m,
+                       bool *restrict eof)
+{
+    struct stat st;
+
+    /* The size is checked every time, as the file may grow or shrink */
+    if (fstat(m->fd, &st))
+    {
+        msg_Err(access, "read error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    if ((uint64_t)st.st_size <= m->pos)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    uint64_t start = m->pos & ~(uint64_t)(m->page_size - 1);
+    size_t skip = m->pos - start;
+    size_t length = m->window;
+
+    if ((uint64_t)st.st_size - start < length)
+        length = st.st_size - start;
+
+    if (MmapCanShrink(m->fd, &st))
+        return MmapBlockRead(access, m, length - skip, eof);
+
+    struct file_mmap_block *mb = malloc(sizeof (*mb));
+    if (unlikely(mb == NULL))
+        return NULL;
+
+    mb->base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    m->fd, start);
+    if (mb->base == MAP_FAILED)
+    {
+        free(mb);
+        return MmapBlockRead(access, m, length - skip, eof);
+    }
+
+    mb->length = length;
+    madvise(mb->base, length, MADV_SEQUENTIAL);
+    madvise(mb->base, length, MADV_WILLNEED);
+
+#ifdef HAVE_POSIX_FADVISE
+    /* Get the next window in the page cache while this one is consumed */
+    posix_fadvise(m->fd, start + length, m->window, POSIX_FADV_WILLNEED);
+#endif
+
+    block_Init(&mb->self, &MmapBlockCallbacks,
+               (uint8_t *)mb->base + skip, length - skip);
+    m->pos = start + length;
+    return &mb->self;
+}
+
+void FileMmapSeek(struct file_mmap *m, uint64_t offset)
+{
+    m->pos = offset;
+}
+
+struct file_mmap *FileMmapNew(stream_t *access, int fd)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) || MmapCanShrink(fd, &st))
+    {
+        msg_Dbg(access, "file can shrink, not memory-mapped");
+        return NULL;
+    }
+
+    struct file_mmap *m = malloc(sizeof (*m));
+    if (unlikely(m == NULL))
+        return NULL;
+
+    m->fd = fd;
+    m->pos = 0;
+    m->page_size = sysconf(_SC_PAGESIZE);
+    m->window = var_InheritInteger(access, "file-mmap-size") << 10;
+    m->window = (m->window + m->page_size - 1) & ~(m->page_size - 1);
+
+    msg_Dbg(access, "memory-mapped blocks of %zu KiB", m->window >> 10);
+    return m;
+}
+
+void FileMmapDelete(stream_t *access, struct file_mmap *m)
+{
+    (void) access;
+    free(m);
+}
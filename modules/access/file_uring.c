@@ -0,0 +1,769 @@
+/*****************************************************************************
+ * file_uring.c: asynchronous file read-ahead with io_uring
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include <vlc_common.h>
+#include <vlc_access.h>
+#include <vlc_fs.h>
+#include <vlc_interrupt.h>
+#include "fs.h"
+
+/* Read-ahead is organized as a set of fixed-size slots, each holding one
+ * large read. Slots are either free, in flight, completed, or cancelled
+ * (in flight, but whose completion will be discarded).
+ *
+ * The slots ahead of the current position form the read-ahead window.
+ * A seek hint starts a second run at the hinted offset, and the current
+ * position is then served by on-demand reads until the consumer seeks
+ * into the hinted run. */
+enum
+{
+    SLOT_FREE,
+    SLOT_INFLIGHT,
+    SLOT_DONE,
+    SLOT_CANCELLED,
+};
+
+#define URING_CANCEL_TAG UINT64_MAX
+
+struct file_slot
+{
+    uint8_t *buf;
+    uint64_t offset;
+    size_t length; /* requested length, then actual length when done */
+    int error;
+    int state;
+    bool hint; /* belongs to the hinted run */
+    vlc_tick_t submitted;
+    struct iovec iov;
+};
+
+struct file_uring
+{
+    int fd; /* file descriptor */
+    int ring; /* io_uring descriptor */
+
+    /* Submission queue */
+    _Atomic unsigned *sq_head;
+    _Atomic unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned sq_pending;
+
+    /* Completion queue */
+    _Atomic unsigned *cq_head;
+    _Atomic unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_map, *cq_map;
+    size_t sq_map_size, cq_map_size, sqes_size;
+
+    uint64_t pos; /* current position */
+    uint64_t ahead; /* next read-ahead offset */
+    uint64_t eof; /* known end of file */
+    size_t read_size;
+    bool hinted;
+
+    /* Adaptive depth */
+    unsigned depth; /* current target of reads ahead */
+    unsigned max_depth;
+    vlc_tick_t latency; /* average read completion time */
+    vlc_tick_t interval; /* average consumption time of a slot */
+    vlc_tick_t last_consumed;
+    unsigned stalls;
+
+    unsigned slot_count;
+    struct file_slot slots[];
+};
+
+static int uring_enter(int fd, unsigned submit, unsigned wait, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, submit, wait, flags, NULL, 0);
+}
+
+static int UringSetup(struct file_uring *u, unsigned entries)
+{
+    struct io_uring_params p;
+
+    memset(&p, 0, sizeof (p));
+    u->ring = syscall(__NR_io_uring_setup, entries, &p);
+    if (u->ring == -1)
+        return -1;
+
+    u->sq_map_size = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+    u->cq_map_size = p.cq_off.cqes
+                   + p.cq_entries * sizeof (struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (u->cq_map_size > u->sq_map_size)
+            u->sq_map_size = u->cq_map_size;
+        u->cq_map_size = 0;
+    }
+
+    u->sq_map = mmap(NULL, u->sq_map_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, u->ring, IORING_OFF_SQ_RING);
+    if (u->sq_map == MAP_FAILED)
+        goto error;
+
+    if (u->cq_map_size > 0)
+    {
+        u->cq_map = mmap(NULL, u->cq_map_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, u->ring,
+                         IORING_OFF_CQ_RING);
+        if (u->cq_map == MAP_FAILED)
+        {
+            munmap(u->sq_map, u->sq_map_size);
+            goto error;
+        }
+    }
+    else
+        u->cq_map = u->sq_map;
+
+    u->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, u->ring, IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED)
+    {
+        if (u->cq_map != u->sq_map)
+            munmap(u->cq_map, u->cq_map_size);
+        munmap(u->sq_map, u->sq_map_size);
+        goto error;
+    }
+
+    uint8_t *sq = u->sq_map, *cq = u->cq_map;
+
+    u->sq_head = (_Atomic unsigned *)(sq + p.sq_off.head);
+    u->sq_tail = (_Atomic unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->sq_pending = 0;
+    u->cq_head = (_Atomic unsigned *)(cq + p.cq_off.head);
+    u->cq_tail = (_Atomic unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    return 0;
+
+error:
+    vlc_close(u->ring);
+    return -1;
+}
+
+static void UringCleanup(struct file_uring *u)
+{
+    munmap(u->sqes, u->sqes_size);
+    if (u->cq_map != u->sq_map)
+        munmap(u->cq_map, u->cq_map_size);
+    munmap(u->sq_map, u->sq_map_size);
+    vlc_close(u->ring);
+}
+
+static struct io_uring_sqe *UringGetSQE(struct file_uring *u)
+{
+    unsigned tail = atomic_load_explicit(u->sq_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(u->sq_head, memory_order_acquire);
+
+    if (tail - head > u->sq_mask)
+        return NULL; /* full: cannot happen with the sizes used here */
+
+    unsigned idx = tail & u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[idx];
+
+    memset(sqe, 0, sizeof (*sqe));
+    u->sq_array[idx] = idx;
+    atomic_store_explicit(u->sq_tail, tail + 1, memory_order_release);
+    u->sq_pending++;
+    return sqe;
+}
+
+static size_t SlotIndex(const struct file_uring *u, const struct file_slot *s)
+{
+    return s - u->slots;
+}
+
+static void SlotSubmit(struct file_uring *u, struct file_slot *s,
+                       uint64_t offset, bool hint)
+{
+    struct io_uring_sqe *sqe = UringGetSQE(u);
+
+    assert(s->state == SLOT_FREE);
+    if (unlikely(sqe == NULL))
+        return;
+
+    s->offset = offset;
+    s->length = u->read_size;
+    s->error = 0;
+    s->state = SLOT_INFLIGHT;
+    s->hint = hint;
+    s->submitted = vlc_tick_now();
+    s->iov.iov_base = s->buf;
+    s->iov.iov_len = u->read_size;
+
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = u->fd;
+    sqe->off = offset;
+    sqe->addr = (uintptr_t)&s->iov;
+    sqe->len = 1;
+    sqe->user_data = SlotIndex(u, s);
+}
+
+static void SlotRelease(struct file_uring *u, struct file_slot *s)
+{
+    switch (s->state)
+    {
+        case SLOT_INFLIGHT:
+        {
+            struct io_uring_sqe *sqe = UringGetSQE(u);
+
+            /* The completion is still needed to recycle the buffer, even if
+             * the cancellation fails. */
+            s->state = SLOT_CANCELLED;
+            if (likely(sqe != NULL))
+            {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = SlotIndex(u, s);
+                sqe->user_data = URING_CANCEL_TAG;
+            }
+            break;
+        }
+        case SLOT_DONE:
+            s->state = SLOT_FREE;
+            break;
+    }
+}
+
+static struct file_slot *SlotGetFree(struct file_uring *u)
+{
+    for (unsigned i = 0; i < u->slot_count; i++)
+        if (u->slots[i].state == SLOT_FREE)
+            return &u->slots[i];
+    return NULL;
+}
+
+/* Finds the active slot covering the given offset, or starting at the given
+ * offset if it hit the end of file */
+static struct file_slot *SlotFind(struct file_uring *u, uint64_t offset)
+{
+    for (unsigned i = 0; i < u->slot_count; i++)
+    {
+        struct file_slot *s = &u->slots[i];
+
+        if ((s->state == SLOT_INFLIGHT || s->state == SLOT_DONE)
+         && offset >= s->offset
+         && (offset - s->offset < s->length || offset == s->offset))
+            return s;
+    }
+    return NULL;
+}
+
+static void UringReap(struct file_uring *u)
+{
+    unsigned head = atomic_load_explicit(u->cq_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(u->cq_tail, memory_order_acquire);
+
+    if (head == tail)
+        return;
+
+    vlc_tick_t now = vlc_tick_now();
+
+    for (; head != tail; head++)
+    {
+        const struct io_uring_cqe *cqe = &u->cqes[head & u->cq_mask];
+
+        if (cqe->user_data == URING_CANCEL_TAG)
+            continue;
+
+        assert(cqe->user_data < u->slot_count);
+        struct file_slot *s = &u->slots[cqe->user_data];
+
+        if (s->state == SLOT_CANCELLED)
+        {
+            s->state = SLOT_FREE;
+            continue;
+        }
+
+        assert(s->state == SLOT_INFLIGHT);
+        s->state = SLOT_DONE;
+        if (cqe->res < 0)
+        {
+            s->error = -cqe->res;
+            s->length = 0;
+            continue;
+        }
+
+        s->length = cqe->res;
+        if ((size_t)cqe->res < u->read_size)
+            u->eof = s->offset + cqe->res; /* short read: end of file */
+        else if (s->offset + cqe->res > u->eof)
+            u->eof = s->offset + cqe->res; /* file grew */
+
+        u->latency = (7 * u->latency + (now - s->submitted)) / 8;
+    }
+    atomic_store_explicit(u->cq_head, head, memory_order_release);
+}
+
+/* Counts the submitted entries whose completion is still to come */
+static unsigned UringInFlight(const struct file_uring *u)
+{
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < u->slot_count; i++)
+        if (u->slots[i].state == SLOT_INFLIGHT
+         || u->slots[i].state == SLOT_CANCELLED)
+            count++;
+
+    /* Minus the reads not submitted yet */
+    unsigned tail = atomic_load_explicit(u->sq_tail, memory_order_relaxed);
+
+    for (unsigned i = tail - u->sq_pending; i != tail; i++)
+        if (u->sqes[i & u->sq_mask].user_data != URING_CANCEL_TAG)
+            count--;
+    return count;
+}
+
+/* Withdraws the entries that could not be submitted. Their reads complete
+ * at once with the error, so that they are done synchronously instead. */
+static void UringFail(struct file_uring *u, int error)
+{
+    unsigned tail = atomic_load_explicit(u->sq_tail, memory_order_relaxed);
+
+    for (unsigned i = tail - u->sq_pending; i != tail; i++)
+    {
+        const struct io_uring_sqe *sqe = &u->sqes[i & u->sq_mask];
+
+        if (sqe->user_data == URING_CANCEL_TAG)
+            continue; /* the read it cancels completes normally */
+
+        struct file_slot *s = &u->slots[sqe->user_data];
+
+        if (s->state == SLOT_CANCELLED)
+            s->state = SLOT_FREE;
+        else
+        {
+            assert(s->state == SLOT_INFLIGHT);
+            s->state = SLOT_DONE;
+            s->error = error;
+            s->length = 0;
+        }
+    }
+
+    atomic_store_explicit(u->sq_tail, tail - u->sq_pending,
+                          memory_order_release);
+    u->sq_pending = 0;
+}
+
+static int UringSubmit(struct file_uring *u)
+{
+    while (u->sq_pending > 0)
+    {
+        int val = uring_enter(u->ring, u->sq_pending, 0, 0);
+        if (val > 0)
+        {
+            u->sq_pending -= val;
+            continue;
+        }
+        if (val < 0 && errno == EINTR)
+            continue;
+
+        /* Out of resources, or completions overflowing: wait for some of
+         * the submitted entries to complete first, if there are any */
+        if (val < 0 && (errno == EAGAIN || errno == EBUSY)
+         && UringInFlight(u) > 0)
+        {
+            UringReap(u);
+            if (uring_enter(u->ring, 0, 1, IORING_ENTER_GETEVENTS) == 0
+             || errno == EINTR)
+            {
+                UringReap(u);
+                continue;
+            }
+        }
+
+        UringFail(u, val < 0 ? errno : EIO);
+        return -1;
+    }
+    return 0;
+}
+
+/* Chooses how many reads to keep ahead: enough to cover the completion
+ * latency at the current consumption rate, plus one for jitter.
+ * The depth grows at once, but only shrinks one read at a time. */
+static void UringAdapt(struct file_uring *u)
+{
+    unsigned depth = 2;
+
+    if (u->interval > 0)
+        depth += u->latency / u->interval;
+    if (depth > u->max_depth)
+        depth = u->max_depth;
+
+    if (depth > u->depth)
+        u->depth = depth;
+    else if (depth < u->depth)
+        u->depth--;
+}
+
+/* Keeps depth reads ahead. As the depth is lower than the number of slots,
+ * there is always a slot left for on-demand reads.
+ * A hinted run only gets one read until the consumer actually seeks to it,
+ * as hints can be wrong. */
+static void UringFill(struct file_uring *u)
+{
+    unsigned depth = u->hinted ? 1 : u->depth;
+    unsigned active = 0;
+
+    for (unsigned i = 0; i < u->slot_count; i++)
+    {
+        const struct file_slot *s = &u->slots[i];
+
+        if ((s->state == SLOT_INFLIGHT || s->state == SLOT_DONE)
+         && (!u->hinted || s->hint))
+            active++;
+    }
+
+    while (active < depth && u->ahead < u->eof)
+    {
+        struct file_slot *s = SlotGetFree(u);
+        if (s == NULL)
+            break;
+
+        SlotSubmit(u, s, u->ahead, u->hinted);
+        u->ahead += u->read_size;
+        active++;
+    }
+    UringSubmit(u);
+}
+
+/* Releases the slots that cannot serve any upcoming read */
+static void UringDrop(struct file_uring *u)
+{
+    for (unsigned i = 0; i < u->slot_count; i++)
+    {
+        struct file_slot *s = &u->slots[i];
+
+        if ((s->state == SLOT_INFLIGHT || s->state == SLOT_DONE) && !s->hint
+         && (s->offset + s->length <= u->pos || s->offset >= u->ahead))
+            SlotRelease(u, s);
+    }
+}
+
+/* Read-ahead ramps up again after a seek, as random accesses are
+ * typically short. */
+static void UringRewind(struct file_uring *u)
+{
+    u->depth = 2;
+    u->last_consumed = VLC_TICK_INVALID;
+}
+
+static void UringRestart(struct file_uring *u, uint64_t offset)
+{
+    for (unsigned i = 0; i < u->slot_count; i++)
+        SlotRelease(u, &u->slots[i]);
+    UringRewind(u);
+
+    u->pos = offset;
+    u->ahead = offset;
+    u->hinted = false;
+    if (u->eof <= offset)
+        u->eof = offset + u->read_size; /* probe past the known end */
+}
+
+static int UringWait(struct file_uring *u)
+{
+    struct pollfd ufd = { .fd = u->ring, .events = POLLIN };
+
+    if (vlc_poll_i11e(&ufd, 1, -1) < 0)
+        return -1;
+    UringReap(u);
+    return 0;
+}
+
+static ssize_t UringReadSync(stream_t *access, struct file_uring *u,
+                             void *buf, size_t len)
+{
+    ssize_t val = pread(u->fd, buf, len, u->pos);
+    if (val < 0)
+    {
+        switch (errno)
+        {
+            case EINTR:
+            case EAGAIN:
+                return -1;
+        }
+
+        msg_Err(access, "read error: %s", vlc_strerror_c(errno));
+        return 0;
+    }
+
+    u->pos += val;
+    if (!u->hinted)
+        UringDrop(u);
+    return val;
+}
+
+ssize_t FileUringRead(stream_t *access, struct file_uring *u,
+                      void *buf, size_t len)
+{
+    for (;;)
+    {
+        UringReap(u);
+
+        struct file_slot *s = SlotFind(u, u->pos);
+        if (s == NULL)
+        {
+            if (!u->hinted)
+            {   /* Start a new read-ahead run here */
+                UringRestart(u, u->pos);
+                UringFill(u);
+            }
+            else
+            {   /* Read-ahead is busy at the hinted offset: read on demand */
+                s = SlotGetFree(u);
+                if (s == NULL)
+                {
+                    if (UringWait(u))
+                        return -1;
+                    continue;
+                }
+                SlotSubmit(u, s, u->pos, false);
+                UringSubmit(u);
+            }
+
+            s = SlotFind(u, u->pos);
+            if (s == NULL)
+            {   /* No free slots, or failed submission */
+                if (UringWait(u))
+                    return -1;
+                continue;
+            }
+        }
+
+        if (s->state == SLOT_INFLIGHT)
+        {
+            u->stalls++;
+            if (u->depth < u->max_depth)
+                u->depth++;
+            if (UringWait(u))
+                return -1;
+            continue;
+        }
+
+        assert(s->state == SLOT_DONE);
+        if (s->error)
+        {   /* Read synchronously instead, which reports the error if any */
+            msg_Dbg(access, "asynchronous read failed: %s",
+                    vlc_strerror_c(s->error));
+            s->state = SLOT_FREE;
+            return UringReadSync(access, u, buf, len);
+        }
+
+        size_t offset = u->pos - s->offset;
+        size_t copy = s->length - offset;
+
+        if (copy == 0)
+        {   /* End of file (for now) */
+            s->state = SLOT_FREE;
+            return 0;
+        }
+        if (copy > len)
+            copy = len;
+        memcpy(buf, s->buf + offset, copy);
+        u->pos += copy;
+
+        if (u->pos == s->offset + s->length)
+        {   /* Slot fully consumed */
+            vlc_tick_t now = vlc_tick_now();
+
+            if (u->last_consumed != VLC_TICK_INVALID)
+                u->interval = (7 * u->interval + (now - u->last_consumed)) / 8;
+            u->last_consumed = now;
+            s->state = SLOT_FREE;
+            UringAdapt(u);
+        }
+
+        if (!u->hinted)
+            UringDrop(u);
+        UringFill(u);
+        return copy;
+    }
+}
+
+int FileUringSeek(struct file_uring *u, uint64_t offset)
+{
+    UringReap(u);
+
+    struct file_slot *s = SlotFind(u, offset);
+    if (s == NULL)
+    {
+        UringRestart(u, offset);
+        UringFill(u);
+        return VLC_SUCCESS;
+    }
+
+    if (u->hinted && s->hint)
+    {   /* Landed in the hinted run: it becomes the read-ahead window */
+        for (unsigned i = 0; i < u->slot_count; i++)
+        {
+            struct file_slot *h = &u->slots[i];
+
+            if (h->hint)
+                h->hint = false;
+            else
+                SlotRelease(u, h);
+        }
+        u->hinted = false;
+        UringRewind(u);
+    }
+    else if (u->hinted)
+    {   /* Still outside the hinted run (on-demand reads) */
+        u->pos = offset;
+        return VLC_SUCCESS;
+    }
+
+    u->pos = offset;
+    UringDrop(u);
+    UringFill(u);
+    return VLC_SUCCESS;
+}
+
+void FileUringHint(struct file_uring *u, uint64_t offset)
+{
+    UringReap(u);
+
+    if (offset >= u->pos && offset < u->ahead && !u->hinted)
+        return; /* already in the read-ahead window */
+
+    struct file_slot *cur = SlotFind(u, u->pos);
+
+    for (unsigned i = 0; i < u->slot_count; i++)
+        if (&u->slots[i] != cur)
+            SlotRelease(u, &u->slots[i]);
+    if (cur != NULL)
+        cur->hint = false;
+
+    u->ahead = offset;
+    u->hinted = true;
+    if (u->eof <= offset)
+        u->eof = offset + u->read_size;
+    UringFill(u);
+}
+
+struct file_uring *FileUringNew(stream_t *access, int fd, uint64_t size)
+{
+    unsigned depth = var_InheritInteger(access, "file-uring-depth");
+    size_t read_size = var_InheritInteger(access, "file-uring-size") * 1024;
+
+    /* One slot more than the depth for on-demand reads */
+    struct file_uring *u = malloc(sizeof (*u)
+                                  + (depth + 1) * sizeof (u->slots[0]));
+    if (unlikely(u == NULL))
+        return NULL;
+
+    /* Each slot may have a cancellation pending besides its read */
+    if (UringSetup(u, 2 * (depth + 1)))
+    {
+        msg_Dbg(access, "io_uring not available: %s",
+                vlc_strerror_c(errno));
+        free(u);
+        return NULL;
+    }
+
+    u->fd = fd;
+    u->slot_count = depth + 1;
+    for (unsigned i = 0; i < u->slot_count; i++)
+    {
+        struct file_slot *s = &u->slots[i];
+
+        s->buf = aligned_alloc(4096, read_size);
+        s->state = SLOT_FREE;
+        s->hint = false;
+        if (unlikely(s->buf == NULL))
+        {
+            while (i > 0)
+                free(u->slots[--i].buf);
+            UringCleanup(u);
+            free(u);
+            return NULL;
+        }
+    }
+
+    u->pos = 0;
+    u->ahead = 0;
+    u->eof = size;
+    u->read_size = read_size;
+    u->hinted = false;
+    u->max_depth = depth;
+    u->latency = 0;
+    u->interval = 0;
+    u->stalls = 0;
+    UringRewind(u);
+
+    msg_Dbg(access, "io_uring read-ahead: up to %u reads of %zu KiB",
+            depth, read_size / 1024);
+    return u;
+}
+
+void FileUringDelete(stream_t *access, struct file_uring *u)
+{
+    msg_Dbg(access, "io_uring read-ahead: %u stalls, depth %u, "
+            "latency %"PRId64" us", u->stalls, u->depth,
+            US_FROM_VLC_TICK(u->latency));
+
+    /* The kernel may still write to the buffers of the pending reads, even
+     * after the ring is closed. Wait for all of them to complete. */
+    for (unsigned i = 0; i < u->slot_count; i++)
+        SlotRelease(u, &u->slots[i]);
+    UringSubmit(u);
+
+    for (;;)
+    {
+        bool pending = false;
+
+        UringReap(u);
+        for (unsigned i = 0; i < u->slot_count; i++)
+            if (u->slots[i].state != SLOT_FREE)
+                pending = true;
+        if (!pending)
+            break;
+        if (uring_enter(u->ring, 0, 1, IORING_ENTER_GETEVENTS) < 0
+         && errno != EINTR)
+            break;
+    }
+
+    UringCleanup(u);
+    for (unsigned i = 0; i < u->slot_count; i++)
+        free(u->slots[i].buf);
+    free(u);
+}
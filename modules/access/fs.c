@@ -37,6 +37,28 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_IO_URING
+    add_bool( "file-uring", false, N_("Asynchronous read-ahead"),
+              N_("Read regular files ahead of time with io_uring, if "
+                 "supported by the kernel.") )
+    add_integer_with_range( "file-uring-depth", 16, 2, 256,
+                            N_("Maximum read-ahead depth"),
+                            N_("Maximum number of concurrent reads ahead of "
+                               "the current position. The actual depth "
+                               "follows the consumption rate.") )
+    add_integer_with_range( "file-uring-size", 256, 4, 16384,
+                            N_("Read-ahead size (KiB)"),
+                            N_("Size of each asynchronous read.") )
+#endif
+#ifdef HAVE_MMAP
+    add_bool( "file-mmap", false, N_("Memory-mapped blocks"),
+              N_("Map local files in memory instead of reading them, so "
+                 "that demuxers can use the data without copying it. "
+                 "Only files that nobody can write to are mapped.") )
+    add_integer_with_range( "file-mmap-size", 4096, 64, 65536,
+                            N_("Mapping size (KiB)"),
+                            N_("Size of each memory-mapped block.") )
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
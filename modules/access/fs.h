@@ -23,6 +23,23 @@
 int FileOpen (vlc_object_t *);
 void FileClose (vlc_object_t *);
 
+#ifdef HAVE_IO_URING
+struct file_uring;
+struct file_uring *FileUringNew (stream_t *, int fd, uint64_t size);
+void FileUringDelete (stream_t *, struct file_uring *);
+ssize_t FileUringRead (stream_t *, struct file_uring *, void *, size_t);
+int FileUringSeek (struct file_uring *, uint64_t);
+void FileUringHint (struct file_uring *, uint64_t);
+#endif
+
+#ifdef HAVE_MMAP
+struct file_mmap;
+struct file_mmap *FileMmapNew (stream_t *, int fd);
+void FileMmapDelete (stream_t *, struct file_mmap *);
+block_t *FileMmapBlock (stream_t *, struct file_mmap *, bool *restrict eof);
+void FileMmapSeek (struct file_mmap *, uint64_t);
+#endif
+
 int DirOpen (vlc_object_t *);
 int DirInit (stream_t *p_access, DIR *handle);
 void DirClose (vlc_object_t *);
@@ -47,6 +47,8 @@
 #endif
 
 #define DEFAULT_MRU (1500u - (20 + 8))
+/* Maximum number of datagrams received per system call */
+#define RTP_BATCH 32
 
 /**
  * Processes a packet received from the RTP socket.
@@ -98,13 +100,24 @@ static int rtp_timeout (vlc_tick_t deadline)
 /**
  * RTP/RTCP session thread for datagram sockets
  */
+static void rtp_batch_cleanup (void *data)
+{
+    block_t **blocks = data;
+
+    for (unsigned i = 0; i < RTP_BATCH; i++)
+        if (blocks[i] != NULL)
+            block_Release (blocks[i]);
+}
+
 void *rtp_dgram_thread (void *opaque)
 {
     demux_t *demux = opaque;
     demux_sys_t *sys = demux->p_sys;
     vlc_tick_t deadline = VLC_TICK_INVALID;
     struct vlc_dtls *rtp_sock = sys->rtp_sock;
+    block_t *blocks[RTP_BATCH] = { NULL };
 
+    vlc_cleanup_push (rtp_batch_cleanup, blocks);
     for (;;)
     {
         struct pollfd ufd[1];
@@ -122,32 +135,55 @@ void *rtp_dgram_thread (void *opaque)
 
         if (ufd[0].revents)
         {
-            block_t *block = block_Alloc(DEFAULT_MRU);
-            if (unlikely(block == NULL))
-                break; /* we are totallly screwed */
-
-            bool truncated;
-            ssize_t len = vlc_dtls_Recv(rtp_sock, block->p_buffer,
-                                       block->i_buffer, &truncated);
-            if (len >= 0) {
-                if (truncated) {
+            struct iovec iov[RTP_BATCH];
+            size_t lenv[RTP_BATCH];
+            bool truncv[RTP_BATCH];
+
+            /* Only the blocks consumed by the previous batch need refilling */
+            for (unsigned i = 0; i < RTP_BATCH; i++)
+            {
+                if (blocks[i] == NULL)
+                {
+                    blocks[i] = block_Alloc(DEFAULT_MRU);
+                    if (unlikely(blocks[i] == NULL))
+                    {
+                        vlc_restorecancel (canc);
+                        goto out; /* we are totallly screwed */
+                    }
+                }
+                iov[i].iov_base = blocks[i]->p_buffer;
+                iov[i].iov_len = blocks[i]->i_buffer;
+            }
+
+            int count = vlc_dtls_RecvBatch(rtp_sock, iov, lenv, truncv,
+                                           RTP_BATCH);
+            if (count < 0)
+            {
+                if (errno == EPIPE)
+                {
+                    vlc_restorecancel (canc);
+                    break; /* connection terminated */
+                }
+                if (errno != EAGAIN)
+                    msg_Warn (demux, "RTP network error: %s",
+                              vlc_strerror_c(errno));
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                block_t *block = blocks[i];
+
+                if (truncv[i]) {
                     msg_Err(demux, "packet truncated (MRU was %zu)",
                             block->i_buffer);
                     block->i_flags |= BLOCK_FLAG_CORRUPTED;
                 }
                 else
-                    block->i_buffer = len;
+                    block->i_buffer = lenv[i];
 
+                blocks[i] = NULL;
                 rtp_process (demux, block);
             }
-            else
-            {
-                if (errno == EPIPE)
-                    break; /* connection terminated */
-                msg_Warn (demux, "RTP network error: %s",
-                          vlc_strerror_c(errno));
-                block_Release (block);
-            }
 
             n--;
         }
@@ -157,5 +193,8 @@ void *rtp_dgram_thread (void *opaque)
             deadline = VLC_TICK_INVALID;
         vlc_restorecancel (canc);
     }
+out:
+    vlc_cleanup_pop ();
+    rtp_batch_cleanup (blocks);
     return NULL;
 }
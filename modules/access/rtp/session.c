@@ -106,6 +106,10 @@ int rtp_add_type(rtp_session_t *ses, rtp_pt_t *pt)
     return 0;
 }
 
+/* Size of the per-source reordering window (must be a power of two).
+ * At 100 Mb/s, this is about 100 ms worth of 1316-bytes payloads. */
+#define RTP_REORDER_SIZE 1024
+
 /** State for an RTP source */
 struct rtp_source_t
 {
@@ -120,12 +124,16 @@ struct rtp_source_t
     uint16_t bad_seq; /* tentatively next expected sequence for resync */
     uint16_t max_seq; /* next expected sequence */
 
-    uint16_t last_seq; /* sequence of the next dequeued packet */
-    block_t *blocks; /* re-ordered blocks queue */
+    uint16_t last_seq; /* sequence of the last dequeued packet */
+    bool discontinuity; /* flag the next dequeued packet */
+    unsigned count; /* number of packets in the reordering ring */
     struct {
         struct vlc_rtp_pt *instance; /* Per-source current payload format */
         void *opaque; /* Per-source payload format private data */
     } pt;
+    /* Packets waiting for reordering, indexed by sequence number, within
+     * the window starting after last_seq */
+    block_t *ring[RTP_REORDER_SIZE];
 };
 
 /**
@@ -147,13 +155,36 @@ rtp_source_create (demux_t *demux, const rtp_session_t *session,
     source->ref_ntp = UINT64_C (1) << 51;
     source->max_seq = source->bad_seq = init_seq;
     source->last_seq = init_seq - 1;
-    source->blocks = NULL;
+    source->discontinuity = false;
+    source->count = 0;
+    for (size_t i = 0; i < RTP_REORDER_SIZE; i++)
+        source->ring[i] = NULL;
     source->pt.instance = NULL;
     msg_Dbg (demux, "added RTP source (%08x)", ssrc);
     return source;
 }
 
 
+static inline block_t **rtp_slot (rtp_source_t *src, uint16_t seq)
+{
+    return &src->ring[seq % RTP_REORDER_SIZE];
+}
+
+/**
+ * Empties the reordering ring of an RTP source.
+ */
+static void rtp_source_flush (rtp_source_t *src)
+{
+    for (size_t i = 0; i < RTP_REORDER_SIZE && src->count > 0; i++)
+        if (src->ring[i] != NULL)
+        {
+            block_Release (src->ring[i]);
+            src->ring[i] = NULL;
+            src->count--;
+        }
+    assert (src->count == 0);
+}
+
 /**
  * Destroys an RTP source and its associated streams.
  */
@@ -162,7 +193,7 @@ static void rtp_source_destroy(demux_t *demux, rtp_source_t *source)
     msg_Dbg (demux, "removing RTP source (%08x)", source->ssrc);
     if (source->pt.instance != NULL)
         vlc_rtp_pt_end(source->pt.instance, source->pt.opaque);
-    block_ChainRelease (source->blocks);
+    rtp_source_flush (source);
     free (source);
 }
 
@@ -178,6 +209,22 @@ static inline uint32_t rtp_timestamp (const block_t *block)
     return GetDWBE (block->p_buffer + 4);
 }
 
+/**
+ * Finds the first packet in sequence order in the reordering ring.
+ * There must be at least one.
+ */
+static block_t **rtp_first (rtp_source_t *src)
+{
+    assert (src->count > 0);
+
+    for (uint16_t seq = src->last_seq + 1;; seq++)
+    {
+        block_t **slot = rtp_slot (src, seq);
+        if (*slot != NULL)
+            return slot;
+    }
+}
+
 static struct vlc_rtp_pt *rtp_find_ptype(const rtp_session_t *session,
                                          const block_t *block)
 {
@@ -304,10 +351,10 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
         if (seq == src->bad_seq)
         {
             src->max_seq = src->bad_seq = seq + 1;
-            src->last_seq = seq - 0x7fffe; /* hack for rtp_decode() */
+            src->last_seq = seq - 1;
+            src->discontinuity = true;
             msg_Warn (demux, "sequence resynchronized");
-            block_ChainRelease (src->blocks);
-            src->blocks = NULL;
+            rtp_source_flush (src);
         }
         else
         {
@@ -321,21 +368,35 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
 
     /* Queues the block in sequence order,
      * hence there is a single queue for all payload types. */
-    block_t **pp = &src->blocks;
-    for (block_t *prev = *pp; prev != NULL; prev = *pp)
+    delta_seq.u = seq - (uint16_t)(src->last_seq + 1);
+    if (delta_seq.s < 0)
+    {   /* Trash too late packets (and PIM Assert duplicates) */
+        msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")", seq);
+        goto drop;
+    }
+
+    /* Out of the reordering window: give up on the oldest missing packets */
+    while (delta_seq.u >= RTP_REORDER_SIZE)
     {
-        delta_seq.u = seq - rtp_seq (prev);
-        if (delta_seq.s < 0)
-            break;
-        if (delta_seq.s == 0)
+        if (src->count > 0)
+            rtp_decode (demux, session, src);
+        else
         {
-            msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
-            goto drop; /* duplicate */
+            msg_Warn (demux, "%"PRIu16" packet(s) lost", delta_seq.u);
+            src->last_seq = seq - 1;
+            src->discontinuity = true;
         }
-        pp = &prev->p_next;
+        delta_seq.u = seq - (uint16_t)(src->last_seq + 1);
     }
-    block->p_next = *pp;
-    *pp = block;
+
+    block_t **slot = rtp_slot (src, seq);
+    if (*slot != NULL)
+    {
+        msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
+        goto drop; /* duplicate */
+    }
+    *slot = block;
+    src->count++;
 
     /*rtp_decode (demux, session, src);*/
     return;
@@ -370,7 +431,6 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
     for (unsigned i = 0, max = session->srcc; i < max; i++)
     {
         rtp_source_t *src = session->srcv[i];
-        block_t *block;
 
         /* Because of IP packet delay variation (IPDV), we need to guesstimate
          * how long to wait for a missing packet in the RTP sequence
@@ -388,14 +448,16 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
          * LibVLC E/S-out clock synchronization. Here, we need to bother about
          * re-ordering packets, as decoders can't cope with mis-ordered data.
          */
-        while (((block = src->blocks)) != NULL)
+        while (src->count > 0)
         {
-            if ((int16_t)(rtp_seq (block) - (src->last_seq + 1)) <= 0)
-            {   /* Next (or earlier) block ready, no need to wait */
+            if (*rtp_slot (src, src->last_seq + 1) != NULL)
+            {   /* Next block ready, no need to wait */
                 rtp_decode (demux, session, src);
                 continue;
             }
 
+            const block_t *block = *rtp_first (src);
+
             /* Wait for 3 times the inter-arrival delay variance (about 99.7%
              * match for random gaussian jitter).
              */
@@ -431,29 +493,29 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
 }
 
 /**
- * Decodes one RTP packet.
+ * Decodes the first RTP packet in sequence order.
  */
 static void
 rtp_decode (demux_t *demux, const rtp_session_t *session, rtp_source_t *src)
 {
-    block_t *block = src->blocks;
+    block_t **slot = rtp_first (src);
+    block_t *block = *slot;
 
-    assert (block);
-    src->blocks = block->p_next;
-    block->p_next = NULL;
+    *slot = NULL;
+    src->count--;
 
     /* Discontinuity detection */
     uint16_t delta_seq = rtp_seq (block) - (src->last_seq + 1);
     if (delta_seq != 0)
     {
-        if (delta_seq >= 0x8000)
-        {   /* Trash too late packets (and PIM Assert duplicates) */
-            msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")",
-                      rtp_seq (block));
-            goto drop;
-        }
+        assert (delta_seq < RTP_REORDER_SIZE);
         msg_Warn (demux, "%"PRIu16" packet(s) lost", delta_seq);
+        src->discontinuity = true;
+    }
+    if (src->discontinuity)
+    {
         block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        src->discontinuity = false;
     }
     src->last_seq = rtp_seq (block);
 
@@ -0,0 +1,215 @@
+/**
+ * @file session.c
+ * @brief RTP session reordering test
+ */
+/*****************************************************************************
+ * Copyright © 2024 VLC authors and VideoLAN
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ ****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_demux.h>
+#include "../rtp.h"
+
+const char vlc_module_name[] = "rtp_session_test";
+
+#define PACKETS  (1u << 20)
+#define WINDOW   64 /* maximum reordering distance */
+
+static uint16_t next_seq;
+static unsigned decoded, discontinuities;
+
+static void *test_init(struct vlc_rtp_pt *pt)
+{
+    (void) pt;
+    return &next_seq;
+}
+
+static void test_decode(struct vlc_rtp_pt *pt, void *data, block_t *block,
+                        const struct vlc_rtp_pktinfo *restrict info)
+{
+    (void) pt; (void) info;
+    assert(data == &next_seq);
+    /* The sequence number is echoed in the payload */
+    assert(block->i_buffer == 2);
+    uint16_t seq = GetWBE(block->p_buffer);
+
+    if (block->i_flags & BLOCK_FLAG_DISCONTINUITY)
+        discontinuities++;
+    else
+        assert(seq == next_seq);
+    next_seq = seq + 1;
+    decoded++;
+    block_Release(block);
+}
+
+static const struct vlc_rtp_pt_operations test_ops = {
+    NULL, test_init, NULL, test_decode,
+};
+
+void vlc_rtp_pt_release(struct vlc_rtp_pt *pt)
+{
+    assert(pt->ops == &test_ops);
+}
+
+static block_t *test_packet(uint16_t seq)
+{
+    block_t *block = block_Alloc(14);
+
+    assert(block != NULL);
+    block->p_buffer[0] = 0x80;
+    block->p_buffer[1] = 96;
+    SetWBE(block->p_buffer + 2, seq);
+    SetDWBE(block->p_buffer + 4, seq * 160u);
+    SetDWBE(block->p_buffer + 8, 0x12345678);
+    SetWBE(block->p_buffer + 12, seq);
+    return block;
+}
+
+/* Shuffles within consecutive windows, so that no packet is displaced by
+ * more than the window size. */
+static void shuffle(uint16_t *seqv, size_t count)
+{
+    for (size_t base = 0; base < count; base += WINDOW)
+    {
+        size_t n = count - base;
+
+        if (n > WINDOW)
+            n = WINDOW;
+        for (size_t i = n - 1; i > 0; i--)
+        {
+            size_t j = rand() % (i + 1);
+            uint16_t tmp = seqv[base + i];
+
+            seqv[base + i] = seqv[base + j];
+            seqv[base + j] = tmp;
+        }
+    }
+}
+
+static void dequeue_all(demux_t *demux, rtp_session_t *session)
+{
+    vlc_tick_t deadline;
+
+    while (rtp_dequeue(demux, session, &deadline))
+        vlc_tick_wait(deadline);
+}
+
+int main(void)
+{
+    demux_t *demux = (vlc_object_create)(NULL, sizeof (*demux));
+    demux_sys_t sys = {
+        .timeout = VLC_TICK_FROM_SEC(60),
+        .max_dropout = 3000,
+        .max_misorder = 100,
+        .max_src = 1,
+    };
+    struct vlc_rtp_pt pt = {
+        .ops = &test_ops,
+        .frequency = 8000,
+        .number = 96,
+    };
+
+    assert(demux != NULL);
+    demux->p_sys = &sys;
+
+    rtp_session_t *session = rtp_session_create(demux);
+    assert(session != NULL);
+    assert(rtp_add_type(session, &pt) == 0);
+
+    uint16_t *seqv = malloc(PACKETS * sizeof (*seqv));
+    block_t **blockv = malloc(PACKETS * sizeof (*blockv));
+    assert(seqv != NULL && blockv != NULL);
+
+    srand(42);
+    for (size_t i = 0; i < PACKETS; i++)
+        seqv[i] = 1000 + i; /* wraps around several times */
+    shuffle(seqv, PACKETS);
+    /* The first packet defines the initial sequence number */
+    for (size_t i = 1; i < WINDOW; i++)
+        if (seqv[i] == 1000)
+        {
+            seqv[i] = seqv[0];
+            seqv[0] = 1000;
+        }
+    next_seq = 1000;
+
+    /* Reordered packets, none lost */
+    for (size_t i = 0; i < PACKETS; i++)
+        blockv[i] = test_packet(seqv[i]);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (size_t i = 0; i < PACKETS; i++)
+    {
+        vlc_tick_t deadline;
+
+        rtp_queue(demux, session, blockv[i]);
+        rtp_dequeue(demux, session, &deadline);
+    }
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    dequeue_all(demux, session);
+    assert(decoded == PACKETS);
+    assert(discontinuities == 0);
+    printf("%u reordered packets in %"PRId64" us, %.0f packets/s\n",
+           PACKETS, US_FROM_VLC_TICK(elapsed),
+           PACKETS / secf_from_vlc_tick(elapsed));
+
+    /* Duplicates and late packets are discarded */
+    uint16_t seq = next_seq;
+
+    rtp_queue(demux, session, test_packet(seq + 1));
+    rtp_queue(demux, session, test_packet(seq + 1));
+    rtp_queue(demux, session, test_packet(seq));
+    dequeue_all(demux, session);
+    rtp_queue(demux, session, test_packet(seq));
+    dequeue_all(demux, session);
+    assert(decoded == PACKETS + 2);
+    assert(discontinuities == 0);
+
+    /* Lost packet: decoding resumes after the deadline */
+    seq = next_seq;
+    rtp_queue(demux, session, test_packet(seq + 1));
+    rtp_queue(demux, session, test_packet(seq + 2));
+    dequeue_all(demux, session);
+    assert(decoded == PACKETS + 4);
+    assert(discontinuities == 1);
+
+    /* Jump beyond the reordering window flushes the older packets */
+    seq = next_seq;
+    rtp_queue(demux, session, test_packet(seq + 1));
+    rtp_queue(demux, session, test_packet(seq + 2000));
+    assert(decoded == PACKETS + 5);
+    assert(discontinuities == 2);
+    dequeue_all(demux, session);
+    assert(decoded == PACKETS + 6);
+    assert(discontinuities == 3);
+
+    rtp_session_destroy(demux, session);
+    free(blockv);
+    free(seqv);
+    vlc_object_delete(demux);
+    return 0;
+}
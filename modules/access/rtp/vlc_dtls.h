@@ -37,6 +37,9 @@ struct vlc_dtls_operations {
     ssize_t (*readv)(struct vlc_dtls *, struct iovec *iov, unsigned len,
                      bool *restrict truncated);
     ssize_t (*writev)(struct vlc_dtls *, const struct iovec *iov, unsigned len);
+    /* Optional: receives up to count datagrams without blocking */
+    int (*readmmsg)(struct vlc_dtls *, struct iovec *iov, size_t *lenv,
+                    bool *truncv, unsigned count);
 };
 
 static inline void vlc_dtls_Close(struct vlc_dtls *dgs)
@@ -57,6 +60,28 @@ static inline ssize_t vlc_dtls_Recv(struct vlc_dtls *dgs, void *buf, size_t len,
     return dgs->ops->readv(dgs, &iov, 1, truncated);
 }
 
+/**
+ * Receives a batch of datagrams.
+ *
+ * Each datagram is received into the matching single-buffer I/O vector.
+ * If the socket does not support batching, this receives one datagram.
+ *
+ * @return the number of received datagrams, or -1 on error
+ */
+static inline int vlc_dtls_RecvBatch(struct vlc_dtls *dgs, struct iovec *iov,
+                                     size_t *restrict lenv,
+                                     bool *restrict truncv, unsigned count)
+{
+    if (dgs->ops->readmmsg != NULL)
+        return dgs->ops->readmmsg(dgs, iov, lenv, truncv, count);
+
+    ssize_t len = dgs->ops->readv(dgs, iov, 1, truncv);
+    if (len < 0)
+        return -1;
+    lenv[0] = len;
+    return 1;
+}
+
 static inline ssize_t vlc_dtls_Send(struct vlc_dtls *dgs, const void *buf,
                                    size_t len)
 {
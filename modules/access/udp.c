@@ -47,23 +47,56 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <errno.h>
+# include <time.h>
+# include <netinet/udp.h>
+#endif
 
 /* Buffer can be max theoretical datagram content minus anticipated MTU.
  * IPv6 headers are larger than IPv4, ignore IPv6 jumbograms.
  */
 #define MRU 65507u
 
+#ifdef HAVE_RECVMMSG
+/* Number of datagrams received per system call */
+# define UDP_BATCH 32
+/* Initial size of the receive blocks, enough for 7 TS packets in RTP or an
+ * Ethernet frame. It grows to the MRU if a larger datagram shows up. */
+# define UDP_SLOT_SIZE 2048u
+
+typedef union {
+    char buf[CMSG_SPACE(sizeof (struct timespec))];
+    struct cmsghdr align;
+} udp_cmsg_t;
+#endif
+
 typedef struct {
     int fd;
     int timeout;
 
+#ifdef HAVE_RECVMMSG
+    size_t slot_size;
+    unsigned next; /**< Next received block to return */
+    unsigned count; /**< Number of received blocks */
+    block_t *slots[UDP_BATCH];
+    struct mmsghdr msgs[UDP_BATCH];
+    struct iovec iovecs[UDP_BATCH];
+    udp_cmsg_t *cmsgs; /**< Kernel time stamps buffers, if enabled */
+    vlc_tick_t arrival; /**< Arrival time of the latest returned block */
+#else
     size_t length;
     char *offset;
     char buf[MRU];
+#endif
 } access_sys_t;
 
 static int Control(stream_t *access, int query, va_list args)
 {
+#ifdef HAVE_RECVMMSG
+    access_sys_t *sys = access->p_sys;
+#endif
+
     switch (query) {
         case STREAM_CAN_SEEK:
         case STREAM_CAN_FASTSEEK:
@@ -77,12 +110,165 @@ static int Control(stream_t *access, int query, va_list args)
                 VLC_TICK_FROM_MS(var_InheritInteger(access, "network-caching"));
             break;
 
+#ifdef HAVE_RECVMMSG
+        case STREAM_GET_ARRIVAL_TIME:
+            if (sys->arrival == VLC_TICK_INVALID)
+                return VLC_EGENERIC;
+            *va_arg(args, vlc_tick_t *) = sys->arrival;
+            break;
+#endif
+
         default:
             return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
 }
 
+#ifdef HAVE_RECVMMSG
+/**
+ * Returns the arrival time of a datagram from its kernel time stamp,
+ * converted to the vlc_tick_now() time base, not skewed by the scheduling
+ * latency of the input thread.
+ */
+static vlc_tick_t ArrivalTime(struct msghdr *msg, vlc_tick_t now_mono,
+                              vlc_tick_t now_real)
+{
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET
+         && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            struct timespec ts;
+            vlc_tick_t age;
+
+            memcpy(&ts, CMSG_DATA(cmsg), sizeof (ts));
+            age = now_real - vlc_tick_from_timespec(&ts);
+            return (age > 0) ? now_mono - age : now_mono;
+        }
+    }
+    return now_mono;
+}
+
+/**
+ * Receives as many datagrams as available, up to the batch size.
+ * \return the number of datagrams, 0 on time-out, -1 on error/interruption
+ */
+static int Receive(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    int val;
+
+    for (unsigned i = 0; i < UDP_BATCH; i++)
+    {
+        if (sys->slots[i] == NULL)
+        {
+            sys->slots[i] = block_Alloc(sys->slot_size);
+            if (unlikely(sys->slots[i] == NULL))
+                return -1;
+        }
+
+        block_t *block = sys->slots[i];
+        struct msghdr *msg = &sys->msgs[i].msg_hdr;
+
+        sys->iovecs[i].iov_base = block->p_buffer;
+        sys->iovecs[i].iov_len = block->i_buffer;
+        msg->msg_iov = &sys->iovecs[i];
+        msg->msg_iovlen = 1;
+        if (sys->cmsgs != NULL) {
+            msg->msg_control = sys->cmsgs[i].buf;
+            msg->msg_controllen = sizeof (sys->cmsgs[i].buf);
+        } else {
+            msg->msg_control = NULL;
+            msg->msg_controllen = 0;
+        }
+        msg->msg_flags = 0;
+    }
+
+    /* Drain the socket first, only wait if it is empty */
+    while ((val = recvmmsg(sys->fd, sys->msgs, UDP_BATCH, MSG_DONTWAIT,
+                           NULL)) < 0)
+    {
+        if (errno != EAGAIN && errno != EINTR)
+            return -1;
+
+        struct pollfd ufd = { .fd = sys->fd, .events = POLLIN, };
+
+        switch (vlc_poll_i11e(&ufd, 1, sys->timeout)) {
+            case 0:
+                msg_Err(access, "receive time-out");
+                return 0;
+            case -1:
+                return -1;
+        }
+    }
+
+    vlc_tick_t now_mono = VLC_TICK_INVALID, now_real = 0;
+
+    if (sys->cmsgs != NULL) {
+        struct timespec ts;
+
+        now_mono = vlc_tick_now();
+        if (clock_gettime(CLOCK_REALTIME, &ts) == 0)
+            now_real = vlc_tick_from_timespec(&ts);
+    }
+
+    for (int i = 0; i < val; i++)
+    {
+        block_t *block = sys->slots[i];
+        struct msghdr *msg = &sys->msgs[i].msg_hdr;
+
+        if (unlikely(msg->msg_flags & MSG_TRUNC))
+        {
+            if (sys->slot_size < MRU)
+            {
+                msg_Warn(access, "datagram too large, increasing buffers");
+                sys->slot_size = MRU;
+            }
+            block->i_buffer = 0; /* drop it */
+            continue;
+        }
+
+        block->i_buffer = sys->msgs[i].msg_len;
+        if (sys->cmsgs != NULL)
+            block->i_dts = ArrivalTime(msg, now_mono, now_real);
+    }
+    return val;
+}
+
+static block_t *Block(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    for (;;)
+    {
+        while (sys->next < sys->count)
+        {
+            block_t *block = sys->slots[sys->next];
+
+            sys->slots[sys->next++] = NULL;
+            /* empty (0 bytes) payload does *not* mean EOF here */
+            if (block->i_buffer > 0) {
+                if (block->i_dts != VLC_TICK_INVALID)
+                    sys->arrival = block->i_dts;
+                return block;
+            }
+            block_Release(block);
+        }
+
+        sys->next = sys->count = 0;
+
+        int val = Receive(access);
+        if (val <= 0)
+        {
+            if (val == 0)
+                *eof = true;
+            return NULL;
+        }
+        sys->count = val;
+    }
+}
+#else
 static ssize_t Read(stream_t *access, void *buf, size_t len)
 {
     access_sys_t *sys = access->p_sys;
@@ -131,6 +317,7 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
 
     return val;
 }
+#endif
 
 /*****************************************************************************
  * Open: open the socket
@@ -147,10 +334,22 @@ static int Open( vlc_object_t *p_this )
     if( unlikely( sys == NULL ) )
         return VLC_ENOMEM;
 
-    sys->length = 0;
     p_access->p_sys = sys;
+#ifdef HAVE_RECVMMSG
+    sys->slot_size = UDP_SLOT_SIZE;
+    sys->next = sys->count = 0;
+    for (size_t i = 0; i < UDP_BATCH; i++)
+        sys->slots[i] = NULL;
+    memset(sys->msgs, 0, sizeof (sys->msgs));
+    sys->cmsgs = NULL;
+    sys->arrival = VLC_TICK_INVALID;
+    p_access->pf_read = NULL;
+    p_access->pf_block = Block;
+#else
+    sys->length = 0;
     p_access->pf_read = Read;
     p_access->pf_block = NULL;
+#endif
     p_access->pf_control = Control;
     p_access->pf_seek = NULL;
 
@@ -217,6 +416,27 @@ static int Open( vlc_object_t *p_this )
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+# ifdef UDP_GRO
+    /* Coalesced datagrams are simply concatenated, as is the stream */
+    if( var_InheritBool( p_access, "udp-gro" )
+     && setsockopt( sys->fd, SOL_UDP, UDP_GRO, &(int){ 1 },
+                    sizeof (int) ) == 0 )
+        sys->slot_size = MRU;
+# endif
+# ifdef SO_TIMESTAMPNS
+    if( var_InheritBool( p_access, "udp-timestamps" ) )
+    {
+        if( setsockopt( sys->fd, SOL_SOCKET, SO_TIMESTAMPNS, &(int){ 1 },
+                        sizeof (int) ) == 0 )
+            sys->cmsgs = vlc_obj_calloc( p_this, UDP_BATCH,
+                                         sizeof (*sys->cmsgs) );
+        else
+            msg_Warn( p_access, "kernel time stamps not supported: %s",
+                      vlc_strerror_c(errno) );
+    }
+# endif
+#endif
     return VLC_SUCCESS;
 }
 
@@ -229,9 +449,22 @@ static void Close( vlc_object_t *p_this )
     access_sys_t *sys = p_access->p_sys;
 
     net_Close( sys->fd );
+#ifdef HAVE_RECVMMSG
+    for (size_t i = 0; i < UDP_BATCH; i++)
+        if (sys->slots[i] != NULL)
+            block_Release(sys->slots[i]);
+#endif
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define GRO_TEXT N_("UDP receive offload")
+#define GRO_LONGTEXT N_("Let the kernel coalesce consecutive datagrams " \
+    "from the same source into larger buffers. This reduces the CPU usage " \
+    "at high bit rates, at the expense of memory.")
+#define TIMESTAMPS_TEXT N_("Kernel arrival time stamps")
+#define TIMESTAMPS_LONGTEXT N_("Date the received data with the time it " \
+    "reached the network stack, rather than when it was read. The dates " \
+    "are set on the blocks and can be queried from the stream.")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -240,6 +473,12 @@ vlc_module_begin()
 
     add_obsolete_integer("udp-buffer") /* since 3.0.0 */
     add_integer("udp-timeout", -1, TIMEOUT_TEXT, NULL)
+#if defined(HAVE_RECVMMSG) && defined(UDP_GRO)
+    add_bool("udp-gro", false, GRO_TEXT, GRO_LONGTEXT)
+#endif
+#if defined(HAVE_RECVMMSG) && defined(SO_TIMESTAMPNS)
+    add_bool("udp-timestamps", false, TIMESTAMPS_TEXT, TIMESTAMPS_LONGTEXT)
+#endif
 
     set_capability("access", 0)
     add_shortcut("udp", "udpstream", "udp4", "udp6")
@@ -116,6 +116,7 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     resources = res;
     first = true;
     initializing = true;
+    chasingLiveEdge = true;
     bufferingLogic = bl;
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
@@ -220,6 +221,7 @@ void SegmentTracker::reset()
     next = Position();
     resetChunksSequence();
     initializing = true;
+    chasingLiveEdge = true;
     format = StreamFormat::Type::Unknown;
 }
 
@@ -335,8 +337,12 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed,
     if(!adaptationSet || !next.isValid())
         return nullptr;
 
+    bool b_catchup = false;
     if(chunkssequence.empty())
     {
+        Position pos = getCatchUpPosition();
+        b_catchup = (pos.number != next.number);
+        next = pos;
         ChunkEntry chunk = prepareChunk(switch_allowed, next, connManager);
         chunkssequence.push_back(chunk);
     }
@@ -408,7 +414,7 @@ ChunkInterface * SegmentTracker::getNextChunk(bool switch_allowed,
         notify(SegmentChangedEvent(adaptationSet->getID(), chunk.starttime, chunk.duration, chunk.displaytime));
 
     /* Handle both implicit and explicit discontinuities */
-    if(b_gap || b_discontinuity)
+    if(b_gap || b_discontinuity || b_catchup)
         notify(DiscontinuityEvent());
 
     if(!b_gap)
@@ -438,7 +444,11 @@ bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool try
     if(pos.rep->getSegmentNumberByTime(time, &pos.number))
     {
         if(!tryonly)
+        {
+            /* user chosen position, don't skip ahead from it */
+            chasingLiveEdge = false;
             setPosition(pos, restarted);
+        }
         return true;
     }
     return false;
@@ -454,6 +464,31 @@ void SegmentTracker::setPosition(const Position &pos, bool restarted)
     notify(PositionChangedEvent());
 }
 
+SegmentTracker::Position SegmentTracker::getCatchUpPosition() const
+{
+    /* Low latency: when lagging too far behind the live edge, restart
+     * from the live start position instead of downloading all late
+     * segments. Playback rate is driven by the input clock, so skipping
+     * is the only way to recover the latency target. */
+    Position pos = next;
+    if(!chasingLiveEdge || !pos.init_sent || !pos.index_sent)
+        return pos;
+
+    const vlc_tick_t threshold = bufferingLogic->getCatchUpThreshold(adaptationSet->getPlaylist());
+    if(!threshold || pos.rep->getMinAheadTime(pos.number) <= threshold)
+        return pos;
+
+    uint64_t number = bufferingLogic->getStartSegmentNumber(pos.rep);
+    if(number != std::numeric_limits<uint64_t>::max() && number > pos.number)
+    {
+        msg_Info(adaptationSet->getPlaylist()->getVLCObject(),
+                 "Catching up with live edge, skipping %" PRIu64 " segments",
+                 number - pos.number);
+        pos.number = number;
+    }
+    return pos;
+}
+
 SegmentTracker::Position SegmentTracker::getStartPosition() const
 {
     Position pos;
@@ -218,10 +218,12 @@ namespace adaptive
             ChunkEntry prepareChunk(bool switch_allowed, Position pos,
                                     AbstractConnectionManager *connManager) const;
             void resetChunksSequence();
+            Position getCatchUpPosition() const;
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const TrackerEvent &) const;
             bool first;
             bool initializing;
+            bool chasingLiveEdge;
             Position current;
             Position next;
             StreamFormat format;
@@ -82,6 +82,13 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_DOWNLOADS_TEXT N_("Concurrent downloads")
+#define ADAPT_DOWNLOADS_LONGTEXT N_("Maximum number of segments downloaded at once")
+
+#define ADAPT_HOSTCONNS_TEXT N_("Connections per host")
+#define ADAPT_HOSTCONNS_LONGTEXT N_("Maximum number of concurrent segment downloads " \
+                                    "from a single host (0 for unlimited)")
+
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
@@ -142,6 +149,12 @@ vlc_module_begin ()
         add_integer( "adaptive-maxbuffer",
                      MS_FROM_VLC_TICK(AbstractBufferingLogic::DEFAULT_MAX_BUFFERING),
                      ADAPT_MAXBUFFER_TEXT, nullptr );
+        add_integer( "adaptive-downloads", 3,
+                     ADAPT_DOWNLOADS_TEXT, ADAPT_DOWNLOADS_LONGTEXT );
+            change_integer_range( 1, 16 )
+        add_integer( "adaptive-host-connections", 2,
+                     ADAPT_HOSTCONNS_TEXT, ADAPT_HOSTCONNS_LONGTEXT );
+            change_integer_range( 0, 16 )
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT );
             change_integer_list(rgi_latency, ppsz_latency)
         set_callbacks( Open, Close )
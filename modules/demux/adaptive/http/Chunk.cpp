@@ -177,6 +177,11 @@ bool HTTPChunkSource::init(const std::string &url)
     return true;
 }
 
+const ConnectionParams & HTTPChunkSource::getConnectionParams() const
+{
+    return params;
+}
+
 bool HTTPChunkSource::hasMoreData() const
 {
     mutex_locker locker {lock};
@@ -217,7 +222,20 @@ block_t * HTTPChunkSource::read(size_t readsize)
         return nullptr;
     }
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    /* connection reads can be partial, fill up the block */
+    ssize_t ret = 0;
+    while((size_t) ret < readsize)
+    {
+        ssize_t partial = connection->read(&p_block->p_buffer[ret], readsize - ret);
+        if(partial <= 0)
+        {
+            if(ret == 0)
+                ret = partial;
+            break;
+        }
+        ret += partial;
+    }
+
     if(ret < 0)
     {
         block_Release(p_block);
@@ -325,6 +343,7 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     done = false;
     eof = false;
     held = false;
+    sharedStartTime = 0;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -365,10 +384,12 @@ void HTTPChunkBufferedSource::release()
     avail.signal();
 }
 
-void HTTPChunkBufferedSource::bufferize(size_t readsize)
+void HTTPChunkBufferedSource::bufferize(size_t readsize, TransferClock &clock)
 {
     {
         mutex_locker locker {lock};
+        if(!prepared)
+            sharedStartTime = clock.getTime();
         if(!prepare())
         {
             done = true;
@@ -380,8 +401,8 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         if(readsize < HTTPChunkSource::CHUNK_SIZE)
             readsize = HTTPChunkSource::CHUNK_SIZE;
 
-        if(contentLength && readsize > contentLength - buffered)
-            readsize = contentLength - buffered;
+        if(contentLength && readsize > contentLength - buffered - consumed)
+            readsize = contentLength - buffered - consumed;
     }
 
     block_t *p_block = block_Alloc(readsize);
@@ -407,7 +428,7 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         done = true;
         downloadEndTime = vlc_tick_now();
         rate.size = buffered + consumed;
-        rate.time = downloadEndTime - requestStartTime;
+        rate.time = clock.getTime(downloadEndTime) - sharedStartTime;
         rate.latency = responseTime - requestStartTime;
     }
     else
@@ -416,12 +437,14 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         mutex_locker locker {lock};
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        /* Short reads are only partial data. Without length (chunked
+         * transfer), the end is signaled by an empty read. */
+        if(contentLength && buffered + consumed >= contentLength)
         {
             done = true;
             downloadEndTime = vlc_tick_now();
             rate.size = buffered + consumed;
-            rate.time = downloadEndTime - requestStartTime;
+            rate.time = clock.getTime(downloadEndTime) - sharedStartTime;
             rate.latency = responseTime - requestStartTime;
         }
     }
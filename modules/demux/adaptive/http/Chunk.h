@@ -42,6 +42,7 @@ namespace adaptive
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class TransferClock;
 
         enum class ChunkType
         {
@@ -132,6 +133,7 @@ namespace adaptive
                                 bool = false);
 
                 virtual bool        prepare();
+                const ConnectionParams & getConnectionParams() const;
                 AbstractConnection    *connection;
                 AbstractConnectionManager *connManager;
                 mutable vlc::threads::mutex lock;
@@ -163,7 +165,7 @@ namespace adaptive
                 HTTPChunkBufferedSource(const std::string &url, AbstractConnectionManager *,
                                         const ID &, ChunkType, const BytesRange &,
                                         bool = false);
-                void               bufferize(size_t);
+                void               bufferize(size_t, TransferClock &);
                 bool               isDone() const;
                 void               hold();
                 void               release();
@@ -176,6 +178,7 @@ namespace adaptive
                 bool                eof;
                 vlc::threads::condition_variable avail;
                 bool                held;
+                vlc_tick_t          sharedStartTime; /* on the TransferClock */
         };
 
         class HTTPChunk : public AbstractChunk
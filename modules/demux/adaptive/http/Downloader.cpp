@@ -25,35 +25,75 @@
 
 #include <vlc_threads.h>
 
-#include <atomic>
+#include <algorithm>
+#include <cassert>
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+TransferClock::TransferClock()
+{
+    sharedTime = 0;
+    lastUpdate = VLC_TICK_INVALID;
+    transfers = 0;
+}
+
+void TransferClock::advance(vlc_tick_t now)
+{
+    if(lastUpdate != VLC_TICK_INVALID && now > lastUpdate)
+        sharedTime += (now - lastUpdate) / (transfers ? transfers : 1);
+    if(lastUpdate == VLC_TICK_INVALID || now > lastUpdate)
+        lastUpdate = now;
+}
+
+vlc_tick_t TransferClock::getTime(vlc_tick_t now)
+{
+    vlc::threads::mutex_locker locker {lock};
+    advance(now);
+    return sharedTime;
+}
+
+void TransferClock::transferStarted(vlc_tick_t now)
+{
+    vlc::threads::mutex_locker locker {lock};
+    advance(now);
+    transfers++;
+}
+
+void TransferClock::transferEnded(vlc_tick_t now)
+{
+    vlc::threads::mutex_locker locker {lock};
+    advance(now);
+    assert(transfers > 0);
+    transfers--;
+}
+
+Downloader::Downloader(TransferClock &clock_, unsigned workers_,
+                       unsigned hostConnections_)
+    : clock(clock_)
 {
     killed = false;
-    thread_handle_valid = false;
-    current = nullptr;
-    cancel_current = false;
+    workers = workers_ ? workers_ : 1;
+    hostConnections = hostConnections_;
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    while(threads.size() < workers)
     {
-        return false;
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        threads.push_back(thread_handle);
     }
-    thread_handle_valid = true;
-    return true;
+    return !threads.empty();
 }
 
 Downloader::~Downloader()
 {
     kill();
 
-    if(thread_handle_valid)
+    for(vlc_thread_t thread_handle : threads)
         vlc_join(thread_handle, nullptr);
 }
 
@@ -61,33 +101,91 @@ void Downloader::kill()
 {
     vlc::threads::mutex_locker locker {lock};
     killed = true;
-    wait_cond.signal();
+    wait_cond.broadcast();
 }
 
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
+    const ConnectionParams &params = source->getConnectionParams();
+    Transfer transfer;
+    transfer.source = source;
+    transfer.host = params.getScheme() + "://" + params.getHostname() + ":" +
+                    std::to_string(params.getPort());
+    transfer.active = false;
+    transfer.cancel = false;
+
     vlc::threads::mutex_locker locker {lock};
     source->hold();
-    chunks.push_back(source);
+    transfers.push_back(transfer);
     wait_cond.signal();
 }
 
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc::threads::mutex_locker locker {lock};
-    while (current == source)
+    std::list<Transfer>::iterator it;
+    while((it = find(source)) != transfers.end() && it->active)
     {
-        cancel_current = true;
+        it->cancel = true;
         updated_cond.wait(lock);
     }
 
-    if(!source->isDone())
+    if(it != transfers.end())
     {
-        chunks.remove(source);
+        transfers.erase(it);
         source->release();
     }
 }
 
+std::list<Downloader::Transfer>::iterator
+Downloader::find(const HTTPChunkBufferedSource *source)
+{
+    return std::find_if(transfers.begin(), transfers.end(),
+                        [source](const Transfer &t){ return t.source == source; });
+}
+
+unsigned Downloader::activeTransfers(const std::string &host) const
+{
+    return std::count_if(transfers.cbegin(), transfers.cend(),
+                         [&host](const Transfer &t){ return t.active && t.host == host; });
+}
+
+unsigned Downloader::activeTransfers(const ID &id) const
+{
+    return std::count_if(transfers.cbegin(), transfers.cend(),
+                         [&id](const Transfer &t){ return t.active && t.source->sourceid == id; });
+}
+
+/* Picks the next queued transfer within the host connection budget.
+ * Streams with the fewest running transfers go first, so that a small
+ * audio segment does not wait behind a large video one, then
+ * initialization and index data, then the queue order. */
+std::list<Downloader::Transfer>::iterator Downloader::getNextTransfer()
+{
+    std::list<Transfer>::iterator next = transfers.end();
+    unsigned nextrunning = 0;
+    bool nextsegment = true;
+
+    for(auto it = transfers.begin(); it != transfers.end(); ++it)
+    {
+        if(it->active)
+            continue;
+        if(hostConnections && activeTransfers(it->host) >= hostConnections)
+            continue;
+
+        unsigned running = activeTransfers(it->source->sourceid);
+        bool segment = it->source->getChunkType() == ChunkType::Segment;
+        if(next == transfers.end() || running < nextrunning ||
+           (running == nextrunning && !segment && nextsegment))
+        {
+            next = it;
+            nextrunning = running;
+            nextsegment = segment;
+        }
+    }
+    return next;
+}
+
 void * Downloader::downloaderThread(void *opaque)
 {
     Downloader *instance = static_cast<Downloader *>(opaque);
@@ -97,31 +195,38 @@ void * Downloader::downloaderThread(void *opaque)
 
 void Downloader::Run()
 {
+    std::list<Transfer>::iterator it;
+
+    lock.lock();
     while(1)
     {
-        lock.lock();
-
-        while(chunks.empty() && !killed)
+        while(!killed && (it = getNextTransfer()) == transfers.end())
             wait_cond.wait(lock);
 
         if(killed)
-        {
-            lock.unlock();
             break;
-        }
 
-        current = chunks.front();
+        it->active = true;
+        HTTPChunkBufferedSource *source = it->source;
         lock.unlock();
-        current->bufferize(HTTPChunkSource::CHUNK_SIZE);
-        lock.lock();
-        if(current->isDone() || cancel_current)
+
+        clock.transferStarted();
+        bool finished;
+        do
         {
-            chunks.pop_front();
-            current->release();
-        }
-        cancel_current = false;
-        current = nullptr;
-        updated_cond.signal();
-        lock.unlock();
+            source->bufferize(HTTPChunkSource::CHUNK_SIZE, clock);
+            lock.lock();
+            finished = source->isDone() || it->cancel || killed;
+            lock.unlock();
+        } while(!finished);
+        clock.transferEnded();
+
+        lock.lock();
+        transfers.erase(it);
+        source->release();
+        updated_cond.broadcast();
+        /* A host connection is available again */
+        wait_cond.signal();
     }
+    lock.unlock();
 }
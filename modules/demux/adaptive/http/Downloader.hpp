@@ -25,35 +25,66 @@
 #include <vlc_common.h>
 #include <vlc_cxx_helpers.hpp>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
 
     namespace http
     {
+        /* Splits the elapsed time between the transfers running at once,
+         * so that the sum of the times of overlapping transfers is the time
+         * the link was busy, and rates derived from them add up to the
+         * link throughput. */
+        class TransferClock
+        {
+            public:
+                TransferClock();
+                vlc_tick_t getTime(vlc_tick_t = vlc_tick_now());
+                void transferStarted(vlc_tick_t = vlc_tick_now());
+                void transferEnded(vlc_tick_t = vlc_tick_now());
+
+            private:
+                void advance(vlc_tick_t);
+                vlc::threads::mutex lock;
+                vlc_tick_t   sharedTime;
+                vlc_tick_t   lastUpdate;
+                unsigned     transfers;
+        };
 
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(TransferClock &, unsigned = 1, unsigned = 0);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
 
             private:
+                struct Transfer
+                {
+                    HTTPChunkBufferedSource *source;
+                    std::string host;
+                    bool         active;
+                    bool         cancel;
+                };
                 static void * downloaderThread(void *);
                 void Run();
                 void kill();
-                vlc_thread_t thread_handle;
+                std::list<Transfer>::iterator getNextTransfer();
+                std::list<Transfer>::iterator find(const HTTPChunkBufferedSource *);
+                unsigned activeTransfers(const std::string &) const;
+                unsigned activeTransfers(const ID &) const;
+                TransferClock &clock;
+                std::vector<vlc_thread_t> threads;
+                unsigned     workers;
+                unsigned     hostConnections; /* per host, 0 for unlimited */
                 vlc::threads::mutex lock;
                 vlc::threads::condition_variable wait_cond;
                 vlc::threads::condition_variable updated_cond;
-                bool         thread_handle_valid;
                 bool         killed;
-                bool         cancel_current;
-                std::list<HTTPChunkBufferedSource *> chunks;
-                HTTPChunkBufferedSource *current;
+                std::list<Transfer> transfers;
         };
 
     }
@@ -408,7 +408,9 @@ RequestStatus LibVLCHTTPConnection::request(const std::string &path,
 
 ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
 {
-    ssize_t read = vlc_stream_Read(stream, p_buffer, len);
+    /* Return data as soon as received. Segments still being produced
+     * (low latency, chunked transfer) are consumed as they arrive. */
+    ssize_t read = vlc_stream_ReadPartial(stream, p_buffer, len);
     bytesRead = source->totalRead;
     return read;
 }
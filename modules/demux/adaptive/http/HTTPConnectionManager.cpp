@@ -75,8 +75,12 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_)
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new Downloader();
-    downloaderhp = new Downloader();
+    unsigned workers = var_InheritInteger(p_object, "adaptive-downloads");
+    unsigned hostconnections = var_InheritInteger(p_object, "adaptive-host-connections");
+    transferClock = new TransferClock();
+    downloader = new Downloader(*transferClock, workers, hostconnections);
+    /* blocking playlist reloads can be held by the server for a while */
+    downloaderhp = new Downloader(*transferClock, workers);
     downloader->start();
     downloaderhp->start();
 }
@@ -85,6 +89,7 @@ HTTPConnectionManager::~HTTPConnectionManager   ()
 {
     delete downloader;
     delete downloaderhp;
+    delete transferClock;
     this->closeAllConnections();
     while(!factories.empty())
     {
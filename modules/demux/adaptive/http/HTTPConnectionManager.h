@@ -42,6 +42,7 @@ namespace adaptive
         class AbstractConnectionFactory;
         class AbstractConnection;
         class Downloader;
+        class TransferClock;
         class AbstractChunkSource;
         enum class ChunkType;
 
@@ -94,6 +95,7 @@ namespace adaptive
                 void    releaseAllConnections ();
                 Downloader                                         *downloader;
                 Downloader                                         *downloaderhp;
+                TransferClock                                      *transferClock;
                 vlc_mutex_t                                         lock;
                 std::vector<AbstractConnection *>                   connectionPool;
                 std::list<AbstractConnectionFactory *>              factories;
@@ -129,7 +129,13 @@ vlc_tick_t DefaultBufferingLogic::getMaxBuffering(const BasePlaylist *p) const
 vlc_tick_t DefaultBufferingLogic::getLiveDelay(const BasePlaylist *p) const
 {
     if(isLowLatency(p))
-        return getMinBuffering(p);
+    {
+        /* honor the target latency (DASH ServiceDescription), or the
+         * server hold back (HLS PART-HOLD-BACK) */
+        vlc_tick_t delay = p->targetLatency.Get() ? p->targetLatency.Get()
+                                                  : p->suggestedPresentationDelay.Get();
+        return std::max(getMinBuffering(p), delay);
+    }
     vlc_tick_t delay = userLiveDelay ? userLiveDelay
                                      : DEFAULT_LIVE_BUFFERING;
     if(p->suggestedPresentationDelay.Get())
@@ -152,6 +158,14 @@ vlc_tick_t DefaultBufferingLogic::getStableBuffering(const BasePlaylist *p) cons
     return std::min(getMinBuffering(p) * 2, max);
 }
 
+vlc_tick_t DefaultBufferingLogic::getCatchUpThreshold(const BasePlaylist *p) const
+{
+    /* Only low latency playback chases the live edge */
+    if(!p->isLive() || !isLowLatency(p))
+        return 0;
+    return getLiveDelay(p) * 2;
+}
+
 uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *rep) const
 {
     BasePlaylist *playlist = rep->getPlaylist();
@@ -242,7 +256,8 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
         {
             /* Compute playback offset and effective finished segment from wall time */
             vlc_tick_t now = vlc_tick_from_sec(time(nullptr));
-            vlc_tick_t playbacktime = now - i_buffering;
+            vlc_tick_t playbacktime = now + mediaSegmentTemplate->inheritAvailabilityTimeOffset()
+                                    - i_buffering;
             vlc_tick_t minavailtime = playlist->availabilityStartTime.Get() + rep->getPeriodStart();
             const uint64_t startnumber = mediaSegmentTemplate->inheritStartNumber();
             const Timescale timescale = mediaSegmentTemplate->inheritTimescale();
@@ -351,6 +366,15 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
             skipduration -= (*it)->duration.Get();
         }
 
+        /* Step back to a unit decoding can start from (HLS parts) */
+        for(auto it = list.rbegin(); it != list.rend(); ++it)
+        {
+            if((*it)->getSequenceNumber() > start || !(*it)->independent)
+                continue;
+            start = (*it)->getSequenceNumber();
+            break;
+        }
+
         return start;
     }
     else if(segmentBase)
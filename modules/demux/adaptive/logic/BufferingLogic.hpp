@@ -47,6 +47,8 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const = 0;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const = 0;
+                /* max lag behind the live edge before skipping ahead, 0 if disabled */
+                virtual vlc_tick_t getCatchUpThreshold(const BasePlaylist *) const = 0;
                 void setUserMinBuffering(vlc_tick_t);
                 void setUserMaxBuffering(vlc_tick_t);
                 void setUserLiveDelay(vlc_tick_t);
@@ -73,6 +75,7 @@ namespace adaptive
                 virtual vlc_tick_t getMaxBuffering(const BasePlaylist *) const override;
                 virtual vlc_tick_t getLiveDelay(const BasePlaylist *) const override;
                 virtual vlc_tick_t getStableBuffering(const BasePlaylist *) const override;
+                virtual vlc_tick_t getCatchUpThreshold(const BasePlaylist *) const override;
                 static const unsigned SAFETY_BUFFERING_EDGE_OFFSET;
                 static const unsigned SAFETY_EXPURGING_OFFSET;
 
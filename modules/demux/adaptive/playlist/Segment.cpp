@@ -50,6 +50,7 @@ ISegment::ISegment(const ICanonicalUrl *parent):
     sequence = 0;
     templated = false;
     discontinuity = false;
+    independent = true;
     displayTime = VLC_TICK_INVALID;
 }
 
@@ -80,6 +80,7 @@ namespace adaptive
                 Property<stime_t>       startTime;
                 Property<stime_t>       duration;
                 bool                    discontinuity;
+                bool                    independent; /* playback can start here */
 
             protected:
                 virtual bool                            prepareChunk    (SharedResources *,
@@ -30,6 +30,7 @@
 #include "SegmentInformation.hpp"
 #include "SegmentTimeline.h"
 
+#include <algorithm>
 #include <limits>
 
 using namespace adaptive;
@@ -63,22 +64,20 @@ Segment * SegmentList::getMediaSegment(uint64_t number) const
         return segments.at(listindex);
     }
 
-    std::vector<Segment *>::const_iterator it = segments.begin();
-    for(it = segments.begin(); it != segments.end(); ++it)
-    {
-        Segment *seg = *it;
-        if(seg->getSequenceNumber() == number)
-        {
-            return seg;
-        }
-        else if (seg->getSequenceNumber() > number)
-        {
-            break;
-        }
-    }
+    std::vector<Segment *>::const_iterator it = findSegmentByNumber(number);
+    if(it != segments.end() && (*it)->getSequenceNumber() == number)
+        return *it;
     return nullptr;
 }
 
+std::vector<Segment *>::const_iterator SegmentList::findSegmentByNumber(uint64_t number) const
+{
+    /* segments are ordered by sequence number */
+    return std::lower_bound(segments.begin(), segments.end(), number,
+                            [](const Segment *seg, uint64_t n)
+                            { return seg->getSequenceNumber() < n; });
+}
+
 void SegmentList::addSegment(Segment *seg)
 {
     seg->setParent(AbstractSegmentBaseType::parent);
@@ -230,12 +229,13 @@ vlc_tick_t SegmentList::getMinAheadTime(uint64_t curnum) const
 
     vlc_tick_t minTime = 0;
     const Timescale timescale = inheritTimescale();
-    std::vector<Segment *>::const_iterator it;
-    for(it = segments.begin(); it != segments.end(); ++it)
+    std::vector<Segment *>::const_reverse_iterator it;
+    for(it = segments.rbegin(); it != segments.rend(); ++it)
     {
         const Segment *seg = *it;
-        if(seg->getSequenceNumber() > curnum)
-            minTime += timescale.ToTime(seg->duration.Get());
+        if(seg->getSequenceNumber() <= curnum)
+            break;
+        minTime += timescale.ToTime(seg->duration.Get());
     }
     return minTime;
 }
@@ -255,18 +255,14 @@ Segment *  SegmentList::getNextMediaSegment(uint64_t i_pos,uint64_t *pi_newpos,
         return segments.at(listindex);
     }
 
-    std::vector<Segment *>::const_iterator it;
-    for(it = segments.begin(); it != segments.end(); ++it)
-    {
-        Segment *seg = *it;
-        if(seg->getSequenceNumber() >= i_pos)
-        {
-            *pi_newpos = seg->getSequenceNumber();
-            *pb_gap = (*pi_newpos != i_pos);
-            return seg;
-        }
-    }
-    return nullptr;
+    std::vector<Segment *>::const_iterator it = findSegmentByNumber(i_pos);
+    if(it == segments.end())
+        return nullptr;
+
+    Segment *seg = *it;
+    *pi_newpos = seg->getSequenceNumber();
+    *pb_gap = (*pi_newpos != i_pos);
+    return seg;
 }
 
 uint64_t SegmentList::getStartSegmentNumber() const
@@ -60,6 +60,7 @@ namespace adaptive
                 virtual void debug(vlc_object_t *, int = 0) const override;
 
             private:
+                std::vector<Segment *>::const_iterator findSegmentByNumber(uint64_t) const;
                 std::vector<Segment *>  segments;
                 stime_t totalLength;
         };
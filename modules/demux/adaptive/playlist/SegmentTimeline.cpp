@@ -43,24 +43,68 @@ SegmentTimeline::SegmentTimeline(AbstractMultipleSegmentBaseType *parent_)
 
 SegmentTimeline::~SegmentTimeline()
 {
-    std::list<Element *>::iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        delete *it;
 }
 
 void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
 {
-    Element *element = new (std::nothrow) Element(number, d, r, t);
-    if(element)
+    Element element(number, d, r, t);
+    if(!elements.empty() && !t)
+        element.t = elements.back().end();
+    appendElement(element);
+}
+
+void SegmentTimeline::appendElement(Element &element)
+{
+    if(!elements.empty())
     {
-        if(!elements.empty() && !t)
+        Element &last = elements.back();
+        /* Long DVR windows are mostly made of identical durations, often
+           written as one <S> per segment. Fold them into the previous run. */
+        if(last.isFolded() && element.isFolded() &&
+           last.d == element.d &&
+           last.end() == element.t &&
+           last.number + last.r + 1 == element.number)
         {
-            const Element *el = elements.back();
-            element->t = el->t + (el->d * (el->r + 1));
+            last.r += element.r + 1;
+            last.entries += element.entries;
+            totalLength += (element.d * (element.r + 1));
+            return;
         }
-        elements.push_back(element);
-        totalLength += (d * (r + 1));
+        element.position = last.position + last.entries;
     }
+    elements.push_back(element);
+    totalLength += (element.d * (element.r + 1));
+}
+
+void SegmentTimeline::extendLastElement(uint64_t count)
+{
+    Element &last = elements.back();
+    if(last.entries > 1)
+    {
+        /* Only the last folded <S> entry gets repeated */
+        Element tail(last.number + last.r, last.d, 0, last.t + last.d * last.r);
+        tail.position = last.position + last.entries - 1;
+        last.r -= 1;
+        last.entries -= 1;
+        elements.push_back(tail);
+    }
+    elements.back().r += count;
+    totalLength += elements.back().d * count;
+}
+
+std::deque<SegmentTimeline::Element>::const_iterator
+SegmentTimeline::findElementByNumber(uint64_t number) const
+{
+    /* first element starting after number, the previous one might contain it */
+    auto it = std::upper_bound(elements.cbegin(), elements.cend(), number,
+                               [](uint64_t n, const Element &el)
+                               { return n < el.number; });
+    if(it == elements.cbegin())
+        return elements.cend();
+    --it;
+    if(number > it->number + it->r)
+        return elements.cend();
+    return it;
 }
 
 stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
@@ -72,16 +116,16 @@ stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
        maxElementNumber() < number)
         return 0;
 
-    std::list<Element *>::const_reverse_iterator it;
-    for(it = elements.rbegin(); it != elements.rend(); ++it)
+    std::deque<Element>::const_reverse_iterator it;
+    for(it = elements.crbegin(); it != elements.crend(); ++it)
     {
-        const Element *el = *it;
-        if(number > el->number + el->r)
+        const Element &el = *it;
+        if(number > el.number + el.r)
             break;
-        else if(number < el->number)
-            totalscaledtime += (el->d * (el->r + 1));
+        else if(number < el.number)
+            totalscaledtime += (el.d * (el.r + 1));
         else /* within repeat range */
-            totalscaledtime += el->d * (el->number + el->r - number);
+            totalscaledtime += el.d * (el.number + el.r - number);
     }
 
     return totalscaledtime;
@@ -89,53 +133,32 @@ stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
 
 uint64_t SegmentTimeline::getElementNumberByScaledPlaybackTime(stime_t scaled) const
 {
-    const Element *prevel = nullptr;
-    std::list<Element *>::const_iterator it;
-
     if(!elements.size())
         return 0;
 
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(scaled >= el->t)
-        {
-            if((uint64_t)scaled < el->t + (el->d * el->r))
-                return el->number + (scaled - el->t) / el->d;
-        }
-        /* might have been discontinuity */
-        else
-        {
-            if(prevel) /* > prev but < current */
-                return prevel->number + prevel->r;
-            else /* << first of the list */
-                return el->number;
-        }
-        prevel = el;
-    }
+    auto it = std::upper_bound(elements.cbegin(), elements.cend(), scaled,
+                               [](stime_t time, const Element &el)
+                               { return time < el.t; });
+    if(it == elements.cbegin()) /* << first of the list */
+        return it->number;
 
-    /* time is >> any of the list */
-    return prevel->number + prevel->r;
+    const Element &el = *(--it);
+    if(scaled < el.end())
+        return el.number + (scaled - el.t) / el.d;
+
+    /* might have been discontinuity, or time is >> any of the list */
+    return el.number + el.r;
 }
 
 bool SegmentTimeline::getScaledPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                                    stime_t *time, stime_t *duration) const
 {
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(number >= el->number)
-        {
-            if(number <= el->number + el->r)
-            {
-                *time = el->t + el->d * (number - el->number);
-                *duration = el->d;
-                return true;
-            }
-        }
-    }
-    return false;
+    auto it = findElementByNumber(number);
+    if(it == elements.cend())
+        return false;
+    *time = it->t + it->d * (number - it->number);
+    *duration = it->d;
+    return true;
 }
 
 stime_t SegmentTimeline::getScaledPlaybackTimeByElementNumber(uint64_t number) const
@@ -155,30 +178,31 @@ uint64_t SegmentTimeline::maxElementNumber() const
     if(elements.empty())
         return 0;
 
-    const Element *e = elements.back();
-    return e->number + e->r;
+    const Element &e = elements.back();
+    return e.number + e.r;
 }
 
 uint64_t SegmentTimeline::minElementNumber() const
 {
     if(elements.empty())
         return 0;
-    return elements.front()->number;
+    return elements.front().number;
 }
 
 uint64_t SegmentTimeline::getElementIndexBySequence(uint64_t number) const
 {
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(number >= el->number)
-        {
-            if(number <= el->number + el->r)
-                return std::distance(elements.begin(), it);
-        }
-    }
-    return std::numeric_limits<uint64_t>::max();
+    auto it = findElementByNumber(number);
+    if(it == elements.cend())
+        return std::numeric_limits<uint64_t>::max();
+    uint64_t position = it->position - elements.front().position;
+    if(it->isFolded())
+        position += number - it->number;
+    return position;
+}
+
+size_t SegmentTimeline::getElementsCount() const
+{
+    return elements.size();
 }
 
 void SegmentTimeline::pruneByPlaybackTime(vlc_tick_t time)
@@ -193,27 +217,31 @@ size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
     size_t prunednow = 0;
     while(elements.size())
     {
-        Element *el = elements.front();
-        if(el->number >= number)
+        Element &el = elements.front();
+        if(el.number >= number)
         {
             break;
         }
-        else if(el->number + el->r >= number)
+        else if(el.number + el.r >= number)
         {
-            uint64_t count = number - el->number;
-            el->number += count;
-            el->t += count * el->d;
-            el->r -= count;
+            uint64_t count = number - el.number;
+            if(el.isFolded())
+            {
+                el.position += count;
+                el.entries -= count;
+            }
+            el.number += count;
+            el.t += count * el.d;
+            el.r -= count;
             prunednow += count;
-            totalLength -= count * el->d;
+            totalLength -= count * el.d;
             break;
         }
         else
         {
-            prunednow += el->r + 1;
+            prunednow += el.r + 1;
+            totalLength -= (el.d * (el.r + 1));
             elements.pop_front();
-            totalLength -= (el->d * (el->r + 1));
-            delete el;
         }
     }
 
@@ -222,42 +250,47 @@ size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
 
 void SegmentTimeline::updateWith(SegmentTimeline &other)
 {
-    if(elements.empty())
+    auto it = other.elements.cbegin();
+    if(!elements.empty())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
-        return;
+        /* Refreshed timelines mostly repeat what we already have:
+           skip directly to the first element ending after our last one */
+        const stime_t lastend = elements.back().end();
+        it = std::upper_bound(other.elements.cbegin(), other.elements.cend(), lastend,
+                              [](stime_t time, const Element &el)
+                              { return time < el.end(); });
     }
 
-    Element *last = elements.back();
-    while(other.elements.size())
+    for(; it != other.elements.cend(); ++it)
     {
-        Element *el = other.elements.front();
-        other.elements.pop_front();
-
-        if(last->contains(el->t)) /* Same element, but prev could have been middle of repeat */
-        {
-            const uint64_t count = (el->t - last->t) / last->d;
-            totalLength -= (last->d * (last->r + 1));
-            last->r = std::max(last->r, el->r + count);
-            totalLength += (last->d * (last->r + 1));
-            delete el;
-        }
-        else if(el->t < last->t)
-        {
-            delete el;
-        }
-        else /* Did not exist in previous list */
+        Element el = *it;
+        if(!elements.empty())
         {
-            totalLength += (el->d * (el->r + 1));
-            elements.push_back(el);
-            el->number = last->number + last->r + 1;
-            last = el;
+            const Element &last = elements.back();
+            const stime_t lastend = last.end();
+            if(el.t < lastend) /* Same element, but prev could have been middle of repeat */
+            {
+                const uint64_t count = (lastend - el.t + el.d - 1) / el.d;
+                if(count > el.r)
+                    continue;
+                if(el.d == last.d && !el.isFolded())
+                {
+                    extendLastElement(el.r + 1 - count);
+                    continue;
+                }
+                if(el.isFolded())
+                    el.entries -= count;
+                el.t += count * el.d;
+                el.r -= count;
+            }
+            /* Did not exist in previous list */
+            el.number = last.number + last.r + 1;
         }
+        appendElement(el);
     }
+
+    other.elements.clear();
+    other.totalLength = 0;
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
@@ -266,9 +299,9 @@ void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
     ss << std::string(indent, ' ') << "Timeline";
     msg_Dbg(obj, "%s", ss.str().c_str());
 
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        (*it)->debug(obj, indent + 1);
+    std::deque<Element>::const_iterator it;
+    for(it = elements.cbegin(); it != elements.cend(); ++it)
+        it->debug(obj, indent + 1);
 }
 
 SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, stime_t t_)
@@ -277,13 +310,18 @@ SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, sti
     d = d_;
     t = t_;
     r = r_;
+    position = 0;
+    entries = 1;
+}
+
+stime_t SegmentTimeline::Element::end() const
+{
+    return t + (stime_t)(r + 1) * d;
 }
 
-bool SegmentTimeline::Element::contains(stime_t time) const
+bool SegmentTimeline::Element::isFolded() const
 {
-    if(time >= t && time < t + (stime_t)(r + 1) * d)
-        return true;
-    return false;
+    return entries == r + 1;
 }
 
 void SegmentTimeline::Element::debug(vlc_object_t *obj, int indent) const
@@ -26,7 +26,7 @@
 #include "Inheritables.hpp"
 
 #include <vlc_common.h>
-#include <list>
+#include <deque>
 
 namespace adaptive
 {
@@ -50,27 +50,39 @@ namespace adaptive
                 uint64_t maxElementNumber() const;
                 uint64_t minElementNumber() const;
                 uint64_t getElementIndexBySequence(uint64_t) const;
+                size_t getElementsCount() const;
                 void pruneByPlaybackTime(vlc_tick_t);
                 size_t pruneBySequenceNumber(uint64_t);
                 void updateWith(SegmentTimeline &);
                 void debug(vlc_object_t *, int = 0) const;
 
             private:
-                std::list<Element *> elements;
-                stime_t totalLength;
-                AbstractMultipleSegmentBaseType *parent;
-
+                /* Run length encoded <S> entries, stored by value and ordered
+                 * by both number and time, so lookups can bisect.
+                 * Consecutive single segment entries are folded into a single
+                 * run, still accounting the folded <S> for index lookups */
                 class Element
                 {
                     public:
                         Element(uint64_t, stime_t, uint64_t, stime_t);
                         void debug(vlc_object_t *, int = 0) const;
-                        bool contains(stime_t) const;
+                        stime_t end() const;
+                        bool isFolded() const;
                         stime_t  t;
                         stime_t  d;
                         uint64_t r;
                         uint64_t number;
+                        uint64_t position; /* of first <S> entry */
+                        uint64_t entries; /* <S> entries in that run */
                 };
+
+                void appendElement(Element &);
+                void extendLastElement(uint64_t);
+                std::deque<Element>::const_iterator findElementByNumber(uint64_t) const;
+
+                std::deque<Element> elements;
+                stime_t totalLength;
+                AbstractMultipleSegmentBaseType *parent;
         };
     }
 }
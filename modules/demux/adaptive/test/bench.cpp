@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * bench.cpp: SegmentTimeline build, lookup and refresh benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../playlist/SegmentTimeline.h"
+
+#include <cstdio>
+#include <malloc.h>
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+
+extern const char vlc_module_name[] = "foobar";
+
+/* DVR window of 2s segments @90kHz, as written by most packagers: one <S>
+ * per segment, with slightly varying durations every few segments */
+#define BENCH_TIMESCALE     90000
+#define BENCH_SEGMENT       (2 * BENCH_TIMESCALE)
+#define BENCH_REFRESHES     30
+
+static size_t HeapUsage()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+static stime_t SegmentDuration(uint64_t number)
+{
+    /* audio aligned segments drift, and get fixed up every 8 segments */
+    return (number % 8 == 7) ? BENCH_SEGMENT + 720 : BENCH_SEGMENT - 90;
+}
+
+/* Fills the timeline the way the MPD parser does, <S> by <S> */
+static SegmentTimeline * BuildTimeline(uint64_t first, uint64_t count)
+{
+    SegmentTimeline *timeline = new SegmentTimeline(nullptr);
+    stime_t t = 0;
+    for(uint64_t i = 0; i < first; i++)
+        t += SegmentDuration(i);
+    for(uint64_t i = first; i < first + count; i++)
+    {
+        timeline->addElement(i, SegmentDuration(i), 0, i == first ? t : 0);
+        t += SegmentDuration(i);
+    }
+    return timeline;
+}
+
+static void RunBench(unsigned hours)
+{
+    const uint64_t count = UINT64_C(3600) * hours * BENCH_TIMESCALE / BENCH_SEGMENT;
+
+    size_t heap = HeapUsage();
+    vlc_tick_t start = vlc_tick_now();
+    SegmentTimeline *timeline = BuildTimeline(0, count);
+    vlc_tick_t build = vlc_tick_now() - start;
+    heap = HeapUsage() - heap;
+
+    /* seek around the window */
+    start = vlc_tick_now();
+    const stime_t total = timeline->getTotalLength();
+    for(unsigned i = 0; i < 100000; i++)
+    {
+        stime_t time, duration;
+        uint64_t number = timeline->getElementNumberByScaledPlaybackTime(total / 100000 * i);
+        timeline->getScaledPlaybackTimeDurationBySegmentNumber(number, &time, &duration);
+    }
+    vlc_tick_t lookup = vlc_tick_now() - start;
+
+    /* live refreshes, sliding the window by one segment each time */
+    vlc_tick_t refresh = 0;
+    for(uint64_t i = 1; i <= BENCH_REFRESHES; i++)
+    {
+        SegmentTimeline *updated = BuildTimeline(i, count);
+        start = vlc_tick_now();
+        timeline->updateWith(*updated);
+        timeline->pruneBySequenceNumber(i);
+        refresh += vlc_tick_now() - start;
+        delete updated;
+    }
+
+    printf("%3uh %7" PRIu64 " segments: %5zu runs, %8zu bytes, "
+           "build %7.3f ms, 100k lookups %7.3f ms, refresh %7.3f ms\n",
+           hours, count, timeline->getElementsCount(), heap,
+           secf_from_vlc_tick(build) * 1000,
+           secf_from_vlc_tick(lookup) * 1000,
+           secf_from_vlc_tick(refresh) * 1000 / BENCH_REFRESHES);
+
+    delete timeline;
+}
+
+int main()
+{
+    static const unsigned hours[] = { 1, 6, 24, 72 };
+    for(size_t i = 0; i < ARRAY_SIZE(hours); i++)
+        RunBench(hours[i]);
+    return 0;
+}
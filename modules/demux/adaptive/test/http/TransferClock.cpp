@@ -0,0 +1,67 @@
+/*****************************************************************************
+ *
+ *****************************************************************************
+ * Copyright (C) 2020 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../http/Downloader.hpp"
+
+#include "../test.hpp"
+
+using namespace adaptive::http;
+
+int TransferClock_test()
+{
+    TransferClock clock;
+    const vlc_tick_t base = VLC_TICK_FROM_SEC(100);
+
+    /* single transfer runs at wall clock speed */
+    Expect(clock.getTime(base) == 0);
+    clock.transferStarted(base);
+    Expect(clock.getTime(base + VLC_TICK_FROM_MS(400)) == VLC_TICK_FROM_MS(400));
+
+    /* two overlapping transfers share the link */
+    clock.transferStarted(base + VLC_TICK_FROM_MS(400));
+    vlc_tick_t start = clock.getTime(base + VLC_TICK_FROM_MS(400));
+    Expect(clock.getTime(base + VLC_TICK_FROM_MS(800)) - start == VLC_TICK_FROM_MS(200));
+    clock.transferEnded(base + VLC_TICK_FROM_MS(1000));
+    Expect(clock.getTime(base + VLC_TICK_FROM_MS(1000)) - start == VLC_TICK_FROM_MS(300));
+
+    /* back to a single transfer */
+    Expect(clock.getTime(base + VLC_TICK_FROM_MS(1100)) - start == VLC_TICK_FROM_MS(400));
+    clock.transferEnded(base + VLC_TICK_FROM_MS(1100));
+
+    /* sum of the shared durations is the busy link time */
+    vlc_tick_t t0 = clock.getTime(base + VLC_TICK_FROM_SEC(2));
+    clock.transferStarted(base + VLC_TICK_FROM_SEC(2));
+    clock.transferStarted(base + VLC_TICK_FROM_SEC(2));
+    clock.transferStarted(base + VLC_TICK_FROM_SEC(2));
+    vlc_tick_t t1 = clock.getTime(base + VLC_TICK_FROM_SEC(5));
+    Expect(3 * (t1 - t0) == VLC_TICK_FROM_SEC(3));
+    clock.transferEnded(base + VLC_TICK_FROM_SEC(5));
+    clock.transferEnded(base + VLC_TICK_FROM_SEC(5));
+    clock.transferEnded(base + VLC_TICK_FROM_SEC(5));
+
+    /* does not go backward */
+    vlc_tick_t t2 = clock.getTime(base + VLC_TICK_FROM_SEC(6));
+    Expect(clock.getTime(base + VLC_TICK_FROM_SEC(4)) == t2);
+
+    return 0;
+}
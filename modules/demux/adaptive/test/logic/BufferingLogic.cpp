@@ -144,7 +144,20 @@ int BufferingLogic_test()
         Expect(bufferinglogic.getMinBuffering(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
         Expect(bufferinglogic.getLiveDelay(playlist) >= DefaultBufferingLogic::BUFFERING_LOWEST_LIMIT);
 
+        /* catching up with live edge */
+        Expect(bufferinglogic.getCatchUpThreshold(playlist) > bufferinglogic.getLiveDelay(playlist));
+        playlist->suggestedPresentationDelay.Set(VLC_TICK_FROM_SEC(5));
+        Expect(bufferinglogic.getLiveDelay(playlist) == VLC_TICK_FROM_SEC(5));
+        Expect(bufferinglogic.getCatchUpThreshold(playlist) > VLC_TICK_FROM_SEC(5));
+        playlist->targetLatency.Set(VLC_TICK_FROM_SEC(3));
+        Expect(bufferinglogic.getLiveDelay(playlist) == VLC_TICK_FROM_SEC(3));
+
         playlist->b_lowlatency = false;
+        /* target latency is only for low latency playback */
+        Expect(bufferinglogic.getLiveDelay(playlist) >= VLC_TICK_FROM_SEC(5));
+        playlist->targetLatency.Set(0);
+        playlist->suggestedPresentationDelay.Set(0);
+        Expect(bufferinglogic.getCatchUpThreshold(playlist) == 0);
         Expect(bufferinglogic.getStartSegmentNumber(rep) == number);
 
         while(segmentList->getTotalLength() <
@@ -382,6 +382,112 @@ int M3U8Playlist_test()
         return 1;
     }
 
+    /* Manifest 5, low latency */
+    const char manifest5[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-VERSION:9\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4.0\n"
+    "seg10.mp4\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.0.mp4\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.1.mp4\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.2.mp4\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.3.mp4\"\n"
+    "#EXTINF:4.0\n"
+    "seg11.mp4\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg12.0.mp4\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg12.1.mp4\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg12.2.mp4\"\n";
+
+    const char manifest5update[] =
+    "#EXTM3U\n"
+    "#EXT-X-TARGETDURATION:4\n"
+    "#EXT-X-VERSION:9\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n"
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:11\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.0.mp4\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.1.mp4\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.2.mp4\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg11.3.mp4\"\n"
+    "#EXTINF:4.0\n"
+    "seg11.mp4\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg12.0.mp4\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg12.1.mp4\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"seg12.2.mp4\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg12.3.mp4\"\n";
+
+    m3u = ParseM3U8(obj, manifest5, sizeof(manifest5));
+    try
+    {
+        Expect(m3u);
+        Expect(m3u->isLive());
+        Expect(m3u->isLowLatency());
+        Expect(m3u->suggestedPresentationDelay.Get() == vlc_tick_from_sec(3));
+        HLSRepresentation *rep = static_cast<HLSRepresentation *>
+                (m3u->getFirstPeriod()->getAdaptationSets().front()->getRepresentations().front());
+        Timescale timescale = rep->inheritTimescale();
+        Expect(timescale.isValid());
+
+        /* whole segment, then one unit per part, then the hint */
+        const std::vector<Segment *> &list = rep->inheritSegmentList()->getSegments();
+        Expect(list.size() == 8);
+        Expect(list.front()->getSequenceNumber() == 10);
+        Expect(static_cast<HLSSegment *>(list.front())->getPartIndex() == -1);
+        HLSSegment *part = static_cast<HLSSegment *>(rep->getMediaSegment(13));
+        Expect(part);
+        Expect(part->getMediaSequence() == 11);
+        Expect(part->getPartIndex() == 2);
+        Expect(part->independent);
+        Expect(part->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(6)));
+        Expect(!rep->getMediaSegment(14)->independent);
+        part = static_cast<HLSSegment *>(rep->getMediaSegment(17));
+        Expect(part);
+        Expect(part->getMediaSequence() == 12);
+        Expect(part->getPartIndex() == 2);
+        Expect(part->startTime.Get() == timescale.ToScaled(vlc_tick_from_sec(10)));
+        Expect(part->duration.Get() == timescale.ToScaled(vlc_tick_from_sec(1)));
+
+        /* blocking reload for the hinted part */
+        const std::string reloadurl = rep->getPlaylistReloadUrl();
+        Expect(reloadurl.find("?_HLS_msn=12&_HLS_part=2") != std::string::npos);
+
+        /* numbering is kept across reloads */
+        M3U8Parser parser(nullptr);
+        stream_t *substream = vlc_stream_MemoryNew(obj, ((uint8_t *)manifest5update),
+                                                   sizeof(manifest5update), true);
+        Expect(substream);
+        parser.appendSegmentsFromPlaylist(obj, rep, substream);
+        vlc_stream_Delete(substream);
+
+        Expect(rep->getMediaSegment(10) == nullptr);
+        part = static_cast<HLSSegment *>(rep->getMediaSegment(11));
+        Expect(part);
+        Expect(part->getMediaSequence() == 11);
+        Expect(part->getPartIndex() == 0);
+        part = static_cast<HLSSegment *>(rep->getMediaSegment(18));
+        Expect(part);
+        Expect(part->getMediaSequence() == 12);
+        Expect(part->getPartIndex() == 3);
+        uint64_t number;
+        bool discont;
+        Segment *seg = rep->getNextMediaSegment(16, &number, &discont);
+        Expect(seg);
+        Expect(number == 16);
+        Expect(!discont);
+        Expect(rep->getPlaylistReloadUrl().find("?_HLS_msn=12&_HLS_part=3") != std::string::npos);
+
+        delete m3u;
+    }
+    catch (...)
+    {
+        delete m3u;
+        return 1;
+    }
+
 
     return 0;
 }
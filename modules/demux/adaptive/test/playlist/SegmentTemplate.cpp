@@ -96,6 +96,18 @@ int SegmentTemplate_test()
         Expect(templ->getLiveTemplateNumber(now + timescale.ToTime(100) * 2 + 1, true) ==
                templ->getStartSegmentNumber() + 1);
 
+        /* low latency, segment available before its end */
+        rep->replaceAttribute(new DurationAttr(6000));
+        now = vlc_tick_from_sec(::time(nullptr));
+        pl->availabilityStartTime.Set(now - timescale.ToTime(6000) * 10 - timescale.ToTime(3000));
+        pl->availabilityEndTime.Set(0);
+        const vlc_tick_t ahead = templ->getMinAheadTime(11);
+        Expect(ahead > 0);
+        rep->addAttribute(new AvailabilityTimeOffsetAttr(timescale.ToTime(6000)));
+        Expect(templ->getMinAheadTime(11) == ahead + timescale.ToTime(6000));
+        rep->replaceAttribute(new AvailabilityTimeOffsetAttr(0));
+        rep->replaceAttribute(new DurationAttr(100));
+
         /* reset */
         pl->availabilityStartTime.Set(0);
         pl->availabilityEndTime.Set(0);
@@ -173,6 +173,60 @@ int Timeline_test()
 
         delete timeline;
         delete timeline2;
+        timeline2 = nullptr;
+
+        /* Folding of single segment entries */
+        timeline = new SegmentTimeline(nullptr);
+        timeline->addElement(100, 10, 0, START);
+        for(uint64_t i=1; i<1000; i++)
+            timeline->addElement(100 + i, 10, 0, 0);
+        Expect(timeline->getElementsCount() == 1);
+        Expect(timeline->minElementNumber() == 100);
+        Expect(timeline->maxElementNumber() == 100 + 999);
+        Expect(timeline->getTotalLength() == 10 * 1000);
+        Expect(timeline->getElementIndexBySequence(100 + 500) == 500);
+        Expect(timeline->getScaledPlaybackTimeByElementNumber(100 + 500) == START + 10 * 500);
+        Expect(timeline->getElementNumberByScaledPlaybackTime(START + 10 * 500 + 5) == 100 + 500);
+        Expect(timeline->getMinAheadScaledTime(100 + 990) == 10 * 9);
+        timeline->addElement(1100, 20, 0, 0); /* different duration */
+        timeline->addElement(1101, 20, 2, 0); /* repeated entry */
+        timeline->addElement(1104, 20, 0, 0);
+        Expect(timeline->getElementsCount() == 4);
+        Expect(timeline->getElementIndexBySequence(1100) == 1000);
+        Expect(timeline->getElementIndexBySequence(1103) == 1001);
+        Expect(timeline->getElementIndexBySequence(1104) == 1002);
+        timeline->addElement(1105, 20, 0, START + 20000); /* discontinuity */
+        Expect(timeline->getElementsCount() == 5);
+        Expect(timeline->getElementNumberByScaledPlaybackTime(START + 19990) == 1104);
+        Expect(timeline->getElementNumberByScaledPlaybackTime(START + 20010) == 1105);
+
+        Expect(timeline->pruneBySequenceNumber(100 + 400) == 400);
+        Expect(timeline->getElementsCount() == 5);
+        Expect(timeline->getElementIndexBySequence(100 + 500) == 100);
+        Expect(timeline->getTotalLength() == 10 * 600 + 20 * 6);
+
+        /* Refresh with a sliding window of single segment entries */
+        timeline2 = new SegmentTimeline(nullptr);
+        timeline2->addElement(100 + 600, 10, 0, START + 10 * 600);
+        for(uint64_t i=601; i<1000; i++)
+            timeline2->addElement(100 + i, 10, 0, 0);
+        timeline2->addElement(1100, 20, 0, 0);
+        timeline2->addElement(1101, 20, 2, 0);
+        timeline2->addElement(1104, 20, 0, 0);
+        timeline2->addElement(1105, 20, 0, START + 20000);
+        for(uint64_t i=1106; i<1200; i++)
+            timeline2->addElement(i, 20, 0, 0);
+        Expect(timeline2->getElementsCount() == 5);
+        timeline->updateWith(*timeline2);
+        Expect(timeline->getElementsCount() == 5);
+        Expect(timeline->minElementNumber() == 100 + 400);
+        Expect(timeline->maxElementNumber() == 1199);
+        Expect(timeline->getTotalLength() == 10 * 600 + 20 * 100);
+        Expect(timeline->getElementIndexBySequence(1150) == 600 + 3 + 45);
+        Expect(timeline->getScaledPlaybackTimeByElementNumber(1150) == START + 20000 + 20 * 45);
+
+        delete timeline;
+        delete timeline2;
 
     } catch (...) {
         delete timeline;
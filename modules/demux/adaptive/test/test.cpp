@@ -46,6 +46,7 @@ int main()
     TEST(TemplatedUri) ||
     TEST(BufferingLogic) ||
     TEST(CommandsQueue) ||
+    TEST(TransferClock) ||
     TEST(M3U8MasterPlaylist) ||
     TEST(M3U8Playlist);
 }
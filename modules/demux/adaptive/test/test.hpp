@@ -47,5 +47,6 @@ int M3U8MasterPlaylist_test();
 int M3U8Playlist_test();
 int CommandsQueue_test();
 int BufferingLogic_test();
+int TransferClock_test();
 
 #endif
@@ -33,6 +33,7 @@
 #include "../../adaptive/playlist/SegmentList.h"
 
 #include <ctime>
+#include <sstream>
 #include <limits>
 #include <cassert>
 
@@ -47,6 +48,11 @@ HLSRepresentation::HLSRepresentation  ( BaseAdaptationSet *set ) :
     b_failed = false;
     lastUpdateTime = 0;
     targetDuration = 0;
+    b_lowLatency = false;
+    b_canBlockReload = false;
+    partTarget = 0;
+    reloadMediaSequence = 0;
+    reloadPart = -1;
     streamFormat = StreamFormat::Type::Unknown;
 }
 
@@ -64,6 +70,11 @@ bool HLSRepresentation::isLive() const
     return b_live;
 }
 
+bool HLSRepresentation::isLowLatency() const
+{
+    return b_lowLatency;
+}
+
 bool HLSRepresentation::initialized() const
 {
     return b_loaded;
@@ -89,6 +100,21 @@ Url HLSRepresentation::getPlaylistUrl() const
     }
 }
 
+std::string HLSRepresentation::getPlaylistReloadUrl() const
+{
+    std::string url = getPlaylistUrl().toString();
+    if(!b_lowLatency || !b_canBlockReload || reloadPart < 0)
+        return url;
+
+    /* Blocking reload: the server holds the response until the
+     * playlist contains the requested part */
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url << (url.find('?') == std::string::npos ? '?' : '&')
+       << "_HLS_msn=" << reloadMediaSequence << "&_HLS_part=" << reloadPart;
+    return ss.str();
+}
+
 void HLSRepresentation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -135,10 +161,18 @@ bool HLSRepresentation::needsUpdate(uint64_t number) const
     {
         const vlc_tick_t now = vlc_tick_now();
         const vlc_tick_t elapsed = now - lastUpdateTime;
-        const vlc_tick_t duration = targetDuration
-                                  ? vlc_tick_from_sec(targetDuration)
-                                  : VLC_TICK_FROM_SEC(2);
-        if(elapsed < duration)
+        vlc_tick_t duration = targetDuration
+                            ? vlc_tick_from_sec(targetDuration)
+                            : VLC_TICK_FROM_SEC(2);
+        vlc_tick_t interval = duration;
+        if(b_lowLatency && partTarget)
+        {
+            /* Reload as parts get published. A blocking reload returns
+             * only once the next part is available. */
+            duration = partTarget;
+            interval = b_canBlockReload ? partTarget / 4 : partTarget;
+        }
+        if(elapsed < interval)
             return false;
 
         if(number != std::numeric_limits<uint64_t>::max())
@@ -45,7 +45,9 @@ namespace hls
 
                 void setPlaylistUrl(const std::string &);
                 Url getPlaylistUrl() const;
+                std::string getPlaylistReloadUrl() const;
                 bool isLive() const;
+                bool isLowLatency() const;
                 bool initialized() const;
                 virtual void scheduleNextUpdate(uint64_t, bool) override;
                 virtual bool needsUpdate(uint64_t) const override;
@@ -62,6 +64,12 @@ namespace hls
                 vlc_tick_t lastUpdateTime;
                 time_t targetDuration;
                 Url playlistUrl;
+                /* Low latency, with partial segments */
+                bool b_lowLatency;
+                bool b_canBlockReload;
+                vlc_tick_t partTarget;
+                uint64_t reloadMediaSequence; /* next part to wait for */
+                int reloadPart;
         };
     }
 }
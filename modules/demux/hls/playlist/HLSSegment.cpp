@@ -27,11 +27,13 @@
 
 using namespace hls::playlist;
 
-HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq ) :
+HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq, int part ) :
     Segment( parent )
 {
     setSequenceNumber(seq);
     utcTime = 0;
+    mediaSequence = seq;
+    partIndex = part;
 }
 
 HLSSegment::~HLSSegment()
@@ -44,7 +46,7 @@ bool HLSSegment::prepareChunk(SharedResources *res, SegmentChunk *chunk, BaseRep
     {
         if (encryption.iv.size() != 16)
         {
-            uint64_t sequence = getSequenceNumber();
+            uint64_t sequence = mediaSequence;
             encryption.iv.clear();
             encryption.iv.resize(16);
             encryption.iv[15] = (sequence >> 0) & 0xff;
@@ -62,6 +64,22 @@ vlc_tick_t HLSSegment::getUTCTime() const
     return utcTime;
 }
 
+uint64_t HLSSegment::getMediaSequence() const
+{
+    return mediaSequence;
+}
+
+int HLSSegment::getPartIndex() const
+{
+    return partIndex;
+}
+
+bool HLSSegment::isSameUnit(const HLSSegment *other) const
+{
+    return mediaSequence == other->mediaSequence &&
+           partIndex == other->partIndex;
+}
+
 int HLSSegment::compare(ISegment *segment) const
 {
     HLSSegment *hlssegment = dynamic_cast<HLSSegment *>(segment);
@@ -36,13 +36,18 @@ namespace hls
             friend class M3U8Parser;
 
             public:
-                HLSSegment( ICanonicalUrl *parent, uint64_t sequence );
+                HLSSegment( ICanonicalUrl *parent, uint64_t sequence, int part = -1 );
                 virtual ~HLSSegment();
                 vlc_tick_t getUTCTime() const;
                 virtual int compare(ISegment *) const override;
+                uint64_t getMediaSequence() const;
+                int getPartIndex() const;
+                bool isSameUnit(const HLSSegment *) const;
 
             protected:
                 vlc_tick_t utcTime;
+                uint64_t mediaSequence;
+                int partIndex; /* -1 for a whole segment */
                 virtual bool prepareChunk(SharedResources *, SegmentChunk *,
                                           BaseRepresentation *) override;
         };
@@ -67,3 +67,22 @@ bool M3U8::isLive() const
     return b_live;
 }
 
+bool M3U8::isLowLatency() const
+{
+    if(!isLive())
+        return false;
+
+    for(const BasePeriod *period : periods)
+    {
+        for(const BaseAdaptationSet *adaptSet : period->getAdaptationSets())
+        {
+            for(const BaseRepresentation *r : adaptSet->getRepresentations())
+            {
+                const HLSRepresentation *rep = dynamic_cast<const HLSRepresentation *>(r);
+                if(rep && rep->initialized() && rep->isLowLatency())
+                    return true;
+            }
+        }
+    }
+    return false;
+}
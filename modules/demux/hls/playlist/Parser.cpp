@@ -162,18 +162,14 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresentation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(resources, ChunkType::Playlist, rep->getPlaylistReloadUrl());
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
         if(substream)
         {
-            std::list<Tag *> tagslist = parseEntries(substream);
+            appendSegmentsFromPlaylist(p_obj, rep, substream);
             vlc_stream_Delete(substream);
-
-            parseSegments(p_obj, rep, tagslist);
-
-            releaseTagsList(tagslist);
         }
         block_Release(p_block);
         return true;
@@ -181,6 +177,14 @@ bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, HLSRepresent
     return false;
 }
 
+void M3U8Parser::appendSegmentsFromPlaylist(vlc_object_t *p_obj, HLSRepresentation *rep,
+                                            stream_t *stream)
+{
+    std::list<Tag *> tagslist = parseEntries(stream);
+    parseSegments(p_obj, rep, tagslist);
+    releaseTagsList(tagslist);
+}
+
 static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
                             CommonEncryption &encryption)
 {
@@ -216,6 +220,110 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
+static HLSSegment * createPartSegment(HLSRepresentation *rep, const AttributesTag *tag,
+                                      uint64_t mediaSequence, int partIndex,
+                                      std::size_t *prevrangeend)
+{
+    const Attribute *uriAttr = tag->getAttributeByName("URI");
+    if(!uriAttr)
+        return nullptr;
+
+    HLSSegment *part = new (std::nothrow) HLSSegment(rep, mediaSequence, partIndex);
+    if(!part)
+        return nullptr;
+
+    part->setSourceUrl(uriAttr->quotedString());
+
+    if(tag->getType() == AttributesTag::EXTXPART)
+    {
+        const Attribute *byterangeAttr = tag->getAttributeByName("BYTERANGE");
+        if(byterangeAttr)
+        {
+            std::pair<std::size_t,std::size_t> range = byterangeAttr->unescapeQuotes().getByteRange();
+            if(range.first == 0) /* first = offset, second = length */
+                range.first = *prevrangeend;
+            *prevrangeend = range.first + range.second;
+            part->setByteRange(range.first, *prevrangeend - 1);
+        }
+        const Attribute *independentAttr = tag->getAttributeByName("INDEPENDENT");
+        part->independent = (partIndex == 0) ||
+                            (independentAttr && independentAttr->value == "YES");
+    }
+    else /* preload hint, possibly open ended */
+    {
+        const Attribute *startAttr = tag->getAttributeByName("BYTERANGE-START");
+        const Attribute *lengthAttr = tag->getAttributeByName("BYTERANGE-LENGTH");
+        if(startAttr || lengthAttr)
+        {
+            std::size_t start = startAttr ? startAttr->decimal() : 0;
+            std::size_t end = lengthAttr ? start + lengthAttr->decimal() - 1 : 0;
+            part->setByteRange(start, end);
+        }
+        part->independent = (partIndex == 0);
+    }
+
+    return part;
+}
+
+/* Units are whole segments, or parts near the live edge. Their numbers must
+ * stay the same across reloads, and follow each other without holes, as
+ * any gap in numbering is a discontinuity to the tracker. */
+static void numberSegments(const SegmentList *previous,
+                           const std::list<HLSSegment *> &units)
+{
+    bool b_parts = std::any_of(units.cbegin(), units.cend(),
+                               [](const HLSSegment *s){ return s->getPartIndex() >= 0; });
+    const std::vector<Segment *> *prevsegs = previous ? &previous->getSegments() : nullptr;
+    if(prevsegs && !b_parts)
+    {
+        b_parts = std::any_of(prevsegs->cbegin(), prevsegs->cend(), [](const Segment *s){
+            const HLSSegment *hlsseg = dynamic_cast<const HLSSegment *>(s);
+            return hlsseg && hlsseg->getPartIndex() >= 0;
+        });
+    }
+    /* Regular playlists are numbered by media sequence */
+    if(!b_parts || units.empty())
+        return;
+
+    uint64_t first = units.front()->getMediaSequence();
+    if(prevsegs && !prevsegs->empty())
+    {
+        const HLSSegment *last = dynamic_cast<const HLSSegment *>(prevsegs->back());
+        bool b_anchored = false;
+        uint64_t index = 0;
+        for(auto it = units.cbegin(); it != units.cend() && !b_anchored; ++it, ++index)
+        {
+            for(const Segment *s : *prevsegs)
+            {
+                const HLSSegment *prev = dynamic_cast<const HLSSegment *>(s);
+                if(prev && prev->isSameUnit(*it))
+                {
+                    first = prev->getSequenceNumber() - index;
+                    b_anchored = true;
+                    break;
+                }
+            }
+        }
+        if(!b_anchored && last)
+        {
+            /* No overlap: continue after the last known unit */
+            index = 0;
+            for(auto it = units.cbegin(); it != units.cend(); ++it, ++index)
+            {
+                if((*it)->getMediaSequence() > last->getMediaSequence() ||
+                   ((*it)->getMediaSequence() == last->getMediaSequence() &&
+                    (*it)->getPartIndex() > last->getPartIndex()))
+                    break;
+            }
+            first = last->getSequenceNumber() + 1 - index;
+        }
+    }
+
+    uint64_t number = first;
+    for(HLSSegment *unit : units)
+        unit->setSequenceNumber(number++);
+}
+
 void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std::list<Tag *> &tagslist)
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
@@ -233,8 +341,31 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
     const SingleValueTag *ctx_byterange = nullptr;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = nullptr;
+    const AttributesTag *ctx_preloadhint = nullptr;
+    vlc_tick_t partHoldBack = 0;
 
     std::list<HLSSegment *> segmentstoappend;
+    std::list<HLSSegment *> partstoappend; /* parts of the current segment */
+    std::size_t prevpartrangeend = 0;
+    int partIndex = 0;
+
+    auto appendParts = [&](stime_t start, vlc_tick_t displaytime, bool discont)
+    {
+        for(HLSSegment *part : partstoappend)
+        {
+            part->startTime.Set(start);
+            start += part->duration.Get();
+            if(displaytime != VLC_TICK_INVALID)
+            {
+                part->setDisplayTime(displaytime);
+                displaytime += timescale.ToTime(part->duration.Get());
+            }
+            part->discontinuity = discont;
+            discont = false;
+            segmentstoappend.push_back(part);
+        }
+        partstoappend.clear();
+    };
 
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
@@ -310,6 +441,70 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
 
                 if(encryption.method != CommonEncryption::Method::None)
                     segment->setEncryption(encryption);
+
+                /* Near the live edge, the segment is also listed as parts,
+                 * which keep the same numbering as when it was in progress.
+                 * Parts of encrypted segments can't be decrypted alone. */
+                if(!partstoappend.empty() &&
+                   encryption.method == CommonEncryption::Method::None)
+                {
+                    segmentstoappend.pop_back();
+                    appendParts(segment->startTime.Get(), segment->getDisplayTime(),
+                                segment->discontinuity);
+                    delete segment;
+                }
+                vlc_delete_all(partstoappend);
+                partIndex = 0;
+                prevpartrangeend = 0;
+            }
+            break;
+
+            case AttributesTag::EXTXPART:
+            {
+                const AttributesTag *parttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *durAttribute = parttag->getAttributeByName("DURATION");
+                const Attribute *gapAttribute = parttag->getAttributeByName("GAP");
+                if(durAttribute && !(gapAttribute && gapAttribute->value == "YES"))
+                {
+                    HLSSegment *part = createPartSegment(rep, parttag, sequenceNumber,
+                                                         partIndex, &prevpartrangeend);
+                    if(part)
+                    {
+                        part->duration.Set(timescale.ToScaled(
+                                    vlc_tick_from_sec(durAttribute->floatingPoint())));
+                        partstoappend.push_back(part);
+                    }
+                }
+                partIndex++;
+            }
+            break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+            {
+                const AttributesTag *hinttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *typeAttribute = hinttag->getAttributeByName("TYPE");
+                if(typeAttribute && typeAttribute->value == "PART")
+                    ctx_preloadhint = hinttag;
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *targetAttribute = static_cast<const AttributesTag *>(tag)->
+                                                   getAttributeByName("PART-TARGET");
+                if(targetAttribute)
+                    rep->partTarget = vlc_tick_from_sec(targetAttribute->floatingPoint());
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *controltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *blockAttribute = controltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_canBlockReload = blockAttribute && blockAttribute->value == "YES";
+                const Attribute *holdbackAttribute = controltag->getAttributeByName("PART-HOLD-BACK");
+                if(holdbackAttribute)
+                    partHoldBack = vlc_tick_from_sec(holdbackAttribute->floatingPoint());
             }
             break;
 
@@ -383,6 +578,40 @@ void M3U8Parser::parseSegments(vlc_object_t *, HLSRepresentation *rep, const std
         }
     }
 
+    /* Parts of the segment in progress, then the next part to be published,
+     * which the server delivers as soon as it is available */
+    if(encryption.method == CommonEncryption::Method::None &&
+       (!partstoappend.empty() || (ctx_preloadhint && rep->partTarget)))
+    {
+        if(ctx_preloadhint && rep->partTarget)
+        {
+            HLSSegment *hint = createPartSegment(rep, ctx_preloadhint, sequenceNumber,
+                                                 partIndex, &prevpartrangeend);
+            if(hint)
+            {
+                hint->duration.Set(timescale.ToScaled(rep->partTarget));
+                partstoappend.push_back(hint);
+            }
+        }
+        appendParts(timescale.ToScaled(nzStartTime), absReferenceTime, discontinuity);
+    }
+    vlc_delete_all(partstoappend);
+
+    rep->b_lowLatency = std::any_of(segmentstoappend.cbegin(), segmentstoappend.cend(),
+                                    [](const HLSSegment *s){ return s->getPartIndex() >= 0; });
+    if(rep->b_lowLatency)
+    {
+        /* Numbering is per rendition */
+        rep->b_consistent = false;
+        rep->reloadMediaSequence = sequenceNumber;
+        rep->reloadPart = partIndex;
+        if(partHoldBack)
+            rep->getPlaylist()->suggestedPresentationDelay.Set(partHoldBack);
+    }
+    else rep->reloadPart = -1;
+
+    numberSegments(rep->inheritSegmentList(), segmentstoappend);
+
     for(HLSSegment *seg : segmentstoappend)
         segmentList->addSegment(seg);
     segmentstoappend.clear();
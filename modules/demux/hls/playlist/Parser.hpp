@@ -60,6 +60,7 @@ namespace hls
 
                 M3U8 *             parse  (vlc_object_t *p_obj, stream_t *p_stream, const std::string &);
                 bool appendSegmentsFromPlaylistURI(vlc_object_t *, HLSRepresentation *);
+                void appendSegmentsFromPlaylist(vlc_object_t *, HLSRepresentation *, stream_t *);
 
             private:
                 HLSRepresentation * createRepresentation(BaseAdaptationSet *, const AttributesTag *);
@@ -22,6 +22,7 @@
  *****************************************************************************/
 
 #include "matroska_segment.hpp"
+#include "matroska_segment_indexer.hpp"
 #include "chapters.hpp"
 #include "demux.hpp"
 #include "util.hpp"
@@ -68,6 +69,8 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
 
 matroska_segment_c::~matroska_segment_c()
 {
+    _indexer.reset();
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -792,6 +795,31 @@ bool matroska_segment_c::LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int
     return true;
 }
 
+/* Without usable Cues, the seek index is built by walking the clusters in
+ * the background and/or loaded from a previous playback */
+void matroska_segment_c::StartIndexing()
+{
+    if( _indexer )
+        return;
+
+    bool b_background = sys.b_fastseekable &&
+                        var_InheritBool( &sys.demuxer, "mkv-background-index" );
+    bool b_cache = sys.b_seekable &&
+                   var_InheritBool( &sys.demuxer, "mkv-index-cache" );
+    if( !b_background && !b_cache )
+        return;
+
+    _indexer.reset( new (std::nothrow) SegmentIndexer( *this ) );
+    if( _indexer && !_indexer->Start( b_background, b_cache ) )
+        _indexer.reset();
+}
+
+void matroska_segment_c::MergeIndex()
+{
+    if( _indexer )
+        _indexer->Merge();
+}
+
 bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date, vlc_tick_t i_mk_time_offset, bool b_accurate )
 {
     SegmentSeeker::tracks_seekpoint_t seekpoints;
@@ -838,6 +866,8 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
 
     // find appropriate seekpoints //
 
+    MergeIndex();
+
     try {
         seekpoints = _seeker.get_seekpoints( *this, i_mk_date, priority, selected_tracks );
     }
@@ -889,6 +919,11 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
 
     _seeker.mkv_jump_to( *this, i_seek_position );
 
+    /* the Cues pointed to no Cluster, and the next one was used instead */
+    if( b_cues && _indexer &&
+        ( cluster == NULL || cluster->GetElementPosition() > i_seek_position ) )
+        _indexer->CuesMissed();
+
     // debug diagnostics //
 
     msg_Dbg( &sys.demuxer, "seek: preroll{ req: %" PRId64 ", start-pts: %" PRId64 ", start-fpos: %" PRIu64 "} ",
@@ -45,6 +45,7 @@ class chapter_translation_c;
 class chapter_item_c;
 
 class mkv_track_t;
+class SegmentIndexer;
 
 typedef enum
 {
@@ -146,6 +147,9 @@ public:
 
     bool Seek( demux_t &, vlc_tick_t i_mk_date, vlc_tick_t i_mk_time_offset, bool b_accurate );
 
+    void StartIndexing();
+    void MergeIndex();
+
     int BlockGet( KaxBlock * &, KaxSimpleBlock * &, KaxBlockAdditions * &,
                   bool *, bool *, int64_t *);
 
@@ -176,8 +180,10 @@ private:
     void EnsureDuration();
 
     SegmentSeeker _seeker;
+    std::unique_ptr<SegmentIndexer> _indexer;
 
     friend SegmentSeeker;
+    friend SegmentIndexer;
 };
 
 } // namespace
@@ -0,0 +1,703 @@
+/*****************************************************************************
+ * matroska_segment_indexer.cpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "matroska_segment_indexer.hpp"
+#include "matroska_segment.hpp"
+#include "demux.hpp"
+
+namespace {
+    /* EBML IDs, with their length marker */
+    enum {
+        MKV_ID_CLUSTER        = 0x1F43B675,
+        MKV_ID_TIMECODE       = 0xE7,
+        MKV_ID_SIMPLEBLOCK    = 0xA3,
+        MKV_ID_BLOCKGROUP     = 0xA0,
+        MKV_ID_BLOCK          = 0xA1,
+        MKV_ID_REFERENCEBLOCK = 0xFB,
+    };
+
+    const uint64_t EBML_UNKNOWN_SIZE = UINT64_MAX;
+
+    /* Cues positions checked for a Cluster, spread over the segment */
+    const size_t   CUES_CHECKED   = 32;
+
+    const char     CACHE_MAGIC[4] = { 'M', 'K', 'V', 'I' };
+    const uint32_t CACHE_VERSION  = 1;
+    const size_t   CACHE_MAX_SIZE = 64 << 20;
+
+    bool ReadVint( stream_t *s, uint64_t *pi_value, unsigned *pi_len,
+                   bool b_keep_marker )
+    {
+        uint8_t p_buf[8];
+        if( vlc_stream_Read( s, p_buf, 1 ) != 1 || p_buf[0] == 0 )
+            return false;
+
+        unsigned i_len = 1;
+        uint8_t  i_mask = 0x80;
+        while( !( p_buf[0] & i_mask ) )
+        {
+            i_mask >>= 1;
+            i_len++;
+        }
+
+        if( i_len > 1 &&
+            vlc_stream_Read( s, &p_buf[1], i_len - 1 ) != (ssize_t)(i_len - 1) )
+            return false;
+
+        uint64_t i_value = b_keep_marker ? p_buf[0] : p_buf[0] & ( i_mask - 1 );
+        bool b_all_ones = ( p_buf[0] & ( i_mask - 1 ) ) == i_mask - 1;
+        for( unsigned i = 1; i < i_len; i++ )
+        {
+            i_value = ( i_value << 8 ) | p_buf[i];
+            b_all_ones &= p_buf[i] == 0xFF;
+        }
+
+        *pi_value = ( b_all_ones && !b_keep_marker ) ? EBML_UNKNOWN_SIZE : i_value;
+        *pi_len = i_len;
+        return true;
+    }
+
+    bool ReadElementHeader( stream_t *s, uint32_t *pi_id, uint64_t *pi_size )
+    {
+        uint64_t i_id;
+        unsigned i_len;
+        if( !ReadVint( s, &i_id, &i_len, true ) || i_len > 4 )
+            return false;
+        *pi_id = i_id;
+        return ReadVint( s, pi_size, &i_len, false );
+    }
+
+    bool ReadUInteger( stream_t *s, uint64_t i_size, uint64_t *pi_value )
+    {
+        uint8_t p_buf[8];
+        if( i_size > 8 || vlc_stream_Read( s, p_buf, i_size ) != (ssize_t)i_size )
+            return false;
+        *pi_value = 0;
+        for( uint64_t i = 0; i < i_size; i++ )
+            *pi_value = ( *pi_value << 8 ) | p_buf[i];
+        return true;
+    }
+
+    /* track number, relative timecode and flags of a (Simple)Block */
+    bool ReadBlockHeader( stream_t *s, uint64_t *pi_track, int16_t *pi_timecode,
+                          uint8_t *pi_flags )
+    {
+        unsigned i_len;
+        uint8_t p_buf[3];
+        if( !ReadVint( s, pi_track, &i_len, false ) ||
+            vlc_stream_Read( s, p_buf, 3 ) != 3 )
+            return false;
+        *pi_timecode = (int16_t)GetWBE( p_buf );
+        *pi_flags = p_buf[2];
+        return true;
+    }
+
+    class CacheWriter
+    {
+        public:
+            void u32( uint32_t v ) { size_t i = buf.size(); buf.resize( i + 4 ); SetDWLE( &buf[i], v ); }
+            void u64( uint64_t v ) { size_t i = buf.size(); buf.resize( i + 8 ); SetQWLE( &buf[i], v ); }
+
+            std::vector<uint8_t> buf;
+    };
+
+    class CacheReader
+    {
+        public:
+            CacheReader( const uint8_t *p_buf, size_t i_size )
+                : p( p_buf ), i_left( i_size ), b_ok( true )
+            { }
+
+            uint32_t u32()
+            {
+                if( !has( 4 ) ) return 0;
+                uint32_t v = GetDWLE( p ); p += 4; i_left -= 4;
+                return v;
+            }
+            uint64_t u64()
+            {
+                if( !has( 8 ) ) return 0;
+                uint64_t v = GetQWLE( p ); p += 8; i_left -= 8;
+                return v;
+            }
+            /* rejects counts that cannot fit in what is left */
+            bool has( uint64_t i_size )
+            {
+                if( i_size > i_left )
+                    b_ok = false;
+                return b_ok;
+            }
+
+            const uint8_t *p;
+            size_t i_left;
+            bool b_ok;
+    };
+}
+
+namespace mkv {
+
+SegmentIndexer::SegmentIndexer( matroska_segment_c & segment )
+    :ms( segment )
+    ,demuxer( segment.sys.demuxer )
+    ,s( NULL )
+    ,i_timescale( segment.i_timescale )
+    ,i_start( 0 )
+    ,i_end( 0 )
+    ,b_running( false )
+    ,b_abort( false )
+    ,b_pending( false )
+    ,b_index( !segment.b_cues )
+    ,b_drop_cues( false )
+    ,i_indexed_end( 0 )
+    ,b_complete( false )
+    ,b_background( false )
+    ,b_cues_dropped( false )
+    ,i_merged_end( 0 )
+    ,b_dirty( false )
+{
+    vlc_mutex_init( &lock );
+    cache.psz_path = NULL;
+    cache.psz_dir = NULL;
+}
+
+SegmentIndexer::~SegmentIndexer()
+{
+    Stop();
+    Merge();
+
+    if( cache.psz_path != NULL && b_dirty )
+        SaveCache();
+    seekindex_cache_Clean( &cache );
+}
+
+bool SegmentIndexer::Start( bool b_background_, bool b_cache )
+{
+    if( ms.cluster == NULL )
+        return false;
+    b_background = b_background_;
+
+    if( !b_index )
+    {
+        SegmentSeeker const& seeker = ms._seeker;
+        vlc_tick_t i_last_cue = -1;
+
+        for( SegmentSeeker::tracks_seekpoints_t::const_iterator it = seeker._tracks_seekpoints.begin();
+             it != seeker._tracks_seekpoints.end(); ++it )
+        {
+            for( size_t i = 0; i < it->second.size(); i++ )
+                if( it->second[i].trust_level != SegmentSeeker::Seekpoint::DISABLED &&
+                    it->second[i].pts > i_last_cue )
+                    i_last_cue = it->second[i].pts;
+        }
+
+        /* the rest of the segment could only be reached by parsing it */
+        if( ms.i_duration > 0 &&
+            i_last_cue < ms.i_duration - std::max( ms.i_duration / 10, vlc_tick_t( VLC_TICK_FROM_SEC( 10 ) ) ) )
+        {
+            msg_Warn( &demuxer, "Cues cover %" PRId64 "/%" PRId64 " s only, indexing the segment",
+                      SEC_FROM_VLC_TICK( i_last_cue ), SEC_FROM_VLC_TICK( ms.i_duration ) );
+            b_index = true;
+        }
+        else
+        {
+            SegmentSeeker::cluster_positions_t const& positions = seeker._cluster_positions;
+            size_t i_step = std::max<size_t>( positions.size() / CUES_CHECKED, 1 );
+
+            for( size_t i = 0; i < positions.size(); i += i_step )
+                cue_positions.push_back( positions[i] );
+            if( !positions.empty() && cue_positions.back() != positions.back() )
+                cue_positions.push_back( positions.back() );
+        }
+    }
+
+    uint64_t i_size;
+    if( ms.segment->IsFiniteSize() )
+        i_end = ms.segment->GetEndPosition();
+    else if( !vlc_stream_GetSize( demuxer.s, &i_size ) )
+        i_end = i_size;
+    else
+        return false;
+
+    i_start = i_indexed_end = i_merged_end = ms.cluster->GetElementPosition();
+
+    for( matroska_segment_c::tracks_map_t::const_iterator it = ms.tracks.begin();
+         it != ms.tracks.end(); ++it )
+        tracks.push_back( it->first );
+
+    if( b_cache )
+    {
+        /* one entry per segment of the file */
+        std::vector<uint8_t> key( 8 );
+        SetQWLE( key.data(), ms.segment->GetElementPosition() );
+        if( ms.p_segment_uid != NULL )
+            key.insert( key.end(), ms.p_segment_uid->GetBuffer(),
+                        ms.p_segment_uid->GetBuffer() + ms.p_segment_uid->GetSize() );
+
+        if( seekindex_cache_Init( &cache, VLC_OBJECT( &demuxer ), "mkvindex",
+                                  demuxer.psz_filepath, key.data(), key.size() ) == VLC_SUCCESS &&
+            LoadCache() )
+            msg_Dbg( &demuxer, "seek index loaded from %s%s", cache.psz_path,
+                     b_complete ? "" : " (partial)" );
+    }
+
+    if( b_background && !b_complete )
+        StartThread();
+
+    return b_running || cache.psz_path != NULL;
+}
+
+bool SegmentIndexer::StartThread()
+{
+    s = vlc_stream_NewURL( &demuxer, demuxer.psz_url );
+    if( s == NULL )
+        return false;
+
+    b_abort = false;
+    b_running = !vlc_clone( &thread, Run, this, VLC_THREAD_PRIORITY_LOW );
+    if( !b_running )
+    {
+        vlc_stream_Delete( s );
+        s = NULL;
+    }
+    return b_running;
+}
+
+/* A seek based on the Cues did not land where expected */
+void SegmentIndexer::CuesMissed()
+{
+    if( b_drop_cues.exchange( true ) )
+        return;
+
+    msg_Warn( &demuxer, "seek missed with the Cues, indexing the segment" );
+    b_index = true;
+    b_pending = true;
+
+    /* the check may have succeeded and ended the thread already */
+    Stop();
+    if( b_background && !b_complete )
+        StartThread();
+}
+
+void SegmentIndexer::Stop()
+{
+    if( !b_running )
+        return;
+
+    b_abort = true;
+    vlc_join( thread, NULL );
+    b_running = false;
+
+    vlc_stream_Delete( s );
+    s = NULL;
+}
+
+void *SegmentIndexer::Run( void *data )
+{
+    SegmentIndexer *p_indexer = static_cast<SegmentIndexer *>( data );
+    p_indexer->Index();
+    return NULL;
+}
+
+bool SegmentIndexer::CheckCues()
+{
+    for( size_t i = 0; i < cue_positions.size() && !b_abort; i++ )
+    {
+        uint32_t i_id;
+        uint64_t i_size;
+
+        if( vlc_stream_Seek( s, cue_positions[i] ) ||
+            !ReadElementHeader( s, &i_id, &i_size ) || i_id != MKV_ID_CLUSTER )
+        {
+            msg_Warn( &demuxer, "no Cluster at Cues position %" PRIu64 ", indexing the segment",
+                      cue_positions[i] );
+            return false;
+        }
+    }
+    return true;
+}
+
+void SegmentIndexer::Index()
+{
+    if( !b_index )
+    {
+        if( CheckCues() || b_abort )
+            return;
+
+        b_drop_cues = true;
+        b_index = true;
+        b_pending = true;
+    }
+
+    fptr_t fpos;
+    {
+        vlc_mutex_locker lock_guard( &lock );
+        fpos = i_indexed_end;
+    }
+
+    vlc_tick_t i_start_time = vlc_tick_now();
+
+    while( !b_abort && fpos < i_end )
+    {
+        uint32_t i_id;
+        uint64_t i_size;
+
+        if( vlc_stream_Seek( s, fpos ) || !ReadElementHeader( s, &i_id, &i_size ) )
+            break;
+
+        /* live recordings: nothing past an unknown sized cluster can be
+         * reached without parsing it all */
+        fptr_t data = vlc_stream_Tell( s );
+        if( i_size == EBML_UNKNOWN_SIZE || i_size > i_end - data )
+            break;
+
+        if( i_id == MKV_ID_CLUSTER && !IndexCluster( s, fpos, data + i_size ) )
+            break;
+
+        fpos = data + i_size;
+    }
+
+    if( b_abort )
+        return;
+
+    vlc_mutex_locker lock_guard( &lock );
+    /* a read error or an unknown sized cluster leaves the rest to a later
+     * run, resuming from i_indexed_end */
+    b_complete = fpos >= i_end;
+    b_pending = true;
+
+    msg_Dbg( &demuxer, "segment indexed up to %" PRIu64 "/%" PRIu64 " in %" PRId64 " ms",
+             i_indexed_end, i_end, MS_FROM_VLC_TICK( vlc_tick_now() - i_start_time ) );
+}
+
+bool SegmentIndexer::IndexCluster( stream_t *s, fptr_t fpos, fptr_t end )
+{
+    std::vector<std::pair<track_id_t, SegmentSeeker::Seekpoint> > points;
+    uint64_t i_cluster_tc = 0;
+    bool b_timecode = false;
+
+    for( fptr_t pos = vlc_stream_Tell( s ); pos < end; )
+    {
+        uint32_t i_id;
+        uint64_t i_size;
+
+        if( b_abort || !ReadElementHeader( s, &i_id, &i_size ) )
+            return false;
+
+        fptr_t data = vlc_stream_Tell( s );
+        if( i_size == EBML_UNKNOWN_SIZE || i_size > end - data )
+            return false;
+
+        fptr_t block_pos = std::numeric_limits<fptr_t>::max();
+        uint64_t i_track = 0;
+        int16_t i_block_tc = 0;
+        bool b_key = false;
+
+        switch( i_id )
+        {
+            case MKV_ID_TIMECODE:
+                if( !ReadUInteger( s, i_size, &i_cluster_tc ) )
+                    return false;
+                b_timecode = true;
+                break;
+
+            case MKV_ID_SIMPLEBLOCK:
+            {
+                uint8_t i_flags;
+                if( !ReadBlockHeader( s, &i_track, &i_block_tc, &i_flags ) )
+                    return false;
+                block_pos = pos;
+                b_key = i_flags & 0x80;
+                break;
+            }
+
+            case MKV_ID_BLOCKGROUP:
+            {
+                /* a Block without ReferenceBlock is a keyframe */
+                b_key = true;
+                for( fptr_t child = data; child < data + i_size; )
+                {
+                    uint32_t i_child_id;
+                    uint64_t i_child_size;
+
+                    if( vlc_stream_Seek( s, child ) ||
+                        !ReadElementHeader( s, &i_child_id, &i_child_size ) )
+                        return false;
+
+                    fptr_t child_data = vlc_stream_Tell( s );
+                    if( i_child_size > data + i_size - child_data )
+                        return false;
+
+                    if( i_child_id == MKV_ID_BLOCK )
+                    {
+                        uint8_t i_flags;
+                        if( !ReadBlockHeader( s, &i_track, &i_block_tc, &i_flags ) )
+                            return false;
+                        block_pos = child;
+                    }
+                    else if( i_child_id == MKV_ID_REFERENCEBLOCK )
+                        b_key = false;
+
+                    child = child_data + i_child_size;
+                }
+                break;
+            }
+        }
+
+        if( b_key && b_timecode && block_pos != std::numeric_limits<fptr_t>::max() &&
+            std::find( tracks.begin(), tracks.end(), i_track ) != tracks.end() )
+        {
+            vlc_tick_t i_pts = VLC_TICK_FROM_NS(
+                ( (int64_t) i_cluster_tc + i_block_tc ) * (int64_t) i_timescale );
+            points.push_back( std::make_pair( track_id_t( i_track ),
+                                              SegmentSeeker::Seekpoint( block_pos, i_pts ) ) );
+        }
+
+        pos = data + i_size;
+        if( pos < end && vlc_stream_Seek( s, pos ) )
+            return false;
+    }
+
+    if( !b_timecode )
+        return false;
+
+    SegmentSeeker::Cluster cinfo = {
+        /* fpos     */ fpos,
+        /* pts      */ vlc_tick_t( VLC_TICK_FROM_NS( i_cluster_tc * i_timescale ) ),
+        /* duration */ vlc_tick_t( -1 ),
+        /* size     */ end - fpos
+    };
+
+    vlc_mutex_locker lock_guard( &lock );
+    clusters.push_back( cinfo );
+    seekpoints.insert( seekpoints.end(), points.begin(), points.end() );
+    i_indexed_end = end;
+    b_pending = true;
+    return true;
+}
+
+/* Only the first Cluster is kept: the indexer finds the others */
+void SegmentIndexer::DropCues()
+{
+    SegmentSeeker & seeker = ms._seeker;
+
+    for( SegmentSeeker::tracks_seekpoints_t::iterator it = seeker._tracks_seekpoints.begin();
+         it != seeker._tracks_seekpoints.end(); ++it )
+    {
+        for( size_t i = 0; i < it->second.size(); i++ )
+            it->second[i].trust_level = SegmentSeeker::Seekpoint::DISABLED;
+    }
+    for( size_t i = 0; i < tracks.size(); i++ )
+        seeker.add_seekpoint( tracks[i], SegmentSeeker::Seekpoint( i_start, -1,
+                              SegmentSeeker::Seekpoint::QUESTIONABLE ) );
+
+    seeker._cluster_positions.clear();
+    seeker.add_cluster_position( i_start );
+    for( SegmentSeeker::cluster_map_t::const_iterator it = seeker._clusters.begin();
+         it != seeker._clusters.end(); ++it )
+    {
+        if( !std::binary_search( seeker._cluster_positions.begin(),
+                                 seeker._cluster_positions.end(), it->second.fpos ) )
+            seeker.add_cluster_position( it->second.fpos );
+    }
+    b_cues_dropped = true;
+}
+
+void SegmentIndexer::Merge()
+{
+    if( !b_pending.exchange( false ) )
+        return;
+
+    if( b_drop_cues && !b_cues_dropped )
+        DropCues();
+
+    std::vector<SegmentSeeker::Cluster> new_clusters;
+    std::vector<std::pair<track_id_t, SegmentSeeker::Seekpoint> > new_seekpoints;
+    fptr_t i_new_end;
+    {
+        vlc_mutex_locker lock_guard( &lock );
+        new_clusters.swap( clusters );
+        new_seekpoints.swap( seekpoints );
+        i_new_end = i_indexed_end;
+    }
+
+    SegmentSeeker & seeker = ms._seeker;
+
+    for( size_t i = 0; i < new_clusters.size(); i++ )
+        seeker.add_cluster( new_clusters[i] );
+
+    for( size_t i = 0; i < new_seekpoints.size(); i++ )
+        seeker.add_seekpoint( new_seekpoints[i].first, new_seekpoints[i].second );
+
+    if( i_new_end > i_merged_end )
+    {
+        seeker.mark_range_as_searched( SegmentSeeker::Range( i_merged_end, i_new_end - 1 ) );
+        i_merged_end = i_new_end;
+    }
+
+    b_dirty = true;
+}
+
+/*****************************************************************************
+ * Sidecar cache, little endian:
+ *  check    : timescale, first cluster position
+ *  header   : indexed end, complete
+ *  ranges   : count, { start, end }
+ *  clusters : count, { fpos, pts, size }
+ *  tracks   : count, { track number, count, { fpos, pts } }
+ *****************************************************************************/
+bool SegmentIndexer::LoadCache()
+{
+    uint8_t p_check[16];
+    SetQWLE( &p_check[0], i_timescale );
+    SetQWLE( &p_check[8], i_start );
+
+    size_t i_size;
+    uint8_t *p_buf = seekindex_cache_Load( &cache, CACHE_MAGIC, CACHE_VERSION,
+                                           p_check, sizeof(p_check), CACHE_MAX_SIZE, &i_size );
+    if( p_buf == NULL )
+        return false;
+
+    CacheReader r( p_buf, i_size );
+    fptr_t i_cached_end = r.u64();
+    bool b_cached_complete = r.u32() != 0;
+
+    SegmentSeeker::ranges_t ranges;
+    for( uint32_t i_count = r.u32(); r.has( i_count * UINT64_C(16) ) && i_count; i_count-- )
+    {
+        fptr_t start = r.u64();
+        ranges.push_back( SegmentSeeker::Range( start, r.u64() ) );
+    }
+
+    std::vector<SegmentSeeker::Cluster> cached_clusters;
+    for( uint32_t i_count = r.u32(); r.has( i_count * UINT64_C(24) ) && i_count; i_count-- )
+    {
+        SegmentSeeker::Cluster cinfo;
+        cinfo.fpos     = r.u64();
+        cinfo.pts      = r.u64();
+        cinfo.duration = -1;
+        cinfo.size     = r.u64();
+        cached_clusters.push_back( cinfo );
+    }
+
+    SegmentSeeker::tracks_seekpoints_t cached_seekpoints;
+    for( uint32_t i_tracks = r.u32(); r.has( i_tracks * UINT64_C(12) ) && i_tracks; i_tracks-- )
+    {
+        track_id_t track_id = r.u64();
+        SegmentSeeker::seekpoints_t & points = cached_seekpoints[ track_id ];
+        for( uint32_t i_count = r.u32(); r.has( i_count * UINT64_C(16) ) && i_count; i_count-- )
+        {
+            fptr_t fpos = r.u64();
+            points.push_back( SegmentSeeker::Seekpoint( fpos, vlc_tick_t( r.u64() ) ) );
+        }
+    }
+
+    free( p_buf );
+
+    if( !r.b_ok || i_cached_end < i_start || i_cached_end > i_end )
+    {
+        seekindex_cache_Corrupted( &cache );
+        return false;
+    }
+
+    if( !b_index )
+    {
+        /* indexed by a previous playback, as the Cues were not usable */
+        b_index = true;
+        b_drop_cues = true;
+        DropCues();
+    }
+
+    SegmentSeeker & seeker = ms._seeker;
+
+    for( size_t i = 0; i < ranges.size(); i++ )
+        seeker.mark_range_as_searched( ranges[i] );
+
+    for( size_t i = 0; i < cached_clusters.size(); i++ )
+        seeker.add_cluster( cached_clusters[i] );
+
+    for( SegmentSeeker::tracks_seekpoints_t::const_iterator it = cached_seekpoints.begin();
+         it != cached_seekpoints.end(); ++it )
+    {
+        for( size_t i = 0; i < it->second.size(); i++ )
+            seeker.add_seekpoint( it->first, it->second[i] );
+    }
+
+    i_indexed_end = i_merged_end = i_cached_end;
+    b_complete = b_cached_complete;
+    return true;
+}
+
+void SegmentIndexer::SaveCache()
+{
+    SegmentSeeker const& seeker = ms._seeker;
+    CacheWriter w;
+
+    {
+        vlc_mutex_locker lock_guard( &lock );
+        w.u64( i_merged_end );
+        w.u32( b_complete && i_merged_end == i_indexed_end );
+    }
+
+    w.u32( seeker._ranges_searched.size() );
+    for( size_t i = 0; i < seeker._ranges_searched.size(); i++ )
+    {
+        w.u64( seeker._ranges_searched[i].start );
+        w.u64( seeker._ranges_searched[i].end );
+    }
+
+    w.u32( seeker._clusters.size() );
+    for( SegmentSeeker::cluster_map_t::const_iterator it = seeker._clusters.begin();
+         it != seeker._clusters.end(); ++it )
+    {
+        w.u64( it->second.fpos );
+        w.u64( it->second.pts );
+        w.u64( it->second.size );
+    }
+
+    w.u32( seeker._tracks_seekpoints.size() );
+    for( SegmentSeeker::tracks_seekpoints_t::const_iterator it = seeker._tracks_seekpoints.begin();
+         it != seeker._tracks_seekpoints.end(); ++it )
+    {
+        /* only keep the keyframes found while parsing */
+        size_t i_count_pos = w.buf.size() + 8;
+        uint32_t i_count = 0;
+
+        w.u64( it->first );
+        w.u32( 0 );
+        for( size_t i = 0; i < it->second.size(); i++ )
+        {
+            SegmentSeeker::Seekpoint const& sp = it->second[i];
+            if( sp.trust_level != SegmentSeeker::Seekpoint::TRUSTED || sp.pts < 0 )
+                continue;
+            w.u64( sp.fpos );
+            w.u64( sp.pts );
+            i_count++;
+        }
+        SetDWLE( &w.buf[i_count_pos], i_count );
+    }
+
+    uint8_t p_check[16];
+    SetQWLE( &p_check[0], i_timescale );
+    SetQWLE( &p_check[8], i_start );
+    seekindex_cache_Save( &cache, CACHE_MAGIC, CACHE_VERSION, p_check, sizeof(p_check),
+                          w.buf.data(), w.buf.size() );
+}
+
+} // namespace
@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * matroska_segment_indexer.hpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef MKV_MATROSKA_SEGMENT_INDEXER_HPP_
+#define MKV_MATROSKA_SEGMENT_INDEXER_HPP_
+
+#include "mkv.hpp"
+#include "matroska_segment_seeker.hpp"
+#include "../seekindex_cache.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace mkv {
+
+class matroska_segment_c;
+
+/* Builds the SegmentSeeker index of a segment without usable Cues.
+ *
+ * Cues covering only part of the segment are not used. The others are
+ * checked in the background, by looking for a Cluster at some of their
+ * positions, and by the seeks made with them: if that fails, they are
+ * dropped from the seeker and the segment is indexed.
+ *
+ * The clusters are walked from a separate stream in a background thread,
+ * the results are handed over to the seeker by Merge() which must be
+ * called from the demux thread. The index can be kept in a sidecar file of
+ * the user cache directory, keyed by the identity of the file, so that it
+ * does not have to be rebuilt the next time the file is opened. */
+class SegmentIndexer
+{
+    public:
+        typedef SegmentSeeker::fptr_t fptr_t;
+        typedef SegmentSeeker::track_id_t track_id_t;
+
+        SegmentIndexer( matroska_segment_c & );
+        ~SegmentIndexer();
+
+        bool Start( bool b_background, bool b_cache );
+        void Merge();
+        void CuesMissed();
+
+    private:
+        static void *Run( void * );
+        bool StartThread();
+        bool CheckCues();
+        void DropCues();
+        void Index();
+        bool IndexCluster( stream_t *, fptr_t fpos, fptr_t end );
+        void Stop();
+
+        bool LoadCache();
+        void SaveCache();
+
+        matroska_segment_c & ms;
+        demux_t            & demuxer;
+
+        /* read-only while the thread runs */
+        stream_t           *s;
+        uint64_t           i_timescale;
+        fptr_t             i_start;
+        fptr_t             i_end;
+        SegmentSeeker::track_ids_t tracks;
+        std::vector<fptr_t> cue_positions; /* to check */
+
+        vlc_thread_t       thread;
+        bool               b_running;
+        std::atomic<bool>  b_abort;
+        std::atomic<bool>  b_pending;
+        std::atomic<bool>  b_index; /* no usable Cues */
+        std::atomic<bool>  b_drop_cues; /* Cues pointing to no Cluster */
+
+        /* guarded by lock */
+        vlc_mutex_t        lock;
+        std::vector<SegmentSeeker::Cluster> clusters;
+        std::vector<std::pair<track_id_t, SegmentSeeker::Seekpoint> > seekpoints;
+        fptr_t             i_indexed_end;
+        bool               b_complete;
+
+        /* demux thread only */
+        bool               b_background;
+        bool               b_cues_dropped;
+        fptr_t             i_merged_end;
+        seekindex_cache_t  cache;
+        bool               b_dirty;
+};
+
+} // namespace
+
+#endif /* include-guard */
@@ -74,7 +74,14 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
             : UINT64_MAX
     };
 
-    add_cluster_position( cinfo.fpos );
+    return add_cluster( cinfo );
+}
+
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( Cluster const& cinfo )
+{
+    if( !std::binary_search( _cluster_positions.begin(), _cluster_positions.end(), cinfo.fpos ) )
+        add_cluster_position( cinfo.fpos );
 
     cluster_map_t::iterator it = _clusters.lower_bound( cinfo.pts );
 
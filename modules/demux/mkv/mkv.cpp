@@ -81,6 +81,14 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback") );
 
+    add_bool( "mkv-background-index", false,
+            N_("Index clusters in the background"),
+            N_("Build the seek index of files without usable Cues while playing them.") );
+
+    add_bool( "mkv-index-cache", false,
+            N_("Cache the seek index"),
+            N_("Keep the seek index of files without usable Cues, so that they can be seeked at once when played again.") );
+
     add_shortcut( "mka", "mkv" )
     add_file_extension("mka")
     add_file_extension("mks")
@@ -267,6 +275,12 @@ static int OpenInternal( demux_t *p_demux, bool trust_cues )
         goto error;
     }
 
+    for (size_t i=0; i<p_stream->segments.size(); i++)
+    {
+        if ( p_stream->segments[i]->b_preloaded )
+            p_stream->segments[i]->StartIndexing();
+    }
+
     return VLC_SUCCESS;
 
 error:
@@ -762,6 +776,8 @@ static int Demux( demux_t *p_demux)
     if ( p_segment == NULL )
         return VLC_DEMUXER_EOF;
 
+    p_segment->MergeIndex();
+
     KaxBlock *block;
     KaxSimpleBlock *simpleblock;
     KaxBlockAdditions *additions;
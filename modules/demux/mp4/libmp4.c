@@ -5423,6 +5423,13 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *p_stream )
             goto error;
         }
 
+        /* The samples will be read from the mdat once the moov is loaded:
+         * let the stream fetch them meanwhile. */
+        MP4_Box_t *p_mdat = MP4_BoxGet( p_vroot, "mdat" );
+        if( p_mdat != NULL )
+            vlc_stream_SeekHint( p_stream, p_mdat->i_pos +
+                                           mp4_box_headersize( p_mdat ) );
+
         /* continue loading up to moov */
         const uint32_t stoplist[] = { ATOM_moov, 0 };
         i_result = MP4_ReadBoxContainerChildren( p_stream, p_vroot, stoplist );
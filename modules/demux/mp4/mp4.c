@@ -346,103 +346,95 @@ static es_out_id_t * MP4_CreateES( es_out_t *out, const es_format_t *p_fmt,
     return p_es;
 }
 
-static int MP4_ChunkAllocDtsEntries( mp4_chunk_t *ck )
-{
-    size_t entries = ck->i_entries_dts;
-
-    if( entries <= ARRAY_SIZE(ck->small_dts_buf) / 2 )
-    {
-        ck->p_sample_count_dts = ck->small_dts_buf;
-        ck->p_sample_delta_dts = ck->small_dts_buf + entries;
-        return 0;
-    }
-
-    uint32_t *buf = calloc( entries, sizeof( buf[0] ) * 2 );
-    if( unlikely(buf == NULL) )
-        return VLC_ENOMEM;
-
-    ck->p_sample_count_dts = buf;
-    ck->p_sample_delta_dts = buf + entries;
-    return 0;
-}
-
-static int MP4_ChunkAllocPtsEntries( mp4_chunk_t *ck )
+static const mp4_chunk_t * MP4_TrackChunkForSample( const mp4_track_t *p_track,
+                                                    uint32_t i_sample )
 {
-    size_t entries = ck->i_entries_pts;
+    if( i_sample >= p_track->i_sample_count || p_track->i_chunk_count == 0 )
+        return NULL;
 
-    if( entries <= ARRAY_SIZE(ck->small_pts_buf) / 2 )
+    /* chunks are ordered by first sample: bisect */
+    uint32_t i_low = 0, i_high = p_track->i_chunk_count - 1;
+    while( i_low < i_high )
     {
-        ck->p_sample_count_pts = ck->small_pts_buf;
-        ck->p_sample_offset_pts = ck->small_pts_buf + entries;
-        return 0;
+        uint32_t i_mid = i_low + (i_high - i_low + 1) / 2;
+        if( p_track->chunk[i_mid].i_sample_first <= i_sample )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
     }
 
-    uint32_t *buf = calloc( entries, sizeof( buf[0] ) * 2 );
-    if( unlikely(buf == NULL) )
-        return VLC_ENOMEM;
-
-    ck->p_sample_count_pts = buf;
-    ck->p_sample_offset_pts = buf + entries;
-    return 0;
-}
-
-static void MP4_ChunkDestroy( mp4_chunk_t *ck )
-{
-    if( ck->p_sample_count_dts != ck->small_dts_buf )
-        free( ck->p_sample_count_dts );
-    if( ck->p_sample_count_pts != ck->small_pts_buf )
-        free( ck->p_sample_count_pts );
+    const mp4_chunk_t *ck = &p_track->chunk[i_low];
+    if( i_sample >= ck->i_sample_first &&
+        i_sample - ck->i_sample_first < ck->i_sample_count )
+        return ck;
+    return NULL;
 }
 
-static const mp4_chunk_t * MP4_TrackChunkForSample( const mp4_track_t *p_track,
-                                                    uint32_t i_sample )
+static uint32_t MP4_TrackChunkForTime( const mp4_track_t *p_track, stime_t i_start )
 {
-    if( i_sample >= p_track->i_sample_count )
-        return NULL;
-    for( uint32_t i=0; i<p_track->i_chunk_count; i++ )
-    {
-        if( i_sample >= p_track->chunk[i].i_sample_first &&
-            i_sample - p_track->chunk[i].i_sample_first < p_track->chunk[i].i_sample_count )
-            return &p_track->chunk[i];
+    /* chunks are ordered by first dts: bisect for the last one starting
+       before i_start, or the first one */
+    uint32_t i_low = 0, i_high = p_track->i_chunk_count - 1;
+    while( i_low < i_high )
+    {
+        uint32_t i_mid = i_low + (i_high - i_low + 1) / 2;
+        if( p_track->chunk[i_mid].i_first_dts <= (uint64_t)i_start )
+            i_low = i_mid;
+        else
+            i_high = i_mid - 1;
     }
-    return NULL;
+    return i_low;
 }
 
-static stime_t MP4_ChunkGetSampleDTS( const mp4_chunk_t *p_chunk,
+static stime_t MP4_ChunkGetSampleDTS( const mp4_track_t *p_track,
+                                      const mp4_chunk_t *p_chunk,
                                       uint32_t i_sample )
 {
-    uint32_t i_index = 0;
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_index = p_chunk->i_stts_index;
+    uint32_t i_skip = p_chunk->i_stts_skip;
     stime_t sdts = p_chunk->i_first_dts;
-    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
+    while( i_sample > 0 && stts && i_index < stts->i_entry_count )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        uint32_t i_count = stts->pi_sample_count[i_index] - i_skip;
+        uint32_t i_delta = stts->pi_sample_delta[i_index];
+        if( i_sample > i_count )
         {
-            sdts += (stime_t)p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index++];
+            sdts += (stime_t)i_count * i_delta;
+            i_sample -= i_count;
+            i_index++;
+            i_skip = 0;
         }
         else
         {
-            sdts += (stime_t)i_sample * p_chunk->p_sample_delta_dts[i_index];
+            sdts += (stime_t)i_sample * i_delta;
             break;
         }
     }
     return sdts;
 }
 
-static bool MP4_ChunkGetSampleCTSDelta( const mp4_chunk_t *p_chunk,
+static bool MP4_ChunkGetSampleCTSDelta( const mp4_track_t *p_track,
+                                        const mp4_chunk_t *p_chunk,
                                         uint32_t i_sample, stime_t *pi_delta )
 {
-    if( p_chunk->p_sample_count_pts && p_chunk->p_sample_offset_pts )
+    const MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
+    if( ctts && i_sample < p_chunk->i_sample_count )
     {
-        for( uint32_t i_index = 0; i_index < p_chunk->i_entries_pts ; i_index++ )
+        uint32_t i_skip = p_chunk->i_ctts_skip;
+        for( uint32_t i_index = p_chunk->i_ctts_index;
+             i_index < ctts->i_entry_count; i_index++ )
         {
-            if( i_sample < p_chunk->p_sample_count_pts[i_index] )
+            if( i_sample < ctts->pi_sample_count[i_index] - i_skip )
             {
-                *pi_delta = p_chunk->p_sample_offset_pts[i_index];
+                int64_t i_ctsdelta = ctts->pi_sample_offset[i_index] + p_track->i_cts_shift;
+                if( i_ctsdelta < 0 ) /* should not */
+                    i_ctsdelta = 0;
+                *pi_delta = (uint32_t) i_ctsdelta;
                 return true;
             }
-            i_sample -= p_chunk->p_sample_count_pts[i_index];
+            i_sample -= ctts->pi_sample_count[i_index] - i_skip;
+            i_skip = 0;
         }
     }
     return false;
@@ -499,43 +491,15 @@ static inline vlc_tick_t MP4_GetSamplesDuration( demux_t *p_demux, mp4_track_t *
     VLC_UNUSED( p_demux );
 
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
-    stime_t i_duration = 0;
-
-    /* Forward to right index, and set remaining count in that index */
-    unsigned i_index = 0;
-    unsigned i_remain = 0;
-    for( unsigned i = p_chunk->i_sample_first;
-         i<p_track->i_sample && i_index < p_chunk->i_entries_dts; )
-    {
-        if( p_track->i_sample - i >= p_chunk->p_sample_count_dts[i_index] )
-        {
-            i += p_chunk->p_sample_count_dts[i_index];
-            i_index++;
-        }
-        else
-        {
-            i_remain = p_track->i_sample - i;
-            break;
-        }
-    }
+    uint32_t i_chunk_sample = p_track->i_sample - p_chunk->i_sample_first;
+    if( i_chunk_sample >= p_chunk->i_sample_count )
+        return 0;
+    if( i_nb_samples > p_chunk->i_sample_count - i_chunk_sample )
+        i_nb_samples = p_chunk->i_sample_count - i_chunk_sample;
 
-    /* Compute total duration from all samples from index */
-    while( i_nb_samples > 0 && i_index < p_chunk->i_entries_dts )
-    {
-        if( i_nb_samples >= p_chunk->p_sample_count_dts[i_index] - i_remain )
-        {
-            i_duration += (p_chunk->p_sample_count_dts[i_index] - i_remain) *
-                          (int64_t) p_chunk->p_sample_delta_dts[i_index];
-            i_nb_samples -= (p_chunk->p_sample_count_dts[i_index] - i_remain);
-            i_index++;
-            i_remain = 0;
-        }
-        else
-        {
-            i_duration += (stime_t)i_nb_samples * p_chunk->p_sample_delta_dts[i_index];
-            break;
-        }
-    }
+    stime_t i_duration =
+            MP4_ChunkGetSampleDTS( p_track, p_chunk, i_chunk_sample + i_nb_samples ) -
+            MP4_ChunkGetSampleDTS( p_track, p_chunk, i_chunk_sample );
 
     return MP4_rescale_mtime( i_duration, p_track->i_timescale );
 }
@@ -2453,12 +2417,10 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
         ck->i_offset = BOXDATA(p_co64)->i_chunk_offset[i_chunk];
 
         ck->i_first_dts = 0;
-        ck->i_entries_dts = 0;
-        ck->p_sample_count_dts = NULL;
-        ck->p_sample_delta_dts = NULL;
-        ck->i_entries_pts = 0;
-        ck->p_sample_count_pts = NULL;
-        ck->p_sample_offset_pts = NULL;
+        ck->i_stts_index = 0;
+        ck->i_stts_skip = 0;
+        ck->i_ctts_index = 0;
+        ck->i_ctts_skip = 0;
     }
 
     /* now we read index for SampleEntry( soun vide mp4a mp4v ...)
@@ -2520,54 +2482,6 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
-{
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
-    {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
-
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_EINVAL;
-        }
-
-        if ( i_index_samples_left )
-        {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
-        }
-        else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
-        }
-    }
-
-    return VLC_SUCCESS;
-}
-
 static int TrackCreateSamplesIndex( demux_t *p_demux,
                                     mp4_track_t *p_demux_track )
 {
@@ -2588,7 +2502,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     stsz = p_box->data.p_stsz;
 
-    /* Use stsz table to create a sample number -> sample size table */
+    /* Use stsz table as sample number -> sample size table */
     if( p_demux_track->i_sample_count != stsz->i_sample_count )
     {
         msg_Warn( p_demux, "Incorrect total samples stsc %" PRIu32 " <> stsz %"PRIu32 ", "
@@ -2605,18 +2519,11 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 2: each sample can have a different size, read from the box table */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
+        p_demux_track->p_sample_size = stsz->i_entry_size;
         if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+            return VLC_EGENERIC;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2631,116 +2538,66 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
     /* Use stts table to create a sample number -> dts table.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  the box! so each chunk only remembers where its first sample is
+     *  in the table, and samples are decoded on demand from there.
+     *  Expanding it per chunk takes seconds and hundreds of MB on long
+     *  recordings. */
 
     int64_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    if( !p_box || !p_box->data.p_stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
     else
     {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
+        const MP4_Box_data_stts_t *stts = p_box->data.p_stts;
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
+        p_demux_track->p_stts = stts;
+
+        /* Set chunks position in stts, and their dts */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
+        bool b_truncated = false;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
 
-            /* save first dts */
             ck->i_first_dts = i_next_dts;
+            ck->i_stts_index = i_index;
+            ck->i_stts_skip = i_skip;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            i_ret = MP4_ChunkAllocDtsEntries( ck );
-            if( i_ret )
+            uint32_t i_sample_count = ck->i_sample_count;
+            while( i_sample_count > 0 && !b_truncated )
             {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return i_ret;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
-            {
-                if ( i_current_index_samples_left )
+                if( i_index >= stts->i_entry_count )
                 {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
+                    msg_Err( p_demux, "invalid index counting total samples %u %u",
+                             i_index, stts->i_entry_count );
+                    b_truncated = true;
+                    break;
                 }
-                else
+
+                uint32_t i_left = stts->pi_sample_count[i_index] - i_skip;
+                uint32_t i_count = __MIN( i_left, i_sample_count );
+                i_next_dts += (int64_t)i_count * (uint32_t) stts->pi_sample_delta[i_index];
+                i_sample_count -= i_count;
+                if( i_count == i_left )
                 {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += (int64_t)ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
-
+                else i_skip += i_count;
             }
+
+            ck->i_duration = i_next_dts - ck->i_first_dts;
         }
     }
 
@@ -2751,7 +2608,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
     if( p_box && p_box->data.p_ctts )
     {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+        const MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
@@ -2770,84 +2627,32 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
             }
         }
 
-        /* Create pts-dts table per chunk */
+        p_demux_track->p_ctts = ctts;
+        p_demux_track->i_cts_shift = i_cts_shift;
+
+        /* Set chunks position in ctts */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            i_ret = MP4_ChunkAllocPtsEntries( ck );
-            if( i_ret )
-            {
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return i_ret;
-            }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_ctts_index = i_index;
+            ck->i_ctts_skip = i_skip;
 
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
+            uint32_t i_sample_count = ck->i_sample_count;
+            while( i_sample_count > 0 && i_index < ctts->i_entry_count )
             {
-                int64_t i_ctsdelta = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                if( i_ctsdelta < 0 ) /* should not */
-                    i_ctsdelta = 0;
-                if ( i_current_index_samples_left )
+                uint32_t i_left = ctts->pi_sample_count[i_index] - i_skip;
+                uint32_t i_count = __MIN( i_left, i_sample_count );
+                i_sample_count -= i_count;
+                if( i_count == i_left )
                 {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
+                    i_index++;
+                    i_skip = 0;
                 }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = i_ctsdelta;
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-
+                else i_skip += i_count;
             }
         }
     }
@@ -3078,17 +2883,22 @@ static int TrackGetNearestSeekPoint( demux_t *p_demux, mp4_track_t *p_track,
         const MP4_Box_data_stss_t *p_stss_data = BOXDATA(p_stss);
         msg_Dbg( p_demux, "track[Id 0x%x] using Sync Sample Box (stss)",
                  p_track->i_track_ID );
-        for( unsigned i_index = 0; i_index < p_stss_data->i_entry_count; i_index++ )
+        if( p_stss_data->i_entry_count )
         {
-            if( i_index >= p_stss_data->i_entry_count - 1 ||
-                i_sample < p_stss_data->i_sample_number[i_index+1] )
+            /* sync samples are ordered: bisect for the last one before i_sample */
+            uint32_t i_low = 0, i_high = p_stss_data->i_entry_count - 1;
+            while( i_low < i_high )
             {
-                *pi_sync_sample = p_stss_data->i_sample_number[i_index];
-                msg_Dbg( p_demux, "stss gives %d --> %" PRIu32 " (sample number)",
-                         i_sample, *pi_sync_sample );
-                i_ret = VLC_SUCCESS;
-                break;
+                uint32_t i_mid = i_low + (i_high - i_low + 1) / 2;
+                if( p_stss_data->i_sample_number[i_mid] <= i_sample )
+                    i_low = i_mid;
+                else
+                    i_high = i_mid - 1;
             }
+            *pi_sync_sample = p_stss_data->i_sample_number[i_low];
+            msg_Dbg( p_demux, "stss gives %d --> %" PRIu32 " (sample number)",
+                     i_sample, *pi_sync_sample );
+            i_ret = VLC_SUCCESS;
         }
     }
 
@@ -3189,52 +2999,37 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = MP4_rescale_qtime( start, p_track->i_timescale );
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
     /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
-    {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
-        {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
-        }
-    }
+    i_chunk = MP4_TrackChunkForTime( p_track, i_start );
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
-
-    for( uint_fast32_t i_index = 0;
-         i_index < p_track->chunk[i_chunk].i_entries_dts &&
-         i_sample < p_track->chunk[i_chunk].i_sample_count;
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    uint32_t i_skip = ck->i_stts_skip;
+    i_sample = ck->i_sample_first;
+    i_dts    = ck->i_first_dts;
+
+    for( uint32_t i_index = ck->i_stts_index;
+         stts && i_index < stts->i_entry_count &&
+         i_sample < ck->i_sample_first + ck->i_sample_count;
          i_index++ )
     {
-        if( i_dts +
-            (uint64_t)p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
+        uint32_t i_count = __MIN( stts->pi_sample_count[i_index] - i_skip,
+                                  ck->i_sample_first + ck->i_sample_count - i_sample );
+        uint32_t i_delta = stts->pi_sample_delta[i_index];
+        i_skip = 0;
+        if( i_dts + (uint64_t)i_count * i_delta < (uint64_t)i_start )
         {
-            i_dts    +=
-                (uint64_t)p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
-
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
+            i_dts    += (uint64_t)i_count * i_delta;
+            i_sample += i_count;
         }
         else
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
+            if( i_delta == 0 || (uint64_t)i_start <= i_dts )
             {
                 break;
             }
-            i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+            i_sample += ( i_start - i_dts ) / i_delta;
             break;
         }
     }
@@ -3384,8 +3179,7 @@ static void TrackUpdateStarttimes( mp4_track_t *p_track )
     p_track->i_start_delta = p_track->i_next_delta;
 
     /* Probe the 16 first B frames */
-    const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
-    if( p_chunk->i_entries_pts )
+    if( p_track->p_ctts )
     {
         for( uint32_t i=1; i<16; i++ )
         {
@@ -3394,9 +3188,9 @@ static void TrackUpdateStarttimes( mp4_track_t *p_track )
             if(!ck)
                 break;
             stime_t pts;
-            stime_t dts = pts = MP4_ChunkGetSampleDTS( ck, i_nextsample - ck->i_sample_first );
+            stime_t dts = pts = MP4_ChunkGetSampleDTS( p_track, ck, i_nextsample - ck->i_sample_first );
             stime_t delta = UNKNOWN_DELTA;
-            if( MP4_ChunkGetSampleCTSDelta( ck, i_nextsample - ck->i_sample_first, &delta ) )
+            if( MP4_ChunkGetSampleCTSDelta( p_track, ck, i_nextsample - ck->i_sample_first, &delta ) )
                 pts += delta;
             stime_t lowest = p_track->i_start_dts;
             if( p_track->i_start_delta != UNKNOWN_DELTA )
@@ -3414,9 +3208,9 @@ static void TrackUpdateSampleAndTimes( mp4_track_t *p_track )
 {
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
     uint32_t i_chunk_sample = p_track->i_sample - p_chunk->i_sample_first;
-    p_track->i_next_dts = MP4_ChunkGetSampleDTS( p_chunk, i_chunk_sample );
+    p_track->i_next_dts = MP4_ChunkGetSampleDTS( p_track, p_chunk, i_chunk_sample );
     stime_t i_next_delta;
-    if( !MP4_ChunkGetSampleCTSDelta( p_chunk, i_chunk_sample, &i_next_delta ) )
+    if( !MP4_ChunkGetSampleCTSDelta( p_track, p_chunk, i_chunk_sample, &i_next_delta ) )
         p_track->i_next_delta = UNKNOWN_DELTA;
     else
         p_track->i_next_delta = i_next_delta;
@@ -3709,16 +3503,8 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            MP4_ChunkDestroy( &p_track->chunk[i_chunk] );
-    }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     ASFPacketTrackReset( &p_track->asfinfo );
 
     free( p_track->context.runs.p_array );
@@ -46,18 +46,12 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
-    uint32_t     i_entries_dts;
-    uint32_t     *p_sample_count_dts;
-    uint32_t     *p_sample_delta_dts;   /* dts delta */
-    uint32_t     small_dts_buf[4];
-
-    uint32_t     i_entries_pts;
-    uint32_t     *p_sample_count_pts;
-    uint32_t     *p_sample_offset_pts;  /* pts-dts */
-    uint32_t     small_pts_buf[4];
-
-    /* TODO if needed add pts
-        but quickly *add* support for edts and seeking */
+    /* stts/ctts are not expanded, but decoded on demand from the tables
+       entry holding the first sample of this chunk */
+    uint32_t     i_stts_index;  /* stts entry of the first sample */
+    uint32_t     i_stts_skip;   /* samples of that entry in previous chunks */
+    uint32_t     i_ctts_index;
+    uint32_t     i_ctts_skip;
 
 } mp4_chunk_t;
 
@@ -146,8 +140,12 @@ typedef struct
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* points to the stsz/stz2 table */
+
+    /* sample tables, walked from the chunks entries */
+    const MP4_Box_data_stts_t *p_stts;
+    const MP4_Box_data_ctts_t *p_ctts; /* could be NULL */
+    int64_t          i_cts_shift;
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
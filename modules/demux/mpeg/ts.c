@@ -44,6 +44,8 @@
 #include "ts_psip.h"
 
 #include "ts_hotfixes.h"
+#include "ts_index.h"
+#include "ts_fanout.h"
 #include "ts_sl.h"
 #include "ts_metadata.h"
 #include "sections.h"
@@ -114,6 +116,21 @@ static void Close ( vlc_object_t * );
     "Seek and position based on a percent byte position, not a PCR generated " \
     "time position. If seeking doesn't work property, turn on this option." )
 
+#define SEEK_INDEX_TEXT N_("Seek index")
+#define SEEK_INDEX_LONGTEXT N_( \
+    "Record the PCR and random access point positions of the programs " \
+    "while playing, and seek from them." )
+
+#define SEEK_INDEX_CACHE_TEXT N_("Keep the seek index")
+#define SEEK_INDEX_CACHE_LONGTEXT N_( \
+    "Save the seek index of local files in the user cache directory, " \
+    "and reuse it for later playbacks." )
+
+#define SEEK_INDEX_SCAN_TEXT N_("Build the seek index in the background")
+#define SEEK_INDEX_SCAN_LONGTEXT N_( \
+    "Scan the whole file for the seek index while playing. Only applies " \
+    "to inputs with fast seeking, such as local files." )
+
 #define CC_CHECK_TEXT       "Check packets continuity counter"
 #define CC_CHECK_LONGTEXT   "Detect discontinuities and drop packet duplicates. " \
                             "(bluRay sources are known broken and have false positives). "
@@ -126,6 +143,19 @@ static void Close ( vlc_object_t * );
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
+#define READ_BATCH_TEXT N_("Packets read at once")
+#define READ_BATCH_LONGTEXT N_( \
+    "Number of TS packets fetched from the stream with a single read. " \
+    "1 reads packets one by one (always the case in low delay mode)." )
+
+#define PROGRAM_THREADS_TEXT N_("Programs output threads")
+#define PROGRAM_THREADS_LONGTEXT N_( \
+    "Number of threads outputting the programs data, a program being " \
+    "always handled by the same thread. Useful when recording or streaming " \
+    "many programs of a multiplex at once. Only the reassembly and parsing " \
+    "of the PES run in parallel: the input serializes the sending to the " \
+    "decoders. 0 outputs everything from the input thread." )
+
 static const char *const ts_standards_list[] =
     { "auto", "mpeg", "dvb", "arib", "atsc", "tdmb" };
 static const char *const ts_standards_list_text[] =
@@ -157,12 +187,19 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT )
+    add_bool( "ts-seek-index", true, SEEK_INDEX_TEXT, SEEK_INDEX_LONGTEXT )
+    add_bool( "ts-seek-index-scan", false, SEEK_INDEX_SCAN_TEXT, SEEK_INDEX_SCAN_LONGTEXT )
+    add_bool( "ts-seek-index-cache", false, SEEK_INDEX_CACHE_TEXT, SEEK_INDEX_CACHE_LONGTEXT )
     add_bool( "ts-cc-check", true, CC_CHECK_TEXT, CC_CHECK_LONGTEXT )
     add_bool( "ts-pmtfix-waitdata", true, TS_SKIP_GHOST_PROGRAM_TEXT, NULL )
     add_bool( "ts-patfix", true, TS_PATFIX_TEXT, NULL )
     add_bool( "ts-pcr-offsetfix", true, TS_OFFSETFIX_TEXT, NULL )
     add_integer_with_range( "ts-generated-pcr-offset", 120, 0, 500,
                             TS_GENERATED_PCR_OFFSET_TEXT, NULL )
+    add_integer_with_range( "ts-read-batch", 32, 1, 1024,
+                            READ_BATCH_TEXT, READ_BATCH_LONGTEXT )
+    add_integer_with_range( "ts-program-threads", 0, 0, 64,
+                            PROGRAM_THREADS_TEXT, PROGRAM_THREADS_LONGTEXT )
 
     set_capability( "demux", 10 )
     set_callbacks( Open, Close )
@@ -194,10 +231,15 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static void FlushTSPackets( demux_sys_t *p_sys );
+static uint64_t TellTSPacket( demux_sys_t *p_sys );
+static int SeekTSPacket( demux_sys_t *p_sys, uint64_t i_pos );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
+static void SeekIndexPacket( demux_t *p_demux, ts_pid_t *, const block_t *, stime_t );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
+static void PESOutputHandle( vlc_object_t *, void *, block_t *, uint8_t, unsigned, int );
 
 #define TS_PACKET_SIZE_188 188
 #define TS_PACKET_SIZE_192 192
@@ -501,6 +543,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_canseek = false;
     p_sys->b_canfastseek = false;
     p_sys->b_lowdelay = var_InheritBool( p_demux, "low-delay" );
+    /* Batching can block until enough data is available, don't delay live */
+    p_sys->reader.i_batch = p_sys->b_lowdelay ? 1 :
+                            var_InheritInteger( p_demux, "ts-read-batch" );
     p_sys->b_ignore_time_for_positions = var_InheritBool( p_demux, "ts-seek-percent" );
     p_sys->b_cc_check = var_InheritBool( p_demux, "ts-cc-check" );
 
@@ -531,6 +576,30 @@ static int Open( vlc_object_t *p_this )
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
 
+    if( p_sys->b_canseek && !p_demux->b_preparsing &&
+        var_InheritBool( p_demux, "ts-seek-index" ) )
+    {
+        p_sys->seekindex.p_index = ts_index_New( VLC_OBJECT(p_demux) );
+        if( p_sys->seekindex.p_index )
+        {
+            if( var_InheritBool( p_demux, "ts-seek-index-cache" ) )
+                ts_index_OpenCache( p_sys->seekindex.p_index, p_demux->psz_filepath,
+                                    p_sys->i_packet_size );
+            p_sys->seekindex.b_scan = p_sys->b_canfastseek &&
+                                      !ts_index_IsComplete( p_sys->seekindex.p_index ) &&
+                                      var_InheritBool( p_demux, "ts-seek-index-scan" );
+        }
+    }
+
+    unsigned i_program_threads = var_InheritInteger( p_demux, "ts-program-threads" );
+    if( i_program_threads > 0 && p_demux->out && !p_demux->b_preparsing )
+    {
+        ts_fanout_output_callback cb = { .p_obj = VLC_OBJECT(p_demux),
+                                         .out = p_demux->out,
+                                         .pf_output = PESOutputHandle };
+        p_sys->p_fanout = ts_fanout_New( &cb, i_program_threads );
+    }
+
     if( !p_sys->b_access_control && var_CreateGetBool( p_demux, "ts-pmtfix-waitdata" ) )
         p_sys->es_creation = DELAY_ES;
     else
@@ -561,6 +630,13 @@ static void Close( vlc_object_t *p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    /* Sends the remaining data while the ES are still there */
+    if( p_sys->p_fanout )
+        ts_fanout_Delete( p_sys->p_fanout );
+
+    if( p_sys->seekindex.p_index )
+        ts_index_Delete( p_sys->seekindex.p_index );
+
     PIDRelease( p_demux, GetPID(p_sys, 0) );
 
     vlc_mutex_lock( &p_sys->csa_lock );
@@ -585,6 +661,8 @@ static void Close( vlc_object_t *p_this )
         p_sys->stream = p_demux->s;
     }
 
+    FlushTSPackets( p_sys );
+
     /* Release all non default pids */
     ts_pid_list_Release( p_demux, &p_sys->pids );
 
@@ -641,6 +719,8 @@ static int Demux( demux_t *p_demux )
         block_t     *p_pkt;
         if( !(p_pkt = ReadTSPacket( p_demux )) )
         {
+            /* Everything must be output before the decoders are drained */
+            ProgramsOutputSync( p_demux );
             return VLC_DEMUXER_EOF;
         }
 
@@ -679,6 +759,13 @@ static int Demux( demux_t *p_demux )
                 p_sys->b_valid_scrambling = true;
         }
 
+        if( p_pid->i_flags & FLAG_DROP )
+        {
+            /* Unselected ES without PCR, don't waste any time on it */
+            block_Release( p_pkt );
+            continue;
+        }
+
         /* Drop duplicates and invalid (DOES NOT drop corrupted) */
         p_pkt = ProcessTSPacket( p_demux, p_pid, p_pkt, &i_header );
         if( !p_pkt )
@@ -694,6 +781,9 @@ static int Demux( demux_t *p_demux )
         if( i_pcr >= 0 )
             PCRHandle( p_demux, p_pid, i_pcr );
 
+        if( p_sys->seekindex.p_index )
+            SeekIndexPacket( p_demux, p_pid, p_pkt, i_pcr );
+
         /* Probe streams to build PAT/PMT after MIN_PAT_INTERVAL in case we don't see any PAT */
         if( !SEEN( GetPID( p_sys, 0 ) ) &&
             (p_pkt->p_buffer[1] & 0xC0) == 0x40 && /* Payload start but not corrupt */
@@ -809,11 +899,33 @@ static inline void HasSelectedES( es_out_t *out, const ts_es_t *p_es,
     }
 }
 
+static bool PIDCarriesPCR( const ts_pat_t *p_pat, uint16_t i_pid )
+{
+    for( int i=0; i< p_pat->programs.i_size; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+        if( p_pmt->i_pid_pcr == i_pid ||
+           ( p_pmt->i_pid_pcr == 0x1FFF && PIDReferencedByProgram( p_pmt, i_pid ) ) )
+            return true;
+    }
+    return false;
+}
+
+void ProgramsOutputSync( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->p_fanout )
+        ts_fanout_Sync( p_sys->p_fanout );
+}
+
 void UpdatePESFilters( demux_t *p_demux, bool b_all )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
 
+    ProgramsOutputSync( p_demux );
+
     /* We need 3 pass to avoid loss on deselect/relesect with hw filters and
        because pid could be shared and its state altered by another unselected pmt
        First clear flag on every referenced pid
@@ -888,6 +1000,27 @@ void UpdatePESFilters( demux_t *p_demux, bool b_all )
         }
         UpdateHWFilter( p_sys, GetPID(p_sys, p_pmt->i_pid_pcr) );
     }
+
+    /* Flag unselected ES pids that can be dropped as soon as read */
+    for( int i=0; i< p_pat->programs.i_size; i++ )
+    {
+        ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+        for( int j=0; j< p_pmt->e_streams.i_size; j++ )
+        {
+            ts_pid_t *espid = p_pmt->e_streams.p_elems[j];
+            if( !p_sys->b_access_control && p_sys->es_creation == CREATE_ES &&
+                (espid->i_flags & FLAG_FILTERED) == 0 &&
+                !PIDCarriesPCR( p_pat, espid->i_pid ) )
+            {
+                espid->i_flags |= FLAG_DROP;
+            }
+            else if( espid->i_flags & FLAG_DROP )
+            {
+                espid->i_flags &= ~FLAG_DROP;
+                espid->i_cc = 0xff; /* CC was not tracked while dropping */
+            }
+        }
+    }
 }
 
 static int Control( demux_t *p_demux, int i_query, va_list args )
@@ -953,7 +1086,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         if( (i64 = stream_Size( p_sys->stream) ) > 0 )
         {
-            uint64_t offset = vlc_stream_Tell( p_sys->stream );
+            uint64_t offset = TellTSPacket( p_sys );
             *pf = (double)offset / (double)i64;
             return VLC_SUCCESS;
         }
@@ -1000,7 +1133,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         i64 = stream_Size( p_sys->stream );
         if( i64 > 0 &&
-            vlc_stream_Seek( p_sys->stream, (int64_t)(i64 * f) ) == VLC_SUCCESS )
+            SeekTSPacket( p_sys, (int64_t)(i64 * f) ) == VLC_SUCCESS )
         {
             ReadyQueuesPostSeek( p_demux );
             return VLC_SUCCESS;
@@ -1151,9 +1284,11 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     }
 
     case DEMUX_SET_TITLE:
+        FlushTSPackets( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_TITLE, args );
 
     case DEMUX_SET_SEEKPOINT:
+        FlushTSPackets( p_sys );
         return vlc_stream_vaControl( p_sys->stream, STREAM_SET_SEEKPOINT,
                                      args );
 
@@ -1380,6 +1515,32 @@ static vlc_tick_t GetTimeForUntimed( const ts_pmt_t *p_pmt )
     return i_ts;
 }
 
+/* Uses the program clock, so is done on the demux thread */
+static void FixTeletextTimestamps( const ts_es_t *p_es, block_t *p_block )
+{
+    const ts_pmt_t *p_pmt = p_es->p_program;
+    if( p_block->i_pts != VLC_TICK_INVALID &&
+        p_pmt->pcr.i_current > -1 )
+    {
+        /* Teletext can have totally offset timestamps... RAI1, German */
+        vlc_tick_t i_pcr = FROM_SCALE(TimeStampWrapAround( p_pmt->pcr.i_first,
+                                                           p_pmt->pcr.i_current ));
+        if( i_pcr < p_block->i_pts || i_pcr - p_block->i_pts > CLOCK_FREQ )
+            p_block->i_dts = p_block->i_pts = VLC_TICK_INVALID;
+    }
+    if( p_block->i_pts == VLC_TICK_INVALID )
+    {
+        /* Teletext may have missing PTS (ETSI EN 300 472 Annexe A)
+         * In this case use the last PCR + 40ms */
+        stime_t i_ts = GetTimeForUntimed( p_es->p_program );
+        if( SETANDVALID(i_ts) )
+        {
+            i_ts = TimeStampWrapAround( p_pmt->pcr.i_first, i_ts );
+            p_block->i_dts = p_block->i_pts = FROM_SCALE(i_ts) + VLC_TICK_FROM_MS(40);
+        }
+    }
+}
+
 static block_t * ConvertPESBlock( demux_t *p_demux, ts_es_t *p_es,
                                   size_t i_pes_size, uint8_t i_stream_id,
                                   block_t *p_block )
@@ -1398,30 +1559,6 @@ static block_t * ConvertPESBlock( demux_t *p_demux, ts_es_t *p_es,
         if( p_block )
             p_block->p_buffer[p_block->i_buffer -1] = '\0';
     }
-    else if( p_es->fmt.i_codec == VLC_CODEC_TELETEXT )
-    {
-        const ts_pmt_t *p_pmt = p_es->p_program;
-        if( p_block->i_pts != VLC_TICK_INVALID &&
-            p_pmt->pcr.i_current > -1 )
-        {
-            /* Teletext can have totally offset timestamps... RAI1, German */
-            vlc_tick_t i_pcr = FROM_SCALE(TimeStampWrapAround( p_pmt->pcr.i_first,
-                                                               p_pmt->pcr.i_current ));
-            if( i_pcr < p_block->i_pts || i_pcr - p_block->i_pts > CLOCK_FREQ )
-                p_block->i_dts = p_block->i_pts = VLC_TICK_INVALID;
-        }
-        if( p_block->i_pts == VLC_TICK_INVALID )
-        {
-            /* Teletext may have missing PTS (ETSI EN 300 472 Annexe A)
-             * In this case use the last PCR + 40ms */
-            stime_t i_ts = GetTimeForUntimed( p_es->p_program );
-            if( SETANDVALID(i_ts) )
-            {
-                i_ts = TimeStampWrapAround( p_pmt->pcr.i_first, i_ts );
-                p_block->i_dts = p_block->i_pts = FROM_SCALE(i_ts) + VLC_TICK_FROM_MS(40);
-            }
-        }
-    }
     else if( p_es->fmt.i_codec == VLC_CODEC_ARIB_A ||
              p_es->fmt.i_codec == VLC_CODEC_ARIB_C )
     {
@@ -1477,10 +1614,10 @@ static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
             p_block->i_flags |= BLOCK_FLAG_AU_END;
 
         ts_es_t *p_es_send = p_es;
-        if( p_es_send->i_next_block_flags )
+        if( p_es_send->i_output_block_flags )
         {
-            p_block->i_flags |= p_es_send->i_next_block_flags;
-            p_es_send->i_next_block_flags = 0;
+            p_block->i_flags |= p_es_send->i_output_block_flags;
+            p_es_send->i_output_block_flags = 0;
         }
 
         while( p_es_send )
@@ -1526,6 +1663,49 @@ static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
     }
 }
 
+/* Whether the stream data is also sent to ES of other programs */
+static bool PESIsShared( const ts_es_t *p_es )
+{
+    if( p_es->p_next )
+        return true;
+    for( const ts_es_t *p_extra = p_es->p_extraes; p_extra; p_extra = p_extra->p_next )
+    {
+        if( p_extra->p_program != p_es->p_program )
+            return true;
+    }
+    return false;
+}
+
+/****************************************************************************
+ * Converts and sends a timestamped PES block. Only uses the stream state,
+ * as it runs from the program output thread when enabled.
+ ****************************************************************************/
+static void OutputPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_block,
+                            uint8_t i_stream_id, unsigned i_pes_size, int i_block_flags )
+{
+    ts_es_t *p_es = pid->u.p_stream->p_es;
+
+    /* Set on the first block sent, as the conversion can hold or merge
+     * blocks, and not seen by the stream processor */
+    p_es->i_output_block_flags |= i_block_flags;
+
+    /*** From here, block can become a chain again though conversion below ***/
+
+    if( pid->u.p_stream->p_proc )
+    {
+        if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
+            ts_stream_processor_Reset( pid->u.p_stream->p_proc );
+        p_block = ts_stream_processor_Push( pid->u.p_stream->p_proc, i_stream_id, p_block );
+    }
+    else
+    /* Some codecs might need xform or AU splitting */
+    {
+        p_block = ConvertPESBlock( p_demux, p_es, i_pes_size, i_stream_id, p_block );
+    }
+
+    SendDataChain( p_demux, p_es, p_block );
+}
+
 /****************************************************************************
  * gathering stuff
  ****************************************************************************/
@@ -1722,21 +1902,26 @@ static void ParsePESDataChain( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes,
                         p_block->i_pts += FROM_SCALE_NZ(p_pmt->pcr.i_pcroffset);
                 }
 
-                /*** From here, block can become a chain again though conversion below ***/
+                /* Pending discontinuities from the gathering or seeking */
+                int i_block_flags = p_es->i_next_block_flags;
+                p_es->i_next_block_flags = 0;
+
+                if( p_es->fmt.i_codec == VLC_CODEC_TELETEXT )
+                    FixTeletextTimestamps( p_es, p_block );
 
-                if( pid->u.p_stream->p_proc )
+                if( p_sys->p_fanout && !PESIsShared( p_es ) )
                 {
-                    if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
-                        ts_stream_processor_Reset( pid->u.p_stream->p_proc );
-                    p_block = ts_stream_processor_Push( pid->u.p_stream->p_proc, i_stream_id, p_block );
+                    ts_fanout_Output( p_sys->p_fanout, p_pmt->i_number, pid,
+                                      p_block, i_stream_id, i_pes_size, i_block_flags );
                 }
                 else
-                /* Some codecs might need xform or AU splitting */
                 {
-                    p_block = ConvertPESBlock( p_demux, p_es, i_pes_size, i_stream_id, p_block );
+                    /* A shared PID also feeds other programs, whose threads
+                     * must have output their earlier data first */
+                    ProgramsOutputSync( p_demux );
+                    OutputPESBlock( p_demux, pid, p_block, i_stream_id, i_pes_size,
+                                    i_block_flags );
                 }
-
-                SendDataChain( p_demux, p_es, p_block );
             }
             else
             {
@@ -1766,6 +1951,156 @@ static void PESDataChainHandle( vlc_object_t *p_obj, void *priv, block_t *p_data
     ParsePESDataChain( (demux_t *)p_obj, (ts_pid_t *) priv, p_data, i_appendpcr );
 }
 
+static void PESOutputHandle( vlc_object_t *p_obj, void *priv, block_t *p_block,
+                             uint8_t i_stream_id, unsigned i_pes_size, int i_block_flags )
+{
+    OutputPESBlock( (demux_t *)p_obj, (ts_pid_t *) priv, p_block, i_stream_id, i_pes_size,
+                    i_block_flags );
+}
+
+/*****************************************************************************
+ * Batched packet reading:
+ *  A slab holds a run of consecutive packets read with a single stream call,
+ *  and the block headers used to hand them out. Each packet view holds a
+ *  reference to the slab, which is freed when the last view is released.
+ *  The packets data is the block returned by the stream, which is not copied
+ *  if the stream can slice it out of its own buffers (e.g. mapped files).
+ *****************************************************************************/
+typedef struct
+{
+    block_t self;
+    ts_packet_slab_t *p_slab;
+} ts_packet_view_t;
+
+struct ts_packet_slab_t
+{
+    vlc_atomic_rc_t rc;
+    unsigned i_count;
+    unsigned i_packet_size;
+    uint8_t *p_data;
+    block_t *p_source;
+    ts_packet_view_t views[];
+};
+
+static void TSPacketSlabRelease( ts_packet_slab_t *p_slab )
+{
+    if( vlc_atomic_rc_dec( &p_slab->rc ) )
+    {
+        block_Release( p_slab->p_source );
+        free( p_slab );
+    }
+}
+
+static void TSPacketViewRelease( block_t *p_block )
+{
+    ts_packet_view_t *p_view = container_of( p_block, ts_packet_view_t, self );
+    TSPacketSlabRelease( p_view->p_slab );
+}
+
+static const struct vlc_block_callbacks ts_packet_view_cbs =
+{
+    TSPacketViewRelease,
+};
+
+static ts_packet_slab_t * TSPacketSlabNew( block_t *p_source, unsigned i_count,
+                                            unsigned i_packet_size )
+{
+    ts_packet_slab_t *p_slab = malloc( sizeof(ts_packet_slab_t) +
+                                       sizeof(ts_packet_view_t) * i_count );
+    if( unlikely(!p_slab) )
+        return NULL;
+    vlc_atomic_rc_init( &p_slab->rc );
+    p_slab->i_count = i_count;
+    p_slab->i_packet_size = i_packet_size;
+    p_slab->p_data = p_source->p_buffer;
+    p_slab->p_source = p_source;
+    return p_slab;
+}
+
+static block_t * TSPacketSlabGet( ts_packet_slab_t *p_slab, unsigned i )
+{
+    ts_packet_view_t *p_view = &p_slab->views[i];
+    p_view->p_slab = p_slab;
+    vlc_atomic_rc_inc( &p_slab->rc );
+    return block_Init( &p_view->self, &ts_packet_view_cbs,
+                       &p_slab->p_data[i * p_slab->i_packet_size],
+                       p_slab->i_packet_size );
+}
+
+/* Drops the packets read ahead but not handed out yet */
+static void FlushTSPackets( demux_sys_t *p_sys )
+{
+    if( p_sys->reader.p_slab )
+    {
+        TSPacketSlabRelease( p_sys->reader.p_slab );
+        p_sys->reader.p_slab = NULL;
+    }
+    p_sys->reader.i_next = 0;
+}
+
+/* Stream position of the next packet ReadTSPacket() will return */
+static uint64_t TellTSPacket( demux_sys_t *p_sys )
+{
+    uint64_t i_pos = vlc_stream_Tell( p_sys->stream );
+    const ts_packet_slab_t *p_slab = p_sys->reader.p_slab;
+    if( p_slab )
+        i_pos -= (uint64_t)(p_slab->i_count - p_sys->reader.i_next) * p_slab->i_packet_size;
+    return i_pos;
+}
+
+static int SeekTSPacket( demux_sys_t *p_sys, uint64_t i_pos )
+{
+    FlushTSPackets( p_sys );
+    return vlc_stream_Seek( p_sys->stream, i_pos );
+}
+
+static block_t * ReadTSPacketBatched( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->reader.p_slab &&
+        p_sys->reader.i_next < p_sys->reader.p_slab->i_count )
+        return TSPacketSlabGet( p_sys->reader.p_slab, p_sys->reader.i_next++ );
+
+    FlushTSPackets( p_sys );
+
+    /* Only batch the run of packets that are in sync: the first unsynced
+     * one, EOF and short reads are left to the single packet path. */
+    const uint8_t *p_peek;
+    ssize_t i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
+                                      p_sys->i_packet_size * p_sys->reader.i_batch );
+    if( i_peek < 0 )
+        i_peek = 0;
+    unsigned i_count = 0;
+    while( (size_t) i_peek >= (i_count + 1) * p_sys->i_packet_size &&
+           p_peek[i_count * p_sys->i_packet_size + p_sys->i_packet_header_size] == 0x47 )
+        i_count++;
+
+    if( i_count < 2 )
+        return vlc_stream_Block( p_sys->stream, p_sys->i_packet_size );
+
+    const size_t i_read = (size_t) i_count * p_sys->i_packet_size;
+    block_t *p_source = vlc_stream_Block( p_sys->stream, i_read );
+    if( !p_source )
+        return NULL;
+    if( p_source->i_buffer != i_read )
+    {
+        block_Release( p_source );
+        return NULL;
+    }
+
+    ts_packet_slab_t *p_slab = TSPacketSlabNew( p_source, i_count, p_sys->i_packet_size );
+    if( unlikely(!p_slab) )
+    {
+        block_Release( p_source );
+        return NULL;
+    }
+
+    p_sys->reader.p_slab = p_slab;
+    p_sys->reader.i_next = 1;
+    return TSPacketSlabGet( p_slab, 0 );
+}
+
 static block_t* ReadTSPacket( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -1773,7 +2108,12 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     block_t     *p_pkt;
 
     /* Get a new TS packet */
-    if( !( p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size ) ) )
+    if( p_sys->reader.i_batch > 1 )
+        p_pkt = ReadTSPacketBatched( p_demux );
+    else
+        p_pkt = vlc_stream_Block( p_sys->stream, p_sys->i_packet_size );
+
+    if( !p_pkt )
     {
         int64_t size = stream_Size( p_sys->stream );
         if( size >= 0 && (uint64_t)size == vlc_stream_Tell( p_sys->stream ) )
@@ -1916,6 +2256,8 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    ProgramsOutputSync( p_demux );
+
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
     for( int i=0; i< p_pat->programs.i_size; i++ )
     {
@@ -1957,13 +2299,20 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
 
     /* Deal with common but worst binary search case */
     if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
+        return SeekTSPacket( p_sys, 0 );
+
+    /* Served from the index, any seekable input will do */
+    uint64_t i_index_pos;
+    if( p_sys->seekindex.p_index &&
+        ts_index_Find( p_sys->seekindex.p_index, p_pmt->i_number, i_scaledtime, &i_index_pos ) &&
+        SeekTSPacket( p_sys, i_index_pos ) == VLC_SUCCESS )
+        return VLC_SUCCESS;
 
     const int64_t i_stream_size = stream_Size( p_sys->stream );
     if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
         return VLC_EGENERIC;
 
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellTSPacket( p_sys );
 
     /* Find the time position by using binary search algorithm. */
     uint64_t i_head_pos = 0;
@@ -1979,7 +2328,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
         uint64_t i_div = i_splitpos % p_sys->i_packet_size;
         i_splitpos -= i_div;
 
-        if ( vlc_stream_Seek( p_sys->stream, i_splitpos ) != VLC_SUCCESS )
+        if ( SeekTSPacket( p_sys, i_splitpos ) != VLC_SUCCESS )
             break;
 
         uint64_t i_pos = i_splitpos;
@@ -1993,7 +2342,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
                 break;
             }
             else
-                i_pos = vlc_stream_Tell( p_sys->stream );
+                i_pos = TellTSPacket( p_sys );
 
             int i_pid = PIDGet( p_pkt );
             ts_pid_t *p_pid = GetPID(p_sys, i_pid);
@@ -2050,7 +2399,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
-        if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) != VLC_SUCCESS )
+        if( SeekTSPacket( p_sys, i_initial_pos ) != VLC_SUCCESS )
             msg_Err( p_demux, "Can't seek back to %" PRIu64, i_initial_pos );
         return VLC_EGENERIC;
     }
@@ -2136,7 +2485,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
                         if( b_end )
                         {
                             p_pmt->i_last_dts = i_pcr;
-                            p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                            p_pmt->i_last_dts_byte = TellTSPacket( p_sys );
                         }
                         /* Start, only keep first */
                         else if( b_pcrresult && p_pmt->pcr.i_first == -1 )
@@ -2164,7 +2513,7 @@ static int ProbeChunk( demux_t *p_demux, int i_program, bool b_end, bool *pb_fou
 int ProbeStart( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellTSPacket( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = 0;
@@ -2176,7 +2525,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
         i_pos = (int64_t)p_sys->i_packet_size * i_probe_count;
         i_pos = __MIN( i_pos, i_stream_size );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( SeekTSPacket( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count =  ProbeChunk( p_demux, i_program, false, &b_found );
@@ -2188,7 +2537,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
     } while( i_pos < i_stream_size && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( SeekTSPacket( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2197,7 +2546,7 @@ int ProbeStart( demux_t *p_demux, int i_program )
 int ProbeEnd( demux_t *p_demux, int i_program )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+    const uint64_t i_initial_pos = TellTSPacket( p_sys );
     int64_t i_stream_size = stream_Size( p_sys->stream );
 
     int i_probe_count = PROBE_CHUNK_COUNT;
@@ -2209,7 +2558,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
         i_pos = i_stream_size - (p_sys->i_packet_size * i_probe_count);
         i_pos = __MAX( i_pos, 0 );
 
-        if( vlc_stream_Seek( p_sys->stream, i_pos ) )
+        if( SeekTSPacket( p_sys, i_pos ) )
             return VLC_EGENERIC;
 
         int i_count = ProbeChunk( p_demux, i_program, true, &b_found );
@@ -2221,7 +2570,7 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     } while( i_pos > 0 && !b_found &&
              i_probe_count < PROBE_MAX );
 
-    if( vlc_stream_Seek( p_sys->stream, i_initial_pos ) )
+    if( SeekTSPacket( p_sys, i_initial_pos ) )
         return VLC_EGENERIC;
 
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
@@ -2273,17 +2622,21 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
 
     if ( p_sys->i_pmt_es )
     {
-        es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
+        /* Ordered with the program data */
+        if( p_sys->p_fanout )
+            ts_fanout_SetPCR( p_sys->p_fanout, p_pmt->i_number, FROM_SCALE(i_pcr) );
+        else
+            es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            TellTSPacket( p_sys ) > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = TellTSPacket( p_sys );
             }
         }
     }
@@ -2420,6 +2773,91 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
     }
 }
 
+/* Starts the background scan once the programs time references are known */
+static void SeekIndexStartScan( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
+    bool b_ready = true;
+    bool b_late = false;
+
+    for( int i = 0; i < p_pat->programs.i_size; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+        if( p_pmt->pcr.b_disable )
+            continue;
+        if( p_pmt->pcr.i_first == -1 )
+            b_ready = false;
+        else if( p_pmt->pcr.i_current - p_pmt->pcr.i_first > TS_INDEX_MAX_GAP )
+            b_late = true; /* don't wait forever for ghost programs */
+    }
+
+    if( !b_ready && !b_late )
+        return;
+
+    p_sys->seekindex.b_scan = false;
+
+    ts_index_t *p_index = p_sys->seekindex.p_index;
+    for( int i = 0; i < p_pat->programs.i_size; i++ )
+    {
+        const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+        if( p_pmt->pcr.b_disable || p_pmt->pcr.i_first == -1 )
+            continue;
+        ts_index_ScanProgram( p_index, p_pmt->i_number, p_pmt->i_pid_pcr, p_pmt->pcr.i_first );
+        for( int j = 0; j < p_pmt->e_streams.i_size; j++ )
+            ts_index_ScanPID( p_index, p_pmt->e_streams.p_elems[j]->i_pid, p_pmt->i_number );
+    }
+
+    if( ts_index_ScanStart( p_index, p_demux->psz_url, p_sys->i_packet_size,
+                            p_sys->i_packet_header_size ) != VLC_SUCCESS )
+        msg_Warn( p_demux, "cannot start the seek index scan" );
+}
+
+/* Records PCR and random access points positions into the seek index */
+static void SeekIndexPacket( demux_t *p_demux, ts_pid_t *p_pid, const block_t *p_pkt, stime_t i_pcr )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint8_t *p = p_pkt->p_buffer;
+
+    if( p_sys->i_pmt_es <= 0 || GetPID(p_sys, 0)->type != TYPE_PAT )
+        return;
+
+    const bool b_rap = p_pid->type == TYPE_STREAM &&
+                       (p[3] & 0x20) && p[4] > 0 && (p[5] & 0x40); /* random_access_indicator */
+    if( i_pcr < 0 && !b_rap )
+        return;
+
+    const uint64_t i_pos = TellTSPacket( p_sys ) - p_sys->i_packet_size;
+
+    if( i_pcr >= 0 )
+    {
+        ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
+        for( int i = 0; i < p_pat->programs.i_size; i++ )
+        {
+            const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+            if( p_pmt->i_pid_pcr == p_pid->i_pid && !p_pmt->pcr.b_disable &&
+                p_pmt->pcr.i_first != -1 )
+                ts_index_Add( p_sys->seekindex.p_index, p_pmt->i_number, i_pos,
+                              TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr ), false );
+        }
+
+        if( p_sys->seekindex.b_scan )
+            SeekIndexStartScan( p_demux );
+    }
+
+    if( b_rap )
+    {
+        for( const ts_es_t *p_es = p_pid->u.p_stream->p_es; p_es; p_es = p_es->p_next )
+        {
+            const ts_pmt_t *p_pmt = p_es->p_program;
+            if( p_pmt && p_pmt->pcr.i_current != -1 && p_pmt->pcr.i_first != -1 )
+                ts_index_Add( p_sys->seekindex.p_index, p_pmt->i_number, i_pos,
+                              TimeStampWrapAround( p_pmt->pcr.i_first, p_pmt->pcr.i_current ),
+                              true );
+        }
+    }
+}
+
 int FindPCRCandidate( ts_pmt_t *p_pmt )
 {
     ts_pid_t *p_cand = NULL;
@@ -2734,6 +3172,8 @@ void AddAndCreateES( demux_t *p_demux, ts_pid_t *pid, bool b_create_delayed )
 {
     demux_sys_t  *p_sys = p_demux->p_sys;
 
+    ProgramsOutputSync( p_demux );
+
     if( b_create_delayed )
         p_sys->es_creation = CREATE_ES;
 
@@ -24,6 +24,9 @@
     typedef struct arib_instance_t arib_instance_t;
 #endif
 typedef struct csa_t csa_t;
+typedef struct ts_packet_slab_t ts_packet_slab_t;
+typedef struct ts_index_t ts_index_t;
+typedef struct ts_fanout_t ts_fanout_t;
 
 #define TS_USER_PMT_NUMBER (0)
 
@@ -71,9 +74,28 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Batched packet reads: packets are read i_batch at a time into a
+     * single slab, and handed out as views over it */
+    struct
+    {
+        ts_packet_slab_t *p_slab;
+        unsigned    i_next;
+        unsigned    i_batch;
+    } reader;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
+    /* PCR/random access point seek index */
+    struct
+    {
+        ts_index_t *p_index;
+        bool        b_scan; /* background scan still to be started */
+    } seekindex;
+
+    /* Per program output threads, NULL when outputting from the demux thread */
+    ts_fanout_t *p_fanout;
+
     ts_standards_e standard;
 
 #ifdef HAVE_ARIBB24
@@ -149,6 +171,8 @@ void TsChangeStandard( demux_sys_t *, ts_standards_e );
 bool ProgramIsSelected( demux_sys_t *, uint16_t i_pgrm );
 
 void UpdatePESFilters( demux_t *p_demux, bool b_all );
+/* Waits for the programs output threads before changing the streams */
+void ProgramsOutputSync( demux_t *p_demux );
 
 int ProbeStart( demux_t *p_demux, int i_program );
 int ProbeEnd( demux_t *p_demux, int i_program );
@@ -0,0 +1,285 @@
+/*****************************************************************************
+ * ts_fanout.c: Transport Stream per program output threads
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_es_out.h>
+
+#include "ts_fanout.h"
+
+/* Items queued per thread before the demux thread has to wait */
+#define TS_FANOUT_MAX_QUEUED 256
+
+typedef struct ts_fanout_item_t ts_fanout_item_t;
+struct ts_fanout_item_t
+{
+    ts_fanout_item_t *p_next;
+    block_t *p_block; /* NULL for a PCR update */
+    void *priv;
+    uint8_t i_stream_id;
+    unsigned i_pes_size;
+    int i_block_flags;
+    int i_program;
+    vlc_tick_t i_pcr;
+};
+
+typedef struct
+{
+    ts_fanout_t *p_fanout;
+    vlc_thread_t thread;
+    bool b_running;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /* queued items or exit */
+    vlc_cond_t done; /* item output */
+    ts_fanout_item_t *p_first;
+    ts_fanout_item_t **pp_last;
+    unsigned i_queued;
+    bool b_busy;
+    bool b_exit;
+} ts_fanout_worker_t;
+
+typedef struct
+{
+    int i_program;
+    unsigned i_worker;
+} ts_fanout_program_t;
+
+struct ts_fanout_t
+{
+    ts_fanout_output_callback cb;
+
+    /* demux thread only */
+    DECL_ARRAY(ts_fanout_program_t) programs;
+    unsigned i_next_worker;
+
+    unsigned i_workers;
+    ts_fanout_worker_t workers[];
+};
+
+static void OutputItem( ts_fanout_t *p_fanout, ts_fanout_item_t *p_item )
+{
+    if( p_item->p_block )
+        p_fanout->cb.pf_output( p_fanout->cb.p_obj, p_item->priv, p_item->p_block,
+                                p_item->i_stream_id, p_item->i_pes_size,
+                                p_item->i_block_flags );
+    else
+        es_out_Control( p_fanout->cb.out, ES_OUT_SET_GROUP_PCR,
+                        p_item->i_program, p_item->i_pcr );
+    free( p_item );
+}
+
+static void *WorkerThread( void *data )
+{
+    ts_fanout_worker_t *p_worker = data;
+
+    vlc_mutex_lock( &p_worker->lock );
+    for( ;; )
+    {
+        while( !p_worker->p_first && !p_worker->b_exit )
+            vlc_cond_wait( &p_worker->wait, &p_worker->lock );
+
+        /* Whatever was queued is output before exiting */
+        ts_fanout_item_t *p_item = p_worker->p_first;
+        if( !p_item )
+            break;
+
+        p_worker->p_first = p_item->p_next;
+        if( !p_worker->p_first )
+            p_worker->pp_last = &p_worker->p_first;
+        p_worker->i_queued--;
+        p_worker->b_busy = true;
+        vlc_mutex_unlock( &p_worker->lock );
+
+        OutputItem( p_worker->p_fanout, p_item );
+
+        vlc_mutex_lock( &p_worker->lock );
+        p_worker->b_busy = false;
+        vlc_cond_signal( &p_worker->done );
+    }
+    vlc_mutex_unlock( &p_worker->lock );
+
+    return NULL;
+}
+
+ts_fanout_t * ts_fanout_New( const ts_fanout_output_callback *cb, unsigned i_threads )
+{
+    if( i_threads == 0 )
+        return NULL;
+
+    ts_fanout_t *p_fanout = malloc( sizeof(*p_fanout) +
+                                    i_threads * sizeof(ts_fanout_worker_t) );
+    if( !p_fanout )
+        return NULL;
+
+    p_fanout->cb = *cb;
+    ARRAY_INIT( p_fanout->programs );
+    p_fanout->i_next_worker = 0;
+    p_fanout->i_workers = i_threads;
+
+    for( unsigned i = 0; i < i_threads; i++ )
+    {
+        ts_fanout_worker_t *p_worker = &p_fanout->workers[i];
+        p_worker->p_fanout = p_fanout;
+        p_worker->b_running = false;
+        vlc_mutex_init( &p_worker->lock );
+        vlc_cond_init( &p_worker->wait );
+        vlc_cond_init( &p_worker->done );
+        p_worker->p_first = NULL;
+        p_worker->pp_last = &p_worker->p_first;
+        p_worker->i_queued = 0;
+        p_worker->b_busy = false;
+        p_worker->b_exit = false;
+    }
+
+    return p_fanout;
+}
+
+void ts_fanout_Delete( ts_fanout_t *p_fanout )
+{
+    for( unsigned i = 0; i < p_fanout->i_workers; i++ )
+    {
+        ts_fanout_worker_t *p_worker = &p_fanout->workers[i];
+        if( !p_worker->b_running )
+            continue;
+
+        vlc_mutex_lock( &p_worker->lock );
+        p_worker->b_exit = true;
+        vlc_cond_signal( &p_worker->wait );
+        vlc_mutex_unlock( &p_worker->lock );
+
+        vlc_join( p_worker->thread, NULL );
+    }
+
+    ARRAY_RESET( p_fanout->programs );
+    free( p_fanout );
+}
+
+/* Programs are spread over the threads in the order they start sending,
+ * threads being only started when first needed */
+static ts_fanout_worker_t * GetWorker( ts_fanout_t *p_fanout, int i_program )
+{
+    unsigned i_worker = p_fanout->i_workers;
+
+    ts_fanout_program_t prog;
+    ARRAY_FOREACH( prog, p_fanout->programs )
+    {
+        if( prog.i_program == i_program )
+        {
+            i_worker = prog.i_worker;
+            break;
+        }
+    }
+
+    if( i_worker == p_fanout->i_workers )
+    {
+        i_worker = p_fanout->i_next_worker;
+        ts_fanout_program_t newprog = { .i_program = i_program, .i_worker = i_worker };
+        ARRAY_APPEND( p_fanout->programs, newprog );
+        p_fanout->i_next_worker = (i_worker + 1) % p_fanout->i_workers;
+    }
+
+    ts_fanout_worker_t *p_worker = &p_fanout->workers[i_worker];
+    if( !p_worker->b_running )
+    {
+        if( vlc_clone( &p_worker->thread, WorkerThread, p_worker,
+                       VLC_THREAD_PRIORITY_INPUT ) )
+            return NULL;
+        p_worker->b_running = true;
+    }
+
+    return p_worker;
+}
+
+static void Queue( ts_fanout_t *p_fanout, ts_fanout_item_t *p_item )
+{
+    ts_fanout_worker_t *p_worker = GetWorker( p_fanout, p_item->i_program );
+    if( unlikely(!p_worker) )
+    {
+        /* Can't spawn, output from the demux thread */
+        OutputItem( p_fanout, p_item );
+        return;
+    }
+
+    p_item->p_next = NULL;
+
+    vlc_mutex_lock( &p_worker->lock );
+    while( p_worker->i_queued >= TS_FANOUT_MAX_QUEUED )
+        vlc_cond_wait( &p_worker->done, &p_worker->lock );
+    *p_worker->pp_last = p_item;
+    p_worker->pp_last = &p_item->p_next;
+    p_worker->i_queued++;
+    vlc_cond_signal( &p_worker->wait );
+    vlc_mutex_unlock( &p_worker->lock );
+}
+
+void ts_fanout_Output( ts_fanout_t *p_fanout, int i_program, void *priv, block_t *p_block,
+                       uint8_t i_stream_id, unsigned i_pes_size, int i_block_flags )
+{
+    ts_fanout_item_t *p_item = malloc( sizeof(*p_item) );
+    if( unlikely(!p_item) )
+    {
+        block_ChainRelease( p_block );
+        return;
+    }
+
+    p_item->p_block = p_block;
+    p_item->priv = priv;
+    p_item->i_stream_id = i_stream_id;
+    p_item->i_pes_size = i_pes_size;
+    p_item->i_block_flags = i_block_flags;
+    p_item->i_program = i_program;
+    p_item->i_pcr = VLC_TICK_INVALID;
+    Queue( p_fanout, p_item );
+}
+
+void ts_fanout_SetPCR( ts_fanout_t *p_fanout, int i_program, vlc_tick_t i_pcr )
+{
+    ts_fanout_item_t *p_item = malloc( sizeof(*p_item) );
+    if( unlikely(!p_item) )
+        return;
+
+    p_item->p_block = NULL;
+    p_item->priv = NULL;
+    p_item->i_stream_id = 0;
+    p_item->i_pes_size = 0;
+    p_item->i_block_flags = 0;
+    p_item->i_program = i_program;
+    p_item->i_pcr = i_pcr;
+    Queue( p_fanout, p_item );
+}
+
+void ts_fanout_Sync( ts_fanout_t *p_fanout )
+{
+    for( unsigned i = 0; i < p_fanout->i_workers; i++ )
+    {
+        ts_fanout_worker_t *p_worker = &p_fanout->workers[i];
+        if( !p_worker->b_running )
+            continue;
+
+        vlc_mutex_lock( &p_worker->lock );
+        while( p_worker->p_first || p_worker->b_busy )
+            vlc_cond_wait( &p_worker->done, &p_worker->lock );
+        vlc_mutex_unlock( &p_worker->lock );
+    }
+}
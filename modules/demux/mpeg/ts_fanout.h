@@ -0,0 +1,48 @@
+/*****************************************************************************
+ * ts_fanout.h: Transport Stream per program output threads
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_TS_FANOUT_H
+#define VLC_TS_FANOUT_H
+
+typedef struct ts_fanout_t ts_fanout_t;
+
+typedef struct
+{
+    vlc_object_t *p_obj;
+    es_out_t *out;
+    void(*pf_output)(vlc_object_t *, void *, block_t *, uint8_t, unsigned, int);
+} ts_fanout_output_callback;
+
+/* Runs the output of the programs in up to i_threads threads, a program
+ * being always handled by the same thread. PES blocks and PCR updates of a
+ * program are output in the order they were queued.
+ * All the calls are made from the demux thread. */
+ts_fanout_t * ts_fanout_New( const ts_fanout_output_callback *, unsigned i_threads );
+/* Outputs all queued data, then stops the threads */
+void ts_fanout_Delete( ts_fanout_t * );
+
+void ts_fanout_Output( ts_fanout_t *, int i_program, void *priv, block_t *,
+                       uint8_t i_stream_id, unsigned i_pes_size, int i_block_flags );
+void ts_fanout_SetPCR( ts_fanout_t *, int i_program, vlc_tick_t i_pcr );
+
+/* Waits until all queued data has been output. Must be called before
+ * changing or deleting any state used by the output callback. */
+void ts_fanout_Sync( ts_fanout_t * );
+
+#endif
@@ -0,0 +1,549 @@
+/*****************************************************************************
+ * ts_index.c : MPEG TS PCR/random access point seek index
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+
+#include "../seekindex_cache.h"
+#include "timestamps.h"
+#include "ts_index.h"
+
+#include <stdatomic.h>
+#include <assert.h>
+
+#define TS_INDEX_SCAN_PACKETS   1024
+#define TS_INDEX_MAX_PROGRAMS   255
+
+#define TS_INDEX_CACHE_MAGIC    "TSIX"
+#define TS_INDEX_CACHE_VERSION  1
+#define TS_INDEX_CACHE_MAX_SIZE (256 << 20)
+
+typedef struct
+{
+    uint64_t i_pos;
+    stime_t  i_time;
+    bool     b_rap;
+} ts_index_entry_t;
+
+typedef struct
+{
+    int i_number;
+    ts_index_entry_t *p_entries;
+    size_t i_entries;
+    size_t i_alloc;
+} ts_index_program_t;
+
+typedef struct
+{
+    int     i_number;
+    int     i_pcr_pid;
+    stime_t i_first;
+    stime_t i_last; /* last PCR met by the scanner */
+} ts_index_scan_program_t;
+
+struct ts_index_t
+{
+    vlc_object_t *p_obj;
+
+    vlc_mutex_t lock;
+    DECL_ARRAY(ts_index_program_t *) programs;
+    bool b_complete; /* the whole file has been scanned */
+    bool b_dirty;
+
+    seekindex_cache_t cache;
+    unsigned i_packet_size;
+
+    struct
+    {
+        stream_t *s;
+        vlc_thread_t thread;
+        bool b_running;
+        atomic_bool b_abort;
+        unsigned i_packet_size;
+        unsigned i_packet_header_size;
+        ts_index_scan_program_t programs[TS_INDEX_MAX_PROGRAMS];
+        unsigned i_programs;
+        uint8_t pid_program[8192]; /* 1 based index in programs */
+    } scan;
+};
+
+static void SaveCache( ts_index_t * );
+
+ts_index_t * ts_index_New( vlc_object_t *p_obj )
+{
+    ts_index_t *p_index = calloc( 1, sizeof(*p_index) );
+    if( !p_index )
+        return NULL;
+    p_index->p_obj = p_obj;
+    vlc_mutex_init( &p_index->lock );
+    ARRAY_INIT( p_index->programs );
+    atomic_init( &p_index->scan.b_abort, false );
+    return p_index;
+}
+
+void ts_index_Delete( ts_index_t *p_index )
+{
+    if( p_index->scan.b_running )
+    {
+        atomic_store( &p_index->scan.b_abort, true );
+        vlc_join( p_index->scan.thread, NULL );
+        vlc_stream_Delete( p_index->scan.s );
+    }
+
+    if( p_index->cache.psz_path && p_index->b_dirty )
+        SaveCache( p_index );
+    seekindex_cache_Clean( &p_index->cache );
+
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+    {
+        free( p_index->programs.p_elems[i]->p_entries );
+        free( p_index->programs.p_elems[i] );
+    }
+    ARRAY_RESET( p_index->programs );
+    free( p_index );
+}
+
+static ts_index_program_t * GetProgram( ts_index_t *p_index, int i_number, bool b_create )
+{
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+    {
+        if( p_index->programs.p_elems[i]->i_number == i_number )
+            return p_index->programs.p_elems[i];
+    }
+
+    if( !b_create )
+        return NULL;
+
+    ts_index_program_t *p_prog = calloc( 1, sizeof(*p_prog) );
+    if( p_prog )
+    {
+        p_prog->i_number = i_number;
+        ARRAY_APPEND( p_index->programs, p_prog );
+    }
+    return p_prog;
+}
+
+/* first entry after i_pos */
+static size_t UpperBoundPos( const ts_index_program_t *p_prog, uint64_t i_pos )
+{
+    size_t i_lo = 0, i_hi = p_prog->i_entries;
+    while( i_lo < i_hi )
+    {
+        size_t i_mid = i_lo + (i_hi - i_lo) / 2;
+        if( p_prog->p_entries[i_mid].i_pos <= i_pos )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+    return i_lo;
+}
+
+static bool ProgramInsert( ts_index_program_t *p_prog, size_t i, const ts_index_entry_t *p_entry )
+{
+    if( p_prog->i_entries == p_prog->i_alloc )
+    {
+        size_t i_alloc = p_prog->i_alloc ? p_prog->i_alloc * 2 : 256;
+        ts_index_entry_t *p_realloc = realloc( p_prog->p_entries,
+                                               i_alloc * sizeof(*p_realloc) );
+        if( !p_realloc )
+            return false;
+        p_prog->p_entries = p_realloc;
+        p_prog->i_alloc = i_alloc;
+    }
+    memmove( &p_prog->p_entries[i + 1], &p_prog->p_entries[i],
+             (p_prog->i_entries - i) * sizeof(*p_entry) );
+    p_prog->p_entries[i] = *p_entry;
+    p_prog->i_entries++;
+    return true;
+}
+
+static void AddLocked( ts_index_t *p_index, int i_program,
+                       uint64_t i_pos, stime_t i_time, bool b_rap )
+{
+    ts_index_program_t *p_prog = GetProgram( p_index, i_program, true );
+    if( !p_prog )
+        return;
+
+    /* Playback and scanner both walk forward, so this is mostly an append,
+     * or a revisit of an already covered interval */
+    size_t i = UpperBoundPos( p_prog, i_pos );
+
+    if( i > 0 )
+    {
+        ts_index_entry_t *p_prev = &p_prog->p_entries[i - 1];
+        if( p_prev->i_pos == i_pos )
+        {
+            p_index->b_dirty |= b_rap && !p_prev->b_rap;
+            p_prev->b_rap |= b_rap;
+            return;
+        }
+        if( i_time >= p_prev->i_time && i_time - p_prev->i_time < TS_INDEX_INTERVAL )
+        {
+            if( !b_rap || p_prev->b_rap )
+                return;
+            /* a random access point supersedes a nearby plain PCR entry */
+            p_prev->i_pos = i_pos;
+            p_prev->i_time = i_time;
+            p_prev->b_rap = true;
+            p_index->b_dirty = true;
+            return;
+        }
+    }
+
+    if( i < p_prog->i_entries )
+    {
+        const ts_index_entry_t *p_next = &p_prog->p_entries[i];
+        if( p_next->i_time >= i_time && p_next->i_time - i_time < TS_INDEX_INTERVAL &&
+            ( !b_rap || p_next->b_rap ) )
+            return;
+    }
+
+    const ts_index_entry_t entry = { .i_pos = i_pos, .i_time = i_time, .b_rap = b_rap };
+    if( ProgramInsert( p_prog, i, &entry ) )
+        p_index->b_dirty = true;
+}
+
+void ts_index_Add( ts_index_t *p_index, int i_program,
+                   uint64_t i_pos, stime_t i_time, bool b_rap )
+{
+    vlc_mutex_lock( &p_index->lock );
+    AddLocked( p_index, i_program, i_pos, i_time, b_rap );
+    vlc_mutex_unlock( &p_index->lock );
+}
+
+bool ts_index_Find( ts_index_t *p_index, int i_program, stime_t i_time, uint64_t *pi_pos )
+{
+    bool b_found = false;
+
+    vlc_mutex_lock( &p_index->lock );
+
+    const ts_index_program_t *p_prog = GetProgram( p_index, i_program, false );
+    if( !p_prog || !p_prog->i_entries )
+        goto end;
+
+    const ts_index_entry_t *p_entries = p_prog->p_entries;
+
+    /* last entry at or before i_time */
+    size_t i_lo = 0, i_hi = p_prog->i_entries;
+    while( i_lo < i_hi )
+    {
+        size_t i_mid = i_lo + (i_hi - i_lo) / 2;
+        if( p_entries[i_mid].i_time <= i_time )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+    if( i_lo == 0 )
+        goto end;
+
+    size_t i = i_lo - 1;
+
+    /* The target must lie in an indexed span, not in a hole left by
+     * seeks during playback or past what has been indexed */
+    if( i_lo < p_prog->i_entries )
+    {
+        if( p_entries[i_lo].i_time - p_entries[i].i_time > TS_INDEX_MAX_GAP )
+            goto end;
+    }
+    else if( !p_index->b_complete || i_time - p_entries[i].i_time > TS_INDEX_MAX_GAP )
+        goto end;
+
+    /* Restart from the closest previous random access point */
+    for( size_t j = i; i_time - p_entries[j].i_time <= TS_INDEX_MAX_GAP; j-- )
+    {
+        if( p_entries[j].b_rap )
+        {
+            i = j;
+            break;
+        }
+        if( j == 0 || p_entries[j].i_time - p_entries[j - 1].i_time > TS_INDEX_MAX_GAP )
+            break;
+    }
+
+    *pi_pos = p_entries[i].i_pos;
+    b_found = true;
+
+end:
+    vlc_mutex_unlock( &p_index->lock );
+    return b_found;
+}
+
+bool ts_index_IsComplete( ts_index_t *p_index )
+{
+    vlc_mutex_lock( &p_index->lock );
+    bool b_complete = p_index->b_complete;
+    vlc_mutex_unlock( &p_index->lock );
+    return b_complete;
+}
+
+/*****************************************************************************
+ * Background scan
+ *****************************************************************************/
+void ts_index_ScanProgram( ts_index_t *p_index, int i_program, int i_pcr_pid, stime_t i_first )
+{
+    assert( !p_index->scan.b_running );
+    if( p_index->scan.i_programs == TS_INDEX_MAX_PROGRAMS )
+        return;
+
+    ts_index_scan_program_t *p_prog = &p_index->scan.programs[p_index->scan.i_programs++];
+    p_prog->i_number = i_program;
+    p_prog->i_pcr_pid = i_pcr_pid;
+    p_prog->i_first = i_first;
+    p_prog->i_last = -1;
+
+    if( i_pcr_pid >= 0 && i_pcr_pid < 0x1FFF && !p_index->scan.pid_program[i_pcr_pid] )
+        p_index->scan.pid_program[i_pcr_pid] = p_index->scan.i_programs;
+}
+
+void ts_index_ScanPID( ts_index_t *p_index, int i_pid, int i_program )
+{
+    assert( !p_index->scan.b_running );
+    if( i_pid < 0 || i_pid >= 0x1FFF || p_index->scan.pid_program[i_pid] )
+        return;
+
+    for( unsigned i = 0; i < p_index->scan.i_programs; i++ )
+    {
+        if( p_index->scan.programs[i].i_number == i_program )
+        {
+            p_index->scan.pid_program[i_pid] = i + 1;
+            break;
+        }
+    }
+}
+
+static void ScanPacket( ts_index_t *p_index, const uint8_t *p, uint64_t i_pos )
+{
+    const uint16_t i_pid = ((p[1] & 0x1f) << 8) | p[2];
+    const uint8_t i_slot = p_index->scan.pid_program[i_pid];
+
+    if( !i_slot || (p[1] & 0x80) /* transport error */ ||
+        !(p[3] & 0x20) || p[4] == 0 || p[4] > 183 )
+        return;
+
+    ts_index_scan_program_t *p_prog = &p_index->scan.programs[i_slot - 1];
+
+    if( i_pid == p_prog->i_pcr_pid && (p[5] & 0x10) && p[4] >= 7 )
+    {
+        stime_t i_pcr = ( (stime_t)p[6] << 25 ) |
+                        ( (stime_t)p[7] << 17 ) |
+                        ( (stime_t)p[8] << 9 ) |
+                        ( (stime_t)p[9] << 1 ) |
+                        ( (stime_t)p[10] >> 7 );
+        p_prog->i_last = TimeStampWrapAround( p_prog->i_first, i_pcr );
+        ts_index_Add( p_index, p_prog->i_number, i_pos, p_prog->i_last, false );
+    }
+
+    /* random_access_indicator */
+    if( (p[5] & 0x40) && p_prog->i_last != -1 )
+        ts_index_Add( p_index, p_prog->i_number, i_pos, p_prog->i_last, true );
+}
+
+static void *ScanThread( void *data )
+{
+    ts_index_t *p_index = data;
+    stream_t *s = p_index->scan.s;
+    const unsigned i_size = p_index->scan.i_packet_size;
+    const unsigned i_header = p_index->scan.i_packet_header_size;
+
+    uint8_t *p_buf = malloc( (size_t) i_size * TS_INDEX_SCAN_PACKETS );
+    if( !p_buf )
+        return NULL;
+
+    vlc_tick_t i_start = vlc_tick_now();
+    uint64_t i_pos = 0;
+    bool b_eof = false;
+
+    while( !atomic_load( &p_index->scan.b_abort ) )
+    {
+        ssize_t i_read = vlc_stream_Read( s, p_buf, (size_t) i_size * TS_INDEX_SCAN_PACKETS );
+        if( i_read < (ssize_t) i_size )
+        {
+            /* Only a real end of file completes the index, not an error */
+            uint64_t i_file_size;
+            b_eof = i_read >= 0 && vlc_stream_GetSize( s, &i_file_size ) == VLC_SUCCESS &&
+                    i_pos + i_read >= i_file_size;
+            if( !b_eof )
+                msg_Warn( p_index->p_obj, "seek index scan stopped at %"PRIu64, i_pos );
+            break;
+        }
+
+        size_t i_offset = 0;
+        while( i_offset + i_size <= (size_t) i_read )
+        {
+            if( p_buf[i_offset + i_header] != 0x47 )
+            {
+                i_offset++; /* lost sync */
+                continue;
+            }
+            ScanPacket( p_index, &p_buf[i_offset + i_header], i_pos + i_offset );
+            i_offset += i_size;
+        }
+
+        i_pos += i_offset;
+        if( i_offset != (size_t) i_read && vlc_stream_Seek( s, i_pos ) )
+            break;
+    }
+
+    free( p_buf );
+
+    if( b_eof )
+    {
+        vlc_mutex_lock( &p_index->lock );
+        p_index->b_complete = true;
+        p_index->b_dirty = true;
+        vlc_mutex_unlock( &p_index->lock );
+
+        msg_Dbg( p_index->p_obj, "seek index scanned %"PRIu64" bytes in %"PRId64" ms",
+                 i_pos, MS_FROM_VLC_TICK( vlc_tick_now() - i_start ) );
+    }
+
+    return NULL;
+}
+
+int ts_index_ScanStart( ts_index_t *p_index, const char *psz_url,
+                        unsigned i_packet_size, unsigned i_packet_header_size )
+{
+    if( p_index->scan.b_running || !p_index->scan.i_programs || !psz_url )
+        return VLC_EGENERIC;
+
+    p_index->scan.s = vlc_stream_NewURL( p_index->p_obj, psz_url );
+    if( !p_index->scan.s )
+        return VLC_EGENERIC;
+
+    p_index->scan.i_packet_size = i_packet_size;
+    p_index->scan.i_packet_header_size = i_packet_header_size;
+
+    if( vlc_clone( &p_index->scan.thread, ScanThread, p_index, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_stream_Delete( p_index->scan.s );
+        p_index->scan.s = NULL;
+        return VLC_EGENERIC;
+    }
+    p_index->scan.b_running = true;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Sidecar cache payload, little endian:
+ *  check    : packet size
+ *  payload  : complete, programs count, { number, count, { offset, time, rap } }
+ *****************************************************************************/
+static bool LoadCache( ts_index_t *p_index )
+{
+    uint8_t p_check[4];
+    SetDWLE( p_check, p_index->i_packet_size );
+
+    size_t i_size;
+    uint8_t *p_buf = seekindex_cache_Load( &p_index->cache, TS_INDEX_CACHE_MAGIC,
+                                           TS_INDEX_CACHE_VERSION, p_check, sizeof(p_check),
+                                           TS_INDEX_CACHE_MAX_SIZE, &i_size );
+    if( !p_buf )
+        return false;
+
+    const uint8_t *p = p_buf;
+    const uint8_t *p_end = &p_buf[i_size];
+    bool b_ok = false;
+
+    if( i_size < 8 )
+        goto end;
+
+    const bool b_complete = GetDWLE( p );
+    uint32_t i_programs = GetDWLE( &p[4] );
+    p += 8;
+
+    for( ; i_programs > 0; i_programs-- )
+    {
+        if( p_end - p < 8 )
+            goto end;
+        const int i_number = GetDWLE( p );
+        const uint32_t i_count = GetDWLE( &p[4] );
+        p += 8;
+        if( (uint64_t)(p_end - p) < (uint64_t) i_count * 17 )
+            goto end;
+        for( uint32_t i = 0; i < i_count; i++, p += 17 )
+            AddLocked( p_index, i_number, GetQWLE( p ), GetQWLE( &p[8] ), p[16] );
+    }
+
+    p_index->b_complete = b_complete;
+    b_ok = true;
+
+end:
+    if( !b_ok )
+        seekindex_cache_Corrupted( &p_index->cache );
+    free( p_buf );
+    return b_ok;
+}
+
+static void SaveCache( ts_index_t *p_index )
+{
+    size_t i_size = 8;
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+        i_size += 8 + p_index->programs.p_elems[i]->i_entries * 17;
+
+    uint8_t *p_buf = malloc( i_size );
+    if( !p_buf )
+        return;
+
+    uint8_t *p = p_buf;
+    SetDWLE( p, p_index->b_complete );
+    SetDWLE( &p[4], p_index->programs.i_size );
+    p += 8;
+
+    for( int i = 0; i < p_index->programs.i_size; i++ )
+    {
+        const ts_index_program_t *p_prog = p_index->programs.p_elems[i];
+        SetDWLE( p, p_prog->i_number );
+        SetDWLE( &p[4], p_prog->i_entries );
+        p += 8;
+        for( size_t j = 0; j < p_prog->i_entries; j++, p += 17 )
+        {
+            SetQWLE( p, p_prog->p_entries[j].i_pos );
+            SetQWLE( &p[8], p_prog->p_entries[j].i_time );
+            p[16] = p_prog->p_entries[j].b_rap;
+        }
+    }
+
+    uint8_t p_check[4];
+    SetDWLE( p_check, p_index->i_packet_size );
+    seekindex_cache_Save( &p_index->cache, TS_INDEX_CACHE_MAGIC, TS_INDEX_CACHE_VERSION,
+                          p_check, sizeof(p_check), p_buf, i_size );
+    free( p_buf );
+}
+
+bool ts_index_OpenCache( ts_index_t *p_index, const char *psz_filepath, unsigned i_packet_size )
+{
+    if( seekindex_cache_Init( &p_index->cache, p_index->p_obj, "tsindex",
+                              psz_filepath, NULL, 0 ) != VLC_SUCCESS )
+        return false;
+
+    p_index->i_packet_size = i_packet_size;
+
+    vlc_mutex_lock( &p_index->lock );
+    bool b_loaded = LoadCache( p_index );
+    p_index->b_dirty = false;
+    vlc_mutex_unlock( &p_index->lock );
+
+    if( b_loaded )
+        msg_Dbg( p_index->p_obj, "seek index loaded from %s%s", p_index->cache.psz_path,
+                 p_index->b_complete ? "" : " (partial)" );
+    return b_loaded;
+}
@@ -0,0 +1,53 @@
+/*****************************************************************************
+ * ts_index.h : MPEG TS PCR/random access point seek index
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+/* Minimum spacing between two PCR entries of a program. Random access
+ * points are always kept unless one already exists in that interval. */
+#define TS_INDEX_INTERVAL       TO_SCALE_NZ(VLC_TICK_FROM_SEC(1))
+/* Larger holes mean that part of the file was never indexed */
+#define TS_INDEX_MAX_GAP        TO_SCALE_NZ(VLC_TICK_FROM_SEC(5))
+
+typedef struct ts_index_t ts_index_t;
+
+/* Per program (PCR, byte offset, random access point) tuples, in file order.
+ * Times are program times, as compared by SeekToTime(). Thread-safe. */
+ts_index_t * ts_index_New( vlc_object_t * );
+void ts_index_Delete( ts_index_t * );
+
+void ts_index_Add( ts_index_t *, int i_program, uint64_t i_pos, stime_t i_time, bool b_rap );
+/* Returns the offset to resume from for reaching i_time, preferably a
+ * random access point, or false if that part has not been indexed yet */
+bool ts_index_Find( ts_index_t *, int i_program, stime_t i_time, uint64_t *pi_pos );
+
+/* Sidecar file in the user cache directory, keyed by the file path and
+ * validated against its size and modification time. Loads it if present,
+ * and saves the index there on deletion. */
+bool ts_index_OpenCache( ts_index_t *, const char *psz_filepath, unsigned i_packet_size );
+bool ts_index_IsComplete( ts_index_t * );
+
+/* Background scan of the whole file from a second stream. The programs
+ * and their PIDs must be declared before starting it. */
+void ts_index_ScanProgram( ts_index_t *, int i_program, int i_pcr_pid, stime_t i_first );
+void ts_index_ScanPID( ts_index_t *, int i_pid, int i_program );
+int  ts_index_ScanStart( ts_index_t *, const char *psz_url,
+                         unsigned i_packet_size, unsigned i_packet_header_size );
+
+#endif
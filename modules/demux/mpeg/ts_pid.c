@@ -42,8 +42,8 @@ void ts_pid_list_Init( ts_pid_list_t *p_list )
     p_list->pp_all = NULL;
     p_list->i_all = 0;
     p_list->i_all_alloc = 0;
-    p_list->i_last_pid = 0;
-    p_list->p_last = NULL;
+    for( int i = 0; i < PID_INDEX_PAGES; i++ )
+        p_list->pp_index[i] = NULL;
 }
 
 void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
@@ -60,6 +60,8 @@ void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
         free( pid );
     }
     free( p_list->pp_all );
+    for( int i = 0; i < PID_INDEX_PAGES; i++ )
+        free( p_list->pp_index[i] );
 }
 
 struct searchkey
@@ -89,11 +91,30 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
         case 0x1FFF:
             return &p_list->dummy;
         default:
-            if( p_list->i_last_pid == i_pid )
-                return p_list->p_last;
+            if( unlikely(i_pid > 0x1FFF) )
+                return &p_list->dummy;
         break;
     }
 
+    ts_pid_t **pp_page = p_list->pp_index[i_pid >> PID_INDEX_PAGE_BITS];
+    if( likely(pp_page) )
+    {
+        ts_pid_t *p_pid = pp_page[i_pid & (PID_INDEX_PAGE_SIZE - 1)];
+        if( likely(p_pid) )
+            return p_pid;
+    }
+    else
+    {
+        pp_page = calloc( PID_INDEX_PAGE_SIZE, sizeof(ts_pid_t *) );
+        if( !pp_page )
+        {
+            abort();
+            //return NULL;
+        }
+        p_list->pp_index[i_pid >> PID_INDEX_PAGE_BITS] = pp_page;
+    }
+
+    /* Not indexed yet: create it and insert it in the sorted list */
     size_t i_index = 0;
     ts_pid_t *p_pid = NULL;
 
@@ -152,8 +173,7 @@ ts_pid_t * ts_pid_Get( ts_pid_list_t *p_list, uint16_t i_pid )
 
     }
 
-    p_list->p_last = p_pid;
-    p_list->i_last_pid = i_pid;
+    pp_page[i_pid & (PID_INDEX_PAGE_SIZE - 1)] = p_pid;
 
     return p_pid;
 }
@@ -173,7 +193,7 @@ static void PIDReset( ts_pid_t *pid )
     assert(pid->i_refcount == 0);
     pid->i_cc       = 0xff;
     pid->i_dup      = 0;
-    pid->i_flags    &= ~FLAG_SCRAMBLED;
+    pid->i_flags    &= ~(FLAG_SCRAMBLED|FLAG_DROP);
     pid->type = TYPE_FREE;
     memset(pid->prevpktbytes, 0, PREVPKTKEEPBYTES);
 }
@@ -324,7 +344,10 @@ int UpdateHWFilter( demux_sys_t *p_sys, ts_pid_t *p_pid )
 int SetPIDFilter( demux_sys_t *p_sys, ts_pid_t *p_pid, bool b_selected )
 {
     if( b_selected )
+    {
         p_pid->i_flags |= FLAG_FILTERED;
+        p_pid->i_flags &= ~FLAG_DROP;
+    }
     else
         p_pid->i_flags &= ~FLAG_FILTERED;
 
@@ -44,7 +44,8 @@ enum
     FLAGS_NONE = 0,
     FLAG_SEEN  = 1,
     FLAG_SCRAMBLED = 2,
-    FLAG_FILTERED = 4
+    FLAG_FILTERED = 4,
+    FLAG_DROP = 8, /* unselected and carrying no PCR, see UpdatePESFilters */
 };
 
 #define SEEN(x) ((x)->i_flags & FLAG_SEEN)
@@ -85,19 +86,21 @@ struct ts_pid_t
 
 };
 
+#define PID_INDEX_PAGE_BITS 7
+#define PID_INDEX_PAGE_SIZE (1 << PID_INDEX_PAGE_BITS)
+#define PID_INDEX_PAGES     (8192 / PID_INDEX_PAGE_SIZE)
+
 struct ts_pid_list_t
 {
     ts_pid_t   pat;
     ts_pid_t   dummy;
     ts_pid_t   base_si;
-    /* all non commons ones, dynamically allocated */
+    /* all non commons ones, dynamically allocated, sorted by pid */
     ts_pid_t **pp_all;
     int        i_all;
     int        i_all_alloc;
-    /* last recently used */
-    uint16_t   i_last_pid;
-    ts_pid_t  *p_last;
-
+    /* direct lookup, two levels sparse table of the above by pid */
+    ts_pid_t **pp_index[PID_INDEX_PAGES];
 };
 
 /* opacified pid list */
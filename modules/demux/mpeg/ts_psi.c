@@ -95,6 +95,9 @@ static void PATCallBack( void *data, dvbpsi_pat_t *p_dvbpsipat )
 
     msg_Dbg( p_demux, "PATCallBack called" );
 
+    /* Programs and their streams can be released below */
+    ProgramsOutputSync( p_demux );
+
     if(unlikely( GetPID(p_sys, 0)->type != TYPE_PAT ))
     {
         msg_Warn( p_demux, "PATCallBack called on invalid pid" );
@@ -1827,6 +1830,8 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
 
     msg_Dbg( p_demux, "PMTCallBack called for program %d", p_dvbpsipmt->i_program_number );
 
+    ProgramsOutputSync( p_demux );
+
     if (unlikely(GetPID(p_sys, 0)->type != TYPE_PAT))
     {
         assert(GetPID(p_sys, 0)->type == TYPE_PAT);
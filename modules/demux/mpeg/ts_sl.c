@@ -151,6 +151,9 @@ void SLPackets_Section_Handler( demux_t *p_demux,
         const uint8_t *p_data = p_payloaddata;
         size_t i_data = i_payloaddata;
 
+        /* Object descriptors are used by the SL stream processors */
+        ProgramsOutputSync( p_demux );
+
         od_descriptors_t *p_ods = &p_pmt->od;
         sl_header_data header = DecodeSLHeader( i_data, p_data, &p_mpeg4desc->sl_descr );
 
@@ -90,7 +90,8 @@ struct ts_es_t
     es_format_t  fmt;
     es_out_id_t *id;
     uint16_t i_sl_es_id;
-    int         i_next_block_flags;
+    int         i_next_block_flags; /* demux thread, handed to the output */
+    int         i_output_block_flags; /* output side, set on the next block sent */
     ts_es_t *p_extraes; /* Some private streams encapsulate several ES (eg. DVB subtitles) */
     ts_es_t *p_next; /* Next es on same pid from different pmt (shared pid) */
     /* J2K stuff */
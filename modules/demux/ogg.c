@@ -385,6 +385,7 @@ static int Demux( demux_t * p_demux )
     ogg_packet  oggpacket;
     int         i_stream;
     bool b_canseek;
+    int64_t i_pagepos = -1;
 
     int i_active_streams = p_sys->i_streams;
     for ( int i=0; i < p_sys->i_streams; i++ )
@@ -467,6 +468,13 @@ static int Demux( demux_t * p_demux )
          */
         if( Ogg_ReadPage( p_demux, &p_sys->current_page ) != VLC_SUCCESS )
             return VLC_DEMUXER_EOF; /* EOF */
+
+        /* Start of the page, for the seek index of its stream */
+        if( p_sys->i_total_length > 0 )
+            i_pagepos = vlc_stream_Tell( p_demux->s )
+                      - ( p_sys->oy.fill - p_sys->oy.returned )
+                      - p_sys->current_page.header_len - p_sys->current_page.body_len;
+
         /* Test for End of Stream */
         if( ogg_page_eos( &p_sys->current_page ) )
         {
@@ -519,6 +527,10 @@ static int Demux( demux_t * p_demux )
             {
                 continue;
             }
+
+            if( i_pagepos >= 0 )
+                OggSeek_IndexAdd( p_stream, ogg_page_granulepos( &p_sys->current_page ),
+                                  i_pagepos );
         }
 
         /* clear the finished flag if pages after eos (ex: after a seek) */
@@ -2240,8 +2252,8 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
 
         p_stream->p_es = NULL;
 
-        /* initialise kframe index */
-        p_stream->idx=NULL;
+        /* initialise seek index */
+        ARRAY_INIT( p_stream->idx );
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2347,10 +2359,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    oggseek_index_entries_free( p_stream );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
@@ -92,8 +92,8 @@ typedef struct logical_stream_s
     /* offset of first keyframe for theora; can be 0 or 1 depending on version number */
     int8_t i_first_frame_index;
 
-    /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    /* page index for seeking, filled while reading and seeking */
+    DECL_ARRAY(demux_index_entry_t) idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
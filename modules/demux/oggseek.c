@@ -60,115 +60,78 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
+/* free all entries in index */
 
-void oggseek_index_entries_free ( demux_index_entry_t *idx )
+void oggseek_index_entries_free ( logical_stream_t *p_stream )
 {
-    demux_index_entry_t *idx_next;
-
-    while ( idx != NULL )
-    {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
-    }
-}
-
-
-/* internal function to create a new list member */
-
-static demux_index_entry_t *index_entry_new( void )
-{
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    ARRAY_RESET( p_stream->idx );
 }
 
 /* We insert into index, sorting by pagepos (as a page can match multiple
-   time stamps) */
-const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
-                                             vlc_tick_t i_timestamp,
-                                             int64_t i_pagepos )
+   time stamps). Entries are kept at least OGGSEEK_INDEX_INTERVAL apart,
+   and those which would break the time order are dropped. */
+void OggSeek_IndexAdd ( logical_stream_t *p_stream,
+                        int64_t i_granule, int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
-
-    if ( p_stream == NULL ) return NULL;
+    if ( i_granule <= 0 || i_pagepos < p_stream->i_data_start ) return;
 
-    idx = p_stream->idx;
+    vlc_tick_t i_timestamp = Ogg_GranuleToTime( p_stream, i_granule,
+                                                !p_stream->b_contiguous, false );
+    if ( i_timestamp == VLC_TICK_INVALID ) return;
+    if ( i_timestamp < 0 ) /* due to preskip with some codecs */
+        i_timestamp = 0;
 
-    if ( i_timestamp == VLC_TICK_INVALID || i_pagepos < 1 ) return NULL;
-
-    if ( idx == NULL )
+    /* first entry at or after i_pagepos */
+    int i_low = 0, i_high = p_stream->idx.i_size;
+    while ( i_low < i_high )
     {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
-    }
-
-    while ( idx != NULL )
-    {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
-    }
-
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
-    {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
-    }
-    else
-    {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
-    }
-
-    if ( idx->p_next != NULL )
-    {
-        idx->p_next->p_prev = idx;
+        int i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_stream->idx.p_elems[i_mid].i_pagepos < i_pagepos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
 
-    idx->i_value = i_timestamp;
-    idx->i_pagepos = i_pagepos;
+    if ( i_low > 0 &&
+         i_timestamp < p_stream->idx.p_elems[i_low - 1].i_value + OGGSEEK_INDEX_INTERVAL )
+        return;
+    if ( i_low < p_stream->idx.i_size &&
+         i_timestamp + OGGSEEK_INDEX_INTERVAL > p_stream->idx.p_elems[i_low].i_value )
+        return;
 
-    return idx;
+    demux_index_entry_t entry = {
+        .i_value = i_timestamp,
+        .i_granule = i_granule,
+        .i_pagepos = i_pagepos,
+    };
+    ARRAY_INSERT( p_stream->idx, entry, i_low );
 }
 
+/* Gets the entries around i_timestamp, if any. Returns true if they are
+   close enough for seeking to the lower one without probing. */
 static bool OggSeekIndexFind ( logical_stream_t *p_stream, vlc_tick_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+                               const demux_index_entry_t **pp_lower,
+                               const demux_index_entry_t **pp_upper )
 {
-    demux_index_entry_t *idx = p_stream->idx;
-
-    while ( idx != NULL )
+    /* first entry after i_timestamp */
+    int i_low = 0, i_high = p_stream->idx.i_size;
+    while ( i_low < i_high )
     {
-        if ( idx->i_value <= i_timestamp )
-        {
-            if ( !idx->p_next ) /* found on last index */
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
-            }
-        }
-        idx = idx->p_next;
+        int i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_stream->idx.p_elems[i_mid].i_value <= i_timestamp )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
 
-    return false;
+    *pp_lower = ( i_low > 0 ) ? &p_stream->idx.p_elems[i_low - 1] : NULL;
+    *pp_upper = ( i_low < p_stream->idx.i_size ) ? &p_stream->idx.p_elems[i_low] : NULL;
+
+    /* The data read past the lower entry is then bounded, as long as
+     * decoding can start from any packet */
+    return *pp_lower && *pp_upper && !p_stream->b_oggds &&
+           (*pp_upper)->i_value - (*pp_lower)->i_value <= OGGSEEK_INDEX_MAX_GAP &&
+           Ogg_GetKeyframeGranule( p_stream, 0xFF00FF00 ) == 0xFF00FF00;
 }
 
 /*********************************************************************
@@ -652,6 +615,26 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
     i_pos_upper = __MIN( i_pos_upper, p_sys->i_total_length );
     if ( i_pos_upper < 0 ) i_pos_upper = p_sys->i_total_length;
 
+    /* Start from what was already read or probed around the target */
+    const demux_index_entry_t *p_lower, *p_upper;
+    bool b_close = OggSeekIndexFind( p_stream, i_targettime, &p_lower, &p_upper );
+    if ( p_lower && p_lower->i_pagepos >= i_pos_lower && p_lower->i_pagepos < i_pos_upper )
+    {
+        if ( b_close && p_upper->i_pagepos <= i_pos_upper )
+            return p_lower->i_pagepos;
+        i_pos_lower = p_lower->i_pagepos;
+        bestlower.i_pos = p_lower->i_pagepos;
+        bestlower.i_timestamp = p_lower->i_value;
+        bestlower.i_granule = p_lower->i_granule;
+    }
+    if ( p_upper && p_upper->i_pagepos > i_pos_lower && p_upper->i_pagepos < i_pos_upper )
+    {
+        i_pos_upper = p_upper->i_pagepos;
+        lowestupper.i_pos = p_upper->i_pagepos;
+        lowestupper.i_timestamp = p_upper->i_value;
+        lowestupper.i_granule = p_upper->i_granule;
+    }
+
     i_start_pos = i_pos_lower;
     i_end_pos = i_pos_upper;
 
@@ -698,6 +681,7 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
         if ( current.i_pos != -1 && current.i_granule != -1 )
         {
             /* found a page */
+            OggSeek_IndexAdd( p_stream, current.i_granule, current.i_pos );
 
             if ( current.i_timestamp <= i_targettime )
             {
@@ -788,8 +772,11 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( i_lowerpos != -1 ) b_found = true;
 
     /* And also search in our own index */
-    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos ) )
+    const demux_index_entry_t *p_lower, *p_upper;
+    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &p_lower, &p_upper ) )
     {
+        i_lowerpos = p_lower->i_pagepos;
+        i_upperpos = p_upper->i_pagepos;
         b_found = true;
     }
 
@@ -893,10 +880,6 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
     }
     OggDebug( msg_Dbg( p_demux, "Search bounds set to %"PRId64" %"PRId64" using skeleton index", i_offset_lower, i_offset_upper ) );
 
-    OggNoDebug(
-        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper )
-    );
-
     i_offset_lower = __MAX( i_offset_lower, p_stream->i_data_start );
     i_offset_upper = __MIN( i_offset_upper, p_sys->i_total_length );
 
@@ -909,12 +892,6 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
         p_sys->i_input_position = i_pagepos;
         seek_byte( p_demux, p_sys->i_input_position );
     }
-    /* Insert keyframe position into index */
-    OggNoDebug(
-    if ( i_pagepos >= p_stream->i_data_start )
-        OggSeek_IndexAdd( p_stream, i_time, i_pagepos )
-    );
-
     OggDebug( msg_Dbg( p_demux, "=================== Seeked To %"PRId64" time %"PRId64, i_pagepos, i_time ) );
     return i_pagepos;
 }
@@ -40,31 +40,29 @@
 #define OGGSEEK_BYTES_TO_READ 8500
 #define OGGSEEK_SERIALNO_MAX_LOOKUP_BYTES (OGGSEEK_BYTES_TO_READ * 25)
 
-/* index entries are structured as follows:
- *   - for theora, highest granulepos -> pagepos (bytes) where keyframe begins
- *  - for dirac, kframe (sync point) -> pagepos of sequence start (?)
- */
+/* Index entries map the granule of the first complete page found when
+ * reading from i_pagepos. They are filled while playing and from every
+ * seek probe, and kept sorted both by position and by time. */
+#define OGGSEEK_INDEX_INTERVAL VLC_TICK_FROM_SEC(1)
+/* Two entries closer than this locate a time well enough for seeking to
+ * the lower one directly, without probing, if every packet is a keyframe */
+#define OGGSEEK_INDEX_MAX_GAP  VLC_TICK_FROM_SEC(5)
 
 /* this is typedefed to demux_index_entry_t in ogg.h */
 struct oggseek_index_entry
 {
-    demux_index_entry_t *p_next;
-    demux_index_entry_t *p_prev;
-
-    /* value is highest granulepos for theora, sync frame for dirac */
+    /* page end time and granule */
     vlc_tick_t i_value;
+    int64_t i_granule;
     int64_t i_pagepos;
-
-    /* not used for theora because the granulepos tells us this */
-    int64_t i_pagepos_end;
 };
 
 int     Oggseek_BlindSeektoAbsoluteTime ( demux_t *, logical_stream_t *, vlc_tick_t, bool );
 int     Oggseek_BlindSeektoPosition ( demux_t *, logical_stream_t *, double f, bool );
 int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, vlc_tick_t );
-const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, vlc_tick_t, int64_t );
+void    OggSeek_IndexAdd ( logical_stream_t *, int64_t i_granule, int64_t i_pagepos );
 void    Oggseek_ProbeEnd( demux_t * );
 
-void oggseek_index_entries_free ( demux_index_entry_t * );
+void oggseek_index_entries_free ( logical_stream_t * );
 
 int64_t oggseek_read_page ( demux_t * );
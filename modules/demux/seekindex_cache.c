@@ -0,0 +1,262 @@
+/*****************************************************************************
+ * seekindex_cache.c: seek index sidecar files helper
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+
+#include <sys/stat.h>
+
+#include "seekindex_cache.h"
+
+/* Sidecars kept per subdirectory, the least recently written go first */
+#define SEEKINDEX_CACHE_MAX_FILES 256
+
+typedef struct
+{
+    time_t i_mtime;
+    char  *psz_path;
+} seekindex_cache_entry_t;
+
+static int EntryCmp( const void *a, const void *b )
+{
+    const seekindex_cache_entry_t *p_a = a, *p_b = b;
+    return ( p_a->i_mtime > p_b->i_mtime ) - ( p_a->i_mtime < p_b->i_mtime );
+}
+
+static void Evict( seekindex_cache_t *p_cache )
+{
+    DIR *dir = vlc_opendir( p_cache->psz_dir );
+    if( !dir )
+        return;
+
+    seekindex_cache_entry_t *p_entries = NULL;
+    size_t i_entries = 0, i_alloc = 0;
+    const char *psz_name;
+
+    while( ( psz_name = vlc_readdir( dir ) ) != NULL )
+    {
+        size_t i_len = strlen( psz_name );
+        if( i_len < 4 || strcmp( &psz_name[i_len - 4], ".idx" ) )
+            continue;
+
+        char *psz_path;
+        struct stat st;
+        if( asprintf( &psz_path, "%s" DIR_SEP "%s", p_cache->psz_dir, psz_name ) == -1 )
+            break;
+        if( vlc_stat( psz_path, &st ) )
+        {
+            free( psz_path );
+            continue;
+        }
+
+        if( i_entries == i_alloc )
+        {
+            size_t i_new = i_alloc ? i_alloc * 2 : 64;
+            seekindex_cache_entry_t *p_new =
+                realloc( p_entries, i_new * sizeof(*p_entries) );
+            if( !p_new )
+            {
+                free( psz_path );
+                break;
+            }
+            p_entries = p_new;
+            i_alloc = i_new;
+        }
+        p_entries[i_entries].i_mtime = st.st_mtime;
+        p_entries[i_entries].psz_path = psz_path;
+        i_entries++;
+    }
+    closedir( dir );
+
+    if( i_entries > SEEKINDEX_CACHE_MAX_FILES )
+    {
+        qsort( p_entries, i_entries, sizeof(*p_entries), EntryCmp );
+        for( size_t i = 0; i < i_entries - SEEKINDEX_CACHE_MAX_FILES; i++ )
+        {
+            if( strcmp( p_entries[i].psz_path, p_cache->psz_path ) )
+                vlc_unlink( p_entries[i].psz_path );
+        }
+    }
+
+    for( size_t i = 0; i < i_entries; i++ )
+        free( p_entries[i].psz_path );
+    free( p_entries );
+}
+
+int seekindex_cache_Init( seekindex_cache_t *p_cache, vlc_object_t *p_obj,
+                          const char *psz_subdir, const char *psz_filepath,
+                          const void *p_key, size_t i_key )
+{
+    p_cache->p_obj = p_obj;
+    p_cache->psz_dir = NULL;
+    p_cache->psz_path = NULL;
+
+    struct stat st;
+    if( !psz_filepath || vlc_stat( psz_filepath, &st ) )
+        return VLC_EGENERIC;
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( !psz_cachedir )
+        return VLC_EGENERIC;
+
+    vlc_hash_md5_t md5;
+    char psz_digest[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, psz_filepath, strlen( psz_filepath ) );
+    if( i_key )
+        vlc_hash_md5_Update( &md5, p_key, i_key );
+    vlc_hash_FinishHex( &md5, psz_digest );
+
+    if( asprintf( &p_cache->psz_dir, "%s" DIR_SEP "%s", psz_cachedir, psz_subdir ) == -1 )
+        p_cache->psz_dir = NULL;
+    free( psz_cachedir );
+
+    if( !p_cache->psz_dir ||
+        asprintf( &p_cache->psz_path, "%s" DIR_SEP "%s.idx", p_cache->psz_dir, psz_digest ) == -1 )
+    {
+        free( p_cache->psz_dir );
+        p_cache->psz_dir = NULL;
+        p_cache->psz_path = NULL;
+        return VLC_ENOMEM;
+    }
+
+    p_cache->i_file_size = st.st_size;
+    p_cache->i_file_mtime = st.st_mtime;
+    return VLC_SUCCESS;
+}
+
+void seekindex_cache_Clean( seekindex_cache_t *p_cache )
+{
+    free( p_cache->psz_path );
+    free( p_cache->psz_dir );
+    p_cache->psz_path = NULL;
+    p_cache->psz_dir = NULL;
+}
+
+uint8_t *seekindex_cache_Load( seekindex_cache_t *p_cache, const char psz_magic[4],
+                               uint32_t i_version, const void *p_check, size_t i_check,
+                               size_t i_max_size, size_t *pi_size )
+{
+    if( !p_cache->psz_path )
+        return NULL;
+
+    FILE *f = vlc_fopen( p_cache->psz_path, "rb" );
+    if( !f )
+        return NULL;
+
+    const size_t i_header = SEEKINDEX_CACHE_HEADER_SIZE + i_check;
+    uint8_t *p_buf = NULL;
+    long i_size = -1;
+    if( fseek( f, 0, SEEK_END ) == 0 )
+        i_size = ftell( f );
+    if( i_size >= (long) i_header && (size_t) i_size <= i_header + i_max_size &&
+        fseek( f, 0, SEEK_SET ) == 0 )
+    {
+        p_buf = malloc( i_size );
+        if( p_buf && fread( p_buf, 1, i_size, f ) != (size_t) i_size )
+        {
+            free( p_buf );
+            p_buf = NULL;
+        }
+    }
+    fclose( f );
+
+    if( !p_buf )
+        return NULL;
+
+    if( memcmp( p_buf, psz_magic, 4 ) ||
+        GetDWLE( &p_buf[4] ) != i_version ||
+        GetQWLE( &p_buf[8] ) != p_cache->i_file_size ||
+        (int64_t) GetQWLE( &p_buf[16] ) != p_cache->i_file_mtime ||
+        memcmp( &p_buf[SEEKINDEX_CACHE_HEADER_SIZE], p_check, i_check ) )
+    {
+        msg_Dbg( p_cache->p_obj, "discarding stale seek index %s", p_cache->psz_path );
+        free( p_buf );
+        return NULL;
+    }
+
+    *pi_size = i_size - i_header;
+    memmove( p_buf, &p_buf[i_header], *pi_size );
+    return p_buf;
+}
+
+void seekindex_cache_Corrupted( seekindex_cache_t *p_cache )
+{
+    msg_Warn( p_cache->p_obj, "corrupted seek index %s", p_cache->psz_path );
+}
+
+int seekindex_cache_Save( seekindex_cache_t *p_cache, const char psz_magic[4],
+                          uint32_t i_version, const void *p_check, size_t i_check,
+                          const void *p_payload, size_t i_payload )
+{
+    if( !p_cache->psz_path )
+        return VLC_EGENERIC;
+
+    uint8_t p_header[SEEKINDEX_CACHE_HEADER_SIZE];
+    memcpy( p_header, psz_magic, 4 );
+    SetDWLE( &p_header[4], i_version );
+    SetQWLE( &p_header[8], p_cache->i_file_size );
+    SetQWLE( &p_header[16], p_cache->i_file_mtime );
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir )
+    {
+        vlc_mkdir( psz_cachedir, 0700 );
+        free( psz_cachedir );
+    }
+    vlc_mkdir( p_cache->psz_dir, 0700 );
+
+    /* write aside and rename, so that a concurrent open never reads a
+     * partial index */
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.part", p_cache->psz_path ) == -1 )
+        return VLC_ENOMEM;
+
+    bool b_written = false;
+    FILE *f = vlc_fopen( psz_tmp, "wb" );
+    if( f )
+    {
+        b_written = fwrite( p_header, 1, sizeof(p_header), f ) == sizeof(p_header) &&
+                    fwrite( p_check, 1, i_check, f ) == i_check &&
+                    fwrite( p_payload, 1, i_payload, f ) == i_payload;
+        b_written &= fclose( f ) == 0;
+    }
+
+    if( !b_written || vlc_rename( psz_tmp, p_cache->psz_path ) )
+    {
+        msg_Warn( p_cache->p_obj, "cannot write seek index %s", p_cache->psz_path );
+        vlc_unlink( psz_tmp );
+        free( psz_tmp );
+        return VLC_EGENERIC;
+    }
+    free( psz_tmp );
+
+    msg_Dbg( p_cache->p_obj, "seek index saved to %s (%zu bytes)", p_cache->psz_path,
+             sizeof(p_header) + i_check + i_payload );
+
+    Evict( p_cache );
+    return VLC_SUCCESS;
+}
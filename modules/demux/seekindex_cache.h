@@ -0,0 +1,67 @@
+/*****************************************************************************
+ * seekindex_cache.h: seek index sidecar files helper
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_SEEKINDEX_CACHE_H
+#define VLC_SEEKINDEX_CACHE_H
+
+#include <vlc_common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sidecar file of a demuxer seek index, in a subdirectory of the user cache
+ * directory and named after the MD5 of the file path (and of an optional
+ * demuxer key). Only the most recently written sidecars of a subdirectory
+ * are kept. Little endian layout:
+ *  header  : magic, version, file size, file mtime
+ *  check   : demuxer parameters that must match, compared as is
+ *  payload : demuxer index */
+#define SEEKINDEX_CACHE_HEADER_SIZE 24
+
+typedef struct
+{
+    vlc_object_t *p_obj;
+    char *psz_dir;
+    char *psz_path; /* NULL if the cache is unusable */
+    uint64_t i_file_size;
+    int64_t  i_file_mtime;
+} seekindex_cache_t;
+
+int  seekindex_cache_Init( seekindex_cache_t *, vlc_object_t *, const char *psz_subdir,
+                           const char *psz_filepath, const void *p_key, size_t i_key );
+void seekindex_cache_Clean( seekindex_cache_t * );
+
+/* Returns the payload of a sidecar matching the file and the check bytes,
+ * to be freed, or NULL */
+uint8_t *seekindex_cache_Load( seekindex_cache_t *, const char psz_magic[4],
+                               uint32_t i_version, const void *p_check, size_t i_check,
+                               size_t i_max_size, size_t *pi_size );
+/* To be called when the payload returned by Load() turns out invalid */
+void seekindex_cache_Corrupted( seekindex_cache_t * );
+
+int  seekindex_cache_Save( seekindex_cache_t *, const char psz_magic[4],
+                           uint32_t i_version, const void *p_check, size_t i_check,
+                           const void *p_payload, size_t i_payload );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
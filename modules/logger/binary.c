@@ -0,0 +1,529 @@
+/*****************************************************************************
+ * binary.c: binary ring buffer tracer plugin
+ *****************************************************************************
+ * Copyright © 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Traces are encoded by the tracing thread into its own ring buffer, without
+ * locking nor formatting. A background thread drains all the rings into the
+ * output file. If a ring is full, the trace is dropped and counted.
+ *
+ * File format (little endian, see extras/misc/vlc-trace2json.py):
+ *
+ *  header: "VLCTRACE" magic, u32 version, u32 tick rate (ticks per second)
+ *  chunk:  u32 ring serial, u32 length, then length bytes of records
+ *
+ * Records of a given ring are in order across its chunks:
+ *
+ *  THREAD:  u8 tag, varint system thread ID
+ *  STRING:  u8 tag, varint string ID, varint length, bytes
+ *  DROPPED: u8 tag, varint count of traces dropped before the next one
+ *  EVENT:   u8 tag, varint tick delta from the previous event of the ring,
+ *           u8 entry count, then for each entry: string key,
+ *           u8 type, then either a zigzag varint or a string
+ *
+ * Strings are varint IDs, defined by a previous STRING record of the same
+ * ring, or 0 followed by an inline varint length and bytes.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_fs.h>
+#include <vlc_list.h>
+#include <vlc_tracer.h>
+
+#include <stdarg.h>
+#include <errno.h>
+#include <assert.h>
+
+#define BINARY_FILENAME "vlc-trace.bin"
+#define BINARY_VERSION 1
+
+#define RING_MIN_SIZE       (16 * 1024)
+#define RING_STRINGS        256
+#define RING_STRING_MAX     255
+#define RECORD_MAX          2048
+#define ENTRIES_MAX         32
+
+enum
+{
+    RECORD_THREAD = 1,
+    RECORD_STRING,
+    RECORD_DROPPED,
+    RECORD_EVENT,
+};
+
+typedef struct vlc_tracer_sys vlc_tracer_sys_t;
+
+struct ring_string
+{
+    char *str;
+    size_t len;
+    uint32_t hash;
+    uint32_t id;
+    bool defined;
+};
+
+/* Per-thread ring, written by its thread, read by the writer thread */
+struct ring
+{
+    struct vlc_list node;
+    uint32_t serial;
+    atomic_bool dead;
+
+    atomic_size_t head; /* bytes written, owned by the tracing thread */
+    atomic_size_t tail; /* bytes read, owned by the writer thread */
+
+    /* Tracing thread state */
+    vlc_tick_t last_ts;
+    uint64_t dropped;
+    uint32_t next_string_id;
+    struct ring_string strings[RING_STRINGS];
+
+    size_t mask;
+    uint8_t data[];
+};
+
+struct vlc_tracer_sys
+{
+    FILE *stream;
+    size_t ring_size;
+    vlc_threadvar_t key;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    struct vlc_list rings;
+    uint32_t next_serial;
+    bool closing;
+    vlc_thread_t thread;
+};
+
+static uint8_t *PutVarint(uint8_t *p, const uint8_t *end, uint64_t value)
+{
+    do
+    {
+        if (p == NULL || p >= end)
+            return NULL;
+        *p++ = (value & 0x7f) | (value > 0x7f ? 0x80 : 0);
+        value >>= 7;
+    } while (value != 0);
+    return p;
+}
+
+static uint8_t *PutByte(uint8_t *p, const uint8_t *end, uint8_t value)
+{
+    if (p == NULL || p >= end)
+        return NULL;
+    *p++ = value;
+    return p;
+}
+
+static uint8_t *PutBytes(uint8_t *p, const uint8_t *end, const void *data,
+                         size_t len)
+{
+    if (p == NULL || (size_t)(end - p) < len)
+        return NULL;
+    memcpy(p, data, len);
+    return p + len;
+}
+
+static uint32_t Hash(const char *str, size_t len)
+{
+    uint32_t hash = 2166136261u; /* FNV-1a */
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (uint8_t)str[i]) * 16777619u;
+    return hash;
+}
+
+/**
+ * Encodes a string reference in the event buffer, and its definition in the
+ * definitions buffer if needed.
+ */
+static uint8_t *PutString(struct ring *ring, uint8_t *p, const uint8_t *end,
+                          uint8_t **restrict defs, const uint8_t *defs_end,
+                          struct ring_string **restrict pending,
+                          unsigned *restrict pending_count, const char *str)
+{
+    if (str == NULL)
+        str = "";
+
+    size_t len = strnlen(str, RING_STRING_MAX);
+    uint32_t hash = Hash(str, len);
+    struct ring_string *entry = NULL;
+
+    for (unsigned i = 0; i < 8; i++)
+    {
+        struct ring_string *s = &ring->strings[(hash + i) % RING_STRINGS];
+        if (s->str == NULL)
+        {   /* New string */
+            s->str = strndup(str, len);
+            if (s->str == NULL)
+                break;
+            s->len = len;
+            s->hash = hash;
+            s->id = ++ring->next_string_id;
+            s->defined = false;
+            entry = s;
+            break;
+        }
+        if (s->hash == hash && s->len == len && !memcmp(s->str, str, len))
+        {
+            entry = s;
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {   /* Table full or no memory: inline string */
+        p = PutVarint(p, end, 0);
+        p = PutVarint(p, end, len);
+        return PutBytes(p, end, str, len);
+    }
+
+    if (!entry->defined)
+    {   /* Defined once the event is committed */
+        *defs = PutByte(*defs, defs_end, RECORD_STRING);
+        *defs = PutVarint(*defs, defs_end, entry->id);
+        *defs = PutVarint(*defs, defs_end, len);
+        *defs = PutBytes(*defs, defs_end, str, len);
+        if (*pending_count < ENTRIES_MAX * 2)
+            pending[(*pending_count)++] = entry;
+    }
+    return PutVarint(p, end, entry->id);
+}
+
+static void RingWrite(struct ring *ring, size_t head, const uint8_t *data,
+                      size_t len)
+{
+    size_t size = ring->mask + 1;
+    size_t offset = head & ring->mask;
+    size_t first = size - offset < len ? size - offset : len;
+
+    if (len == 0)
+        return;
+    memcpy(&ring->data[offset], data, first);
+    memcpy(&ring->data[0], data + first, len - first);
+}
+
+/* Commits a record to the ring, or returns false if there is no room */
+static bool RingPush(struct ring *ring, const uint8_t *a, size_t alen,
+                     const uint8_t *b, size_t blen)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (alen + blen > ring->mask + 1 - (head - tail))
+        return false;
+
+    RingWrite(ring, head, a, alen);
+    RingWrite(ring, head + alen, b, blen);
+    atomic_store_explicit(&ring->head, head + alen + blen,
+                          memory_order_release);
+    return true;
+}
+
+static void RingDelete(struct ring *ring)
+{
+    for (unsigned i = 0; i < RING_STRINGS; i++)
+        free(ring->strings[i].str);
+    free(ring);
+}
+
+static struct ring *RingGet(vlc_tracer_sys_t *sys)
+{
+    struct ring *ring = vlc_threadvar_get(sys->key);
+    if (likely(ring != NULL))
+        return ring;
+
+    ring = malloc(sizeof (*ring) + sys->ring_size);
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    atomic_init(&ring->dead, false);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->last_ts = 0;
+    ring->dropped = 0;
+    ring->next_string_id = 0;
+    memset(ring->strings, 0, sizeof (ring->strings));
+    ring->mask = sys->ring_size - 1;
+
+    uint8_t buf[16], *p = buf;
+    p = PutByte(p, buf + sizeof (buf), RECORD_THREAD);
+    p = PutVarint(p, buf + sizeof (buf), vlc_thread_id());
+    RingPush(ring, buf, p - buf, NULL, 0);
+
+    if (vlc_threadvar_set(sys->key, ring))
+    {
+        free(ring);
+        return NULL;
+    }
+
+    vlc_mutex_lock(&sys->lock);
+    ring->serial = sys->next_serial++;
+    vlc_list_append(&ring->node, &sys->rings);
+    vlc_mutex_unlock(&sys->lock);
+    return ring;
+}
+
+static void RingRelease(void *data)
+{
+    struct ring *ring = data;
+
+    /* The writer thread drains and deletes it */
+    atomic_store_explicit(&ring->dead, true, memory_order_release);
+}
+
+static void TraceBinary(void *opaque, va_list entries)
+{
+    vlc_tracer_sys_t *sys = opaque;
+    vlc_tick_t now = vlc_tick_now();
+
+    struct ring *ring = RingGet(sys);
+    if (unlikely(ring == NULL))
+        return;
+
+    uint8_t event[RECORD_MAX], defs[RECORD_MAX];
+    const uint8_t *event_end = event + sizeof (event);
+    const uint8_t *defs_end = defs + sizeof (defs);
+    uint8_t *p = event, *d = defs;
+    struct ring_string *pending[ENTRIES_MAX * 2];
+    unsigned pending_count = 0;
+
+    if (ring->dropped > 0)
+    {
+        d = PutByte(d, defs_end, RECORD_DROPPED);
+        d = PutVarint(d, defs_end, ring->dropped);
+    }
+
+    p = PutByte(p, event_end, RECORD_EVENT);
+    p = PutVarint(p, event_end, now - ring->last_ts);
+    uint8_t *count = p;
+    p = PutByte(p, event_end, 0);
+
+    unsigned n = 0;
+    for (struct vlc_tracer_entry entry = va_arg(entries, struct vlc_tracer_entry);
+         entry.key != NULL && n < ENTRIES_MAX;
+         entry = va_arg(entries, struct vlc_tracer_entry), n++)
+    {
+        p = PutString(ring, p, event_end, &d, defs_end, pending,
+                      &pending_count, entry.key);
+        p = PutByte(p, event_end, entry.type);
+        switch (entry.type)
+        {
+            case VLC_TRACER_INT:
+            {
+                int64_t v = entry.value.integer;
+                p = PutVarint(p, event_end, ((uint64_t)v << 1) ^ (v >> 63));
+                break;
+            }
+            case VLC_TRACER_STRING:
+                p = PutString(ring, p, event_end, &d, defs_end, pending,
+                              &pending_count, entry.value.string);
+                break;
+            default:
+                vlc_assert_unreachable();
+        }
+    }
+
+    *count = n;
+
+    if (p == NULL || d == NULL || pending_count >= ENTRIES_MAX * 2
+     || !RingPush(ring, defs, d - defs, event, p - event))
+    {
+        ring->dropped++;
+        return;
+    }
+
+    ring->last_ts = now;
+    ring->dropped = 0;
+    for (unsigned i = 0; i < pending_count; i++)
+        pending[i]->defined = true;
+}
+
+static void WriteChunk(vlc_tracer_sys_t *sys, struct ring *ring)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t len = head - tail;
+
+    if (len == 0)
+        return;
+
+    uint8_t hdr[8];
+    SetDWLE(&hdr[0], ring->serial);
+    SetDWLE(&hdr[4], len);
+    fwrite(hdr, sizeof (hdr), 1, sys->stream);
+
+    size_t size = ring->mask + 1;
+    size_t offset = tail & ring->mask;
+    size_t first = size - offset < len ? size - offset : len;
+    fwrite(&ring->data[offset], first, 1, sys->stream);
+    if (len > first)
+        fwrite(&ring->data[0], len - first, 1, sys->stream);
+
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+}
+
+static void Drain(vlc_tracer_sys_t *sys)
+{
+    vlc_mutex_assert(&sys->lock);
+
+    struct ring *ring;
+    vlc_list_foreach(ring, &sys->rings, node)
+    {
+        bool dead = atomic_load_explicit(&ring->dead, memory_order_acquire);
+
+        WriteChunk(sys, ring);
+        if (dead)
+        {
+            vlc_list_remove(&ring->node);
+            RingDelete(ring);
+        }
+    }
+    fflush(sys->stream);
+}
+
+static void *Thread(void *data)
+{
+    vlc_tracer_sys_t *sys = data;
+
+    vlc_mutex_lock(&sys->lock);
+    while (!sys->closing)
+    {
+        Drain(sys);
+        vlc_cond_timedwait(&sys->wait, &sys->lock,
+                           vlc_tick_now() + VLC_TICK_FROM_MS(20));
+    }
+    vlc_mutex_unlock(&sys->lock);
+    return NULL;
+}
+
+static void Close(void *opaque)
+{
+    vlc_tracer_sys_t *sys = opaque;
+
+    vlc_mutex_lock(&sys->lock);
+    sys->closing = true;
+    vlc_cond_signal(&sys->wait);
+    vlc_mutex_unlock(&sys->lock);
+    vlc_join(sys->thread, NULL);
+
+    /* No more thread exit callbacks from now on */
+    vlc_threadvar_delete(&sys->key);
+
+    vlc_mutex_lock(&sys->lock);
+    Drain(sys);
+    struct ring *ring;
+    vlc_list_foreach(ring, &sys->rings, node)
+        RingDelete(ring);
+    vlc_mutex_unlock(&sys->lock);
+
+    fclose(sys->stream);
+    free(sys);
+}
+
+static const struct vlc_tracer_operations binary_ops =
+{
+    TraceBinary,
+    Close
+};
+
+static const struct vlc_tracer_operations *Open(vlc_object_t *obj,
+                                               void **restrict sysp)
+{
+    vlc_tracer_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return NULL;
+
+    size_t size = var_InheritInteger(obj, "binary-tracer-buffer") * 1024;
+    if (size < RING_MIN_SIZE)
+        size = RING_MIN_SIZE;
+    /* Round down to a power of two, for the ring mask */
+    while (size & (size - 1))
+        size &= size - 1;
+    sys->ring_size = size;
+
+    char *path = var_InheritString(obj, "binary-tracer-file");
+    const char *filename = path != NULL ? path : BINARY_FILENAME;
+
+    msg_Dbg(obj, "opening trace file `%s'", filename);
+    sys->stream = vlc_fopen(filename, "wb");
+    if (sys->stream == NULL)
+    {
+        msg_Err(obj, "error opening trace file `%s': %s", filename,
+                vlc_strerror_c(errno));
+        free(path);
+        free(sys);
+        return NULL;
+    }
+    free(path);
+
+    uint8_t hdr[16];
+    memcpy(hdr, "VLCTRACE", 8);
+    SetDWLE(&hdr[8], BINARY_VERSION);
+    SetDWLE(&hdr[12], CLOCK_FREQ);
+    fwrite(hdr, sizeof (hdr), 1, sys->stream);
+
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait);
+    vlc_list_init(&sys->rings);
+    sys->next_serial = 0;
+    sys->closing = false;
+
+    if (vlc_threadvar_create(&sys->key, RingRelease))
+        goto error;
+
+    if (vlc_clone(&sys->thread, Thread, sys, VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_threadvar_delete(&sys->key);
+        goto error;
+    }
+
+    *sysp = sys;
+    return &binary_ops;
+
+error:
+    fclose(sys->stream);
+    free(sys);
+    return NULL;
+}
+
+#define FILE_TEXT N_("Trace filename")
+#define FILE_LONGTEXT N_("Specify the binary trace filename.")
+
+#define BUFFER_TEXT N_("Trace buffer size per thread (KiB)")
+#define BUFFER_LONGTEXT N_( \
+    "Traces are dropped if a thread fills its buffer faster than it is " \
+    "written to the file.")
+
+vlc_module_begin()
+    set_shortname(N_("Binary tracer"))
+    set_description(N_("Binary ring buffer tracer"))
+    set_subcategory(SUBCAT_ADVANCED_MISC)
+    set_capability("tracer", 0)
+    set_callback(Open)
+
+    add_savefile("binary-tracer-file", NULL, FILE_TEXT, FILE_LONGTEXT)
+    add_integer("binary-tracer-buffer", 256, BUFFER_TEXT, BUFFER_LONGTEXT)
+        change_integer_range(16, 65536)
+vlc_module_end()
@@ -594,6 +594,30 @@ static int vlclua_input_metas_internal( lua_State *L, input_item_t *p_item )
     return 1;
 }
 
+static void vlclua_push_latency( lua_State *L, const char *name,
+                                 const struct vlc_latency_histogram *h )
+{
+    lua_newtable( L );
+#define LATENCY_INT( n, v ) lua_pushinteger( L, v ); \
+                            lua_setfield( L, -2, n );
+    LATENCY_INT( "count", h->count )
+    LATENCY_INT( "average", h->count ? US_FROM_VLC_TICK( h->total ) / (int64_t)h->count : 0 )
+    LATENCY_INT( "min", US_FROM_VLC_TICK( h->min ) )
+    LATENCY_INT( "max", US_FROM_VLC_TICK( h->max ) )
+    LATENCY_INT( "p50", US_FROM_VLC_TICK( vlc_latency_histogram_Percentile( h, 50 ) ) )
+    LATENCY_INT( "p95", US_FROM_VLC_TICK( vlc_latency_histogram_Percentile( h, 95 ) ) )
+    LATENCY_INT( "p99", US_FROM_VLC_TICK( vlc_latency_histogram_Percentile( h, 99 ) ) )
+#undef LATENCY_INT
+    lua_newtable( L );
+    for( unsigned i = 0; i < VLC_LATENCY_BUCKETS; i++ )
+    {
+        lua_pushinteger( L, h->buckets[i] );
+        lua_rawseti( L, -2, i + 1 );
+    }
+    lua_setfield( L, -2, "buckets" );
+    lua_setfield( L, -2, name );
+}
+
 static int vlclua_input_item_stats( lua_State *L )
 {
     input_item_t *p_item = vlclua_input_item_get_internal( L );
@@ -624,6 +648,11 @@ static int vlclua_input_item_stats( lua_State *L )
         STATS_INT( lost_pictures )
         STATS_INT( played_abuffers )
         STATS_INT( lost_abuffers )
+        /* Vout stage latencies, in microseconds */
+        vlclua_push_latency( L, "filter_latency", &p_stats->vout_latency.filter );
+        vlclua_push_latency( L, "spu_latency", &p_stats->vout_latency.spu );
+        vlclua_push_latency( L, "prepare_latency", &p_stats->vout_latency.prepare );
+        vlclua_push_latency( L, "display_error", &p_stats->vout_latency.display_error );
 #undef STATS_INT
 #undef STATS_FLOAT
     }
@@ -251,10 +251,12 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         case STREAM_GET_CONTENT_TYPE:
         case STREAM_GET_SIGNAL:
         case STREAM_GET_TAGS:
+        case STREAM_GET_ARRIVAL_TIME:
         case STREAM_SET_PAUSE_STATE:
         case STREAM_SET_PRIVATE_ID_STATE:
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
+        case STREAM_SET_SEEK_HINT:
             return vlc_stream_vaControl(s->s, i_query, args);
 
         case STREAM_SET_TITLE:
@@ -281,6 +283,14 @@ static int Open(vlc_object_t *obj)
     if (s->s->pf_block == NULL)
         return VLC_EGENERIC;
 
+    bool fast_seek;
+
+    /* Blocks of fast-seekable sources, such as memory-mapped files, are
+     * better passed through as they are, without copying them. */
+    if (vlc_stream_Control(s->s, STREAM_CAN_FASTSEEK, &fast_seek) == 0
+     && fast_seek)
+        return VLC_EGENERIC;
+
     stream_sys_t *sys = malloc(sizeof (*sys));
     if (unlikely(sys == NULL))
         return VLC_ENOMEM;
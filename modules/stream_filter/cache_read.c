@@ -464,10 +464,12 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         case STREAM_GET_SIGNAL:
         case STREAM_GET_TAGS:
         case STREAM_GET_TYPE:
+        case STREAM_GET_ARRIVAL_TIME:
         case STREAM_SET_PAUSE_STATE:
         case STREAM_SET_PRIVATE_ID_STATE:
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
+        case STREAM_SET_SEEK_HINT:
             return vlc_stream_vaControl(s->s, i_query, args);
 
         case STREAM_SET_TITLE:
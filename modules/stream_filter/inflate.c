@@ -125,6 +125,7 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_SET_PRIVATE_ID_STATE:
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
+        case STREAM_SET_SEEK_HINT:
             return VLC_EGENERIC;
         default:
             msg_Err(stream, "unimplemented query (%d) in control", query);
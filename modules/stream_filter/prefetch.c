@@ -49,6 +49,36 @@ struct stream_ctrl
     };
 };
 
+/* Read-ahead is organized in windows, each buffering a range of the source
+ * stream in a ring buffer. The window at the reader offset is the active
+ * one. The other windows hold data where the reader is expected to go:
+ *  - where it left off, when it jumped away (e.g. to read an index at the
+ *    end of the file, or the data of another track that is not interleaved),
+ *  - at the next offset of a strided access pattern,
+ *  - at offsets hinted by the demuxer.
+ * A single thread fills the windows from the source stream, seeking between
+ * them. The active window has priority, as long as it holds less data ahead
+ * than the source takes to seek and deliver; predicted windows are only
+ * filled beyond that. */
+#define PREFETCH_WINDOW_MIN     (256 << 10)
+#define PREFETCH_CHUNK_MIN      (64 << 10)
+#define PREFETCH_CHUNK_MAX      (1 << 20)
+#define PREFETCH_CHUNK_DEFAULT  (256 << 10)
+/* How long a prediction remains valid without the reader coming back */
+#define PREFETCH_PREDICTION_TTL VLC_TICK_FROM_SEC(30)
+
+struct prefetch_window
+{
+    uint64_t   offset; /* stream offset of the first buffered byte */
+    size_t     length; /* buffered bytes */
+    size_t     size; /* ring buffer size */
+    char      *buffer;
+    uint64_t   resume; /* offset the reader is (expected to be) at */
+    vlc_tick_t used; /* last use or prediction */
+    bool       predicted;
+    bool       eof;
+};
+
 typedef struct
 {
     vlc_mutex_t  lock;
@@ -57,7 +87,6 @@ typedef struct
     vlc_thread_t thread;
     vlc_interrupt_t *interrupt;
 
-    bool         eof;
     bool         error;
     bool         paused;
 
@@ -68,16 +97,287 @@ typedef struct
     vlc_tick_t   pts_delay;
     char        *content_type;
 
-    uint64_t     buffer_offset;
-    uint64_t     stream_offset;
-    size_t       buffer_length;
-    size_t       buffer_size;
-    char        *buffer;
+    uint64_t     stream_offset; /* reader offset */
+    uint64_t     upstream_offset; /* source stream offset */
     size_t       seek_threshold;
+    size_t       budget; /* total size of the windows */
+    size_t       allocated;
+    unsigned     window_count;
+    struct prefetch_window *windows;
+    struct prefetch_window *filling; /* window being read into */
+
+    /* Access pattern */
+    uint64_t     last_offset; /* reader offset after the last read */
+    uint64_t     last_target; /* last jump target */
+    int64_t      stride;
+    unsigned     strides; /* consecutive jumps by the same stride */
+
+    /* Measurements */
+    uint64_t     rate; /* consumption, bytes per second */
+    uint64_t     rate_bytes;
+    vlc_tick_t   rate_start;
+    uint64_t     throughput; /* source, bytes per second */
+    vlc_tick_t   latency; /* source seek and first read time */
+
+    struct
+    {
+        uint64_t reads;
+        uint64_t hits; /* reads served without waiting */
+        uint64_t stalls;
+        vlc_tick_t stall_time;
+        uint64_t jumps;
+        uint64_t window_hits; /* jumps to already buffered data */
+        uint64_t predictions;
+        uint64_t seeks; /* source seeks */
+    } stats;
 
     struct stream_ctrl *controls;
 } stream_sys_t;
 
+static uint64_t WindowEnd(const struct prefetch_window *w)
+{
+    return w->offset + w->length;
+}
+
+/* Whether the window can serve a read at the given offset, now or later */
+static bool WindowCovers(const struct prefetch_window *w, uint64_t offset)
+{
+    return w->buffer != NULL && offset >= w->offset && offset <= WindowEnd(w);
+}
+
+static size_t WindowAhead(const struct prefetch_window *w)
+{
+    if (w->resume < w->offset || w->resume >= WindowEnd(w))
+        return 0;
+    return WindowEnd(w) - w->resume;
+}
+
+/* Whether data can be added, possibly discarding already read data */
+static bool WindowHasSpace(const struct prefetch_window *w)
+{
+    return w->length < w->size || w->resume > w->offset;
+}
+
+static size_t PrefetchChunk(const stream_sys_t *sys)
+{
+    if (sys->throughput == 0)
+        return PREFETCH_CHUNK_DEFAULT;
+
+    /* About an eighth of a second of data */
+    uint64_t chunk = sys->throughput / 8;
+    return VLC_CLIP(chunk, PREFETCH_CHUNK_MIN, PREFETCH_CHUNK_MAX);
+}
+
+/* How much data a window needs ahead of the reader, so that the reader does
+ * not wait while the source seeks elsewhere and comes back: twice the data
+ * consumed during a seek and a read. */
+static size_t PrefetchLowWater(const stream_sys_t *sys)
+{
+    size_t chunk = PrefetchChunk(sys);
+    vlc_tick_t cover = sys->latency;
+
+    if (sys->throughput > 0)
+        cover += vlc_tick_from_samples(chunk, sys->throughput);
+
+    uint64_t bytes = 2 * sys->rate * cover / CLOCK_FREQ + chunk;
+    return __MIN(bytes, sys->budget / 2);
+}
+
+/* The first window gets half of the budget, as sequential reading is the
+ * most common case. The other windows are sized to cover the source
+ * latency at the current rate. */
+static size_t WindowSize(const stream_sys_t *sys,
+                         const struct prefetch_window *w)
+{
+    size_t avail = sys->budget - sys->allocated;
+    size_t want;
+
+    if (w->buffer != NULL)
+        avail += w->size;
+    if (sys->window_count == 1)
+        return avail;
+
+    if (sys->allocated == 0)
+        want = sys->budget / 2;
+    else
+        want = 4 * PrefetchLowWater(sys);
+    if (want < PREFETCH_WINDOW_MIN)
+        want = PREFETCH_WINDOW_MIN;
+    return __MIN(want, avail);
+}
+
+static int WindowReset(stream_sys_t *sys, struct prefetch_window *w,
+                       uint64_t offset)
+{
+    size_t size = WindowSize(sys, w);
+
+    assert(w != sys->filling);
+    if (w->buffer == NULL || w->size != size)
+    {
+        if (w->buffer != NULL)
+        {
+            sys->allocated -= w->size;
+            free(w->buffer);
+        }
+        w->buffer = malloc(size);
+        if (unlikely(w->buffer == NULL))
+            return -1;
+        w->size = size;
+        sys->allocated += size;
+    }
+
+    w->offset = offset;
+    w->length = 0;
+    w->resume = offset;
+    w->used = vlc_tick_now();
+    w->predicted = false;
+    w->eof = false;
+    return 0;
+}
+
+/* Picks a window to buffer another range: a new one while the budget
+ * allows, otherwise the least recently used one. */
+static struct prefetch_window *WindowVictim(stream_sys_t *sys,
+                                            const struct prefetch_window *keep)
+{
+    struct prefetch_window *victim = NULL;
+
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (w == sys->filling || w == keep)
+            continue;
+        if (w->buffer == NULL)
+        {
+            if (sys->budget - sys->allocated >= PREFETCH_WINDOW_MIN)
+                return w;
+            continue;
+        }
+        if (victim == NULL || w->used < victim->used)
+            victim = w;
+    }
+    return victim;
+}
+
+/* Finds the window with data at the given offset */
+static struct prefetch_window *WindowFind(stream_sys_t *sys, uint64_t offset)
+{
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (WindowCovers(w, offset) && offset < WindowEnd(w))
+            return w;
+    }
+    return NULL;
+}
+
+/* Finds the window that will serve the reader offset */
+static struct prefetch_window *WindowActive(stream_sys_t *sys)
+{
+    struct prefetch_window *active = NULL;
+    uint64_t offset = sys->stream_offset;
+
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (WindowCovers(w, offset)
+         && (active == NULL || WindowEnd(w) > WindowEnd(active)))
+            active = w;
+    }
+    return active;
+}
+
+/* Expects the reader at the given offset later on */
+static void Predict(stream_sys_t *sys, uint64_t offset)
+{
+    if (sys->window_count < 2)
+        return;
+    /* Nothing to read ahead at or past the end */
+    if (sys->size != (uint64_t)-1 && offset >= sys->size)
+        return;
+
+    struct prefetch_window *w = WindowFind(sys, offset);
+
+    if (w == NULL)
+    {
+        w = WindowVictim(sys, WindowActive(sys));
+        if (w == NULL || WindowReset(sys, w, offset))
+            return;
+    }
+    else if (w == WindowActive(sys))
+        return;
+
+    w->resume = offset;
+    w->predicted = true;
+    w->used = vlc_tick_now();
+    sys->stats.predictions++;
+    vlc_cond_signal(&sys->wait_space);
+}
+
+/* Learns from a non-sequential read */
+static void Jump(stream_sys_t *sys, uint64_t from, uint64_t to)
+{
+    sys->stats.jumps++;
+    if (WindowFind(sys, to) != NULL)
+        sys->stats.window_hits++;
+
+    /* The reader is likely to come back where it left off */
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (WindowCovers(w, from) && !WindowCovers(w, to))
+        {
+            w->resume = from;
+            w->predicted = true;
+        }
+    }
+
+    /* Strided access: predict the next jump */
+    int64_t stride = to - sys->last_target;
+
+    if (stride == sys->stride && stride != 0)
+        sys->strides++;
+    else
+    {
+        sys->stride = stride;
+        sys->strides = 0;
+    }
+    sys->last_target = to;
+
+    if (sys->strides >= 2 && (stride > 0 || to >= (uint64_t)-stride))
+        Predict(sys, to + stride);
+}
+
+/* Finds a predicted window that lacks data */
+static struct prefetch_window *WindowNeedy(stream_sys_t *sys,
+                                           const struct prefetch_window *active,
+                                           size_t low_water)
+{
+    vlc_tick_t now = vlc_tick_now();
+    struct prefetch_window *needy = NULL;
+
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        struct prefetch_window *w = &sys->windows[i];
+
+        if (w == active || !w->predicted || w->eof || w->buffer == NULL
+         || now - w->used > PREFETCH_PREDICTION_TTL
+         || WindowAhead(w) >= __MIN(low_water, w->size / 2)
+         || !WindowHasSpace(w))
+            continue;
+        /* Keep filling the same window, to avoid seeking back and forth */
+        if (w == sys->filling)
+            return w;
+        if (needy == NULL || w->used > needy->used)
+            needy = w;
+    }
+    return needy;
+}
+
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -123,6 +423,87 @@ static int ThreadControl(stream_t *stream, int query, ...)
     return ret;
 }
 
+/* Reads one chunk into a window, seeking the source first if needed */
+static void ThreadFill(stream_t *stream, struct prefetch_window *w)
+{
+    stream_sys_t *sys = stream->p_sys;
+    vlc_tick_t start = vlc_tick_now();
+    bool seeked = false;
+
+    sys->filling = w;
+
+    if (sys->upstream_offset != WindowEnd(w))
+    {
+        if (ThreadSeek(stream, WindowEnd(w)))
+        {
+            sys->filling = NULL;
+            /* Do not trust the source offset anymore */
+            sys->upstream_offset = (uint64_t)-1;
+            if (w->predicted)
+            {   /* Only a guess failed: drop it, the reader is not there */
+                w->predicted = false;
+                return;
+            }
+            sys->error = true;
+            vlc_cond_signal(&sys->wait_data);
+            return;
+        }
+        sys->upstream_offset = WindowEnd(w);
+        sys->stats.seeks++;
+        seeked = true;
+    }
+
+    assert(WindowHasSpace(w));
+    if (w->length == w->size)
+    {   /* Discard some already read data to make room. */
+        uint64_t history = w->resume - w->offset;
+        size_t len = history > w->length ? w->length : history;
+
+        w->offset += len;
+        w->length -= len;
+    }
+
+    size_t len = w->size - w->length;
+    size_t offset = WindowEnd(w) % w->size;
+    size_t chunk = PrefetchChunk(sys);
+
+    /* Do not step past the sharp edge of the circular buffer */
+    if (offset + len > w->size)
+        len = w->size - offset;
+    if (len > chunk)
+        len = chunk;
+
+    ssize_t val = ThreadRead(stream, w->buffer + offset, len);
+    if (val < 0)
+        return;
+    if (val == 0)
+    {
+        msg_Dbg(stream, "end of stream at offset %"PRIu64, WindowEnd(w));
+        w->eof = true;
+    }
+    else
+    {
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+
+        if (seeked)
+            sys->latency = sys->latency ? (3 * sys->latency + elapsed) / 4
+                                        : elapsed;
+        else if (elapsed > 0)
+        {
+            uint64_t throughput = (uint64_t)val * CLOCK_FREQ / elapsed;
+
+            sys->throughput = sys->throughput
+                ? (7 * sys->throughput + throughput) / 8 : throughput;
+        }
+    }
+
+    assert((size_t)val <= len);
+    w->length += val;
+    sys->upstream_offset += val;
+    assert(w->length <= w->size);
+    vlc_cond_signal(&sys->wait_data);
+}
+
 static void *Thread(void *data)
 {
     stream_t *stream = data;
@@ -159,105 +540,58 @@ static void *Thread(void *data)
             continue;
         }
 
-        uint_fast64_t stream_offset = sys->stream_offset;
-
-        if (stream_offset < sys->buffer_offset)
-        {   /* Need to seek backward */
-            if (ThreadSeek(stream, stream_offset) == 0)
-            {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
-                assert(!sys->error);
-                sys->eof = false;
+        uint64_t stream_offset = sys->stream_offset;
+        struct prefetch_window *active = WindowActive(sys);
+
+        /* If the reader offset is a little beyond the window being filled,
+         * read through rather than seek. The data before the reader offset
+         * will be discarded first if the window gets full. */
+        if (active == NULL && sys->filling != NULL
+         && sys->filling->buffer != NULL
+         && stream_offset > WindowEnd(sys->filling)
+         && stream_offset - WindowEnd(sys->filling) < sys->seek_threshold
+         && sys->upstream_offset == WindowEnd(sys->filling)
+         && !sys->filling->eof)
+            active = sys->filling;
+
+        if (active == NULL)
+        {   /* Nothing buffered at the reader offset: start a new window */
+            active = WindowVictim(sys, NULL);
+            if (active == NULL)
+            {   /* Only the window being filled: recycle it */
+                active = sys->filling;
+                sys->filling = NULL;
             }
-            else
+            assert(active != NULL);
+            if (WindowReset(sys, active, stream_offset))
             {
                 sys->error = true;
                 vlc_cond_signal(&sys->wait_data);
-            }
-            continue;
-        }
-
-        if (sys->eof)
-        {   /* Do not attempt to read at EOF - would busy loop */
-            vlc_cond_wait(&sys->wait_space, &sys->lock);
-            continue;
-        }
-
-        assert(stream_offset >= sys->buffer_offset);
-
-        /* As long as there is space, the buffer will retain already read
-         * ("historical") data. The data can be used if/when seeking backward.
-         * Unread data is however given precedence if the buffer is full. */
-        uint64_t history = stream_offset - sys->buffer_offset;
-
-        /* If upstream supports seeking and if the downstream offset is far
-         * beyond the upstream offset, then attempt to skip forward.
-         * If it fails, assume upstream is well-behaved such that the failed
-         * seek is a no-op, and continue as if seeking was not supported.
-         * WARNING: Except problems with misbehaving access plug-ins. */
-        if (sys->can_seek
-         && history >= (sys->buffer_length + sys->seek_threshold))
-        {
-            if (ThreadSeek(stream, stream_offset) == 0)
-            {
-                sys->buffer_offset = stream_offset;
-                sys->buffer_length = 0;
-                assert(!sys->error);
-                assert(!sys->eof);
-            }
-            else
-            {   /* Seek failure is not necessarily fatal here. We could read
-                 * data instead until the desired seek offset. But in practice,
-                 * not all upstream accesses handle reads after failed seek
-                 * correctly. Furthermore, sys->stream_offset and/or
-                 * sys->paused might have changed in the mean time. */
-                sys->error = true;
-                vlc_cond_signal(&sys->wait_data);
-            }
-            continue;
-        }
-
-        assert(sys->buffer_size >= sys->buffer_length);
-
-        size_t len = sys->buffer_size - sys->buffer_length;
-        if (len == 0)
-        {   /* Buffer is full */
-            if (history == 0)
-            {   /* Wait for data to be read */
-                vlc_cond_wait(&sys->wait_space, &sys->lock);
                 continue;
             }
+        }
 
-            /* Discard some historical data to make room. */
-            len = history > sys->buffer_length ? sys->buffer_length : history;
+        active->resume = stream_offset;
+        active->used = vlc_tick_now();
+        active->predicted = false;
 
-            sys->buffer_offset += len;
-            sys->buffer_length -= len;
-        }
+        size_t low_water = PrefetchLowWater(sys);
+        struct prefetch_window *fill = NULL;
 
-        size_t offset = (sys->buffer_offset + sys->buffer_length)
-                        % sys->buffer_size;
-         /* Do not step past the sharp edge of the circular buffer */
-        if (offset + len > sys->buffer_size)
-            len = sys->buffer_size - offset;
+        if (!active->eof && WindowHasSpace(active)
+         && WindowAhead(active) < low_water)
+            fill = active;
+        else if ((fill = WindowNeedy(sys, active, low_water)) == NULL
+              && !active->eof && WindowHasSpace(active))
+            fill = active;
 
-        ssize_t val = ThreadRead(stream, sys->buffer + offset, len);
-        if (val < 0)
+        if (fill == NULL)
+        {   /* Wait for data to be read */
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
             continue;
-        if (val == 0)
-        {
-            assert(len > 0);
-            msg_Dbg(stream, "end of stream");
-            sys->eof = true;
         }
 
-        assert((size_t)val <= len);
-        sys->buffer_length += val;
-        assert(sys->buffer_length <= sys->buffer_size);
-        //msg_Dbg(stream, "buffer: %zu/%zu", sys->buffer_length,
-        //        sys->buffer_size);
-        vlc_cond_signal(&sys->wait_data);
+        ThreadFill(stream, fill);
     }
 
     sys->error = true;
@@ -278,27 +612,46 @@ static int Seek(stream_t *stream, uint64_t offset)
     return 0;
 }
 
-static size_t BufferLevel(const stream_t *stream, bool *eof)
+/* Whether the reader offset is at or past the end of the stream */
+static bool ReadEof(const stream_sys_t *sys)
 {
-    stream_sys_t *sys = stream->p_sys;
+    for (unsigned i = 0; i < sys->window_count; i++)
+    {
+        const struct prefetch_window *w = &sys->windows[i];
 
-    *eof = false;
+        if (w->buffer != NULL && w->eof && sys->stream_offset >= w->offset
+         && sys->stream_offset >= WindowEnd(w))
+            return true;
+    }
+    return false;
+}
 
-    if (sys->stream_offset < sys->buffer_offset)
-        return 0;
-    if ((sys->stream_offset - sys->buffer_offset) >= sys->buffer_length)
+static void UpdateRate(stream_sys_t *sys, size_t bytes)
+{
+    vlc_tick_t now = vlc_tick_now();
+
+    sys->rate_bytes += bytes;
+    if (sys->rate_start == VLC_TICK_INVALID)
     {
-        *eof = sys->eof;
-        return 0;
+        sys->rate_start = now;
+        return;
     }
-    return sys->buffer_offset + sys->buffer_length - sys->stream_offset;
+    if (now - sys->rate_start < VLC_TICK_FROM_MS(250))
+        return;
+
+    uint64_t rate = sys->rate_bytes * CLOCK_FREQ / (now - sys->rate_start);
+
+    sys->rate = sys->rate ? (3 * sys->rate + rate) / 4 : rate;
+    sys->rate_bytes = 0;
+    sys->rate_start = now;
 }
 
 static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 {
     stream_sys_t *sys = stream->p_sys;
+    struct prefetch_window *w;
     size_t copy, offset;
-    bool eof;
+    vlc_tick_t stall = VLC_TICK_INVALID;
 
     if (buflen == 0)
         return buflen;
@@ -311,30 +664,53 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
         vlc_cond_signal(&sys->wait_space);
     }
 
-    while ((copy = BufferLevel(stream, &eof)) == 0 && !eof)
+    if (sys->stream_offset != sys->last_offset)
+        Jump(sys, sys->last_offset, sys->stream_offset);
+    sys->stats.reads++;
+
+    while ((w = WindowFind(sys, sys->stream_offset)) == NULL)
     {
         void *data[2];
 
-        if (sys->error)
+        if (sys->error || ReadEof(sys))
         {
+            sys->last_offset = sys->stream_offset;
             vlc_mutex_unlock(&sys->lock);
             return 0;
         }
 
+        if (stall == VLC_TICK_INVALID)
+        {
+            stall = vlc_tick_now();
+            vlc_cond_signal(&sys->wait_space);
+        }
         vlc_interrupt_forward_start(sys->interrupt, data);
         vlc_cond_wait(&sys->wait_data, &sys->lock);
         vlc_interrupt_forward_stop(data);
     }
 
-    offset = sys->stream_offset % sys->buffer_size;
+    if (stall != VLC_TICK_INVALID)
+    {
+        sys->stats.stalls++;
+        sys->stats.stall_time += vlc_tick_now() - stall;
+    }
+    else
+        sys->stats.hits++;
+
+    copy = WindowEnd(w) - sys->stream_offset;
+    offset = sys->stream_offset % w->size;
     if (copy > buflen)
         copy = buflen;
     /* Do not step past the sharp edge of the circular buffer */
-    if (offset + copy > sys->buffer_size)
-        copy = sys->buffer_size - offset;
+    if (offset + copy > w->size)
+        copy = w->size - offset;
 
-    memcpy(buf, sys->buffer + offset, copy);
+    memcpy(buf, w->buffer + offset, copy);
     sys->stream_offset += copy;
+    sys->last_offset = sys->stream_offset;
+    w->resume = sys->stream_offset;
+    w->used = vlc_tick_now();
+    UpdateRate(sys, copy);
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -410,6 +786,15 @@ static int Control(stream_t *stream, int query, va_list args)
             vlc_mutex_unlock(&sys->lock);
             break;
         }
+        case STREAM_SET_SEEK_HINT:
+        {
+            uint64_t offset = va_arg(args, uint64_t);
+
+            vlc_mutex_lock(&sys->lock);
+            Predict(sys, offset);
+            vlc_mutex_unlock(&sys->lock);
+            break;
+        }
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
             return VLC_EGENERIC;
@@ -457,25 +842,45 @@ static int Open(vlc_object_t *obj)
                            &sys->content_type))
         sys->content_type = NULL;
 
-    sys->eof = false;
     sys->error = false;
     sys->paused = false;
-    sys->buffer_offset = 0;
     sys->stream_offset = 0;
-    sys->buffer_length = 0;
-    sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
+    sys->upstream_offset = 0;
+    sys->budget = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
+    sys->window_count = var_InheritInteger(obj, "prefetch-windows");
+    sys->allocated = 0;
+    sys->filling = NULL;
+    sys->last_offset = 0;
+    sys->last_target = 0;
+    sys->stride = 0;
+    sys->strides = 0;
+    sys->rate = 0;
+    sys->rate_bytes = 0;
+    sys->rate_start = VLC_TICK_INVALID;
+    sys->throughput = 0;
+    sys->latency = 0;
+    memset(&sys->stats, 0, sizeof (sys->stats));
     sys->controls = NULL;
 
     uint64_t size = stream_Size(stream->s);
     if (size > 0)
     {   /* No point allocating a buffer larger than the source stream */
-        if (sys->buffer_size > size)
-            sys->buffer_size = size;
+        if (sys->budget > size)
+            sys->budget = size;
     }
 
-    sys->buffer = malloc(sys->buffer_size);
-    if (sys->buffer == NULL)
+    /* Without seeking, there is nothing to predict */
+    if (!sys->can_seek || sys->budget < 2 * PREFETCH_WINDOW_MIN)
+        sys->window_count = 1;
+
+    sys->windows = calloc(sys->window_count, sizeof (*sys->windows));
+    if (sys->windows == NULL)
+        goto error;
+
+    /* The first window is set up synchronously, so that the first read does
+     * not start with a seek. */
+    if (WindowReset(sys, &sys->windows[0], 0))
         goto error;
 
     sys->interrupt = vlc_interrupt_create();
@@ -494,14 +899,17 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
-    msg_Dbg(stream, "using %zu bytes buffer", sys->buffer_size);
+    msg_Dbg(stream, "using up to %u windows in %zu bytes",
+            sys->window_count, sys->budget);
     stream->pf_read = Read;
     stream->pf_seek = Seek;
     stream->pf_control = Control;
     return VLC_SUCCESS;
 
 error:
-    free(sys->buffer);
+    if (sys->windows != NULL)
+        free(sys->windows[0].buffer);
+    free(sys->windows);
     free(sys->content_type);
     free(sys);
     return VLC_ENOMEM;
@@ -524,13 +932,22 @@ static void Close (vlc_object_t *obj)
     vlc_join(sys->thread, NULL);
     vlc_interrupt_destroy(sys->interrupt);
 
+    msg_Dbg(stream, "%"PRIu64" reads, %"PRIu64" hits, %"PRIu64" stalls "
+            "(%"PRId64" ms), %"PRIu64" jumps, %"PRIu64" window hits, "
+            "%"PRIu64" predictions, %"PRIu64" source seeks",
+            sys->stats.reads, sys->stats.hits, sys->stats.stalls,
+            MS_FROM_VLC_TICK(sys->stats.stall_time), sys->stats.jumps,
+            sys->stats.window_hits, sys->stats.predictions, sys->stats.seeks);
+
     while(sys->controls)
     {
         struct stream_ctrl *ctrl = sys->controls;
         sys->controls = ctrl->next;
         free(ctrl);
     }
-    free(sys->buffer);
+    for (unsigned i = 0; i < sys->window_count; i++)
+        free(sys->windows[i].buffer);
+    free(sys->windows);
     free(sys->content_type);
     free(sys);
 }
@@ -545,6 +962,10 @@ vlc_module_begin()
     add_integer("prefetch-buffer-size", 1 << 14, N_("Buffer size"),
                 N_("Prefetch buffer size (KiB)"))
         change_integer_range(4, 1 << 20)
+    add_integer("prefetch-windows", 4, N_("Read-ahead windows"),
+                N_("Maximum number of stream ranges read ahead at once, "
+                   "for demuxers that do not read sequentially"))
+        change_integer_range(1, 16)
     add_obsolete_integer("prefetch-read-size") /* since 4.0.0 */
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"))
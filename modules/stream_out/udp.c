@@ -22,13 +22,19 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #ifdef HAVE_ARPA_INET_H
 #include <arpa/inet.h>
 #endif
+#ifdef __linux__
+# include <netinet/udp.h>
+# include <linux/net_tstamp.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -39,6 +45,43 @@
 #include <vlc_memstream.h>
 #include "sdp_helper.h"
 
+/* Datagrams sent per system call */
+#define UDP_BATCH 64
+/* Datagrams due within this window are sent together */
+#define UDP_PACE_QUANTUM VLC_TICK_FROM_MS(1)
+/* How far ahead datagrams are handed to the kernel with SO_TXTIME */
+#define UDP_TXTIME_AHEAD VLC_TICK_FROM_MS(4)
+/* Schedule discontinuity (or lateness) that resets the pacing */
+#define UDP_PACE_RESYNC VLC_TICK_FROM_SEC(1)
+/* How far beyond the delay the schedule may run ahead of the clock, and how
+ * much data may be queued, before the writer waits for the pacing thread */
+#define UDP_PACE_MAX_AHEAD VLC_TICK_FROM_SEC(1)
+#define UDP_PACE_MAX_BYTES (32 << 20)
+/* Minimum span of the stream rate estimation, for datagrams without dates */
+#define UDP_RATE_WINDOW VLC_TICK_FROM_MS(500)
+/* Period of the pacing statistics report */
+#define UDP_STATS_PERIOD VLC_TICK_FROM_SEC(10)
+
+#if defined(UDP_SEGMENT) || defined(SO_TXTIME)
+typedef union {
+    char buf[CMSG_SPACE(sizeof (uint16_t)) + CMSG_SPACE(sizeof (uint64_t))];
+    struct cmsghdr align;
+} udp_cmsg_t;
+#endif
+
+struct udp_pace_stats
+{
+    vlc_tick_t start;
+    uint64_t bytes;
+    unsigned datagrams;
+    unsigned batches;
+    unsigned max_burst; /**< Largest number of datagrams sent at once */
+    unsigned late; /**< Number of batches sent late */
+    vlc_tick_t max_late;
+    unsigned stalls; /**< Number of times the writer waited for room */
+    vlc_tick_t stalled; /**< Time the writer waited for room */
+};
+
 struct sout_stream_udp
 {
     sout_access_out_t *access;
@@ -46,6 +89,35 @@ struct sout_stream_udp
     session_descriptor_t *sap;
     int fd;
     uint_fast16_t mtu;
+    bool gso;
+    bool txtime;
+
+    /* Pacing */
+    bool paced;
+    vlc_thread_t thread;
+    vlc_mutex_t lock;
+    vlc_cond_t wait; /**< Datagrams queued, or dead */
+    vlc_cond_t drained; /**< Datagrams dequeued */
+    block_t *head; /**< Queue of datagrams, dated with their send date */
+    block_t **tailp;
+    size_t queued; /**< Bytes in the queue */
+    bool dead;
+    struct udp_pace_stats stats; /**< Protected by lock for stalls only */
+
+    /* Scheduling, writer side */
+    uint64_t rate; /**< Constant bit rate (bits/s), or 0 to follow dates */
+    vlc_tick_t delay;
+    vlc_tick_t base; /**< Send date of the reference datagram */
+    vlc_tick_t base_dts; /**< Date of the reference datagram */
+    vlc_tick_t last_dts;
+    vlc_tick_t last_date; /**< Send date of the last datagram */
+    size_t last_size; /**< Size of the last datagram */
+    uint64_t base_bytes; /**< Bytes scheduled since the reference */
+    /* Estimated rate, for datagrams without dates */
+    uint64_t est_rate; /**< bits/s, or 0 if unknown yet */
+    vlc_tick_t est_start; /**< Start of the estimation span */
+    bool est_timed; /**< Span measured with dates, rather than arrivals */
+    uint64_t est_bytes;
 };
 
 static void *Add(sout_stream_t *stream, const es_format_t *fmt)
@@ -145,47 +217,449 @@ static int Control(sout_stream_t *stream, int query, va_list args)
     return VLC_SUCCESS;
 }
 
-static ssize_t AccessOutWrite(sout_access_out_t *access, block_t *block)
+/**
+ * Sets the ancillary data of a message: the GSO segment size (or 0) and the
+ * transmission time (or VLC_TICK_INVALID).
+ */
+static void SetControl(struct msghdr *msg, void *buf, size_t segment,
+                       vlc_tick_t txtime)
+{
+#if defined(UDP_SEGMENT) || defined(SO_TXTIME)
+    msg->msg_control = buf;
+    msg->msg_controllen = sizeof (udp_cmsg_t);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg);
+    size_t len = 0;
+
+# ifdef UDP_SEGMENT
+    if (segment > 0) {
+        uint16_t val = segment;
+
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof (val));
+        memcpy(CMSG_DATA(cmsg), &val, sizeof (val));
+        len += CMSG_SPACE(sizeof (val));
+        cmsg = CMSG_NXTHDR(msg, cmsg);
+    }
+# endif
+# ifdef SO_TXTIME
+    if (txtime != VLC_TICK_INVALID) {
+        uint64_t val = NS_FROM_VLC_TICK(txtime);
+
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_TXTIME;
+        cmsg->cmsg_len = CMSG_LEN(sizeof (val));
+        memcpy(CMSG_DATA(cmsg), &val, sizeof (val));
+        len += CMSG_SPACE(sizeof (val));
+    }
+# endif
+    msg->msg_controllen = len;
+    if (len == 0)
+        msg->msg_control = NULL;
+#else
+    (void) msg; (void) buf; (void) segment; (void) txtime;
+#endif
+}
+
+/**
+ * Sends datagrams with as few system calls as possible.
+ *
+ * With GSO, consecutive datagrams of the same size are merged into a single
+ * message, which the kernel (or the network device) segments.
+ * With SO_TXTIME, the date of each datagram is its transmission time.
+ */
+static ssize_t SendDatagrams(sout_access_out_t *access,
+                             block_t *const *dgrams, unsigned count)
 {
     struct sout_stream_udp *sys = access->p_sys;
+    struct iovec iov[UDP_BATCH];
+    struct msghdr msgs[UDP_BATCH];
+#if defined(UDP_SEGMENT) || defined(SO_TXTIME)
+    udp_cmsg_t cmsgs[UDP_BATCH];
+#else
+    char cmsgs[UDP_BATCH][1];
+#endif
+    size_t sizes[UDP_BATCH];
+    vlc_tick_t now = vlc_tick_now();
+    unsigned n = 0;
     ssize_t total = 0;
 
-    while (block != NULL) {
-        struct iovec iov[16];
-        block_t *unsent = block;
-        unsigned iovlen = 0;
-        size_t tosend = 0;
-
-        /* Count how many blocks to gather */
-        do {
-            if (iovlen >= ARRAY_SIZE(iov))
-                break;
-            if (unsent->i_buffer + tosend > sys->mtu && likely(iovlen > 0))
-                break;
+    assert(count <= UDP_BATCH);
+
+    for (unsigned i = 0; i < count; i++) {
+        iov[i].iov_base = dgrams[i]->p_buffer;
+        iov[i].iov_len = dgrams[i]->i_buffer;
+
+        if (sys->gso && n > 0) {
+            struct msghdr *prev = &msgs[n - 1];
+            size_t segment = prev->msg_iov[0].iov_len;
+
+            /* All segments but the last one must be of the same size */
+            if (prev->msg_iov[prev->msg_iovlen - 1].iov_len == segment
+             && iov[i].iov_len <= segment
+             && sizes[n - 1] + iov[i].iov_len <= 65000
+             && prev->msg_iovlen < 64) {
+                prev->msg_iovlen++;
+                sizes[n - 1] += iov[i].iov_len;
+                continue;
+            }
+        }
+
+        memset(&msgs[n], 0, sizeof (msgs[n]));
+        msgs[n].msg_iov = &iov[i];
+        msgs[n].msg_iovlen = 1;
+        sizes[n] = iov[i].iov_len;
+        n++;
+    }
 
-            iov[iovlen].iov_base = unsent->p_buffer;
-            iov[iovlen].iov_len = unsent->i_buffer;
-            iovlen++;
-            tosend += unsent->i_buffer;
-            unsent = unsent->p_next;
-        } while (unsent != NULL);
+    for (unsigned i = 0; i < n; i++) {
+        struct msghdr *msg = &msgs[i];
+        size_t segment = (msg->msg_iovlen > 1) ? msg->msg_iov[0].iov_len : 0;
+        vlc_tick_t txtime = VLC_TICK_INVALID;
 
-        /* Send */
-        struct msghdr hdr = { .msg_iov = iov, .msg_iovlen = iovlen };
-        int val = sendmsg(sys->fd, &hdr, 0);
+        if (sys->txtime) {
+            const block_t *first = dgrams[msg->msg_iov - iov];
 
-        if (val < 0)
-            msg_Err(access, "send error: %s", vlc_strerror_c(errno));
-        else
+            /* Past transmission times are dropped by the ETF scheduler */
+            txtime = (first->i_dts > now) ? first->i_dts : now;
+        }
+        SetControl(msg, &cmsgs[i], segment, txtime);
+    }
+
+#ifdef HAVE_SENDMMSG
+    struct mmsghdr mmsgs[UDP_BATCH];
+
+    for (unsigned i = 0; i < n; i++) {
+        mmsgs[i].msg_hdr = msgs[i];
+        mmsgs[i].msg_len = 0;
+    }
+#endif
+
+    for (unsigned i = 0; i < n;) {
+#ifdef HAVE_SENDMMSG
+        int val = sendmmsg(sys->fd, &mmsgs[i], n - i, 0);
+
+        if (val > 0) {
+            for (int j = 0; j < val; j++)
+                total += mmsgs[i + j].msg_len;
+            i += val;
+            continue;
+        }
+#else
+        ssize_t val = sendmsg(sys->fd, &msgs[i], 0);
+
+        if (val >= 0) {
             total += val;
+            i++;
+            continue;
+        }
+#endif
+        msg_Err(access, "send error: %s", vlc_strerror_c(errno));
+        i++; /* skip the failing datagram */
+    }
+
+    return total;
+}
+
+/**
+ * Extracts the next datagram from a chain of blocks.
+ *
+ * Blocks are gathered up to the MTU, and copied in a single block if there
+ * are more than one.
+ */
+static block_t *NextDatagram(block_t **restrict chain, size_t mtu)
+{
+    block_t *first = *chain, *unsent = first;
+    size_t tosend = 0;
+    unsigned count = 0;
+
+    do {
+        if (unsent->i_buffer + tosend > mtu && likely(count > 0))
+            break;
+
+        tosend += unsent->i_buffer;
+        unsent = unsent->p_next;
+        count++;
+    } while (unsent != NULL);
+
+    *chain = unsent;
+
+    if (count == 1) {
+        first->p_next = NULL;
+        return first;
+    }
+
+    block_t *dgram = block_Alloc(tosend);
+
+    if (likely(dgram != NULL)) {
+        block_CopyProperties(dgram, first);
+        dgram->i_buffer = 0;
+    }
+
+    for (block_t *b = first; b != unsent;) {
+        block_t *next = b->p_next;
+
+        if (likely(dgram != NULL)) {
+            memcpy(dgram->p_buffer + dgram->i_buffer, b->p_buffer,
+                   b->i_buffer);
+            dgram->i_buffer += b->i_buffer;
+        }
+        block_Release(b);
+        b = next;
+    }
+    return dgram;
+}
 
-        /* Free */
-        do {
-            block_t *next = block->p_next;
+/**
+ * Estimates the stream rate, from the dates of the datagrams or, if there
+ * are none (e.g. with the avformat muxer), from their arrival times.
+ */
+static void EstimateRate(struct sout_stream_udp *sys, vlc_tick_t dts,
+                         size_t size, vlc_tick_t now)
+{
+    bool timed = dts != VLC_TICK_INVALID;
+    vlc_tick_t t = timed ? dts : now;
+
+    if (sys->est_start == VLC_TICK_INVALID || timed != sys->est_timed
+     || t < sys->est_start || t - sys->est_start > 4 * UDP_RATE_WINDOW) {
+        sys->est_start = t;
+        sys->est_timed = timed;
+        sys->est_bytes = 0;
+    } else if (t - sys->est_start >= UDP_RATE_WINDOW) {
+        sys->est_rate = sys->est_bytes * 8 * CLOCK_FREQ
+                      / (t - sys->est_start);
+        sys->est_start = t;
+        sys->est_bytes = 0;
+    }
+    sys->est_bytes += size;
+}
+
+/**
+ * Computes the send date of a datagram, from the constant bit rate, from
+ * the block dates or, for blocks without dates, from the estimated rate.
+ */
+static vlc_tick_t Schedule(sout_access_out_t *access, const block_t *dgram)
+{
+    struct sout_stream_udp *sys = access->p_sys;
+    vlc_tick_t now = vlc_tick_now();
+    vlc_tick_t dts = dgram->i_dts;
+    vlc_tick_t date;
+
+    if (sys->rate == 0)
+        EstimateRate(sys, dts, dgram->i_buffer, now);
+
+    if (sys->base == VLC_TICK_INVALID)
+        goto resync;
+
+    if (sys->rate > 0)
+        date = sys->base + vlc_tick_from_samples(sys->base_bytes * 8,
+                                                 sys->rate);
+    else if (dts == VLC_TICK_INVALID) {
+        if (sys->est_rate == 0)
+            goto resync; /* nothing to follow yet */
+        date = sys->last_date + vlc_tick_from_samples(sys->last_size * 8,
+                                                      sys->est_rate);
+    } else if (sys->last_dts == VLC_TICK_INVALID || dts < sys->last_dts
+            || dts > sys->last_dts + UDP_PACE_RESYNC)
+        goto resync;
+    else
+        date = sys->base + (dts - sys->base_dts);
 
-            block_Release(block);
-            block = next;
-        } while (block != unsent);
+    if (date < now - UDP_PACE_RESYNC) {
+        msg_Warn(access, "pacing late by %"PRId64" ms, resetting",
+                 MS_FROM_VLC_TICK(now - date));
+        goto resync;
+    }
+    goto out;
+
+resync:
+    if (sys->base != VLC_TICK_INVALID && sys->rate == 0
+     && dts != VLC_TICK_INVALID)
+        msg_Dbg(access, "pacing discontinuity");
+    sys->base = date = now + sys->delay;
+    sys->base_dts = dts;
+    sys->base_bytes = 0;
+out:
+    if (dts != VLC_TICK_INVALID)
+        sys->last_dts = dts;
+    sys->last_date = date;
+    sys->last_size = dgram->i_buffer;
+    sys->base_bytes += dgram->i_buffer;
+    return date;
+}
+
+static void ReportStats(sout_access_out_t *access, vlc_tick_t now)
+{
+    struct sout_stream_udp *sys = access->p_sys;
+    struct udp_pace_stats *st = &sys->stats;
+    vlc_tick_t elapsed = now - st->start;
+
+    vlc_mutex_lock(&sys->lock);
+    if (elapsed > 0 && st->datagrams > 0)
+        msg_Dbg(access, "paced %u datagrams in %u batches: %.0f kb/s, "
+                "max burst %u datagrams, %u batches late (max %"PRId64
+                " us), writer waited %u times (%"PRId64" ms)",
+                st->datagrams, st->batches,
+                st->bytes * 8. / 1000. / secf_from_vlc_tick(elapsed),
+                st->max_burst, st->late, US_FROM_VLC_TICK(st->max_late),
+                st->stalls, MS_FROM_VLC_TICK(st->stalled));
+
+    memset(st, 0, sizeof (*st));
+    st->start = now;
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void *PaceThread(void *data)
+{
+    sout_access_out_t *access = data;
+    struct sout_stream_udp *sys = access->p_sys;
+    vlc_tick_t ahead = sys->txtime ? UDP_TXTIME_AHEAD : UDP_PACE_QUANTUM;
+
+    sys->stats.start = vlc_tick_now();
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;) {
+        block_t *head = sys->head;
+        bool dead = sys->dead; /* if so, send whatever is left at once */
+
+        if (head == NULL) {
+            if (dead)
+                break;
+            vlc_cond_wait(&sys->wait, &sys->lock);
+            continue;
+        }
+        if (!dead && head->i_dts - ahead > vlc_tick_now()) {
+            vlc_cond_timedwait(&sys->wait, &sys->lock, head->i_dts - ahead);
+            continue;
+        }
+
+        block_t *dgrams[UDP_BATCH];
+        unsigned count = 0;
+        vlc_tick_t now = vlc_tick_now();
+
+        while (head != NULL && count < UDP_BATCH
+            && (dead || head->i_dts - ahead <= now)) {
+            dgrams[count++] = head;
+            sys->queued -= head->i_buffer;
+            head = head->p_next;
+        }
+        sys->head = head;
+        if (head == NULL)
+            sys->tailp = &sys->head;
+        vlc_cond_signal(&sys->drained);
+        vlc_mutex_unlock(&sys->lock);
+
+        struct udp_pace_stats *st = &sys->stats;
+
+        if (!dead) { /* the final flush is not paced */
+            vlc_tick_t late = now - dgrams[0]->i_dts;
+
+            if (!sys->txtime && late > UDP_PACE_QUANTUM) {
+                st->late++;
+                if (late > st->max_late)
+                    st->max_late = late;
+            }
+            if (count > st->max_burst)
+                st->max_burst = count;
+        }
+        st->batches++;
+        st->datagrams += count;
+        st->bytes += SendDatagrams(access, dgrams, count);
+
+        for (unsigned i = 0; i < count; i++)
+            block_Release(dgrams[i]);
+
+        if (now - st->start >= UDP_STATS_PERIOD)
+            ReportStats(access, now);
+
+        vlc_mutex_lock(&sys->lock);
+    }
+    vlc_mutex_unlock(&sys->lock);
+
+    ReportStats(access, vlc_tick_now());
+    return NULL;
+}
+
+/** Sends the queued datagrams at once, and stops the pacing thread */
+static void PaceStop(struct sout_stream_udp *sys)
+{
+    vlc_mutex_lock(&sys->lock);
+    sys->dead = true;
+    vlc_cond_signal(&sys->wait);
+    vlc_cond_signal(&sys->drained);
+    vlc_mutex_unlock(&sys->lock);
+    vlc_join(sys->thread, NULL);
+}
+
+static ssize_t AccessOutWrite(sout_access_out_t *access, block_t *block)
+{
+    struct sout_stream_udp *sys = access->p_sys;
+    block_t *dgrams[UDP_BATCH];
+    unsigned count = 0;
+    ssize_t total = 0;
+
+    if (sys->paced) {
+        block_t *list = NULL, **tailp = &list;
+
+        vlc_mutex_lock(&sys->lock);
+        /* Bound the queue, whether the rate is below the input rate or the
+         * input comes faster than real time: wait for the pacing thread */
+        vlc_tick_t limit = sys->delay + UDP_PACE_MAX_AHEAD;
+        vlc_tick_t start = vlc_tick_now();
+        bool stalled = false;
+
+        while (!sys->dead && sys->head != NULL) {
+            if (sys->queued > UDP_PACE_MAX_BYTES)
+                vlc_cond_wait(&sys->drained, &sys->lock);
+            else if (sys->last_date - limit > vlc_tick_now())
+                vlc_cond_timedwait(&sys->drained, &sys->lock,
+                                   sys->last_date - limit);
+            else
+                break;
+            stalled = true;
+        }
+        if (stalled) {
+            sys->stats.stalls++;
+            sys->stats.stalled += vlc_tick_now() - start;
+        }
+        vlc_mutex_unlock(&sys->lock);
+
+        while (block != NULL) {
+            block_t *dgram = NextDatagram(&block, sys->mtu);
+
+            if (unlikely(dgram == NULL))
+                continue;
+
+            total += dgram->i_buffer;
+            /* The date becomes the scheduled send date */
+            dgram->i_dts = Schedule(access, dgram);
+            *tailp = dgram;
+            tailp = &dgram->p_next;
+        }
+
+        if (list != NULL) {
+            vlc_mutex_lock(&sys->lock);
+            *sys->tailp = list;
+            sys->tailp = tailp;
+            sys->queued += total;
+            vlc_cond_signal(&sys->wait);
+            vlc_mutex_unlock(&sys->lock);
+        }
+        return total;
+    }
+
+    while (block != NULL) {
+        block_t *dgram = NextDatagram(&block, sys->mtu);
+
+        if (likely(dgram != NULL))
+            dgrams[count++] = dgram;
+
+        if (count == UDP_BATCH || (block == NULL && count > 0)) {
+            total += SendDatagrams(access, dgrams, count);
+            while (count > 0)
+                block_Release(dgrams[--count]);
+        }
     }
 
     return total;
@@ -200,6 +674,8 @@ static void Close(vlc_object_t *obj)
         sout_AnnounceUnRegister(stream, sys->sap);
 
     sout_MuxDelete(sys->mux);
+    if (sys->paced)
+        PaceStop(sys);
     sout_AccessOutDelete(sys->access);
     net_Close(sys->fd);
     free(sys);
@@ -210,7 +686,8 @@ static const struct sout_stream_operations ops = {
 };
 
 static const char *const chain_options[] = {
-    "avformat", "dst", "sap", "name", "description", NULL
+    "avformat", "dst", "sap", "name", "description",
+    "pace", "rate", "delay", "gso", "txtime", NULL
 };
 
 #define DEFAULT_PORT 1234
@@ -308,9 +785,64 @@ static int Open(vlc_object_t *obj)
     sys->access = access;
     sys->fd = fd;
     sys->mtu = var_InheritInteger(stream, "mtu");
+    sys->gso = false;
+    sys->txtime = false;
+    sys->rate = var_GetInteger(stream, SOUT_CFG_PREFIX "rate") * 1000;
+    sys->paced = sys->rate > 0 || var_GetBool(stream, SOUT_CFG_PREFIX "pace");
+    sys->delay = VLC_TICK_FROM_MS(var_GetInteger(stream,
+                                                 SOUT_CFG_PREFIX "delay"));
+    sys->base = VLC_TICK_INVALID;
+    sys->last_dts = VLC_TICK_INVALID;
+    sys->last_date = VLC_TICK_INVALID;
+    sys->last_size = 0;
+    sys->est_rate = 0;
+    sys->est_start = VLC_TICK_INVALID;
+    sys->est_timed = false;
+    sys->est_bytes = 0;
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait);
+    vlc_cond_init(&sys->drained);
+    sys->head = NULL;
+    sys->tailp = &sys->head;
+    sys->queued = 0;
+    sys->dead = false;
+    memset(&sys->stats, 0, sizeof (sys->stats));
+
+#ifdef UDP_SEGMENT
+    if (var_GetBool(stream, SOUT_CFG_PREFIX "gso")) {
+        /* Probe kernel support with an (invalid) zero segment size */
+        if (setsockopt(fd, SOL_UDP, UDP_SEGMENT, &(int){ 0 },
+                       sizeof (int)) == 0)
+            sys->gso = true;
+        else
+            msg_Warn(stream, "UDP segmentation offload not supported");
+    }
+#endif
+#ifdef SO_TXTIME
+    if (sys->paced && var_GetBool(stream, SOUT_CFG_PREFIX "txtime")) {
+        struct sock_txtime cfg = { .clockid = CLOCK_MONOTONIC, .flags = 0 };
+
+        if (setsockopt(fd, SOL_SOCKET, SO_TXTIME, &cfg, sizeof (cfg)) == 0)
+            sys->txtime = true;
+        else
+            msg_Warn(stream, "transmission time not supported: %s",
+                     vlc_strerror_c(errno));
+    }
+#endif
+
+    /* Started first, as the muxer may write as soon as it is created, and
+     * when it is deleted */
+    if (sys->paced
+     && vlc_clone(&sys->thread, PaceThread, access,
+                  VLC_THREAD_PRIORITY_OUTPUT)) {
+        ret = VLC_ENOMEM;
+        goto error;
+    }
 
     sout_mux_t *mux = sout_MuxNew(access, muxmod);
     if (mux == NULL) {
+        if (sys->paced)
+            PaceStop(sys);
         ret = VLC_ENOTSUP;
         goto error;
     }
@@ -346,6 +878,26 @@ error:
 #define DESC_TEXT N_("SAP description")
 #define DESC_LONGTEXT N_( \
     "Short description of the stream that will be announced with SAP.")
+#define PACE_TEXT N_("Pace output")
+#define PACE_LONGTEXT N_( \
+    "Send the datagrams at regular intervals according to their dates, " \
+    "from a dedicated thread, rather than in bursts as they are muxed.")
+#define RATE_TEXT N_("Constant bit rate (kb/s)")
+#define RATE_LONGTEXT N_( \
+    "Pace the output at this constant bit rate rather than according to " \
+    "the dates. 0 disables this.")
+#define DELAY_TEXT N_("Pacing delay (ms)")
+#define DELAY_LONGTEXT N_( \
+    "Delay applied to paced datagrams, to absorb the muxing jitter.")
+#define GSO_TEXT N_("Segmentation offload")
+#define GSO_LONGTEXT N_( \
+    "Send several datagrams of the same size at once and let the kernel " \
+    "or the network interface split them (Linux only).")
+#define TXTIME_TEXT N_("Transmission time")
+#define TXTIME_LONGTEXT N_( \
+    "Hand paced datagrams to the kernel ahead of time, with their " \
+    "transmission time, for the ETF or FQ queue disciplines to release " \
+    "them (Linux only).")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -359,6 +911,13 @@ vlc_module_begin()
     add_bool(SOUT_CFG_PREFIX "sap", false, SAP_TEXT, SAP_LONGTEXT)
     add_string(SOUT_CFG_PREFIX "name", "", NAME_TEXT, NAME_LONGTEXT)
     add_string(SOUT_CFG_PREFIX "description", "", DESC_TEXT, DESC_LONGTEXT)
+    add_bool(SOUT_CFG_PREFIX "pace", false, PACE_TEXT, PACE_LONGTEXT)
+    add_integer(SOUT_CFG_PREFIX "rate", 0, RATE_TEXT, RATE_LONGTEXT)
+        change_integer_range(0, 10000000)
+    add_integer(SOUT_CFG_PREFIX "delay", 100, DELAY_TEXT, DELAY_LONGTEXT)
+        change_integer_range(0, 10000)
+    add_bool(SOUT_CFG_PREFIX "gso", false, GSO_TEXT, GSO_LONGTEXT)
+    add_bool(SOUT_CFG_PREFIX "txtime", false, TXTIME_TEXT, TXTIME_LONGTEXT)
 
     set_callbacks(Open, Close)
 vlc_module_end()
@@ -357,6 +357,18 @@ function stats(name,client)
     client:append("| frames late      :    "..string.format("%5i",stats_tab["late_pictures"]))
     client:append("| frames lost      :    "..string.format("%5i",stats_tab["lost_pictures"]))
     client:append("|")
+    client:append("+-[Video Output Timing] (count, avg/p50/p95/p99/max in us)")
+    for _, stage in ipairs({ { "filter_latency", "filters         " },
+                             { "spu_latency", "subtitles       " },
+                             { "prepare_latency", "display prepare " },
+                             { "display_error", "display error   " } }) do
+        local h = stats_tab[stage[1]]
+        if h ~= nil and h["count"] > 0 then
+            client:append("| "..stage[2]..": "..string.format("%5i, %i/%i/%i/%i/%i",
+                h["count"], h["average"], h["p50"], h["p95"], h["p99"], h["max"]))
+        end
+    end
+    client:append("|")
     client:append("+-[Audio Decoding]")
     client:append("| audio decoded    :    "..string.format("%5i",stats_tab["decoded_audio"]))
     client:append("| buffers played   :    "..string.format("%5i",stats_tab["played_abuffers"]))
@@ -33,6 +33,7 @@
 
 #include <vlc_common.h>
 #include <vlc_aout.h>
+#include <vlc_tracer.h>
 
 #include "aout_internal.h"
 #include "clock/clock.h"
@@ -493,7 +494,13 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
 
     /* Output */
     owner->sync.discontinuity = false;
+
+    struct vlc_tracer *tracer = vlc_object_get_tracer(VLC_OBJECT(aout));
+    if (tracer != NULL)
+        vlc_tracer_TraceBegin(tracer, "RENDER", "aout", "play");
     aout->play(aout, block, play_date);
+    if (tracer != NULL)
+        vlc_tracer_TraceEnd(tracer, "RENDER", "aout", "play");
 
     atomic_fetch_add_explicit(&owner->buffers_played, 1, memory_order_relaxed);
     return ret;
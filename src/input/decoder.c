@@ -64,6 +64,9 @@ enum reload
     RELOAD_DECODER_AOUT /* Stop the aout and reload the decoder module */
 };
 
+/* Blocks queued without locking before falling back to the locked FIFO */
+#define DECODER_FIFO_SLOTS 256
+
 struct vlc_input_decoder_t
 {
     decoder_t        dec;
@@ -876,6 +879,12 @@ static void DecoderThread_ProcessSout( vlc_input_decoder_t *p_owner, vlc_frame_t
     while( ( sout_frame =
                  p_dec->pf_packetize( p_dec, ppframe ) ) )
     {
+        struct vlc_tracer *tracer = vlc_object_get_tracer( &p_dec->obj );
+        if( tracer != NULL )
+            vlc_tracer_TraceStreamDTS( tracer, "PACKETIZER", p_owner->psz_id,
+                                       "OUT", sout_frame->i_pts,
+                                       sout_frame->i_dts );
+
         if( p_owner->p_sout_input == NULL )
         {
             vlc_mutex_lock( &p_owner->lock );
@@ -990,11 +999,11 @@ static void DecoderPlayCc( vlc_input_decoder_t *p_owner, vlc_frame_t *p_cc,
 
         if( i_bitmap > 1 )
         {
-            block_FifoPut( p_ccowner->p_fifo, block_Duplicate(p_cc) );
+            vlc_fifo_Push( p_ccowner->p_fifo, block_Duplicate(p_cc) );
         }
         else
         {
-            block_FifoPut( p_ccowner->p_fifo, p_cc );
+            vlc_fifo_Push( p_ccowner->p_fifo, p_cc );
             p_cc = NULL; /* was last dec */
         }
     }
@@ -1112,13 +1121,17 @@ static void ModuleThread_UpdateStatVideo( vlc_input_decoder_t *p_owner,
     unsigned displayed = 0;
     unsigned vout_lost = 0;
     unsigned vout_late = 0;
+    struct vlc_vout_latency latency;
+    vlc_vout_latency_Init( &latency );
     if( p_owner->p_vout != NULL )
     {
-        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost, &vout_late );
+        vout_GetResetStatistic( p_owner->p_vout, &displayed, &vout_lost,
+                                &vout_late, &latency );
     }
     if (lost) vout_lost++;
 
-    decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed, vout_late);
+    decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed,
+                   vout_late, &latency);
 }
 
 static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
@@ -1423,6 +1436,7 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
         vlc_frame_t *packetized_frame;
         vlc_frame_t **ppframe = frame ? &frame : NULL;
         decoder_t *p_packetizer = p_owner->p_packetizer;
+        struct vlc_tracer *tracer = vlc_object_get_tracer( &p_packetizer->obj );
 
         while( (packetized_frame =
                 p_packetizer->pf_packetize( p_packetizer, ppframe ) ) )
@@ -1450,6 +1464,12 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, vlc_frame_
                 vlc_frame_t *p_next = packetized_frame->p_next;
                 packetized_frame->p_next = NULL;
 
+                if( tracer != NULL )
+                    vlc_tracer_TraceStreamDTS( tracer, "PACKETIZER",
+                                               p_owner->psz_id, "OUT",
+                                               packetized_frame->i_pts,
+                                               packetized_frame->i_dts );
+
                 DecoderThread_DecodeBlock( p_owner, packetized_frame );
                 if( p_owner->error )
                 {
@@ -1861,8 +1881,9 @@ CreateDecoder( vlc_object_t *p_parent, const es_format_t *fmt,
 
     es_format_Init( &p_owner->fmt, fmt->i_cat, 0 );
 
-    /* decoder fifo */
-    p_owner->p_fifo = block_FifoNew();
+    /* decoder fifo: fed by a single thread (es_out or the parent decoder for
+     * CC), so that queuing does not contend with the decoder thread */
+    p_owner->p_fifo = vlc_fifo_NewSingleProducer( DECODER_FIFO_SLOTS );
     if( unlikely(p_owner->p_fifo == NULL) )
     {
         vlc_object_delete(p_dec);
@@ -2235,17 +2256,18 @@ void vlc_input_decoder_Delete( vlc_input_decoder_t *p_owner )
 void vlc_input_decoder_Decode( vlc_input_decoder_t *p_owner, vlc_frame_t *frame,
                                bool b_do_pace )
 {
-    vlc_fifo_Lock( p_owner->p_fifo );
     if( !b_do_pace )
     {
         /* FIXME: ideally we would check the time amount of data
          * in the FIFO instead of its size. */
         /* 400 MiB, i.e. ~ 50mb/s for 60s */
-        if( vlc_fifo_GetBytes( p_owner->p_fifo ) > 400*1024*1024 )
+        if( unlikely(vlc_fifo_GetBytesRelaxed( p_owner->p_fifo ) > 400*1024*1024) )
         {
             msg_Warn( &p_owner->dec, "decoder/packetizer fifo full (data not "
                       "consumed quickly enough), resetting fifo!" );
+            vlc_fifo_Lock( p_owner->p_fifo );
             block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+            vlc_fifo_Unlock( p_owner->p_fifo );
             frame->i_flags |= BLOCK_FLAG_DISCONTINUITY;
         }
     }
@@ -2254,12 +2276,14 @@ void vlc_input_decoder_Decode( vlc_input_decoder_t *p_owner, vlc_frame_t *frame,
     {   /* The FIFO is not consumed when waiting, so pacing would deadlock VLC.
          * Locking is not necessary as b_waiting is only read, not written by
          * the decoder thread. */
+        vlc_fifo_Lock( p_owner->p_fifo );
         while( vlc_fifo_GetCount( p_owner->p_fifo ) >= 10 )
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
+        vlc_fifo_Unlock( p_owner->p_fifo );
     }
 
-    vlc_fifo_QueueUnlocked( p_owner->p_fifo, frame );
-    vlc_fifo_Unlock( p_owner->p_fifo );
+    /* Lock-free unless the decoder thread is waiting for input */
+    vlc_fifo_Push( p_owner->p_fifo, frame );
 }
 
 bool vlc_input_decoder_IsEmpty( vlc_input_decoder_t * p_owner )
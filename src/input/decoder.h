@@ -28,6 +28,8 @@
 #include <vlc_codec.h>
 #include <vlc_mouse.h>
 
+struct vlc_vout_latency;
+
 struct vlc_input_decoder_callbacks {
     /* notifications */
     void (*on_vout_started)(vlc_input_decoder_t *decoder, vout_thread_t *vout,
@@ -40,6 +42,7 @@ struct vlc_input_decoder_callbacks {
 
     void (*on_new_video_stats)(vlc_input_decoder_t *decoder, unsigned decoded,
                                unsigned lost, unsigned displayed, unsigned late,
+                               const struct vlc_vout_latency *latency,
                                void *userdata);
     void (*on_new_audio_stats)(vlc_input_decoder_t *decoder, unsigned decoded,
                                unsigned lost, unsigned played, void *userdata);
@@ -392,7 +392,8 @@ decoder_on_thumbnail_ready(vlc_input_decoder_t *decoder, picture_t *pic, void *u
 
 static void
 decoder_on_new_video_stats(vlc_input_decoder_t *decoder, unsigned decoded, unsigned lost,
-                           unsigned displayed, unsigned late, void *userdata)
+                           unsigned displayed, unsigned late,
+                           const struct vlc_vout_latency *latency, void *userdata)
 {
     (void) decoder;
 
@@ -415,6 +416,7 @@ decoder_on_new_video_stats(vlc_input_decoder_t *decoder, unsigned decoded, unsig
                               memory_order_relaxed);
     atomic_fetch_add_explicit(&stats->late_pictures, late,
                               memory_order_relaxed);
+    input_stats_AddVoutLatency(stats, latency);
 }
 
 static void
@@ -739,11 +739,16 @@ struct input_stats {
     atomic_uintmax_t displayed_pictures;
     atomic_uintmax_t late_pictures;
     atomic_uintmax_t lost_pictures;
+
+    vlc_mutex_t latency_lock;
+    struct vlc_vout_latency vout_latency;
 };
 
 struct input_stats *input_stats_Create(void);
 void input_stats_Destroy(struct input_stats *);
 void input_rate_Add(input_rate_t *, uintmax_t);
+void input_stats_AddVoutLatency(struct input_stats *,
+                                const struct vlc_vout_latency *);
 void input_stats_Compute(struct input_stats *, input_stats_t*);
 
 #endif
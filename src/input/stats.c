@@ -68,6 +68,8 @@ struct input_stats *input_stats_Create(void)
     atomic_init(&stats->displayed_pictures, 0);
     atomic_init(&stats->late_pictures, 0);
     atomic_init(&stats->lost_pictures, 0);
+    vlc_mutex_init(&stats->latency_lock);
+    vlc_vout_latency_Init(&stats->vout_latency);
     return stats;
 }
 
@@ -111,6 +113,21 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+    vlc_mutex_lock(&stats->latency_lock);
+    st->vout_latency = stats->vout_latency;
+    vlc_mutex_unlock(&stats->latency_lock);
+}
+
+void input_stats_AddVoutLatency(struct input_stats *stats,
+                                const struct vlc_vout_latency *latency)
+{
+    if (latency->filter.count == 0 && latency->spu.count == 0
+     && latency->prepare.count == 0 && latency->display_error.count == 0)
+        return;
+
+    vlc_mutex_lock(&stats->latency_lock);
+    vlc_vout_latency_Merge(&stats->vout_latency, latency);
+    vlc_mutex_unlock(&stats->latency_lock);
 }
 
 /** Update a counter element with new values
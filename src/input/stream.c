@@ -33,11 +33,13 @@
 #include <errno.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_block.h>
 #include <vlc_access.h>
 #include <vlc_charset.h>
 #include <vlc_interrupt.h>
 #include <vlc_stream_extractor.h>
+#include <vlc_tracer.h>
 
 #include <libvlc.h>
 #include "stream.h"
@@ -422,6 +424,13 @@ static ssize_t vlc_stream_CopyBlock(block_t **restrict pp,
     return likely(len > 0) ? (ssize_t)len : -1;
 }
 
+static void vlc_stream_TraceRead(stream_t *s, ssize_t ret)
+{
+    struct vlc_tracer *tracer = vlc_object_get_tracer(VLC_OBJECT(s));
+    if (tracer != NULL && ret > 0)
+        vlc_tracer_TraceStreamSize(tracer, "STREAM", s->psz_name, "READ", ret);
+}
+
 static ssize_t vlc_stream_ReadRaw(stream_t *s, void *buf, size_t len)
 {
     stream_priv_t *priv = (stream_priv_t *)s;
@@ -445,6 +454,7 @@ static ssize_t vlc_stream_ReadRaw(stream_t *s, void *buf, size_t len)
         }
         else
             ret = s->pf_read(s, buf, len);
+        vlc_stream_TraceRead(s, ret);
         return ret;
     }
 
@@ -457,6 +467,8 @@ static ssize_t vlc_stream_ReadRaw(stream_t *s, void *buf, size_t len)
         bool eof = false;
 
         priv->block = s->pf_block(s, &eof);
+        if (priv->block != NULL)
+            vlc_stream_TraceRead(s, priv->block->i_buffer);
         ret = vlc_stream_CopyBlock(&priv->block, buf, len);
         if (ret >= 0)
             return ret;
@@ -723,9 +735,159 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
     return s->pf_control(s, cmd, args);
 }
 
+/* Slices of a buffered block, handed out without copying by
+ * vlc_stream_Block(). Each slice covers a disjoint range of the parent,
+ * which is released along with the last slice. */
+#define VLC_STREAM_SLICE_MIN 4096
+
+struct vlc_stream_slice
+{
+    block_t self;
+    struct vlc_stream_slices *parent;
+};
+
+struct vlc_stream_slices
+{
+    vlc_atomic_rc_t rc;
+    block_t *block;
+};
+
+static void vlc_stream_SliceRelease(block_t *block)
+{
+    struct vlc_stream_slice *slice =
+        container_of(block, struct vlc_stream_slice, self);
+    struct vlc_stream_slices *parent = slice->parent;
+
+    if (vlc_atomic_rc_dec(&parent->rc))
+    {
+        block_Release(parent->block);
+        free(parent);
+    }
+    free(slice);
+}
+
+static const struct vlc_block_callbacks vlc_stream_slice_cbs =
+{
+    vlc_stream_SliceRelease,
+};
+
+static block_t *vlc_stream_SliceNew(struct vlc_stream_slices *parent,
+                                    uint8_t *buf, size_t size)
+{
+    struct vlc_stream_slice *slice = malloc(sizeof (*slice));
+    if (unlikely(slice == NULL))
+        return NULL;
+
+    block_Init(&slice->self, &vlc_stream_slice_cbs, buf, size);
+    slice->parent = parent;
+    return &slice->self;
+}
+
+/**
+ * Splits the head of a buffered block, without copying.
+ *
+ * The remainder stays buffered as a slice of the same parent. The usable
+ * range of each slice is restricted to its own payload, so that reallocating
+ * one slice can never overwrite the data of another.
+ */
+static block_t *vlc_stream_SplitBlock(block_t **restrict pp, size_t size)
+{
+    block_t *block = *pp;
+
+    assert(size < block->i_buffer);
+
+    if (block->cbs != &vlc_stream_slice_cbs)
+    {   /* Turn the buffered block into the first slice */
+        struct vlc_stream_slices *parent = malloc(sizeof (*parent));
+        if (unlikely(parent == NULL))
+            return NULL;
+
+        block_t *rest = vlc_stream_SliceNew(parent, block->p_buffer,
+                                            block->i_buffer);
+        if (unlikely(rest == NULL))
+        {
+            free(parent);
+            return NULL;
+        }
+
+        vlc_atomic_rc_init(&parent->rc);
+        parent->block = block;
+        block = *pp = rest;
+    }
+
+    struct vlc_stream_slice *rest =
+        container_of(block, struct vlc_stream_slice, self);
+    block_t *head = vlc_stream_SliceNew(rest->parent, block->p_buffer, size);
+    if (unlikely(head == NULL))
+        return NULL;
+
+    vlc_atomic_rc_inc(&rest->parent->rc);
+    block->p_buffer += size;
+    block->i_buffer -= size;
+    block->p_start = block->p_buffer;
+    block->i_size = block->i_buffer;
+    return head;
+}
+
+/**
+ * Takes a block of data out of the stream buffers without copying, if
+ * enough data is already buffered, or can be buffered from a single block
+ * of the underlying stream.
+ */
+static block_t *vlc_stream_TakeBlock(stream_t *s, size_t size)
+{
+    stream_priv_t *priv = (stream_priv_t *)s;
+    block_t **pp = &priv->peek;
+
+    /* Copying is cheaper than slicing for small sizes, and does not pin
+     * a large buffer for the lifetime of a small block. */
+    if (size < VLC_STREAM_SLICE_MIN)
+        return NULL;
+
+    if (*pp == NULL)
+    {
+        pp = &priv->block;
+        if (*pp == NULL)
+        {
+            if (s->pf_read != NULL || s->pf_block == NULL || vlc_killed())
+                return NULL;
+
+            bool eof = false;
+
+            *pp = s->pf_block(s, &eof);
+            if (*pp == NULL)
+                return NULL; /* let the slow path handle errors */
+            vlc_stream_TraceRead(s, (*pp)->i_buffer);
+        }
+    }
+
+    block_t *block = *pp;
+
+    if (block->i_buffer < size)
+        return NULL;
+
+    if (block->i_buffer == size)
+        *pp = NULL;
+    else
+    {
+        block = vlc_stream_SplitBlock(pp, size);
+        if (unlikely(block == NULL))
+            return NULL;
+    }
+
+    priv->offset += size;
+    block->p_next = NULL;
+    block->i_flags = 0;
+    block->i_pts = block->i_dts = VLC_TICK_INVALID;
+    block->i_length = 0;
+    return block;
+}
+
 /**
  * Read data into a block.
  *
+ * The data is not copied if the stream already buffers it in a block.
+ *
  * @param s stream to read data from
  * @param size number of bytes to read
  * @return a block of data, or NULL on error
@@ -737,7 +899,11 @@ block_t *vlc_stream_Block( stream_t *s, size_t size )
     if( unlikely(size > SSIZE_MAX) )
         return NULL;
 
-    block_t *block = block_Alloc( size );
+    block_t *block = vlc_stream_TakeBlock( s, size );
+    if( block != NULL )
+        return block;
+
+    block = block_Alloc( size );
     if( unlikely(block == NULL) )
         return NULL;
 
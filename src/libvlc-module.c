@@ -1123,6 +1123,22 @@ static const char* const ppsz_restore_playback_desc[] = {
     "all the processor time and render the whole system unresponsive which " \
     "might require a reboot of your machine.")
 
+#define FRAME_CACHE_TEXT N_("Recycle data buffers")
+#define FRAME_CACHE_LONGTEXT N_( \
+    "Keep released data buffers in per-thread caches to speed up their " \
+    "allocation. Disable this when looking for memory errors, as recycled " \
+    "buffers hide use-after-free from memory debuggers.")
+#if defined (__SANITIZE_ADDRESS__)
+# define FRAME_CACHE_DEFAULT false
+#elif defined (__has_feature)
+# if __has_feature(address_sanitizer)
+#  define FRAME_CACHE_DEFAULT false
+# endif
+#endif
+#ifndef FRAME_CACHE_DEFAULT
+# define FRAME_CACHE_DEFAULT true
+#endif
+
 #define CLOCK_SOURCE_TEXT N_("Clock source")
 #ifdef _WIN32
 static const char *const clock_sources[] = {
@@ -2074,6 +2090,9 @@ vlc_module_begin ()
               HPRIORITY_LONGTEXT )
 #endif
 
+    add_bool( "frame-cache", FRAME_CACHE_DEFAULT, FRAME_CACHE_TEXT,
+              FRAME_CACHE_LONGTEXT )
+
 #ifdef _WIN32
     add_string( "clock-source", NULL, CLOCK_SOURCE_TEXT, NULL )
         change_string_list( clock_sources, clock_sources_text )
@@ -182,6 +182,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
 
     vlc_LogInit(p_libvlc);
     vlc_tracer_Init(p_libvlc);
+    priv->frame_cache = vlc_frame_cache_Init(p_libvlc);
 
     /*
      * Support for gettext
@@ -394,6 +395,8 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
 
+    if (priv->frame_cache)
+        vlc_frame_cache_Clean();
     vlc_LogDestroy(p_libvlc->obj.logger);
     vlc_tracer_Destroy(p_libvlc);
     /* Free module bank. It is refcounted, so we call this each time  */
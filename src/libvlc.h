@@ -67,6 +67,12 @@ typedef struct vlc_tracer vlc_tracer_t;
 void vlc_tracer_Init(libvlc_int_t *);
 void vlc_tracer_Destroy(libvlc_int_t *);
 
+/*
+ * Frame allocation cache
+ */
+bool vlc_frame_cache_Init(libvlc_int_t *);
+void vlc_frame_cache_Clean(void);
+
 /*
  * LibVLC exit event handling
  */
@@ -194,6 +200,7 @@ typedef struct libvlc_priv_t
     struct vlc_medialibrary_t *p_media_library; ///< Media library instance
     struct vlc_thumbnailer_t *p_thumbnailer; ///< Lazily instantiated media thumbnailer
     struct vlc_tracer *tracer; ///< Tracer callbacks
+    bool frame_cache; ///< Whether the instance uses the frame cache
 
     /* Exit callback */
     vlc_exit_t       exit;
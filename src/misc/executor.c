@@ -33,19 +33,38 @@
  * An executor can spawn several threads.
  *
  * This structure contains the data specific to one thread.
+ *
+ * Each thread owns one queue per priority. Submitted runnables are
+ * distributed over the thread queues, and a thread with nothing to do in its
+ * own queues steals runnables from the other threads, so that threads do not
+ * contend on a single queue lock.
  */
 struct vlc_executor_thread {
-    /** Node of vlc_executor.threads list */
-    struct vlc_list node;
-
     /** The executor owning the thread */
     vlc_executor_t *owner;
 
+    /** Index of the thread in vlc_executor.threads */
+    unsigned index;
+
     /** The system thread */
     vlc_thread_t thread;
 
     /** The current task executed by the thread, NULL if none */
     struct vlc_runnable *current_task;
+
+    /** Lock protecting the queues and the statistics */
+    vlc_mutex_t lock;
+
+    /** Queues of vlc_runnable, one per priority */
+    struct vlc_list queues[VLC_EXECUTOR_PRIORITY_COUNT];
+
+    /** Statistics of the runnables taken from the queues */
+    struct {
+        uint64_t started;
+        vlc_tick_t latency_total;
+        vlc_tick_t latency_max;
+    } stats[VLC_EXECUTOR_PRIORITY_COUNT];
+    uint64_t stolen;
 };
 
 /**
@@ -58,113 +77,209 @@ struct vlc_executor {
     /** Maximum number of threads to run the tasks */
     unsigned max_threads;
 
-    /** List of active vlc_executor_thread */
-    struct vlc_list threads;
+    /** Thread count, the threads array may be read up to this count without
+     * the lock */
+    atomic_uint nthreads;
 
-    /** Thread count (in a separate field to quickly compare to max_threads) */
-    unsigned nthreads;
+    /** Next thread queue to submit to */
+    unsigned next_queue;
 
     /* Number of tasks requested but not finished. */
-    unsigned unfinished;
+    atomic_uint unfinished;
 
     /** Wait for the executor to be idle (i.e. unfinished == 0) */
     vlc_cond_t idle_wait;
 
-    /** Queue of vlc_runnable */
-    struct vlc_list queue;
+    /** Number of queued runnables, per priority */
+    atomic_size_t queued[VLC_EXECUTOR_PRIORITY_COUNT];
 
-    /** Wait for the queue to be non-empty */
+    /** Wait for a queue to be non-empty */
     vlc_cond_t queue_wait;
 
     /** True if executor deletion is requested */
     bool closing;
+
+    /** Spawned threads */
+    struct vlc_executor_thread *threads[];
 };
 
+static bool
+QueuesEmpty(vlc_executor_t *executor)
+{
+    for (int i = 0; i < VLC_EXECUTOR_PRIORITY_COUNT; ++i)
+        if (atomic_load(&executor->queued[i]) > 0)
+            return false;
+    return true;
+}
+
 static void
 QueuePush(vlc_executor_t *executor, struct vlc_runnable *runnable)
 {
     vlc_mutex_assert(&executor->lock);
 
-    vlc_list_append(&runnable->node, &executor->queue);
+    unsigned nthreads = atomic_load_explicit(&executor->nthreads,
+                                             memory_order_relaxed);
+    struct vlc_executor_thread *thread =
+        executor->threads[executor->next_queue++ % nthreads];
+
+    vlc_mutex_lock(&thread->lock);
+    runnable->queue = thread;
+    vlc_list_append(&runnable->node, &thread->queues[runnable->priority]);
+    atomic_fetch_add(&executor->queued[runnable->priority], 1);
+    vlc_mutex_unlock(&thread->lock);
+
     vlc_cond_signal(&executor->queue_wait);
 }
 
 static struct vlc_runnable *
-QueueTake(vlc_executor_t *executor)
+QueueTakeFrom(struct vlc_executor_thread *queue,
+              struct vlc_executor_thread *thread, int priority)
 {
-    vlc_mutex_assert(&executor->lock);
-
-    while (!executor->closing && vlc_list_is_empty(&executor->queue))
-        vlc_cond_wait(&executor->queue_wait, &executor->lock);
+    vlc_executor_t *executor = queue->owner;
 
-    if (executor->closing)
-        return NULL;
+    vlc_mutex_lock(&queue->lock);
 
     struct vlc_runnable *runnable =
-        vlc_list_first_entry_or_null(&executor->queue, struct vlc_runnable,
-                                     node);
-    assert(runnable);
-    vlc_list_remove(&runnable->node);
+        vlc_list_first_entry_or_null(&queue->queues[priority],
+                                     struct vlc_runnable, node);
+    if (runnable != NULL)
+    {
+        vlc_list_remove(&runnable->node);
 
-    /* Set links to NULL to know that it has been taken by a thread in
-     * vlc_executor_Cancel() */
-    runnable->node.prev = runnable->node.next = NULL;
+        /* Set links to NULL to know that it has been taken by a thread in
+         * vlc_executor_Cancel() */
+        runnable->node.prev = runnable->node.next = NULL;
+        atomic_fetch_sub(&executor->queued[priority], 1);
+
+        vlc_tick_t latency = vlc_tick_now() - runnable->submitted;
+        queue->stats[priority].started++;
+        queue->stats[priority].latency_total += latency;
+        if (latency > queue->stats[priority].latency_max)
+            queue->stats[priority].latency_max = latency;
+        if (queue != thread)
+            queue->stolen++;
+    }
+
+    vlc_mutex_unlock(&queue->lock);
 
     return runnable;
 }
 
+static struct vlc_runnable *
+QueueTake(struct vlc_executor_thread *thread)
+{
+    vlc_executor_t *executor = thread->owner;
+    unsigned nthreads = atomic_load_explicit(&executor->nthreads,
+                                             memory_order_acquire);
+
+    for (int prio = VLC_EXECUTOR_PRIORITY_COUNT - 1; prio >= 0; --prio)
+    {
+        if (atomic_load(&executor->queued[prio]) == 0)
+            continue;
+
+        /* Own queue first, then steal from the others */
+        for (unsigned i = 0; i < nthreads; ++i)
+        {
+            struct vlc_executor_thread *queue =
+                executor->threads[(thread->index + i) % nthreads];
+
+            struct vlc_runnable *runnable =
+                QueueTakeFrom(queue, thread, prio);
+            if (runnable != NULL)
+                return runnable;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+Finish(vlc_executor_t *executor)
+{
+    unsigned unfinished = atomic_fetch_sub(&executor->unfinished, 1);
+
+    assert(unfinished > 0);
+    if (unfinished == 1)
+    {
+        vlc_mutex_lock(&executor->lock);
+        vlc_cond_broadcast(&executor->idle_wait);
+        vlc_mutex_unlock(&executor->lock);
+    }
+}
+
 static void *
 ThreadRun(void *userdata)
 {
     struct vlc_executor_thread *thread = userdata;
     vlc_executor_t *executor = thread->owner;
 
-    vlc_mutex_lock(&executor->lock);
-
-    struct vlc_runnable *runnable;
-    /* When the executor is closing, QueueTake() returns NULL */
-    while ((runnable = QueueTake(executor)))
+    for (;;)
     {
+        struct vlc_runnable *runnable = QueueTake(thread);
+        if (runnable == NULL)
+        {
+            vlc_mutex_lock(&executor->lock);
+            while (!executor->closing && QueuesEmpty(executor))
+                vlc_cond_wait(&executor->queue_wait, &executor->lock);
+
+            bool closing = executor->closing;
+            vlc_mutex_unlock(&executor->lock);
+
+            if (closing)
+                break;
+            continue;
+        }
+
         thread->current_task = runnable;
-        vlc_mutex_unlock(&executor->lock);
 
         /* Execute the user-provided runnable, without the executor lock */
         runnable->run(runnable->userdata);
 
-        vlc_mutex_lock(&executor->lock);
         thread->current_task = NULL;
-
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+        Finish(executor);
     }
 
-    vlc_mutex_unlock(&executor->lock);
-
     return NULL;
 }
 
 static int
 SpawnThread(vlc_executor_t *executor)
 {
-    assert(executor->nthreads < executor->max_threads);
+    unsigned nthreads = atomic_load_explicit(&executor->nthreads,
+                                             memory_order_relaxed);
+    assert(nthreads < executor->max_threads);
 
     struct vlc_executor_thread *thread = malloc(sizeof(*thread));
     if (!thread)
         return VLC_ENOMEM;
 
     thread->owner = executor;
+    thread->index = nthreads;
     thread->current_task = NULL;
+    thread->stolen = 0;
+    vlc_mutex_init(&thread->lock);
+    for (int i = 0; i < VLC_EXECUTOR_PRIORITY_COUNT; ++i)
+    {
+        vlc_list_init(&thread->queues[i]);
+        thread->stats[i].started = 0;
+        thread->stats[i].latency_total = 0;
+        thread->stats[i].latency_max = 0;
+    }
 
     if (vlc_clone(&thread->thread, ThreadRun, thread, VLC_THREAD_PRIORITY_LOW))
     {
+        /* Never published, no other thread may have seen it */
         free(thread);
         return VLC_EGENERIC;
     }
 
-    executor->nthreads++;
-    vlc_list_append(&thread->node, &executor->threads);
+    /* Publish the thread only once started. Until then, it only sees (and
+     * steals from) the other threads. It cannot miss its own queue: it
+     * waits for runnables under the executor lock, held here until the
+     * thread is published. */
+    executor->threads[nthreads] = thread;
+    atomic_store_explicit(&executor->nthreads, nthreads + 1,
+                          memory_order_release);
 
     return VLC_SUCCESS;
 }
@@ -173,18 +288,20 @@ vlc_executor_t *
 vlc_executor_New(unsigned max_threads)
 {
     assert(max_threads);
-    vlc_executor_t *executor = malloc(sizeof(*executor));
+    vlc_executor_t *executor =
+        malloc(sizeof(*executor) + max_threads * sizeof(*executor->threads));
     if (!executor)
         return NULL;
 
     vlc_mutex_init(&executor->lock);
 
     executor->max_threads = max_threads;
-    executor->nthreads = 0;
-    executor->unfinished = 0;
+    atomic_init(&executor->nthreads, 0);
+    executor->next_queue = 0;
+    atomic_init(&executor->unfinished, 0);
 
-    vlc_list_init(&executor->threads);
-    vlc_list_init(&executor->queue);
+    for (int i = 0; i < VLC_EXECUTOR_PRIORITY_COUNT; ++i)
+        atomic_init(&executor->queued[i], 0);
 
     vlc_cond_init(&executor->idle_wait);
     vlc_cond_init(&executor->queue_wait);
@@ -192,7 +309,9 @@ vlc_executor_New(unsigned max_threads)
     executor->closing = false;
 
     /* Create one thread on init so that vlc_executor_Submit() may never fail */
+    vlc_mutex_lock(&executor->lock);
     int ret = SpawnThread(executor);
+    vlc_mutex_unlock(&executor->lock);
     if (ret != VLC_SUCCESS)
     {
         free(executor);
@@ -203,26 +322,45 @@ vlc_executor_New(unsigned max_threads)
 }
 
 void
-vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+vlc_executor_SubmitWithPriority(vlc_executor_t *executor,
+                                struct vlc_runnable *runnable,
+                                enum vlc_executor_priority priority)
 {
+    assert(priority < VLC_EXECUTOR_PRIORITY_COUNT);
+    runnable->priority = priority;
+    runnable->submitted = vlc_tick_now();
+
     vlc_mutex_lock(&executor->lock);
 
     assert(!executor->closing);
 
-    QueuePush(executor, runnable);
-
-    if (++executor->unfinished > executor->nthreads
-            && executor->nthreads < executor->max_threads)
+    unsigned unfinished = atomic_fetch_add(&executor->unfinished, 1) + 1;
+    unsigned nthreads = atomic_load_explicit(&executor->nthreads,
+                                             memory_order_relaxed);
+    if (unfinished > nthreads && nthreads < executor->max_threads)
         /* If it fails, this is not an error, there is at least one thread */
         SpawnThread(executor);
 
+    QueuePush(executor, runnable);
+
     vlc_mutex_unlock(&executor->lock);
 }
 
+void
+vlc_executor_Submit(vlc_executor_t *executor, struct vlc_runnable *runnable)
+{
+    vlc_executor_SubmitWithPriority(executor, runnable,
+                                    VLC_EXECUTOR_PRIORITY_NORMAL);
+}
+
 bool
 vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
 {
-    vlc_mutex_lock(&executor->lock);
+    /* The queue of a runnable never changes once submitted */
+    struct vlc_executor_thread *queue = runnable->queue;
+    assert(queue != NULL && queue->owner == executor);
+
+    vlc_mutex_lock(&queue->lock);
 
     /* Either both prev and next are set, either both are NULL */
     assert(!runnable->node.prev == !runnable->node.next);
@@ -231,14 +369,14 @@ vlc_executor_Cancel(vlc_executor_t *executor, struct vlc_runnable *runnable)
     if (in_queue)
     {
         vlc_list_remove(&runnable->node);
-
-        assert(executor->unfinished > 0);
-        --executor->unfinished;
-        if (!executor->unfinished)
-            vlc_cond_signal(&executor->idle_wait);
+        runnable->node.prev = runnable->node.next = NULL;
+        atomic_fetch_sub(&executor->queued[runnable->priority], 1);
     }
 
-    vlc_mutex_unlock(&executor->lock);
+    vlc_mutex_unlock(&queue->lock);
+
+    if (in_queue)
+        Finish(executor);
 
     return in_queue;
 }
@@ -247,11 +385,56 @@ void
 vlc_executor_WaitIdle(vlc_executor_t *executor)
 {
     vlc_mutex_lock(&executor->lock);
-    while (executor->unfinished)
+    while (atomic_load(&executor->unfinished))
         vlc_cond_wait(&executor->idle_wait, &executor->lock);
     vlc_mutex_unlock(&executor->lock);
 }
 
+void
+vlc_executor_GetStats(vlc_executor_t *executor,
+                      struct vlc_executor_stats *stats)
+{
+    vlc_tick_t latency_total[VLC_EXECUTOR_PRIORITY_COUNT] = { 0 };
+
+    vlc_mutex_lock(&executor->lock);
+
+    stats->threads = atomic_load(&executor->nthreads);
+    stats->unfinished = atomic_load(&executor->unfinished);
+    stats->stolen = 0;
+
+    for (int i = 0; i < VLC_EXECUTOR_PRIORITY_COUNT; ++i)
+    {
+        stats->priorities[i].queued = atomic_load(&executor->queued[i]);
+        stats->priorities[i].started = 0;
+        stats->priorities[i].latency_max = 0;
+    }
+
+    for (unsigned t = 0; t < stats->threads; ++t)
+    {
+        struct vlc_executor_thread *thread = executor->threads[t];
+
+        vlc_mutex_lock(&thread->lock);
+        stats->stolen += thread->stolen;
+        for (int i = 0; i < VLC_EXECUTOR_PRIORITY_COUNT; ++i)
+        {
+            stats->priorities[i].started += thread->stats[i].started;
+            latency_total[i] += thread->stats[i].latency_total;
+            if (thread->stats[i].latency_max > stats->priorities[i].latency_max)
+                stats->priorities[i].latency_max = thread->stats[i].latency_max;
+        }
+        vlc_mutex_unlock(&thread->lock);
+    }
+
+    vlc_mutex_unlock(&executor->lock);
+
+    for (int i = 0; i < VLC_EXECUTOR_PRIORITY_COUNT; ++i)
+    {
+        uint64_t started = stats->priorities[i].started;
+        stats->priorities[i].latency_avg =
+            started ? latency_total[i] / (vlc_tick_t) started : 0;
+    }
+}
+
 void
 vlc_executor_Delete(vlc_executor_t *executor)
 {
@@ -260,29 +443,29 @@ vlc_executor_Delete(vlc_executor_t *executor)
     executor->closing = true;
 
     /* All the tasks must be canceled on delete */
-    assert(vlc_list_is_empty(&executor->queue));
+    assert(QueuesEmpty(executor));
 
     vlc_mutex_unlock(&executor->lock);
 
     /* "closing" is now true, this will wake up threads */
     vlc_cond_broadcast(&executor->queue_wait);
 
-    /* The threads list may not be written at this point, so it is safe to read
-     * it without mutex locked (the mutex must be released to join the
+    /* The threads array may not be written at this point, so it is safe to
+     * read it without mutex locked (the mutex must be released to join the
      * threads). */
 
-    struct vlc_executor_thread *thread;
-    vlc_list_foreach(thread, &executor->threads, node)
+    unsigned nthreads = atomic_load(&executor->nthreads);
+    for (unsigned i = 0; i < nthreads; ++i)
     {
-        vlc_join(thread->thread, NULL);
-        free(thread);
+        vlc_join(executor->threads[i]->thread, NULL);
+        free(executor->threads[i]);
     }
 
-    /* The queue must still be empty (no runnable submitted a new runnable) */
-    assert(vlc_list_is_empty(&executor->queue));
+    /* The queues must still be empty (no runnable submitted a new runnable) */
+    assert(QueuesEmpty(executor));
 
     /* There are no tasks anymore */
-    assert(!executor->unfinished);
+    assert(!atomic_load(&executor->unfinished));
 
     free(executor);
 }
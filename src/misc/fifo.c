@@ -26,6 +26,7 @@
 #endif
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 
 #include <vlc_common.h>
@@ -38,43 +39,139 @@
 struct vlc_fifo_t
 {
     vlc_queue_t         q;
-    size_t              i_depth;
-    size_t              i_size;
+    /* Blocks in the locked queue. These are only written with the lock held,
+     * but may be read without it by vlc_fifo_GetBytesRelaxed(). */
+    atomic_size_t       i_depth;
+    atomic_size_t       i_size;
+
+    /* Single producer ring, see vlc_fifo_NewSingleProducer().
+     * The tail counters are only written by the producer, the head counters
+     * only by the consumer, with the FIFO lock held. */
+    block_t           **ring;
+    size_t              ring_mask;
+    atomic_size_t       ring_head;
+    atomic_size_t       ring_head_bytes;
+    atomic_size_t       ring_tail;
+    atomic_size_t       ring_tail_bytes;
+    /* Set by the producer when it had to queue to the locked queue, cleared
+     * by the consumer once both are empty: this preserves ordering. */
+    atomic_bool         overflow;
+    /* Number of threads in vlc_fifo_Wait() */
+    atomic_uint         waiters;
+    /* Ring tail last seen by vlc_fifo_Wait(), with the FIFO lock held */
+    size_t              ring_wait_tail;
 };
 
 static_assert (offsetof (block_fifo_t, q) == 0, "Problems in <vlc_block.h>");
 
+static void vlc_fifo_Add(atomic_size_t *counter, size_t value)
+{
+    size_t v = atomic_load_explicit(counter, memory_order_relaxed);
+    atomic_store_explicit(counter, v + value, memory_order_relaxed);
+}
+
+static size_t vlc_fifo_RingCount(const block_fifo_t *fifo)
+{
+    size_t head = atomic_load_explicit(&fifo->ring_head, memory_order_acquire);
+    return atomic_load_explicit(&fifo->ring_tail, memory_order_acquire) - head;
+}
+
+static size_t vlc_fifo_RingBytes(const block_fifo_t *fifo)
+{
+    size_t head = atomic_load_explicit(&fifo->ring_head_bytes,
+                                       memory_order_acquire);
+    return atomic_load_explicit(&fifo->ring_tail_bytes,
+                                memory_order_acquire) - head;
+}
+
+/* Consumer side, with the FIFO lock held */
+static block_t *vlc_fifo_RingDequeue(block_fifo_t *fifo)
+{
+    size_t head = atomic_load_explicit(&fifo->ring_head, memory_order_relaxed);
+
+    if (head == atomic_load_explicit(&fifo->ring_tail, memory_order_acquire))
+        return NULL;
+
+    block_t *block = fifo->ring[head & fifo->ring_mask];
+
+    vlc_fifo_Add(&fifo->ring_head_bytes, block->i_buffer);
+    atomic_store_explicit(&fifo->ring_head, head + 1, memory_order_release);
+    return block;
+}
+
 size_t vlc_fifo_GetCount(const block_fifo_t *fifo)
 {
     vlc_mutex_assert(&fifo->q.lock);
-    return fifo->i_depth;
+
+    size_t depth = atomic_load_explicit(&fifo->i_depth, memory_order_relaxed);
+    if (fifo->ring != NULL)
+        depth += vlc_fifo_RingCount(fifo);
+    return depth;
 }
 
 size_t vlc_fifo_GetBytes(const block_fifo_t *fifo)
 {
     vlc_mutex_assert(&fifo->q.lock);
-    return fifo->i_size;
+    return vlc_fifo_GetBytesRelaxed(fifo);
+}
+
+size_t vlc_fifo_GetBytesRelaxed(const block_fifo_t *fifo)
+{
+    size_t size = atomic_load_explicit(&fifo->i_size, memory_order_relaxed);
+    if (fifo->ring != NULL)
+        size += vlc_fifo_RingBytes(fifo);
+    return size;
 }
 
 void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
 {
+    if (block == NULL)
+        return;
+
+    size_t depth = 0, size = 0;
+
     for (block_t *b = block; b != NULL; b = b->p_next) {
-        fifo->i_depth++;
-        fifo->i_size += b->i_buffer;
+        depth++;
+        size += b->i_buffer;
     }
+    vlc_fifo_Add(&fifo->i_depth, depth);
+    vlc_fifo_Add(&fifo->i_size, size);
+
+    /* Blocks already in the ring must be dequeued first */
+    if (fifo->ring != NULL)
+        atomic_store_explicit(&fifo->overflow, true, memory_order_relaxed);
 
     vlc_queue_EnqueueUnlocked(&fifo->q, block);
 }
 
 block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
 {
-    block_t *block = vlc_queue_DequeueUnlocked(&fifo->q);
+    block_t *block;
+
+    if (fifo->ring != NULL) {
+        block = vlc_fifo_RingDequeue(fifo);
+        if (block != NULL)
+            return block;
+    }
+
+    block = vlc_queue_DequeueUnlocked(&fifo->q);
 
     if (block != NULL) {
-        assert(fifo->i_depth > 0);
-        assert(fifo->i_size >= block->i_buffer);
-        fifo->i_depth--;
-        fifo->i_size -= block->i_buffer;
+        size_t depth = atomic_load_explicit(&fifo->i_depth,
+                                            memory_order_relaxed);
+        size_t size = atomic_load_explicit(&fifo->i_size,
+                                           memory_order_relaxed);
+
+        assert(depth > 0);
+        assert(size >= block->i_buffer);
+        atomic_store_explicit(&fifo->i_depth, depth - 1,
+                              memory_order_relaxed);
+        atomic_store_explicit(&fifo->i_size, size - block->i_buffer,
+                              memory_order_relaxed);
+
+        if (fifo->ring != NULL && vlc_queue_IsEmpty(&fifo->q))
+            atomic_store_explicit(&fifo->overflow, false,
+                                  memory_order_relaxed);
     }
 
     return block;
@@ -82,27 +179,152 @@ block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
 
 block_t *vlc_fifo_DequeueAllUnlocked(block_fifo_t *fifo)
 {
-    fifo->i_depth = 0;
-    fifo->i_size = 0;
-    return vlc_queue_DequeueAllUnlocked(&fifo->q);
+    block_t *head = NULL, **pp = &head;
+
+    if (fifo->ring != NULL) {
+        block_t *block;
+
+        while ((block = vlc_fifo_RingDequeue(fifo)) != NULL) {
+            *pp = block;
+            pp = &block->p_next;
+        }
+        atomic_store_explicit(&fifo->overflow, false, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&fifo->i_depth, 0, memory_order_relaxed);
+    atomic_store_explicit(&fifo->i_size, 0, memory_order_relaxed);
+    *pp = vlc_queue_DequeueAllUnlocked(&fifo->q);
+    return head;
 }
 
-block_fifo_t *vlc_fifo_New( void )
+void vlc_fifo_Push(block_fifo_t *fifo, block_t *block)
+{
+    if (fifo->ring == NULL) {
+        vlc_fifo_Put(fifo, block);
+        return;
+    }
+
+    size_t tail = atomic_load_explicit(&fifo->ring_tail, memory_order_relaxed);
+    size_t tail_bytes = atomic_load_explicit(&fifo->ring_tail_bytes,
+                                             memory_order_relaxed);
+
+    while (block != NULL) {
+        size_t head = atomic_load_explicit(&fifo->ring_head,
+                                           memory_order_acquire);
+
+        if (tail - head > fifo->ring_mask
+         || atomic_load_explicit(&fifo->overflow, memory_order_relaxed))
+        {   /* Full ring: fall back to the locked queue for the rest */
+            vlc_fifo_Put(fifo, block);
+            return;
+        }
+
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        fifo->ring[tail & fifo->ring_mask] = block;
+        tail_bytes += block->i_buffer;
+        tail++;
+        atomic_store_explicit(&fifo->ring_tail_bytes, tail_bytes,
+                              memory_order_release);
+        /* Sequentially consistent with the waiters counter, see below */
+        atomic_store(&fifo->ring_tail, tail);
+        block = next;
+    }
+
+    /* The consumer registers itself as a waiter before checking the ring
+     * one last time, with the lock held: it is either going to see the new
+     * tail, or we see it waiting. */
+    if (atomic_load(&fifo->waiters) > 0) {
+        vlc_fifo_Lock(fifo);
+        vlc_fifo_Signal(fifo);
+        vlc_fifo_Unlock(fifo);
+    }
+}
+
+static void vlc_fifo_WaitCleanup(void *data)
+{
+    block_fifo_t *fifo = data;
+
+    atomic_fetch_sub(&fifo->waiters, 1);
+}
+
+void vlc_fifo_Wait(block_fifo_t *fifo)
+{
+    vlc_queue_t *q = vlc_fifo_queue(fifo);
+
+    if (fifo->ring == NULL) {
+        vlc_queue_Wait(q);
+        return;
+    }
+
+    /* Do not sleep if blocks were pushed since the last wait, as the
+     * producer may not have seen this thread waiting then. Blocks that were
+     * already there when the caller decided to wait must not wake it up
+     * again, e.g. while the consumer is paused. */
+    atomic_fetch_add(&fifo->waiters, 1);
+
+    size_t tail = atomic_load(&fifo->ring_tail);
+    if (tail == fifo->ring_wait_tail) {
+        vlc_cleanup_push(vlc_fifo_WaitCleanup, fifo);
+        vlc_queue_Wait(q);
+        vlc_cleanup_pop();
+    }
+    fifo->ring_wait_tail = tail;
+    atomic_fetch_sub(&fifo->waiters, 1);
+}
+
+static block_fifo_t *vlc_fifo_Alloc(size_t slots)
 {
     block_fifo_t *p_fifo = malloc( sizeof( block_fifo_t ) );
 
-    if (likely(p_fifo != NULL)) {
-        vlc_queue_Init(&p_fifo->q, offsetof (block_t, p_next));
-        p_fifo->i_depth = 0;
-        p_fifo->i_size = 0;
+    if (unlikely(p_fifo == NULL))
+        return NULL;
+
+    p_fifo->ring = NULL;
+    p_fifo->ring_mask = 0;
+    if (slots > 0) {
+        p_fifo->ring = vlc_alloc(slots, sizeof (*p_fifo->ring));
+        if (unlikely(p_fifo->ring == NULL)) {
+            free(p_fifo);
+            return NULL;
+        }
+        p_fifo->ring_mask = slots - 1;
     }
 
+    vlc_queue_Init(&p_fifo->q, offsetof (block_t, p_next));
+    atomic_init(&p_fifo->i_depth, 0);
+    atomic_init(&p_fifo->i_size, 0);
+    atomic_init(&p_fifo->ring_head, 0);
+    atomic_init(&p_fifo->ring_head_bytes, 0);
+    atomic_init(&p_fifo->ring_tail, 0);
+    atomic_init(&p_fifo->ring_tail_bytes, 0);
+    atomic_init(&p_fifo->overflow, false);
+    atomic_init(&p_fifo->waiters, 0);
+    p_fifo->ring_wait_tail = 0;
     return p_fifo;
 }
 
+block_fifo_t *vlc_fifo_New( void )
+{
+    return vlc_fifo_Alloc(0);
+}
+
+block_fifo_t *vlc_fifo_NewSingleProducer(size_t slots)
+{
+    /* Round up to a power of two, so that the ring index is a mask */
+    if (slots < 2)
+        slots = 2;
+    if (slots & (slots - 1))
+        slots = (size_t)1 << ((sizeof (slots) * CHAR_BIT) - clz(slots));
+
+    return vlc_fifo_Alloc(slots);
+}
+
 void vlc_fifo_Release( block_fifo_t *p_fifo )
 {
     vlc_fifo_Empty(p_fifo);
+    free( p_fifo->ring );
     free( p_fifo );
 }
 
@@ -130,8 +352,14 @@ block_t *vlc_fifo_Show( block_fifo_t *p_fifo )
     block_t *b;
 
     vlc_fifo_Lock(p_fifo);
-    assert(p_fifo->q.first != NULL);
-    b = (block_t *)p_fifo->q.first;
+    if (p_fifo->ring != NULL && vlc_fifo_RingCount(p_fifo) > 0) {
+        size_t head = atomic_load_explicit(&p_fifo->ring_head,
+                                           memory_order_relaxed);
+        b = p_fifo->ring[head & p_fifo->ring_mask];
+    } else {
+        assert(p_fifo->q.first != NULL);
+        b = (block_t *)p_fifo->q.first;
+    }
     vlc_fifo_Unlock(p_fifo);
 
     return b;
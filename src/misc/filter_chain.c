@@ -29,6 +29,7 @@
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
 #include <vlc_spu.h>
+#include <vlc_tracer.h>
 #include <libvlc.h>
 #include <assert.h>
 
@@ -427,7 +428,15 @@ static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
+        struct vlc_tracer *tracer = vlc_object_get_tracer( VLC_OBJECT(p_filter) );
+        const char *name = tracer != NULL && p_filter->p_module != NULL
+                         ? module_get_object( p_filter->p_module ) : "filter";
+
+        if( tracer != NULL )
+            vlc_tracer_TraceBegin( tracer, "FILTER", name, name );
         p_pic = p_filter->ops->filter_video( p_filter, p_pic );
+        if( tracer != NULL )
+            vlc_tracer_TraceEnd( tracer, "FILTER", name, name );
         if( !p_pic )
             break;
         if( !vlc_picture_chain_IsEmpty( &f->pending ) )
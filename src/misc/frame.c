@@ -30,6 +30,9 @@
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
 
 #include <vlc_common.h>
 #include <vlc_atomic.h>
@@ -37,6 +40,7 @@
 #include <vlc_fs.h>
 
 #include "ancillary.h"
+#include "libvlc.h"
 
 #ifndef NDEBUG
 static void vlc_frame_Check (vlc_frame_t *frame)
@@ -91,10 +95,315 @@ vlc_frame_t *vlc_frame_Init(vlc_frame_t *restrict f, const struct vlc_frame_call
     return f;
 }
 
+/*
+ * Frame cache
+ *
+ * Generic frames are recycled in size classes of powers of two. Each thread
+ * keeps a small cache per class, and exchanges batches of frames with a
+ * shared depot when it runs empty or full, so that frames flowing from a
+ * producer thread to a consumer thread find their way back.
+ */
+#define FRAME_CACHE_MIN_SHIFT   9 /* 512 bytes, including the frame header */
+#define FRAME_CACHE_CLASSES     9 /* up to 128 KiB */
+#define FRAME_CACHE_THREAD_MAX  16 /* frames per class and per thread */
+#define FRAME_CACHE_BATCH       (FRAME_CACHE_THREAD_MAX / 2)
+#define FRAME_CACHE_DEPOT_BYTES (2 << 20) /* bytes per class in the depot */
+#define FRAME_CACHE_STATS_FLUSH 256
+
+struct vlc_frame_cache_list
+{
+    vlc_frame_t *head;
+    unsigned count;
+};
+
+struct vlc_frame_thread_cache
+{
+    struct vlc_frame_cache_list classes[FRAME_CACHE_CLASSES];
+    /* statistics not accounted globally yet */
+    unsigned hits;
+    unsigned misses;
+    ssize_t bytes;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    struct vlc_frame_cache_list list;
+} frame_depot[FRAME_CACHE_CLASSES] = {
+#define DEPOT_INIT { VLC_STATIC_MUTEX, { NULL, 0 } }
+    DEPOT_INIT, DEPOT_INIT, DEPOT_INIT, DEPOT_INIT, DEPOT_INIT,
+    DEPOT_INIT, DEPOT_INIT, DEPOT_INIT, DEPOT_INIT,
+#undef DEPOT_INIT
+};
+
+static atomic_uint_least64_t frame_cache_hits = ATOMIC_VAR_INIT(0);
+static atomic_uint_least64_t frame_cache_misses = ATOMIC_VAR_INIT(0);
+static atomic_size_t frame_cache_bytes = ATOMIC_VAR_INIT(0);
+
+/* The cache is enabled while at least one LibVLC instance wants it */
+static vlc_mutex_t frame_cache_lock = VLC_STATIC_MUTEX;
+static unsigned frame_cache_users;
+static bool frame_cache_key_created;
+static vlc_threadvar_t frame_cache_key;
+static atomic_bool frame_cache_enabled = ATOMIC_VAR_INIT(false);
+
+static size_t vlc_frame_cache_ClassSize(unsigned index)
+{
+    return (size_t)1 << (FRAME_CACHE_MIN_SHIFT + index);
+}
+
+/** @return the class of an allocation size, or -1 if not cached */
+static int vlc_frame_cache_Class(size_t alloc)
+{
+    if (alloc <= vlc_frame_cache_ClassSize(0))
+        return 0;
+    if (alloc > vlc_frame_cache_ClassSize(FRAME_CACHE_CLASSES - 1))
+        return -1;
+    return (sizeof (size_t) * CHAR_BIT) - clz(alloc - 1) - FRAME_CACHE_MIN_SHIFT;
+}
+
+static void vlc_frame_cache_FlushStats(struct vlc_frame_thread_cache *tc)
+{
+    atomic_fetch_add_explicit(&frame_cache_hits, tc->hits,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&frame_cache_misses, tc->misses,
+                              memory_order_relaxed);
+    if (tc->bytes >= 0)
+        atomic_fetch_add_explicit(&frame_cache_bytes, tc->bytes,
+                                  memory_order_relaxed);
+    else
+        atomic_fetch_sub_explicit(&frame_cache_bytes, -tc->bytes,
+                                  memory_order_relaxed);
+    tc->hits = tc->misses = 0;
+    tc->bytes = 0;
+}
+
+/** Moves up to count frames from the head of a list to the head of another */
+static void vlc_frame_cache_Move(struct vlc_frame_cache_list *restrict dst,
+                                 struct vlc_frame_cache_list *restrict src,
+                                 unsigned count)
+{
+    while (count-- > 0 && src->head != NULL)
+    {
+        vlc_frame_t *frame = src->head;
+
+        src->head = frame->p_next;
+        src->count--;
+        frame->p_next = dst->head;
+        dst->head = frame;
+        dst->count++;
+    }
+}
+
+static void vlc_frame_cache_FreeList(struct vlc_frame_cache_list *list)
+{
+    while (list->head != NULL)
+    {
+        vlc_frame_t *frame = list->head;
+
+        list->head = frame->p_next;
+        free(frame);
+    }
+    list->count = 0;
+}
+
+static void vlc_frame_cache_Destroy(void *data)
+{
+    struct vlc_frame_thread_cache *tc = data;
+
+    for (unsigned i = 0; i < FRAME_CACHE_CLASSES; i++)
+    {
+        struct vlc_frame_cache_list *list = &tc->classes[i];
+        const size_t size = vlc_frame_cache_ClassSize(i);
+        const unsigned max = FRAME_CACHE_DEPOT_BYTES / size;
+
+        /* Give what fits back to the depot, unless it is being purged,
+         * free the rest */
+        vlc_mutex_lock(&frame_depot[i].lock);
+        if (atomic_load_explicit(&frame_cache_enabled, memory_order_relaxed))
+        {
+            unsigned room = frame_depot[i].list.count < max
+                          ? max - frame_depot[i].list.count : 0;
+            vlc_frame_cache_Move(&frame_depot[i].list, list, room);
+        }
+        vlc_mutex_unlock(&frame_depot[i].lock);
+
+        tc->bytes -= (ssize_t)(list->count * size);
+        vlc_frame_cache_FreeList(list);
+    }
+    vlc_frame_cache_FlushStats(tc);
+    free(tc);
+}
+
+bool vlc_frame_cache_Init(libvlc_int_t *libvlc)
+{
+    if (!var_InheritBool(libvlc, "frame-cache"))
+        return false;
+
+    vlc_mutex_lock(&frame_cache_lock);
+    /* The key is never deleted: threads that are not joined by LibVLC may
+     * still hold a cache, which their exit will free. */
+    if (!frame_cache_key_created)
+        frame_cache_key_created =
+            vlc_threadvar_create(&frame_cache_key, vlc_frame_cache_Destroy) == 0;
+
+    bool enabled = frame_cache_key_created;
+    if (enabled && frame_cache_users++ == 0)
+        atomic_store_explicit(&frame_cache_enabled, true,
+                              memory_order_relaxed);
+    vlc_mutex_unlock(&frame_cache_lock);
+    return enabled;
+}
+
+void vlc_frame_cache_Clean(void)
+{
+    vlc_mutex_lock(&frame_cache_lock);
+    assert(frame_cache_users > 0);
+    if (--frame_cache_users == 0)
+    {
+        atomic_store_explicit(&frame_cache_enabled, false,
+                              memory_order_relaxed);
+
+        /* The threads of the instance are joined by now: free the cache of
+         * the calling thread, then the depot. Frames cannot enter the depot
+         * once it is purged, as the flag is checked under its lock. */
+        struct vlc_frame_thread_cache *tc = vlc_threadvar_get(frame_cache_key);
+        if (tc != NULL)
+        {
+            vlc_threadvar_set(frame_cache_key, NULL);
+            vlc_frame_cache_Destroy(tc);
+        }
+
+        for (unsigned i = 0; i < FRAME_CACHE_CLASSES; i++)
+        {
+            struct vlc_frame_cache_list list;
+
+            vlc_mutex_lock(&frame_depot[i].lock);
+            list = frame_depot[i].list;
+            frame_depot[i].list.head = NULL;
+            frame_depot[i].list.count = 0;
+            vlc_mutex_unlock(&frame_depot[i].lock);
+
+            atomic_fetch_sub_explicit(&frame_cache_bytes,
+                                      list.count * vlc_frame_cache_ClassSize(i),
+                                      memory_order_relaxed);
+            vlc_frame_cache_FreeList(&list);
+        }
+    }
+    vlc_mutex_unlock(&frame_cache_lock);
+}
+
+static struct vlc_frame_thread_cache *vlc_frame_cache_Get(void)
+{
+    if (!atomic_load_explicit(&frame_cache_enabled, memory_order_relaxed))
+        return NULL;
+
+    struct vlc_frame_thread_cache *tc = vlc_threadvar_get(frame_cache_key);
+    if (unlikely(tc == NULL))
+    {
+        tc = calloc(1, sizeof (*tc));
+        if (unlikely(tc == NULL))
+            return NULL;
+        if (vlc_threadvar_set(frame_cache_key, tc))
+        {
+            free(tc);
+            return NULL;
+        }
+    }
+    return tc;
+}
+
+/** @return a cached frame of the given class, or NULL */
+static vlc_frame_t *vlc_frame_cache_Take(struct vlc_frame_thread_cache *tc,
+                                         unsigned index)
+{
+    struct vlc_frame_cache_list *list = &tc->classes[index];
+
+    if (list->head == NULL)
+    {
+        vlc_mutex_lock(&frame_depot[index].lock);
+        vlc_frame_cache_Move(list, &frame_depot[index].list,
+                             FRAME_CACHE_BATCH);
+        vlc_mutex_unlock(&frame_depot[index].lock);
+    }
+
+    vlc_frame_t *frame = list->head;
+    if (frame != NULL)
+    {
+        list->head = frame->p_next;
+        list->count--;
+        tc->hits++;
+        tc->bytes -= vlc_frame_cache_ClassSize(index);
+    }
+    else
+        tc->misses++;
+
+    if (tc->hits + tc->misses >= FRAME_CACHE_STATS_FLUSH)
+        vlc_frame_cache_FlushStats(tc);
+    return frame;
+}
+
+/** @return true if the frame was cached, false if it must be freed */
+static bool vlc_frame_cache_Put(vlc_frame_t *frame, unsigned index)
+{
+    struct vlc_frame_thread_cache *tc = vlc_frame_cache_Get();
+    if (tc == NULL)
+        return false;
+
+    struct vlc_frame_cache_list *list = &tc->classes[index];
+
+    if (list->count >= FRAME_CACHE_THREAD_MAX)
+    {
+        const unsigned max = FRAME_CACHE_DEPOT_BYTES
+                           / vlc_frame_cache_ClassSize(index);
+        unsigned moved;
+
+        vlc_mutex_lock(&frame_depot[index].lock);
+        moved = frame_depot[index].list.count;
+        if (moved < max
+         && atomic_load_explicit(&frame_cache_enabled, memory_order_relaxed))
+            vlc_frame_cache_Move(&frame_depot[index].list, list,
+                                 FRAME_CACHE_BATCH);
+        moved = frame_depot[index].list.count - moved;
+        vlc_mutex_unlock(&frame_depot[index].lock);
+
+        if (moved == 0)
+            return false; /* depot full */
+    }
+
+    frame->p_next = list->head;
+    list->head = frame;
+    list->count++;
+    tc->bytes += vlc_frame_cache_ClassSize(index);
+    return true;
+}
+
+void vlc_frame_cache_GetStats(struct vlc_frame_cache_stats *stats)
+{
+    struct vlc_frame_thread_cache *tc = vlc_frame_cache_Get();
+    if (tc != NULL)
+        vlc_frame_cache_FlushStats(tc);
+
+    stats->hits = atomic_load_explicit(&frame_cache_hits,
+                                       memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&frame_cache_misses,
+                                         memory_order_relaxed);
+    stats->bytes_cached = atomic_load_explicit(&frame_cache_bytes,
+                                               memory_order_relaxed);
+    stats->enabled = atomic_load_explicit(&frame_cache_enabled,
+                                          memory_order_relaxed);
+}
+
 static void vlc_frame_generic_Release (vlc_frame_t *frame)
 {
     /* That is always true for frames allocated with vlc_frame_Alloc(). */
     assert (frame->p_start == (unsigned char *)(frame + 1));
+
+    const size_t alloc = sizeof (*frame) + frame->i_size;
+    int index = vlc_frame_cache_Class(alloc);
+    if (index >= 0 && alloc == vlc_frame_cache_ClassSize(index)
+     && vlc_frame_cache_Put(frame, index))
+        return;
     free (frame);
 }
 
@@ -120,12 +429,26 @@ vlc_frame_t *vlc_frame_Alloc (size_t size)
     }
 
     /* 2 * VLC_FRAME_PADDING: pre + post padding */
-    const size_t alloc = sizeof (vlc_frame_t) + VLC_FRAME_ALIGN + (2 * VLC_FRAME_PADDING)
-                       + size;
+    size_t alloc = sizeof (vlc_frame_t) + VLC_FRAME_ALIGN + (2 * VLC_FRAME_PADDING)
+                 + size;
     if (unlikely(alloc <= size))
         return NULL;
 
-    vlc_frame_t *f = malloc (alloc);
+    vlc_frame_t *f = NULL;
+    int index = vlc_frame_cache_Class(alloc);
+    if (index >= 0)
+    {
+        struct vlc_frame_thread_cache *tc = vlc_frame_cache_Get();
+        if (tc != NULL)
+        {
+            /* Round up so that the frame can be recycled on release */
+            alloc = vlc_frame_cache_ClassSize(index);
+            f = vlc_frame_cache_Take(tc, index);
+        }
+    }
+
+    if (f == NULL)
+        f = malloc (alloc);
     if (unlikely(f == NULL))
         return NULL;
 
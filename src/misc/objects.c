@@ -67,8 +67,7 @@ int vlc_object_init(vlc_object_t *restrict obj, vlc_object_t *parent,
 
     priv->parent = parent;
     priv->typename = typename;
-    priv->var_root = NULL;
-    vlc_mutex_init (&priv->var_lock);
+    var_InitAll(priv);
     priv->resources = NULL;
 
     obj->priv = priv;
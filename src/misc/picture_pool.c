@@ -39,12 +39,18 @@
 
 static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
 
+/*
+ * Acquiring and releasing pictures only touch the atomic available bitmask.
+ * The lock and condition variable are only used by picture_pool_Wait() to
+ * sleep, and by releasers to wake it up if there are sleeping waiters.
+ */
 struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_bool               canceled;
+    _Atomic unsigned long long available;
+    atomic_uint               waiters;
     vlc_atomic_rc_t    refs;
     unsigned short     picture_count;
     picture_t  *picture[];
@@ -75,11 +81,19 @@ static void picture_pool_ReleaseClone(picture_t *clone)
 
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+    unsigned long long prev = atomic_fetch_or(&pool->available,
+                                              1ULL << offset);
+    assert(!(prev & (1ULL << offset)));
+    (void) prev;
+
+    /* Sequentially consistent ordering with picture_pool_Wait(): either the
+     * waiter sees the picture, or we see the waiter. */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
 
     picture_pool_Destroy(pool);
 }
@@ -115,13 +129,14 @@ picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
     if (count == POOL_MAX)
-        pool->available = ~0ULL;
+        atomic_init(&pool->available, ~0ULL);
     else
-        pool->available = (1ULL << count) - 1;
+        atomic_init(&pool->available, (1ULL << count) - 1);
+    atomic_init(&pool->waiters, 0);
     vlc_atomic_rc_init(&pool->refs);
     pool->picture_count = count;
     memcpy(pool->picture, tab, count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
     return pool;
 }
 
@@ -178,60 +193,71 @@ error:
     return NULL;
 }
 
-picture_t *picture_pool_Get(picture_pool_t *pool)
+/**
+ * Takes the first available picture out of the bitmask.
+ * @return the picture offset, or -1 if none are available
+ */
+static int picture_pool_Acquire(picture_pool_t *pool)
 {
-    unsigned long long available;
-
-    vlc_mutex_lock(&pool->lock);
-    assert(vlc_atomic_rc_get(&pool->refs) > 0);
-    available = pool->available;
+    unsigned long long available = atomic_load(&pool->available);
 
     while (available != 0)
     {
         int i = ctz(available);
 
-        if (unlikely(pool->canceled))
-            break;
+        if (atomic_compare_exchange_weak(&pool->available, &available,
+                                         available & ~(1ULL << i)))
+            return i;
+    }
+    return -1;
+}
 
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
+picture_t *picture_pool_Get(picture_pool_t *pool)
+{
+    assert(vlc_atomic_rc_get(&pool->refs) > 0);
 
-        return picture_pool_ClonePicture(pool, i);
-    }
+    if (unlikely(atomic_load(&pool->canceled)))
+        return NULL;
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+    int i = picture_pool_Acquire(pool);
+    if (i < 0)
+        return NULL;
+
+    return picture_pool_ClonePicture(pool, i);
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
     assert(vlc_atomic_rc_get(&pool->refs) > 0);
 
-    while (pool->available == 0)
+    int i = picture_pool_Acquire(pool);
+    if (likely(i >= 0))
+        return picture_pool_ClonePicture(pool, i);
+
+    vlc_mutex_lock(&pool->lock);
+    atomic_fetch_add(&pool->waiters, 1);
+
+    while ((i = picture_pool_Acquire(pool)) < 0)
     {
-        if (pool->canceled)
-        {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
-        }
+        if (atomic_load(&pool->canceled))
+            break;
         vlc_cond_wait(&pool->wait, &pool->lock);
     }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
+    atomic_fetch_sub(&pool->waiters, 1);
     vlc_mutex_unlock(&pool->lock);
 
+    if (i < 0)
+        return NULL;
     return picture_pool_ClonePicture(pool, i);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
-    vlc_mutex_lock(&pool->lock);
     assert(vlc_atomic_rc_get(&pool->refs) > 0);
 
-    pool->canceled = canceled;
+    vlc_mutex_lock(&pool->lock);
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -27,21 +27,202 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
 #include <limits.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_arrays.h>
 #include <vlc_charset.h>
 #include "libvlc.h"
 #include "variables.h"
 #include "config/configuration.h"
 
+/**
+ * Interned variable name.
+ *
+ * Variable names are interned in a process-wide table, so that variables are
+ * looked up by comparing atoms rather than strings. Atoms live until the last
+ * object is destroyed. Names come either from the code or from the
+ * configuration items (see var_OptionParse()), and their count is capped.
+ */
+struct vlc_var_atom
+{
+    uint32_t hash;
+    /** Incremented whenever a variable of that name is created or removed */
+    atomic_uint generation;
+    char name[];
+};
+
+/**
+ * Process-wide open addressing table of atoms.
+ *
+ * Readers walk the table without locking. Writers serialize on atoms_lock,
+ * and a full table is replaced by a larger copy. Replaced tables are kept
+ * (chained) as concurrent readers may still be walking them.
+ */
+struct vlc_var_atoms
+{
+    struct vlc_var_atoms *prev;
+    size_t mask;
+    _Atomic(struct vlc_var_atom *) slots[];
+};
+
+/** Maximum number of distinct variable names */
+#define VAR_ATOMS_MAX 65536
+
+static vlc_mutex_t atoms_lock = VLC_STATIC_MUTEX;
+static _Atomic(struct vlc_var_atoms *) atoms = NULL;
+static size_t atoms_count = 0;
+/** Number of live objects, the atoms being freed with the last one */
+static atomic_size_t atoms_users = ATOMIC_VAR_INIT(0);
+
+static uint32_t AtomHash(const char *name)
+{
+    uint32_t hash = 2166136261u; /* FNV-1a */
+
+    while (*name != '\0')
+        hash = (hash ^ (unsigned char)*(name++)) * 16777619u;
+    return hash;
+}
+
+static struct vlc_var_atom *AtomFind(const char *name, uint32_t hash)
+{
+    struct vlc_var_atoms *tab = atomic_load_explicit(&atoms,
+                                                     memory_order_acquire);
+    if (tab == NULL)
+        return NULL;
+
+    for (size_t i = hash & tab->mask;; i = (i + 1) & tab->mask)
+    {
+        struct vlc_var_atom *atom =
+            atomic_load_explicit(&tab->slots[i], memory_order_acquire);
+
+        if (atom == NULL)
+            return NULL;
+        if (atom->hash == hash && strcmp(atom->name, name) == 0)
+            return atom;
+    }
+}
+
+static void AtomInsert(struct vlc_var_atoms *tab, struct vlc_var_atom *atom)
+{
+    size_t i = atom->hash & tab->mask;
+
+    while (atomic_load_explicit(&tab->slots[i], memory_order_relaxed) != NULL)
+        i = (i + 1) & tab->mask;
+    atomic_store_explicit(&tab->slots[i], atom, memory_order_release);
+}
+
+/**
+ * Finds or interns a variable name.
+ * \return the atom, or NULL on memory error
+ */
+static struct vlc_var_atom *AtomGet(const char *name)
+{
+    uint32_t hash = AtomHash(name);
+    struct vlc_var_atom *atom = AtomFind(name, hash);
+
+    if (likely(atom != NULL))
+        return atom;
+
+    vlc_mutex_lock(&atoms_lock);
+    atom = AtomFind(name, hash);
+    if (atom != NULL)
+        goto out;
+
+    struct vlc_var_atoms *tab = atomic_load_explicit(&atoms,
+                                                     memory_order_relaxed);
+    size_t size = (tab != NULL) ? tab->mask + 1 : 0;
+
+    if (unlikely(atoms_count >= VAR_ATOMS_MAX))
+        goto out;
+
+    if ((atoms_count + 1) * 2 > size)
+    {   /* Keep the load factor under one half */
+        size_t newsize = (size > 0) ? size * 2 : 512;
+        struct vlc_var_atoms *newtab =
+            malloc(sizeof (*newtab) + newsize * sizeof (newtab->slots[0]));
+        if (unlikely(newtab == NULL))
+            goto out;
+
+        newtab->prev = tab;
+        newtab->mask = newsize - 1;
+        for (size_t i = 0; i < newsize; i++)
+            atomic_init(&newtab->slots[i], NULL);
+        for (size_t i = 0; i < size; i++)
+        {
+            struct vlc_var_atom *old =
+                atomic_load_explicit(&tab->slots[i], memory_order_relaxed);
+            if (old != NULL)
+                AtomInsert(newtab, old);
+        }
+        atomic_store_explicit(&atoms, newtab, memory_order_release);
+        tab = newtab;
+    }
+
+    size_t len = strlen(name) + 1;
+
+    atom = malloc(sizeof (*atom) + len);
+    if (unlikely(atom == NULL))
+        goto out;
+
+    atom->hash = hash;
+    atomic_init(&atom->generation, 0);
+    memcpy(atom->name, name, len);
+    AtomInsert(tab, atom);
+    atoms_count++;
+out:
+    vlc_mutex_unlock(&atoms_lock);
+    return atom;
+}
+
+static void AtomsHold(void)
+{
+    if (atomic_fetch_add_explicit(&atoms_users, 1, memory_order_acquire) == 0)
+    {   /* Wait for a concurrent AtomsRelease() to complete */
+        vlc_mutex_lock(&atoms_lock);
+        vlc_mutex_unlock(&atoms_lock);
+    }
+}
+
+/**
+ * Frees all atoms once no objects are left. Lock-free readers always hold an
+ * object, so none can be walking the table then.
+ */
+static void AtomsRelease(void)
+{
+    if (atomic_fetch_sub_explicit(&atoms_users, 1, memory_order_release) != 1)
+        return;
+
+    vlc_mutex_lock(&atoms_lock);
+    if (atomic_load_explicit(&atoms_users, memory_order_acquire) == 0)
+    {
+        struct vlc_var_atoms *tab = atomic_load_explicit(&atoms,
+                                                         memory_order_relaxed);
+
+        for (size_t i = 0; tab != NULL && i <= tab->mask; i++)
+            free(atomic_load_explicit(&tab->slots[i], memory_order_relaxed));
+        while (tab != NULL)
+        {
+            struct vlc_var_atoms *prev = tab->prev;
+
+            free(tab);
+            tab = prev;
+        }
+        atomic_store_explicit(&atoms, NULL, memory_order_relaxed);
+        atoms_count = 0;
+    }
+    vlc_mutex_unlock(&atoms_lock);
+}
+
+static void AtomChanged(struct vlc_var_atom *atom)
+{
+    atomic_fetch_add_explicit(&atom->generation, 1, memory_order_release);
+}
+
 typedef struct callback_entry_t
 {
     struct callback_entry_t *next;
@@ -67,7 +248,8 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    const char * psz_name; /**< The variable unique name */
+    struct vlc_var_atom *atom; /**< The interned variable name */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -138,23 +320,104 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/*
+ * Per-object variables table: open addressing with linear probing, keyed by
+ * atom. All of the following must be called with the object var_lock held.
+ */
+static size_t VarFindSlot(const vlc_object_internals_t *priv,
+                          const struct vlc_var_atom *atom)
 {
-    const variable_t *va = a, *vb = b;
+    size_t i = atom->hash & priv->var_mask;
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    while (priv->vars[i] != NULL && priv->vars[i]->atom != atom)
+        i = (i + 1) & priv->var_mask;
+    return i;
 }
 
-static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+static variable_t *VarFind(const vlc_object_internals_t *priv,
+                           const struct vlc_var_atom *atom)
+{
+    if (priv->vars == NULL)
+        return NULL;
+    return priv->vars[VarFindSlot(priv, atom)];
+}
+
+/**
+ * Inserts a variable in the table of an object.
+ * \return the variable with the same name (the inserted one if it did not
+ * exist already), or NULL on memory error
+ */
+static variable_t *VarInsert(vlc_object_internals_t *priv, variable_t *var)
+{
+    size_t size = (priv->vars != NULL) ? priv->var_mask + 1 : 0;
+
+    if ((priv->var_count + 1) * 4 > size * 3)
+    {   /* Keep the load factor under three quarters */
+        size_t newsize = (size > 0) ? size * 2 : 16;
+        variable_t **oldvars = priv->vars;
+
+        priv->vars = calloc(newsize, sizeof (*priv->vars));
+        if (unlikely(priv->vars == NULL))
+        {
+            priv->vars = oldvars;
+            return NULL;
+        }
+        priv->var_mask = newsize - 1;
+        for (size_t i = 0; i < size; i++)
+            if (oldvars[i] != NULL)
+                priv->vars[VarFindSlot(priv, oldvars[i]->atom)] = oldvars[i];
+        free(oldvars);
+    }
+
+    size_t i = VarFindSlot(priv, var->atom);
+
+    if (priv->vars[i] == NULL)
+    {
+        priv->vars[i] = var;
+        priv->var_count++;
+        AtomChanged(var->atom);
+    }
+    return priv->vars[i];
+}
+
+static void VarRemove(vlc_object_internals_t *priv, variable_t *var)
+{
+    size_t mask = priv->var_mask;
+    size_t i = VarFindSlot(priv, var->atom);
+
+    assert(priv->vars[i] == var);
+    priv->vars[i] = NULL;
+    priv->var_count--;
+    AtomChanged(var->atom);
+
+    /* Backward shift the following entries of the cluster, so that no
+     * tombstones are needed. */
+    for (size_t j = (i + 1) & mask; priv->vars[j] != NULL; j = (j + 1) & mask)
+    {
+        size_t home = priv->vars[j]->atom->hash & mask;
+
+        /* Move the entry unless its home slot lies cyclically in (i, j] */
+        if (((j - home) & mask) >= ((j - i) & mask))
+        {
+            priv->vars[i] = priv->vars[j];
+            priv->vars[j] = NULL;
+            i = j;
+        }
+    }
+}
+
+static variable_t *LookupAtom(vlc_object_t *obj,
+                              const struct vlc_var_atom *atom)
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    void **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    return (atom != NULL) ? VarFind(priv, atom) : NULL;
+}
+
+static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+{
+    return LookupAtom(obj, AtomFind(psz_name, AtomHash(psz_name)));
 }
 
 static void Destroy( variable_t *p_var )
@@ -169,7 +432,6 @@ static void Destroy( variable_t *p_var )
     free(p_var->choices);
     free(p_var->choices_text);
 
-    free( p_var->psz_name );
     free( p_var->psz_text );
     while (unlikely(p_var->value_callbacks != NULL))
     {
@@ -290,11 +552,16 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
 {
     assert( p_this );
 
+    struct vlc_var_atom *atom = AtomGet( psz_name );
+    if( unlikely(atom == NULL) )
+        return VLC_ENOMEM;
+
     variable_t *p_var = calloc( 1, sizeof( *p_var ) );
     if( p_var == NULL )
         return VLC_ENOMEM;
 
-    p_var->psz_name = strdup( psz_name );
+    p_var->psz_name = atom->name;
+    p_var->atom = atom;
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -354,16 +621,15 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    void **pp_var;
     variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
+    p_oldvar = VarInsert( p_priv, p_var );
+    if( unlikely(p_oldvar == NULL) )
         ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
+    else if( p_oldvar == p_var ) /* Variable create */
         p_var = NULL; /* Variable created */
     else /* Variable already exists */
     {
@@ -394,7 +660,7 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        VarRemove( p_priv, p_var );
     }
     else
     {
@@ -407,17 +673,32 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
+void var_InitAll( vlc_object_internals_t *priv )
 {
-    Destroy( var );
+    priv->vars = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
+    vlc_mutex_init( &priv->var_lock );
+    for( size_t i = 0; i < VLC_VAR_INHERIT_CACHE; i++ )
+        priv->var_inherit[i].atom = NULL;
+    AtomsHold();
 }
 
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    for( size_t i = 0; priv->vars != NULL && i <= priv->var_mask; i++ )
+        if( priv->vars[i] != NULL )
+        {
+            AtomChanged( priv->vars[i]->atom );
+            Destroy( priv->vars[i] );
+        }
+    free( priv->vars );
+    priv->vars = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
+    AtomsRelease();
 }
 
 int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
@@ -723,16 +1004,14 @@ int (var_Set)(vlc_object_t *p_this, const char *psz_name, vlc_value_t val)
     return var_SetChecked( p_this, psz_name, 0, val );
 }
 
-int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
-                     int expected_type, vlc_value_t *p_val)
+static int GetAtom(vlc_object_t *p_this, const struct vlc_var_atom *atom,
+                   int expected_type, vlc_value_t *p_val)
 {
-    assert( p_this );
-
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
     variable_t *p_var;
     int err = VLC_SUCCESS;
 
-    p_var = Lookup( p_this, psz_name );
+    p_var = LookupAtom( p_this, atom );
     if( p_var != NULL )
     {
         assert( expected_type == 0 ||
@@ -752,6 +1031,15 @@ int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
     return err;
 }
 
+int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
+                     int expected_type, vlc_value_t *p_val)
+{
+    assert( p_this );
+
+    return GetAtom( p_this, AtomFind( psz_name, AtomHash( psz_name ) ),
+                    expected_type, p_val );
+}
+
 int (var_Get)(vlc_object_t *p_this, const char *psz_name, vlc_value_t *p_val)
 {
     return var_GetChecked( p_this, psz_name, 0, p_val );
@@ -1036,16 +1324,64 @@ int (var_LocationParse)(vlc_object_t *obj, const char *mrl, const char *pref)
     return ret;
 }
 
-int var_Inherit( vlc_object_t *p_this, const char *psz_name, int i_type,
-                 vlc_value_t *p_val )
+/**
+ * Looks a variable up in an object and its ancestors.
+ *
+ * The object that held the variable (or the lack thereof) is remembered in a
+ * small per-object cache, so that repeated inheritance from deep objects does
+ * not walk the whole parents chain. Cache entries are valid only as long as
+ * no variable of the same name was created or removed.
+ */
+static int InheritAtom(vlc_object_t *obj, const struct vlc_var_atom *atom,
+                       int type, vlc_value_t *val)
 {
-    i_type &= VLC_VAR_CLASS;
-    for (vlc_object_t *obj = p_this; obj != NULL; obj = vlc_object_parent(obj))
+    vlc_object_internals_t *priv = vlc_internals(obj);
+    struct vlc_var_inherit_entry *entry =
+        &priv->var_inherit[atom->hash % VLC_VAR_INHERIT_CACHE];
+    unsigned generation = atomic_load_explicit(&atom->generation,
+                                               memory_order_acquire);
+    vlc_object_t *owner;
+    bool cached;
+
+    vlc_mutex_lock(&priv->var_lock);
+    cached = entry->atom == atom && entry->generation == generation;
+    owner = entry->owner;
+    vlc_mutex_unlock(&priv->var_lock);
+
+    if (cached)
     {
-        if( var_GetChecked( obj, psz_name, i_type, p_val ) == VLC_SUCCESS )
+        if (owner == NULL)
+            return VLC_ENOENT;
+        if (GetAtom(owner, atom, type, val) == VLC_SUCCESS)
             return VLC_SUCCESS;
+        /* Raced with the variable destruction: fall back to the walk */
     }
 
+    for (owner = obj; owner != NULL; owner = vlc_object_parent(owner))
+        if (GetAtom(owner, atom, type, val) == VLC_SUCCESS)
+            break;
+
+    vlc_mutex_lock(&priv->var_lock);
+    entry->atom = atom;
+    entry->owner = owner;
+    entry->generation = generation;
+    vlc_mutex_unlock(&priv->var_lock);
+
+    return (owner != NULL) ? VLC_SUCCESS : VLC_ENOENT;
+}
+
+int var_Inherit( vlc_object_t *p_this, const char *psz_name, int i_type,
+                 vlc_value_t *p_val )
+{
+    i_type &= VLC_VAR_CLASS;
+
+    /* A name that was never interned cannot be an object variable */
+    const struct vlc_var_atom *atom = AtomFind( psz_name,
+                                                AtomHash( psz_name ) );
+    if( atom != NULL
+     && InheritAtom( p_this, atom, i_type, p_val ) == VLC_SUCCESS )
+        return VLC_SUCCESS;
+
     /* else take value from config */
     switch( i_type & VLC_VAR_CLASS )
     {
@@ -1137,21 +1473,6 @@ error:
     return VLC_EGENERIC;
 }
 
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
-}
-
 char **var_GetAllNames(vlc_object_t *obj)
 {
     vlc_object_internals_t *priv = vlc_internals(obj);
@@ -1159,9 +1480,16 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    for (size_t i = 0; priv->vars != NULL && i <= priv->var_mask; i++)
+    {
+        if (priv->vars[i] == NULL)
+            continue;
+
+        char *dup = strdup(priv->vars[i]->psz_name);
+        if (dup != NULL)
+            ARRAY_APPEND(names, dup);
+    }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
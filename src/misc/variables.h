@@ -26,6 +26,21 @@
 # include <vlc_list.h>
 
 struct vlc_res;
+struct variable_t;
+struct vlc_var_atom;
+
+/** Size of the per-object inherited variables lookup cache */
+#define VLC_VAR_INHERIT_CACHE 8
+
+/**
+ * Cached result of a variable inheritance lookup
+ */
+struct vlc_var_inherit_entry
+{
+    const struct vlc_var_atom *atom; /**< Variable name (or NULL) */
+    vlc_object_t *owner; /**< Object holding the variable, NULL if none */
+    unsigned generation; /**< Name generation the entry is valid for */
+};
 
 /**
  * Private LibVLC data for each object.
@@ -38,8 +53,11 @@ struct vlc_object_internals
     const char *typename; /**< Object type human-readable name */
 
     /* Object variables */
-    void           *var_root;
+    struct variable_t **vars; /**< Open addressing table keyed by atom */
+    size_t          var_mask; /**< Table size minus one */
+    size_t          var_count;
     vlc_mutex_t     var_lock;
+    struct vlc_var_inherit_entry var_inherit[VLC_VAR_INHERIT_CACHE];
 
     /* Object resources */
     struct vlc_res *resources;
@@ -49,6 +67,7 @@ struct vlc_object_internals
 # define vlc_externals(priv) (abort(), (void *)(priv))
 
 extern void var_DestroyAll( vlc_object_t * );
+void var_InitAll( vlc_object_internals_t * );
 
 /**
  * Return a list of all variable names
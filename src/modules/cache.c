@@ -27,7 +27,6 @@
 # include "config.h"
 #endif
 
-#include <stdalign.h>
 #include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -39,6 +38,8 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_arrays.h>
+#include <vlc_vector.h>
 #include "libvlc.h"
 
 #include <vlc_plugin.h>
@@ -57,13 +58,107 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 36
+#define CACHE_SUBVERSION_NUM 37
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
 /* Magic for the cache filename */
 #define CACHE_STRING "cache "PACKAGE_NAME" "PACKAGE_VERSION
 
+/*
+ * After the version strings and markers, the cache consists of a header and
+ * of arrays of fixed size records, in this order: plugins, modules,
+ * configuration parameters, string references, integers and the string
+ * table. Records only contain counts and offsets within the string table,
+ * so that the file is position-independent and is used in place once it is
+ * mapped in memory. Strings are deduplicated, and modules, parameters,
+ * string references and integers are consumed in order while the plugins
+ * are loaded.
+ *
+ * The cache is generated and used on the same host, so native endianness
+ * and alignment are used.
+ */
+#define CACHE_ALIGN 8
+#define CACHE_NO_STRING UINT32_MAX
+
+struct vlc_cache_header
+{
+    uint32_t plugins; /**< Count of plugin records */
+    uint32_t modules; /**< Count of module records */
+    uint32_t params; /**< Count of parameter records */
+    uint32_t refs; /**< Count of string references */
+    uint32_t ints; /**< Count of integers */
+    uint32_t strings_size; /**< Size of the string table in bytes */
+};
+
+struct vlc_cache_plugin
+{
+    int64_t mtime;
+    uint64_t size;
+    uint32_t path;
+    uint32_t textdomain;
+    uint32_t modules;
+    uint16_t params;
+    uint8_t unloadable;
+    uint8_t padding;
+};
+
+struct vlc_cache_module
+{
+    uint32_t shortname;
+    uint32_t longname;
+    uint32_t help;
+    uint32_t capability;
+    uint32_t activate;
+    uint32_t deactivate;
+    int32_t score;
+    uint32_t shortcuts; /**< Count of string references */
+};
+
+#define CACHE_PARAM_INTERNAL 0x1
+#define CACHE_PARAM_UNSAVED  0x2
+#define CACHE_PARAM_SAFE     0x4
+#define CACHE_PARAM_OBSOLETE 0x8
+
+struct vlc_cache_param
+{
+    module_value_t orig; /**< Default value, unless string type */
+    module_value_t min;
+    module_value_t max;
+    uint32_t type;
+    uint32_t name;
+    uint32_t text;
+    uint32_t longtext;
+    uint32_t value; /**< Default value, if string type */
+    uint16_t list_count;
+    uint8_t i_type;
+    uint8_t shortname;
+    uint8_t flags;
+    uint8_t padding[7];
+};
+
+static_assert(sizeof (struct vlc_cache_header) % CACHE_ALIGN == 0,
+              "Misaligned cache records");
+static_assert(sizeof (struct vlc_cache_plugin) % CACHE_ALIGN == 0,
+              "Misaligned cache records");
+static_assert(sizeof (struct vlc_cache_module) % CACHE_ALIGN == 0,
+              "Misaligned cache records");
+static_assert(sizeof (struct vlc_cache_param) % CACHE_ALIGN == 0,
+              "Misaligned cache records");
+
+struct vlc_cache_reader
+{
+    const struct vlc_cache_plugin *plugins;
+    const struct vlc_cache_module *modules;
+    const struct vlc_cache_param *params;
+    const uint32_t *refs;
+    const int *ints;
+    const char *strings;
+    struct vlc_cache_header count; /**< Records left to consume */
+
+    struct vlc_param *param_arena; /**< One slot per parameter record */
+    const char **string_arena; /**< One slot per string reference */
+};
 
 static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
 {
@@ -76,32 +171,16 @@ static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
     return 0;
 }
 
-static int vlc_cache_load_bool(bool *out, block_t *in)
-{
-    unsigned char b;
-
-    if (vlc_cache_load_immediate(&b, in, 1) || b > 1)
-        return -1;
-
-    *out = b;
-    return 0;
-}
-
 static int vlc_cache_load_array(const void **p, size_t size, size_t n,
-                                block_t *file)
+                                size_t align, block_t *file)
 {
-    if (n == 0)
-    {
-        *p = NULL;
-        return 0;
-    }
-
-    if (unlikely(size * n < size))
+    if (unlikely(size * n < size && n > 0))
         return -1;
 
     size *= n;
+    size = (size + align - 1) & ~(align - 1);
 
-    if (file->i_buffer < size)
+    if (file->i_buffer < size || ((uintptr_t)file->p_buffer % align) != 0)
         return -1;
 
     *p = file->p_buffer;
@@ -110,27 +189,42 @@ static int vlc_cache_load_array(const void **p, size_t size, size_t n,
     return 0;
 }
 
-static int vlc_cache_load_string(const char **restrict p, block_t *file)
+static int vlc_cache_load_string(const char **restrict p,
+                                 const struct vlc_cache_reader *reader,
+                                 uint32_t offset)
 {
-    uint16_t size;
+    if (offset == CACHE_NO_STRING)
+        *p = NULL;
+    else if (offset < reader->count.strings_size)
+        *p = reader->strings + offset;
+    else
+        return -1;
+    return 0;
+}
 
-    if (vlc_cache_load_immediate(&size, file, sizeof (size)) || size > 16384)
+/**
+ * Materializes the next string references as an array of pointers.
+ */
+static int vlc_cache_load_strings(const char ***restrict p, size_t n,
+                                  struct vlc_cache_reader *reader)
+{
+    if (n > reader->count.refs)
         return -1;
 
-    if (size == 0)
+    const char **tab = reader->string_arena;
+
+    for (size_t i = 0; i < n; i++)
     {
-        *p = NULL;
-        return 0;
+        if (vlc_cache_load_string(&tab[i], reader, reader->refs[i]))
+            return -1;
+        if (tab[i] == NULL) /* NULL -> empty string */
+            tab[i] = "";
     }
 
-    const char *str = (char *)file->p_buffer;
-
-    if (file->i_buffer < size || str[size - 1] != '\0')
-        return -1;
-
-    file->p_buffer += size;
-    file->i_buffer -= size;
-    *p = str;
+    *p = (n > 0) ? tab : NULL;
+    reader->string_arena += n;
+    reader->refs += n;
+    reader->count.refs -= n;
     return 0;
 }
 
@@ -153,71 +247,51 @@ static int vlc_cache_load_align(size_t align, block_t *file)
     return 0;
 }
 
-#define LOAD_IMMEDIATE(a) \
-    if (vlc_cache_load_immediate(&(a), file, sizeof (a))) \
-        goto error
-#define LOAD_FLAG(a) \
-    do \
-    { \
-        bool b; \
-        if (vlc_cache_load_bool(&b, file)) \
-            goto error; \
-        (a) = b; \
-    } while (0)
-#define LOAD_ARRAY(a,n) \
-    do \
-    { \
-        const void *base; \
-        if (vlc_cache_load_array(&base, sizeof (*(a)), (n), file)) \
-            goto error; \
-        (a) = base; \
-    } while (0)
-#define LOAD_STRING(a) \
-    if (vlc_cache_load_string(&(a), file)) \
+#define LOAD_STRING(a, offset) \
+    if (vlc_cache_load_string(&(a), reader, (offset))) \
         goto error
-#define LOAD_ALIGNOF(t) \
-    if (vlc_cache_load_align(alignof(t), file)) \
+#define LOAD_STRINGS(a, n) \
+    if (vlc_cache_load_strings(&(a), (n), reader)) \
         goto error
 
-static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
+static int vlc_cache_load_config(struct vlc_param *param,
+                                 struct vlc_cache_reader *reader)
 {
     module_config_t *cfg = &param->item;
 
-    LOAD_IMMEDIATE (cfg->i_type);
-    LOAD_IMMEDIATE (param->shortname);
-    LOAD_FLAG (param->internal);
-    LOAD_FLAG (param->unsaved);
-    LOAD_FLAG (param->safe);
-    LOAD_FLAG (param->obsolete);
-    LOAD_STRING (cfg->psz_type);
-    LOAD_STRING (cfg->psz_name);
-    LOAD_STRING (cfg->psz_text);
-    LOAD_STRING (cfg->psz_longtext);
-    LOAD_IMMEDIATE (cfg->list_count);
+    if (reader->count.params == 0)
+        return -1;
+
+    const struct vlc_cache_param *rec = reader->params++;
+    reader->count.params--;
+
+    cfg->i_type = rec->i_type;
+    param->shortname = rec->shortname;
+    param->internal = (rec->flags & CACHE_PARAM_INTERNAL) != 0;
+    param->unsaved = (rec->flags & CACHE_PARAM_UNSAVED) != 0;
+    param->safe = (rec->flags & CACHE_PARAM_SAFE) != 0;
+    param->obsolete = (rec->flags & CACHE_PARAM_OBSOLETE) != 0;
+    LOAD_STRING(cfg->psz_type, rec->type);
+    LOAD_STRING(cfg->psz_name, rec->name);
+    LOAD_STRING(cfg->psz_text, rec->text);
+    LOAD_STRING(cfg->psz_longtext, rec->longtext);
+    cfg->list_count = rec->list_count;
 
     if (IsConfigStringType (cfg->i_type))
     {
         const char *psz;
-        LOAD_STRING(psz);
+        LOAD_STRING(psz, rec->value);
         cfg->orig.psz = (char *)psz;
         atomic_init(&param->value.str, NULL);
         vlc_param_SetString(param, psz);
 
-        if (cfg->list_count)
-            cfg->list.psz = xmalloc (cfg->list_count * sizeof (char *));
-        for (unsigned i = 0; i < cfg->list_count; i++)
-        {
-            LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = calloc (1, 1)) == NULL)
-                goto error;
-        }
+        LOAD_STRINGS(cfg->list.psz, cfg->list_count);
     }
     else
     {
-        LOAD_IMMEDIATE (cfg->orig);
-        LOAD_IMMEDIATE (cfg->min);
-        LOAD_IMMEDIATE (cfg->max);
+        cfg->orig = rec->orig;
+        cfg->min = rec->min;
+        cfg->max = rec->max;
         if (IsConfigFloatType(cfg->i_type))
             atomic_store_explicit(&param->value.f, cfg->orig.f,
                                   memory_order_relaxed);
@@ -226,123 +300,96 @@ static int vlc_cache_load_config(struct vlc_param *param, block_t *file)
                                   memory_order_relaxed);
         cfg->value = cfg->orig;
 
-        if (cfg->list_count)
-        {
-            LOAD_ALIGNOF(int);
-        }
-
-        LOAD_ARRAY(cfg->list.i, cfg->list_count);
-    }
-
-    cfg->list_text = xmalloc (cfg->list_count * sizeof (char *));
-    for (unsigned i = 0; i < cfg->list_count; i++)
-    {
-        LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = calloc (1, 1)) == NULL)
+        if (cfg->list_count > reader->count.ints)
             goto error;
+        cfg->list.i = (cfg->list_count > 0) ? reader->ints : NULL;
+        reader->ints += cfg->list_count;
+        reader->count.ints -= cfg->list_count;
     }
 
+    LOAD_STRINGS(cfg->list_text, cfg->list_count);
     return 0;
 error:
-    return -1; /* FIXME: leaks */
+    return -1;
 }
 
-static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file)
+static int vlc_cache_load_module(vlc_plugin_t *plugin,
+                                 struct vlc_cache_reader *reader)
 {
-    uint16_t lines;
-
-    /* Calculate the structure length */
-    LOAD_IMMEDIATE (lines);
-
-    /* Allocate memory */
-    if (lines)
-    {
-        plugin->conf.params = calloc(sizeof (struct vlc_param), lines);
-        if (unlikely(plugin->conf.params == NULL))
-        {
-            plugin->conf.size = 0;
-            return -1;
-        }
-    }
-    else
-        plugin->conf.params = NULL;
-
-    plugin->conf.size = lines;
-
-    /* Do the duplication job */
-    for (size_t i = 0; i < lines; i++)
-    {
-        struct vlc_param *param = plugin->conf.params + i;
-        module_config_t *item = &param->item;
-
-        if (vlc_cache_load_config(param, file))
-            return -1;
-
-        if (CONFIG_ITEM(item->i_type))
-        {
-            plugin->conf.count++;
-            if (item->i_type == CONFIG_ITEM_BOOL)
-                plugin->conf.booleans++;
-        }
-        param->owner = plugin;
-    }
+    if (reader->count.modules == 0)
+        return -1;
 
-    return 0;
-error:
-    return -1; /* FIXME: leaks */
-}
+    const struct vlc_cache_module *rec = reader->modules++;
+    reader->count.modules--;
 
-static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
-{
     module_t *module = vlc_module_create(plugin);
     if (unlikely(module == NULL))
         return -1;
 
-    LOAD_STRING(module->psz_shortname);
-    LOAD_STRING(module->psz_longname);
-    LOAD_STRING(module->psz_help);
+    LOAD_STRING(module->psz_shortname, rec->shortname);
+    LOAD_STRING(module->psz_longname, rec->longname);
+    LOAD_STRING(module->psz_help, rec->help);
 
-    LOAD_IMMEDIATE(module->i_shortcuts);
-    if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
+    if (rec->shortcuts > MODULE_SHORTCUT_MAX)
         goto error;
-    else
-    {
-        module->pp_shortcuts =
-            xmalloc (sizeof (*module->pp_shortcuts) * module->i_shortcuts);
-        for (unsigned j = 0; j < module->i_shortcuts; j++)
-            LOAD_STRING(module->pp_shortcuts[j]);
-    }
+    module->i_shortcuts = rec->shortcuts;
+    LOAD_STRINGS(module->pp_shortcuts, module->i_shortcuts);
 
-    LOAD_STRING(module->activate_name);
-    LOAD_STRING(module->deactivate_name);
-    LOAD_STRING(module->psz_capability);
-    LOAD_IMMEDIATE(module->i_score);
+    LOAD_STRING(module->activate_name, rec->activate);
+    LOAD_STRING(module->deactivate_name, rec->deactivate);
+    LOAD_STRING(module->psz_capability, rec->capability);
+    module->i_score = rec->score;
     return 0;
 error:
     return -1;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+static vlc_plugin_t *vlc_cache_load_plugin(struct vlc_cache_reader *reader)
 {
+    const struct vlc_cache_plugin *rec = reader->plugins++;
+
     vlc_plugin_t *plugin = vlc_plugin_create();
     if (unlikely(plugin == NULL))
         return NULL;
 
-    uint32_t modules;
-    LOAD_IMMEDIATE(modules);
+    /* The descriptor arrays belong to the cache backing from now on */
+    plugin->cached = true;
 
-    for (size_t i = 0; i < modules; i++)
-        if (vlc_cache_load_module(plugin, file))
+    for (size_t i = 0; i < rec->modules; i++)
+        if (vlc_cache_load_module(plugin, reader))
             goto error;
 
-    if (vlc_cache_load_plugin_config(plugin, file))
+    if (rec->params > reader->count.params)
         goto error;
 
-    LOAD_STRING(plugin->textdomain);
+    plugin->conf.params = (rec->params > 0) ? reader->param_arena : NULL;
+    plugin->conf.size = rec->params;
+    reader->param_arena += rec->params;
+
+    for (size_t i = 0; i < rec->params; i++)
+    {
+        struct vlc_param *param = plugin->conf.params + i;
+        module_config_t *item = &param->item;
+
+        if (vlc_cache_load_config(param, reader))
+        {
+            plugin->conf.size = i + 1;
+            goto error;
+        }
+
+        if (CONFIG_ITEM(item->i_type))
+        {
+            plugin->conf.count++;
+            if (item->i_type == CONFIG_ITEM_BOOL)
+                plugin->conf.booleans++;
+        }
+        param->owner = plugin;
+    }
+
+    LOAD_STRING(plugin->textdomain, rec->textdomain);
 
     const char *path;
-    LOAD_STRING(path);
+    LOAD_STRING(path, rec->path);
     if (path == NULL)
         goto error;
 
@@ -350,9 +397,11 @@ static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
     if (unlikely(plugin->path == NULL))
         goto error;
 
-    LOAD_FLAG(plugin->unloadable);
-    LOAD_IMMEDIATE(plugin->mtime);
-    LOAD_IMMEDIATE(plugin->size);
+    if (rec->unloadable > 1)
+        goto error;
+    plugin->unloadable = rec->unloadable;
+    plugin->mtime = rec->mtime;
+    plugin->size = rec->size;
 
     if (plugin->textdomain != NULL)
         vlc_bindtextdomain(plugin->textdomain);
@@ -364,6 +413,43 @@ error:
     return NULL;
 }
 
+static int vlc_cache_load_header(struct vlc_cache_reader *reader,
+                                 block_t *file)
+{
+    struct vlc_cache_header *count = &reader->count;
+    const void *strings;
+
+    if (vlc_cache_load_align(CACHE_ALIGN, file)
+     || vlc_cache_load_immediate(count, file, sizeof (*count))
+     || vlc_cache_load_array((const void **)&reader->plugins,
+                             sizeof (*reader->plugins), count->plugins,
+                             CACHE_ALIGN, file)
+     || vlc_cache_load_array((const void **)&reader->modules,
+                             sizeof (*reader->modules), count->modules,
+                             CACHE_ALIGN, file)
+     || vlc_cache_load_array((const void **)&reader->params,
+                             sizeof (*reader->params), count->params,
+                             CACHE_ALIGN, file)
+     || vlc_cache_load_array((const void **)&reader->refs,
+                             sizeof (*reader->refs), count->refs,
+                             CACHE_ALIGN, file)
+     || vlc_cache_load_array((const void **)&reader->ints,
+                             sizeof (*reader->ints), count->ints,
+                             CACHE_ALIGN, file)
+     || vlc_cache_load_array(&strings, 1, count->strings_size, 1, file))
+        return -1;
+
+    reader->strings = strings;
+
+    /* All strings are NUL-terminated, including the last one, so that any
+     * offset within the table is a valid string. */
+    if (file->i_buffer != 0
+     || (count->strings_size > 0
+      && reader->strings[count->strings_size - 1] != '\0'))
+        return -1;
+    return 0;
+}
+
 /**
  * Loads a plugins cache file.
  *
@@ -443,11 +529,36 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
         return NULL;
     }
 
-    vlc_plugin_t *cache = NULL;
+    struct vlc_cache_reader reader;
 
-    while (file->i_buffer > 0)
+    if (vlc_cache_load_header(&reader, file))
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
+        msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
+        block_Release(file);
+        return NULL;
+    }
+
+    /* Configuration parameters and string pointer arrays are materialized in
+     * a single allocation, released along with the file. */
+    size_t params_size = reader.count.params * sizeof (struct vlc_param);
+    block_t *arena = block_Alloc(params_size
+                                 + reader.count.refs * sizeof (const char *));
+    if (unlikely(arena == NULL))
+    {
+        block_Release(file);
+        return NULL;
+    }
+    memset(arena->p_buffer, 0, params_size);
+    reader.param_arena = (struct vlc_param *)arena->p_buffer;
+    reader.string_arena = (const char **)(arena->p_buffer + params_size);
+
+    /* Keep the order of the cache, which is that of the directory scan, so
+     * that vlc_cache_lookup() usually finds plugins at the head of the list */
+    vlc_plugin_t *cache = NULL, **pp = &cache;
+
+    for (uint32_t i = 0; i < reader.count.plugins; i++)
+    {
+        vlc_plugin_t *plugin = vlc_cache_load_plugin(&reader);
         if (plugin == NULL)
             goto error;
 
@@ -459,146 +570,248 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
             goto error;
         }
 
-        plugin->next = cache;
-        cache = plugin;
+        *pp = plugin;
+        pp = &plugin->next;
     }
+    *pp = NULL;
+
+    if (reader.count.modules != 0 || reader.count.params != 0
+     || reader.count.refs != 0 || reader.count.ints != 0)
+        goto error;
 
     file->p_next = *backingp;
-    *backingp = file;
+    arena->p_next = file;
+    *backingp = arena;
     return cache;
 
 error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
-    /* TODO: cleanup */
+    *pp = NULL;
+    while (cache != NULL)
+    {
+        vlc_plugin_t *plugin = cache;
+
+        cache = plugin->next;
+        vlc_plugin_destroy(plugin);
+    }
+    block_Release(arena);
     block_Release(file);
     return NULL;
 }
-
 #define SAVE_IMMEDIATE( a ) \
     if (fwrite (&(a), sizeof(a), 1, file) != 1) \
         goto error
-#define SAVE_FLAG(a) \
-    do { \
-        char b = (a); \
-        SAVE_IMMEDIATE(b); \
-    } while (0)
+static int CacheSaveAlign(FILE *file, size_t align)
+{
+    assert(align > 0);
+
+    size_t skip = (-ftell(file)) % align;
+    if (skip == 0)
+        return 0;
 
-static int CacheSaveString (FILE *file, const char *str)
+    assert(((ftell(file) + skip) % align) == 0);
+    return fseek(file, skip, SEEK_CUR);
+}
+
+struct vlc_cache_writer
+{
+    struct VLC_VECTOR(struct vlc_cache_plugin) plugins;
+    struct VLC_VECTOR(struct vlc_cache_module) modules;
+    struct VLC_VECTOR(struct vlc_cache_param) params;
+    struct VLC_VECTOR(uint32_t) refs;
+    struct VLC_VECTOR(int) ints;
+    struct VLC_VECTOR(char) strings;
+    vlc_dictionary_t offsets; /**< String table offsets (plus one) */
+};
+
+static int CacheSaveString(struct vlc_cache_writer *writer, const char *str,
+                           uint32_t *restrict offset)
 {
-    uint16_t size = (str != NULL) ? (strlen (str) + 1) : 0;
+    if (str == NULL)
+    {
+        *offset = CACHE_NO_STRING;
+        return 0;
+    }
 
-    SAVE_IMMEDIATE (size);
-    if (size != 0 && fwrite(str, 1, size, file) != size)
+    void *known = vlc_dictionary_value_for_key(&writer->offsets, str);
+    if (known != kVLCDictionaryNotFound)
     {
-error:
-        return -1;
+        *offset = (uintptr_t)known - 1;
+        return 0;
     }
+
+    size_t len = strlen(str) + 1;
+    size_t pos = writer->strings.size;
+
+    if (pos + len >= CACHE_NO_STRING
+     || !vlc_vector_push_all(&writer->strings, str, len))
+        return -1;
+
+    vlc_dictionary_insert(&writer->offsets, str, (void *)(uintptr_t)(pos + 1));
+    *offset = pos;
     return 0;
 }
 
-#define SAVE_STRING( a ) \
-    if (CacheSaveString (file, (a))) \
+#define SAVE_STRING(a, offset) \
+    if (CacheSaveString(writer, (a), &(offset))) \
         goto error
 
-static int CacheSaveAlign(FILE *file, size_t align)
+static int CacheSaveStringRef(struct vlc_cache_writer *writer,
+                              const char *str)
 {
-    assert(align > 0);
+    uint32_t offset;
 
-    size_t skip = (-ftell(file)) % align;
-    if (skip == 0)
-        return 0;
-
-    assert(((ftell(file) + skip) % align) == 0);
-    return fseek(file, skip, SEEK_CUR);
+    if (CacheSaveString(writer, str, &offset)
+     || !vlc_vector_push(&writer->refs, offset))
+        return -1;
+    return 0;
 }
 
-#define SAVE_ALIGNOF(t) \
-    if (CacheSaveAlign(file, alignof (t))) \
+#define SAVE_STRING_REF(a) \
+    if (CacheSaveStringRef(writer, (a))) \
         goto error
 
-static int CacheSaveConfig(FILE *file, const struct vlc_param *param)
+static int CacheSaveConfig(struct vlc_cache_writer *writer,
+                           const struct vlc_param *param)
 {
     const module_config_t *cfg = &param->item;
-
-    SAVE_IMMEDIATE (cfg->i_type);
-    SAVE_IMMEDIATE (param->shortname);
-    SAVE_FLAG (param->internal);
-    SAVE_FLAG (param->unsaved);
-    SAVE_FLAG (param->safe);
-    SAVE_FLAG (param->obsolete);
-    SAVE_STRING (cfg->psz_type);
-    SAVE_STRING (cfg->psz_name);
-    SAVE_STRING (cfg->psz_text);
-    SAVE_STRING (cfg->psz_longtext);
-    SAVE_IMMEDIATE (cfg->list_count);
+    struct vlc_cache_param rec;
+
+    memset(&rec, 0, sizeof (rec));
+    rec.i_type = cfg->i_type;
+    rec.shortname = param->shortname;
+    rec.flags = (param->internal ? CACHE_PARAM_INTERNAL : 0)
+              | (param->unsaved ? CACHE_PARAM_UNSAVED : 0)
+              | (param->safe ? CACHE_PARAM_SAFE : 0)
+              | (param->obsolete ? CACHE_PARAM_OBSOLETE : 0);
+    SAVE_STRING(cfg->psz_type, rec.type);
+    SAVE_STRING(cfg->psz_name, rec.name);
+    SAVE_STRING(cfg->psz_text, rec.text);
+    SAVE_STRING(cfg->psz_longtext, rec.longtext);
+    rec.list_count = cfg->list_count;
 
     if (IsConfigStringType (cfg->i_type))
     {
-        SAVE_STRING (cfg->orig.psz);
+        SAVE_STRING(cfg->orig.psz, rec.value);
 
         for (unsigned i = 0; i < cfg->list_count; i++)
-            SAVE_STRING (cfg->list.psz[i]);
+            SAVE_STRING_REF(cfg->list.psz[i]);
     }
     else
     {
-        SAVE_IMMEDIATE (cfg->orig);
-        SAVE_IMMEDIATE (cfg->min);
-        SAVE_IMMEDIATE (cfg->max);
-
-        if (cfg->list_count > 0)
-        {
-            SAVE_ALIGNOF(int);
-        }
+        rec.orig = cfg->orig;
+        rec.min = cfg->min;
+        rec.max = cfg->max;
+        rec.value = CACHE_NO_STRING;
 
-        for (unsigned i = 0; i < cfg->list_count; i++)
-             SAVE_IMMEDIATE (cfg->list.i[i]);
+        if (cfg->list_count > 0
+         && !vlc_vector_push_all(&writer->ints, cfg->list.i, cfg->list_count))
+            goto error;
     }
     for (unsigned i = 0; i < cfg->list_count; i++)
-        SAVE_STRING (cfg->list_text[i]);
+        SAVE_STRING_REF(cfg->list_text[i]);
 
+    if (!vlc_vector_push(&writer->params, rec))
+        goto error;
     return 0;
 error:
     return -1;
 }
 
-static int CacheSaveModuleConfig(FILE *file, const vlc_plugin_t *plugin)
+static int CacheSaveModule(struct vlc_cache_writer *writer,
+                           const module_t *module)
 {
-    uint16_t lines = plugin->conf.size;
+    struct vlc_cache_module rec;
+
+    SAVE_STRING(module->psz_shortname, rec.shortname);
+    SAVE_STRING(module->psz_longname, rec.longname);
+    SAVE_STRING(module->psz_help, rec.help);
+    rec.shortcuts = module->i_shortcuts;
 
-    SAVE_IMMEDIATE (lines);
+    for (size_t j = 0; j < module->i_shortcuts; j++)
+        SAVE_STRING_REF(module->pp_shortcuts[j]);
 
-    for (size_t i = 0; i < lines; i++)
-        if (CacheSaveConfig(file, plugin->conf.params + i))
-           goto error;
+    SAVE_STRING(module->activate_name, rec.activate);
+    SAVE_STRING(module->deactivate_name, rec.deactivate);
+    SAVE_STRING(module->psz_capability, rec.capability);
+    rec.score = module->i_score;
 
+    if (!vlc_vector_push(&writer->modules, rec))
+        goto error;
     return 0;
 error:
     return -1;
 }
 
-static int CacheSaveModule(FILE *file, const module_t *module)
+static int CacheSavePlugin(struct vlc_cache_writer *writer,
+                           const vlc_plugin_t *plugin)
 {
-    SAVE_STRING(module->psz_shortname);
-    SAVE_STRING(module->psz_longname);
-    SAVE_STRING(module->psz_help);
-    SAVE_IMMEDIATE(module->i_shortcuts);
+    struct vlc_cache_plugin rec;
 
-    for (size_t j = 0; j < module->i_shortcuts; j++)
-         SAVE_STRING(module->pp_shortcuts[j]);
+    memset(&rec, 0, sizeof (rec));
+    rec.modules = plugin->modules_count;
+
+    for (module_t *module = plugin->module;
+         module != NULL;
+         module = module->next)
+        if (CacheSaveModule(writer, module))
+            goto error;
+
+    /* Config stuff */
+    if (plugin->conf.size > UINT16_MAX)
+        goto error;
+    rec.params = plugin->conf.size;
 
-    SAVE_STRING(module->activate_name);
-    SAVE_STRING(module->deactivate_name);
-    SAVE_STRING(module->psz_capability);
-    SAVE_IMMEDIATE(module->i_score);
+    for (size_t i = 0; i < plugin->conf.size; i++)
+        if (CacheSaveConfig(writer, plugin->conf.params + i))
+            goto error;
+
+    /* Save common info */
+    SAVE_STRING(plugin->textdomain, rec.textdomain);
+    SAVE_STRING(plugin->path, rec.path);
+    rec.unloadable = plugin->unloadable;
+    rec.mtime = plugin->mtime;
+    rec.size = plugin->size;
+
+    if (!vlc_vector_push(&writer->plugins, rec))
+        goto error;
     return 0;
 error:
     return -1;
 }
 
+#define SAVE_ARRAY(v) \
+    if (fwrite((v).data, sizeof (*(v).data), (v).size, file) != (v).size \
+     || CacheSaveAlign(file, CACHE_ALIGN)) \
+        goto error
+
 static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
 {
+    struct vlc_cache_writer w, *writer = &w;
     uint32_t i_file_size = 0;
+    int ret = -1;
+
+    vlc_vector_init(&writer->plugins);
+    vlc_vector_init(&writer->modules);
+    vlc_vector_init(&writer->params);
+    vlc_vector_init(&writer->refs);
+    vlc_vector_init(&writer->ints);
+    vlc_vector_init(&writer->strings);
+    vlc_dictionary_init(&writer->offsets, 4096);
+
+    for (size_t i = 0; i < n; i++)
+        if (CacheSavePlugin(writer, cache[i]))
+            goto error;
+
+    struct vlc_cache_header header = {
+        .plugins = writer->plugins.size,
+        .modules = writer->modules.size,
+        .params = writer->params.size,
+        .refs = writer->refs.size,
+        .ints = writer->ints.size,
+        .strings_size = writer->strings.size,
+    };
 
     /* Contains version number */
     if (fputs (CACHE_STRING, file) == EOF)
@@ -619,37 +832,31 @@ static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
-    for (size_t i = 0; i < n; i++)
-    {
-        const vlc_plugin_t *plugin = cache[i];
-        uint32_t count = plugin->modules_count;
-
-        SAVE_IMMEDIATE(count);
-
-        for (module_t *module = plugin->module;
-             module != NULL;
-             module = module->next)
-            if (CacheSaveModule(file, module))
-                goto error;
-
-        /* Config stuff */
-        if (CacheSaveModuleConfig(file, plugin))
-            goto error;
-
-        /* Save common info */
-        SAVE_STRING(plugin->textdomain);
-        SAVE_STRING(plugin->path);
-        SAVE_FLAG(plugin->unloadable);
-        SAVE_IMMEDIATE(plugin->mtime);
-        SAVE_IMMEDIATE(plugin->size);
-    }
+    if (CacheSaveAlign(file, CACHE_ALIGN))
+        goto error;
+    SAVE_IMMEDIATE(header);
+    SAVE_ARRAY(writer->plugins);
+    SAVE_ARRAY(writer->modules);
+    SAVE_ARRAY(writer->params);
+    SAVE_ARRAY(writer->refs);
+    SAVE_ARRAY(writer->ints);
+    if (fwrite(writer->strings.data, 1, writer->strings.size, file)
+            != writer->strings.size)
+        goto error;
 
     if (fflush (file)) /* flush libc buffers */
         goto error;
-    return 0; /* success! */
+    ret = 0; /* success! */
 
 error:
-    return -1;
+    vlc_dictionary_clear(&writer->offsets, NULL, NULL);
+    vlc_vector_destroy(&writer->strings);
+    vlc_vector_destroy(&writer->ints);
+    vlc_vector_destroy(&writer->refs);
+    vlc_vector_destroy(&writer->params);
+    vlc_vector_destroy(&writer->modules);
+    vlc_vector_destroy(&writer->plugins);
+    return ret;
 }
 
 /**
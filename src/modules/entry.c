@@ -106,6 +106,7 @@ vlc_plugin_t *vlc_plugin_create(void)
     plugin->conf.booleans = 0;
 #ifdef HAVE_DYNAMIC_PLUGINS
     plugin->unloadable = true;
+    plugin->cached = false;
     atomic_init(&plugin->handle, 0);
     plugin->abspath = NULL;
     plugin->path = NULL;
@@ -127,6 +128,27 @@ void vlc_plugin_destroy(vlc_plugin_t *plugin)
     assert(!plugin->unloadable || atomic_load(&plugin->handle) == 0);
 #endif
 
+#ifdef HAVE_DYNAMIC_PLUGINS
+    if (plugin->cached)
+    {
+        /* Shortcuts, parameters and choices are owned by the cache backing,
+         * only the current string values were allocated. */
+        for (module_t *module = plugin->module; module != NULL;
+             module = module->next)
+            module->pp_shortcuts = NULL;
+
+        for (size_t i = 0; i < plugin->conf.size; i++)
+        {
+            struct vlc_param *param = plugin->conf.params + i;
+
+            if (IsConfigStringType(param->item.i_type))
+                free(atomic_load_explicit(&param->value.str,
+                                          memory_order_relaxed));
+        }
+        plugin->conf.params = NULL;
+        plugin->conf.size = 0;
+    }
+#endif
     if (plugin->module != NULL)
         vlc_module_destroy(plugin->module);
 
@@ -49,6 +49,7 @@ typedef struct vlc_plugin_t
 
 #ifdef HAVE_DYNAMIC_PLUGINS
     bool unloadable; /**< Whether the plug-in can be unloaded safely */
+    bool cached; /**< Whether the descriptors are backed by the cache */
     atomic_uintptr_t handle; /**< Run-time linker handle (or nul) */
     char *abspath; /**< Absolute path */
 
@@ -345,7 +345,13 @@ int input_preparser_Push( input_preparser_t *preparser,
 
     PreparserAddTask(preparser, task);
 
-    vlc_executor_Submit(preparser->executor, &task->runnable);
+    /* Requests that may interact with the user must not wait behind the
+     * whole queue of background requests */
+    enum vlc_executor_priority priority =
+        i_options & META_REQUEST_OPTION_DO_INTERACT
+            ? VLC_EXECUTOR_PRIORITY_HIGH : VLC_EXECUTOR_PRIORITY_NORMAL;
+    vlc_executor_SubmitWithPriority(preparser->executor, &task->runnable,
+                                    priority);
     return VLC_SUCCESS;
 }
 
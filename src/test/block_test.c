@@ -23,12 +23,14 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #undef NDEBUG
 #include <assert.h>
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include "../../lib/libvlc_internal.h"
 
 static const char text[] =
     "This is a test!\n"
@@ -86,11 +88,157 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void test_block_Cache (void)
+{
+    const char *argv[] = { "vlc", "--ignore-config" };
+    struct vlc_frame_cache_stats before, after;
+    block_t *blocks[64];
+
+    /* The cache lives as long as a LibVLC instance */
+    libvlc_int_t *libvlc = libvlc_InternalCreate ();
+    assert (libvlc != NULL);
+    int ret = libvlc_InternalInit (libvlc, ARRAY_SIZE(argv), argv);
+    assert (ret == VLC_SUCCESS);
+
+    vlc_frame_cache_GetStats (&before);
+
+    /* Warm up the cache, then check released blocks are reused */
+    for (unsigned i = 0; i < ARRAY_SIZE(blocks); i++)
+    {
+        blocks[i] = block_Alloc (188 * (i % 8 + 1));
+        assert (blocks[i] != NULL);
+        memset (blocks[i]->p_buffer, i, blocks[i]->i_buffer);
+    }
+    for (unsigned i = 0; i < ARRAY_SIZE(blocks); i++)
+        block_Release (blocks[i]);
+
+    for (unsigned i = 0; i < ARRAY_SIZE(blocks); i++)
+    {
+        blocks[i] = block_Alloc (188 * (i % 8 + 1));
+        assert (blocks[i] != NULL);
+        assert (blocks[i]->i_buffer == 188 * (i % 8 + 1));
+        assert (((uintptr_t)blocks[i]->p_buffer % 16) == 0);
+        assert (blocks[i]->i_pts == VLC_TICK_INVALID);
+        assert (blocks[i]->i_flags == 0);
+    }
+    for (unsigned i = 0; i < ARRAY_SIZE(blocks); i++)
+        block_Release (blocks[i]);
+
+    vlc_frame_cache_GetStats (&after);
+
+    if (after.enabled)
+    {
+        assert (after.hits > before.hits);
+        assert (after.bytes_cached > 0);
+        printf ("frame cache: %"PRIu64" hits, %"PRIu64" misses, %zu bytes\n",
+                after.hits, after.misses, after.bytes_cached);
+    }
+    else
+        puts ("frame cache disabled, skipping checks");
+
+    libvlc_InternalCleanup (libvlc);
+    libvlc_InternalDestroy (libvlc);
+
+    /* The last instance frees the cache */
+    vlc_frame_cache_GetStats (&after);
+    assert (!after.enabled);
+    assert (after.bytes_cached == 0);
+}
+
+#define FIFO_BLOCKS 100000
+
+static void *test_block_FifoProducer (void *data)
+{
+    block_fifo_t *fifo = data;
+
+    for (unsigned i = 0; i < FIFO_BLOCKS; i++)
+    {
+        block_t *block = block_Alloc (i % 7);
+        assert (block != NULL);
+        block->i_dts = i;
+        vlc_fifo_Push (fifo, block);
+    }
+    return NULL;
+}
+
+static void test_block_FifoSingleProducer (void)
+{
+    block_fifo_t *fifo = vlc_fifo_NewSingleProducer (5);
+    assert (fifo != NULL);
+
+    /* Overflow the ring, then check ordering and accounting */
+    size_t bytes = 0;
+    for (unsigned i = 0; i < 20; i++)
+    {
+        block_t *block = block_Alloc (i);
+        assert (block != NULL);
+        block->i_dts = i;
+        vlc_fifo_Push (fifo, block);
+        bytes += i;
+        assert (vlc_fifo_GetBytesRelaxed (fifo) == bytes);
+    }
+
+    vlc_fifo_Lock (fifo);
+    assert (vlc_fifo_GetCount (fifo) == 20);
+    assert (vlc_fifo_GetBytes (fifo) == bytes);
+    for (unsigned i = 0; i < 10; i++)
+    {
+        block_t *block = vlc_fifo_DequeueUnlocked (fifo);
+        assert (block != NULL && block->i_dts == i);
+        block_Release (block);
+    }
+    vlc_fifo_Unlock (fifo);
+
+    /* Blocks pushed now must still come after the overflowed ones */
+    block_t *block = block_Alloc (0);
+    assert (block != NULL);
+    block->i_dts = 20;
+    vlc_fifo_Push (fifo, block);
+
+    vlc_fifo_Lock (fifo);
+    assert (vlc_fifo_GetCount (fifo) == 11);
+    block = vlc_fifo_DequeueAllUnlocked (fifo);
+    assert (vlc_fifo_IsEmpty (fifo));
+    assert (vlc_fifo_GetBytes (fifo) == 0);
+    vlc_fifo_Unlock (fifo);
+
+    for (unsigned i = 10; i <= 20; i++)
+    {
+        assert (block != NULL && block->i_dts == i);
+        block_t *next = block->p_next;
+        block_Release (block);
+        block = next;
+    }
+    assert (block == NULL);
+
+    /* Concurrent producer and consumer */
+    vlc_thread_t th;
+    int val = vlc_clone (&th, test_block_FifoProducer, fifo,
+                         VLC_THREAD_PRIORITY_LOW);
+    assert (val == 0);
+
+    for (unsigned i = 0; i < FIFO_BLOCKS; i++)
+    {
+        block = vlc_fifo_Get (fifo);
+        assert (block->i_dts == i);
+        assert (block->i_buffer == i % 7);
+        block_Release (block);
+    }
+    vlc_join (th, NULL);
+
+    vlc_fifo_Lock (fifo);
+    assert (vlc_fifo_IsEmpty (fifo));
+    vlc_fifo_Unlock (fifo);
+    vlc_fifo_Release (fifo);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Cache ();
+    test_block_FifoSingleProducer ();
     return 0;
 }
 
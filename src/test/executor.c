@@ -25,8 +25,10 @@
 #undef NDEBUG
 
 #include <assert.h>
+#include <stdio.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_executor.h>
 #include <vlc_tick.h>
 
@@ -271,6 +273,165 @@ static void test_task_chain(void)
         assert(array[i] == 2 * i);
 }
 
+struct priority_data
+{
+    vlc_mutex_t lock;
+    vlc_cond_t cond;
+    bool blocked;
+    int order[10];
+    int count;
+};
+
+struct priority_task
+{
+    struct priority_data *data;
+    int id;
+    struct vlc_runnable runnable;
+};
+
+static void RunBlocker(void *userdata)
+{
+    struct priority_data *data = userdata;
+
+    vlc_mutex_lock(&data->lock);
+    data->blocked = true;
+    vlc_cond_signal(&data->cond);
+    while (data->blocked)
+        vlc_cond_wait(&data->cond, &data->lock);
+    vlc_mutex_unlock(&data->lock);
+}
+
+static void RunRecordOrder(void *userdata)
+{
+    struct priority_task *task = userdata;
+    struct priority_data *data = task->data;
+
+    vlc_mutex_lock(&data->lock);
+    data->order[data->count++] = task->id;
+    vlc_mutex_unlock(&data->lock);
+}
+
+static void test_priority(void)
+{
+    vlc_executor_t *executor = vlc_executor_New(1);
+    assert(executor);
+
+    struct priority_data data = { .blocked = false, .count = 0 };
+    vlc_mutex_init(&data.lock);
+    vlc_cond_init(&data.cond);
+
+    /* Block the only thread, so that all the following tasks are queued */
+    struct vlc_runnable blocker = {
+        .run = RunBlocker,
+        .userdata = &data,
+    };
+    vlc_executor_Submit(executor, &blocker);
+
+    vlc_mutex_lock(&data.lock);
+    while (!data.blocked)
+        vlc_cond_wait(&data.cond, &data.lock);
+    vlc_mutex_unlock(&data.lock);
+
+    static const enum vlc_executor_priority priorities[] = {
+        VLC_EXECUTOR_PRIORITY_LOW, VLC_EXECUTOR_PRIORITY_LOW,
+        VLC_EXECUTOR_PRIORITY_NORMAL, VLC_EXECUTOR_PRIORITY_LOW,
+        VLC_EXECUTOR_PRIORITY_HIGH, VLC_EXECUTOR_PRIORITY_NORMAL,
+        VLC_EXECUTOR_PRIORITY_HIGH,
+    };
+    /* Expected start order: by priority, then by submission */
+    static const int expected[] = { 4, 6, 2, 5, 0, 1, 3 };
+
+    struct priority_task tasks[ARRAY_SIZE(priorities)];
+    for (size_t i = 0; i < ARRAY_SIZE(priorities); ++i)
+    {
+        tasks[i].data = &data;
+        tasks[i].id = i;
+        tasks[i].runnable.run = RunRecordOrder;
+        tasks[i].runnable.userdata = &tasks[i];
+        vlc_executor_SubmitWithPriority(executor, &tasks[i].runnable,
+                                        priorities[i]);
+    }
+
+    struct vlc_executor_stats stats;
+    vlc_executor_GetStats(executor, &stats);
+    assert(stats.threads == 1);
+    assert(stats.unfinished == ARRAY_SIZE(priorities) + 1);
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_LOW].queued == 3);
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_NORMAL].queued == 2);
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_HIGH].queued == 2);
+
+    vlc_mutex_lock(&data.lock);
+    data.blocked = false;
+    vlc_cond_signal(&data.cond);
+    vlc_mutex_unlock(&data.lock);
+
+    vlc_executor_WaitIdle(executor);
+
+    assert(data.count == ARRAY_SIZE(expected));
+    for (size_t i = 0; i < ARRAY_SIZE(expected); ++i)
+        assert(data.order[i] == expected[i]);
+
+    vlc_executor_GetStats(executor, &stats);
+    assert(stats.unfinished == 0);
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_LOW].queued == 0);
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_LOW].started == 3);
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_NORMAL].started == 3);
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_HIGH].started == 2);
+    /* The low priority tasks waited for all the others */
+    assert(stats.priorities[VLC_EXECUTOR_PRIORITY_LOW].latency_max >=
+           stats.priorities[VLC_EXECUTOR_PRIORITY_HIGH].latency_max);
+
+    vlc_executor_Delete(executor);
+}
+
+#define BENCH_TASKS 100000
+
+static void RunSpin(void *userdata)
+{
+    atomic_uint *counter = userdata;
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+}
+
+/* Not a test as such: prints the throughput of many tiny tasks depending on
+ * the thread count, i.e. the cost of queuing, waking and stealing. */
+static void bench_scaling(void)
+{
+    static struct vlc_runnable runnables[BENCH_TASKS];
+    static const unsigned thread_counts[] = { 1, 2, 4, 8 };
+
+    for (size_t t = 0; t < ARRAY_SIZE(thread_counts); ++t)
+    {
+        vlc_executor_t *executor = vlc_executor_New(thread_counts[t]);
+        assert(executor);
+
+        atomic_uint counter = ATOMIC_VAR_INIT(0);
+        vlc_tick_t start = vlc_tick_now();
+
+        for (int i = 0; i < BENCH_TASKS; ++i)
+        {
+            runnables[i].run = RunSpin;
+            runnables[i].userdata = &counter;
+            vlc_executor_Submit(executor, &runnables[i]);
+        }
+        vlc_executor_WaitIdle(executor);
+
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+        assert(atomic_load(&counter) == BENCH_TASKS);
+
+        struct vlc_executor_stats stats;
+        vlc_executor_GetStats(executor, &stats);
+        vlc_executor_Delete(executor);
+
+        const int normal = VLC_EXECUTOR_PRIORITY_NORMAL;
+        printf("executor: %u threads: %.0f tasks/s, %"PRIu64" stolen, "
+               "latency avg %"PRId64" us max %"PRId64" us\n",
+               stats.threads, BENCH_TASKS / secf_from_vlc_tick(elapsed),
+               stats.stolen,
+               US_FROM_VLC_TICK(stats.priorities[normal].latency_avg),
+               US_FROM_VLC_TICK(stats.priorities[normal].latency_max));
+    }
+}
+
 int main(void)
 {
     test_single_runnable();
@@ -278,5 +439,7 @@ int main(void)
     test_blocking_delete();
     test_cancel();
     test_task_chain();
+    test_priority();
+    bench_scaling();
     return 0;
 }
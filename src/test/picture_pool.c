@@ -23,6 +23,7 @@
 #endif
 
 #include <stdbool.h>
+#include <stdio.h>
 #undef NDEBUG
 #include <assert.h>
 
@@ -31,6 +32,8 @@
 #include <vlc_picture_pool.h>
 
 #define PICTURES 10
+#define THREADS 4
+#define ITERATIONS 100000
 
 const char vlc_module_name[] = "test_picture_pool";
 
@@ -108,6 +111,80 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void *waiter(void *data)
+{
+    picture_pool_t *p = data;
+    return picture_pool_Wait(p);
+}
+
+static void test_wakeup(void)
+{
+    picture_t *pics[PICTURES];
+    vlc_thread_t th;
+
+    pool = picture_pool_NewFromFormat(&fmt, PICTURES);
+    assert(pool != NULL);
+
+    for (unsigned i = 0; i < PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+
+    /* A release must wake up a sleeping waiter */
+    assert(vlc_clone(&th, waiter, pool, VLC_THREAD_PRIORITY_LOW) == 0);
+    picture_Release(pics[0]);
+    vlc_join(th, (void **)&pics[0]);
+    assert(pics[0] != NULL);
+
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
+static void *contender(void *data)
+{
+    picture_pool_t *p = data;
+
+    for (unsigned i = 0; i < ITERATIONS; i++) {
+        picture_t *pic = (i & 1) ? picture_pool_Wait(p) : picture_pool_Get(p);
+        if (pic != NULL)
+            picture_Release(pic);
+    }
+    return NULL;
+}
+
+static void test_contention(unsigned count)
+{
+    vlc_thread_t th[THREADS];
+
+    /* Fewer pictures than threads, so that waiters actually sleep */
+    pool = picture_pool_NewFromFormat(&fmt, count);
+    assert(pool != NULL);
+
+    vlc_tick_t start = vlc_tick_now();
+    for (unsigned i = 0; i < THREADS; i++)
+        assert(vlc_clone(&th[i], contender, pool,
+                          VLC_THREAD_PRIORITY_LOW) == 0);
+    for (unsigned i = 0; i < THREADS; i++)
+        vlc_join(th[i], NULL);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    printf("%u threads, %u pictures: %.0f get/release per second\n",
+           THREADS, count, THREADS * ITERATIONS / secf_from_vlc_tick(elapsed));
+
+    /* Every picture must be back in the pool */
+    picture_t *pics[PICTURES];
+    for (unsigned i = 0; i < count; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+    for (unsigned i = 0; i < count; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -123,6 +200,9 @@ int main(void)
 
     test(false);
     test(true);
+    test_wakeup();
+    test_contention(THREADS / 2);
+    test_contention(PICTURES);
 
     return 0;
 }
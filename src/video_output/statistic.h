@@ -23,6 +23,8 @@
 #ifndef LIBVLC_VOUT_STATISTIC_H
 # define LIBVLC_VOUT_STATISTIC_H
 # include <stdatomic.h>
+# include <vlc_threads.h>
+# include <vlc_input_item.h>
 
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
@@ -31,6 +33,12 @@ typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
     atomic_uint late;
+
+    /* The histograms are too large to be updated atomically. They are only
+     * touched by the vout thread and by the decoder thread once per picture,
+     * so the lock is not contended. */
+    vlc_mutex_t lock;
+    struct vlc_vout_latency latency;
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
@@ -38,6 +46,8 @@ static inline void vout_statistic_Init(vout_statistic_t *stat)
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
     atomic_init(&stat->late, 0);
+    vlc_mutex_init(&stat->lock);
+    vlc_vout_latency_Init(&stat->latency);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -73,4 +83,47 @@ static inline void vout_statistic_AddLate(vout_statistic_t *stat, int late)
     atomic_fetch_add_explicit(&stat->late, late, memory_order_relaxed);
 }
 
+static inline void vout_statistic_AddLatency(vout_statistic_t *stat,
+                                             struct vlc_latency_histogram *h,
+                                             vlc_tick_t value)
+{
+    vlc_mutex_lock(&stat->lock);
+    vlc_latency_histogram_Add(h, value);
+    vlc_mutex_unlock(&stat->lock);
+}
+
+static inline void vout_statistic_AddFilterTime(vout_statistic_t *stat,
+                                                vlc_tick_t duration)
+{
+    vout_statistic_AddLatency(stat, &stat->latency.filter, duration);
+}
+
+static inline void vout_statistic_AddSpuTime(vout_statistic_t *stat,
+                                             vlc_tick_t duration)
+{
+    vout_statistic_AddLatency(stat, &stat->latency.spu, duration);
+}
+
+static inline void vout_statistic_AddPrepareTime(vout_statistic_t *stat,
+                                                 vlc_tick_t duration)
+{
+    vout_statistic_AddLatency(stat, &stat->latency.prepare, duration);
+}
+
+static inline void vout_statistic_AddDisplayError(vout_statistic_t *stat,
+                                                  vlc_tick_t error)
+{
+    vout_statistic_AddLatency(stat, &stat->latency.display_error, error);
+}
+
+/* Merges the latency histograms into the given ones and resets them */
+static inline void vout_statistic_GetResetLatency(vout_statistic_t *stat,
+                                        struct vlc_vout_latency *latency)
+{
+    vlc_mutex_lock(&stat->lock);
+    vlc_vout_latency_Merge(latency, &stat->latency);
+    vlc_vout_latency_Init(&stat->latency);
+    vlc_mutex_unlock(&stat->lock);
+}
+
 #endif
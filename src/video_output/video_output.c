@@ -49,6 +49,7 @@
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
 #include <vlc_atomic.h>
+#include <vlc_tracer.h>
 
 #include <libvlc.h>
 #include "vout_private.h"
@@ -231,11 +232,13 @@ static void vout_UpdateWindowSizeLocked(vout_thread_sys_t *vout)
 
 /* */
 void vout_GetResetStatistic(vout_thread_t *vout, unsigned *restrict displayed,
-                            unsigned *restrict lost, unsigned *restrict late)
+                            unsigned *restrict lost, unsigned *restrict late,
+                            struct vlc_vout_latency *latency)
 {
     vout_thread_sys_t *sys = VOUT_THREAD_TO_SYS(vout);
     assert(!sys->dummy);
     vout_statistic_GetReset( &sys->statistic, displayed, lost, late );
+    vout_statistic_GetResetLatency( &sys->statistic, latency );
 }
 
 bool vout_IsEmpty(vout_thread_t *vout)
@@ -938,7 +941,11 @@ static picture_t *PreparePicture(vout_thread_sys_t *vout, bool reuse_decoded,
         sys->displayed.is_interlaced = !decoded->b_progressive;
 
         vout_chrono_Start(&sys->chrono.static_filter);
+        vlc_tick_t filter_start = vlc_tick_now();
         picture = filter_chain_VideoFilter(sys->filter.chain_static, sys->displayed.decoded);
+        if (!filter_chain_IsEmpty(sys->filter.chain_static))
+            vout_statistic_AddFilterTime(&sys->statistic,
+                                         vlc_tick_now() - filter_start);
         vout_chrono_Stop(&sys->chrono.static_filter);
     }
 
@@ -1017,7 +1024,11 @@ static picture_t *FilterPictureInteractive(vout_thread_sys_t *sys)
     picture_Hold(sys->displayed.current);
 
     vlc_mutex_lock(&sys->filter.lock);
+    vlc_tick_t filter_start = vlc_tick_now();
     picture_t *filtered = filter_chain_VideoFilter(sys->filter.chain_interactive, sys->displayed.current);
+    if (!filter_chain_IsEmpty(sys->filter.chain_interactive))
+        vout_statistic_AddFilterTime(&sys->statistic,
+                                     vlc_tick_now() - filter_start);
     vlc_mutex_unlock(&sys->filter.lock);
 
     if (filtered && filtered->date != sys->displayed.current->date)
@@ -1115,12 +1126,16 @@ static int PrerenderPicture(vout_thread_sys_t *sys, picture_t *filtered,
     /* Get the subpicture to be displayed. */
     video_format_t fmt_spu_rot;
     video_format_ApplyRotation(&fmt_spu_rot, &fmt_spu);
-    subpicture_t *subpic = !sys->spu ? NULL :
-                           spu_Render(sys->spu,
-                                      subpicture_chromas, &fmt_spu_rot,
-                                      vd->source, system_now,
-                                      render_subtitle_date,
-                                      do_snapshot, vd->info.can_scale_spu);
+    subpicture_t *subpic = NULL;
+    if (sys->spu)
+    {
+        vlc_tick_t spu_start = vlc_tick_now();
+        subpic = spu_Render(sys->spu, subpicture_chromas, &fmt_spu_rot,
+                            vd->source, system_now, render_subtitle_date,
+                            do_snapshot, vd->info.can_scale_spu);
+        vout_statistic_AddSpuTime(&sys->statistic,
+                                  vlc_tick_now() - spu_start);
+    }
     /*
      * Perform rendering
      *
@@ -1197,6 +1212,7 @@ static int PrerenderPicture(vout_thread_sys_t *sys, picture_t *filtered,
 static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
 {
     vout_display_t *vd = sys->display;
+    struct vlc_tracer *tracer = vlc_object_get_tracer(VLC_OBJECT(&sys->obj));
 
     vout_chrono_Start(&sys->chrono.render);
 
@@ -1208,7 +1224,11 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
 
     picture_t *todisplay;
     subpicture_t *subpic;
+    if (tracer != NULL)
+        vlc_tracer_TraceBegin(tracer, "RENDER", "vout", "render");
     int ret = PrerenderPicture(sys, filtered, &render_now, &todisplay, &subpic);
+    if (tracer != NULL)
+        vlc_tracer_TraceEnd(tracer, "RENDER", "vout", "render");
     if (ret != VLC_SUCCESS)
     {
         vlc_mutex_unlock(&sys->display_lock);
@@ -1227,12 +1247,22 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
         system_pts = system_now;
         render_now = true;
     }
+    const vlc_tick_t display_deadline = system_pts;
 
     const unsigned frame_rate = todisplay->format.i_frame_rate;
     const unsigned frame_rate_base = todisplay->format.i_frame_rate_base;
 
     if (vd->ops->prepare != NULL)
+    {
+        if (tracer != NULL)
+            vlc_tracer_TraceBegin(tracer, "RENDER", "vout", "prepare");
+        vlc_tick_t prepare_start = vlc_tick_now();
         vd->ops->prepare(vd, todisplay, subpic, system_pts);
+        vout_statistic_AddPrepareTime(&sys->statistic,
+                                      vlc_tick_now() - prepare_start);
+        if (tracer != NULL)
+            vlc_tracer_TraceEnd(tracer, "RENDER", "vout", "prepare");
+    }
 
     vout_chrono_Stop(&sys->chrono.render);
 
@@ -1289,7 +1319,14 @@ static int RenderPicture(vout_thread_sys_t *sys, bool render_now)
                           frame_rate, frame_rate_base);
 
     /* Display the direct buffer returned by vout_RenderPicture */
+    if (tracer != NULL)
+        vlc_tracer_TraceBegin(tracer, "RENDER", "vout", "display");
     vout_display_Display(vd, todisplay);
+    if (tracer != NULL)
+        vlc_tracer_TraceEnd(tracer, "RENDER", "vout", "display");
+    if (!render_now)
+        vout_statistic_AddDisplayError(&sys->statistic,
+                                       vlc_tick_now() - display_deadline);
     vlc_mutex_unlock(&sys->display_lock);
 
     picture_Release(todisplay);
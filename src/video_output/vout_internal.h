@@ -28,6 +28,7 @@
 
 typedef struct input_thread_t input_thread_t;
 typedef struct vlc_clock_t vlc_clock_t;
+struct vlc_vout_latency;
 
 /* It should be high enough to absorbe jitter due to difficult picture(s)
  * to decode but not too high as memory is not that cheap.
@@ -218,9 +219,12 @@ void vout_MouseState(vout_thread_t *, const vlc_mouse_t *);
 
 /**
  * This function will return and reset internal statistics.
+ *
+ * The stage latency histograms are merged into the ones pointed by latency.
  */
 void vout_GetResetStatistic( vout_thread_t *p_vout, unsigned *pi_displayed,
-                             unsigned *pi_lost, unsigned *pi_late );
+                             unsigned *pi_lost, unsigned *pi_late,
+                             struct vlc_vout_latency *latency );
 
 /**
  * This function will force to display the next picture while paused
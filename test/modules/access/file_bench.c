@@ -0,0 +1,231 @@
+/*****************************************************************************
+ * file_bench.c: file access read-ahead and zero-copy benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+#include "../common.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Reads a file sequentially with some simulated decoding work per chunk,
+ * first into a buffer, then as blocks, as demuxers do for their payload.
+ * Then jumps between distant chunks with seek hints, and checks the data.
+ * Each 64-bits word of the file holds its own offset.
+ * The page cache is dropped before each run, so that the file is really
+ * read from the storage, if the file system supports it: run with a
+ * directory on a spinning disk or network file system as argument for
+ * meaningful figures. */
+#define BENCH_SIZE      (256 << 20)
+#define BENCH_CHUNK     (64 << 10)
+#define BENCH_WORK      VLC_TICK_FROM_US(100) /* per chunk */
+#define BENCH_JUMPS     256
+
+static void Check(const uint8_t *buf, uint64_t offset, size_t len)
+{
+    if ((offset % 8) != 0 || (len % 8) != 0)
+    {
+        fprintf(stderr, "unaligned read of %zu bytes at offset %"PRIu64"\n",
+                len, offset);
+        abort();
+    }
+    for (size_t i = 0; i < len; i += 8)
+        if (GetQWLE(buf + i) != offset + i)
+        {
+            fprintf(stderr, "corrupted data at offset %"PRIu64"\n",
+                    offset + i);
+            abort();
+        }
+}
+
+static void CheckSize(uint64_t size)
+{
+    if (size != BENCH_SIZE)
+    {
+        fprintf(stderr, "read %"PRIu64" bytes instead of %u\n", size,
+                BENCH_SIZE);
+        abort();
+    }
+}
+
+static int CreateFile(const char *path)
+{
+    int fd = vlc_open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd == -1)
+        return -1;
+
+    static uint8_t buf[BENCH_CHUNK];
+    for (uint64_t offset = 0; offset < BENCH_SIZE; offset += sizeof (buf))
+    {
+        for (size_t i = 0; i < sizeof (buf); i += 8)
+            SetQWLE(buf + i, offset + i);
+        if (write(fd, buf, sizeof (buf)) != sizeof (buf))
+        {
+            vlc_close(fd);
+            return -1;
+        }
+    }
+    fsync(fd);
+    vlc_close(fd);
+    return 0;
+}
+
+static void DropCache(const char *path)
+{
+#ifdef HAVE_POSIX_FADVISE
+    int fd = vlc_open(path, O_RDONLY);
+    if (fd != -1)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        vlc_close(fd);
+    }
+#else
+    (void) path;
+#endif
+}
+
+static int RunBench(const char *mode, const char *path, const char *url)
+{
+    const char *args[] = { mode };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return -1;
+
+    static uint8_t buf[BENCH_CHUNK];
+
+    /* Sequential */
+    DropCache(path);
+    vlc_tick_t start = vlc_tick_now();
+    stream_t *s = vlc_stream_NewURL(vlc->p_libvlc_int, url);
+    if (s == NULL)
+    {
+        libvlc_release(vlc);
+        return -1;
+    }
+
+    uint64_t offset = 0;
+    ssize_t val;
+
+    while ((val = vlc_stream_Read(s, buf, sizeof (buf))) > 0)
+    {
+        Check(buf, offset, val);
+        offset += val;
+        test_Work(BENCH_WORK);
+    }
+    CheckSize(offset);
+
+    vlc_tick_t seq = vlc_tick_now() - start;
+
+    /* Sequential, as blocks */
+    DropCache(path);
+    start = vlc_tick_now();
+    if (vlc_stream_Seek(s, 0))
+        abort();
+
+    offset = 0;
+    for (;;)
+    {
+        block_t *block = vlc_stream_Block(s, BENCH_CHUNK);
+        if (block == NULL)
+            break;
+
+        Check(block->p_buffer, offset, block->i_buffer);
+        offset += block->i_buffer;
+        block_Release(block);
+        test_Work(BENCH_WORK);
+    }
+    CheckSize(offset);
+
+    vlc_tick_t blocks = vlc_tick_now() - start;
+
+    /* Jumps, with the next position hinted while reading */
+    DropCache(path);
+    start = vlc_tick_now();
+    srand(42);
+    uint64_t next = (rand() % (BENCH_SIZE / BENCH_CHUNK)) * BENCH_CHUNK;
+
+    for (unsigned i = 0; i < BENCH_JUMPS; i++)
+    {
+        offset = next;
+        next = (rand() % (BENCH_SIZE / BENCH_CHUNK)) * BENCH_CHUNK;
+        if (vlc_stream_Seek(s, offset))
+            abort();
+        vlc_stream_SeekHint(s, next);
+        if (vlc_stream_Read(s, buf, sizeof (buf)) != sizeof (buf))
+            abort();
+        Check(buf, offset, sizeof (buf));
+        test_Work(BENCH_WORK * 10);
+    }
+
+    vlc_tick_t jumps = vlc_tick_now() - start;
+
+    vlc_stream_Delete(s);
+    libvlc_release(vlc);
+
+    printf("%-16s sequential: %.3f s (%.1f MiB/s), "
+           "blocks: %.3f s (%.1f MiB/s), %u jumps: %.3f s\n",
+           mode, secf_from_vlc_tick(seq),
+           BENCH_SIZE / secf_from_vlc_tick(seq) / (1 << 20),
+           secf_from_vlc_tick(blocks),
+           BENCH_SIZE / secf_from_vlc_tick(blocks) / (1 << 20),
+           BENCH_JUMPS, secf_from_vlc_tick(jumps));
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *dir = (argc > 1) ? argv[1] : "/tmp";
+    char path[256];
+
+    snprintf(path, sizeof (path), "%s/vlc-file-bench-%d", dir,
+             (int) getpid());
+    if (CreateFile(path))
+    {
+        perror(path);
+        return 77;
+    }
+
+    char *url = vlc_path2uri(path, NULL);
+    int ret = 0;
+
+    if (url == NULL
+     || RunBench("--no-file-uring", path, url)
+     || RunBench("--file-uring", path, url)
+#ifdef HAVE_MMAP
+     || RunBench("--file-mmap", path, url)
+#endif
+       )
+        ret = 1;
+
+    free(url);
+    unlink(path);
+    return ret;
+}
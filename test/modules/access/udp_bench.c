@@ -0,0 +1,191 @@
+/*****************************************************************************
+ * udp_bench.c: UDP access loopback multicast throughput benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_stream.h>
+#include <vlc_network.h>
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef HAVE_ARPA_INET_H
+# include <arpa/inet.h>
+#endif
+
+/* Sends datagrams of 7 TS packets in bursts to a multicast group on the
+ * loopback interface, and reads them back through the udp access. The
+ * receiver CPU time per datagram is the figure of merit: the throughput is
+ * bounded by the sender pace.
+ * Another (e.g. unicast) destination address can be given on the command
+ * line, if multicast is not routable on the host.
+ * With kernel time stamps, the delay between the arrival of the data and
+ * its reading is reported too. */
+#define BENCH_GROUP     "239.255.42.42"
+#define BENCH_PORT      5004
+#define BENCH_DATAGRAMS (200 * 1000)
+#define BENCH_SIZE      (7 * 188)
+#define BENCH_BURST     32 /* datagrams per millisecond, about 340 Mbit/s */
+
+static const char *bench_host = BENCH_GROUP;
+static vlc_tick_t bench_start;
+
+static int OpenSender(struct sockaddr_in *addr)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd == -1)
+        return -1;
+
+    memset(addr, 0, sizeof (*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(BENCH_PORT);
+    if (inet_pton(AF_INET, bench_host, &addr->sin_addr) != 1)
+    {
+        vlc_close(fd);
+        return -1;
+    }
+
+    struct in_addr lo = { .s_addr = htonl(INADDR_LOOPBACK) };
+
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &lo, sizeof (lo));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &(int){ 1 }, sizeof (int));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &(int){ 0 }, sizeof (int));
+    return fd;
+}
+
+static void *Sender(void *data)
+{
+    struct sockaddr_in addr;
+    uint8_t buf[BENCH_SIZE];
+    int fd = OpenSender(&addr);
+
+    (void) data;
+    if (fd == -1)
+        return NULL;
+
+    memset(buf, 0x47, sizeof (buf));
+    /* Let the receiver bind its socket. Opening the stream then blocks
+     * until the first datagram is received. */
+    bench_start = vlc_tick_now() + VLC_TICK_FROM_MS(200);
+
+    vlc_tick_t deadline = bench_start;
+    for (unsigned i = 0; i < BENCH_DATAGRAMS; i++)
+    {
+        if ((i % BENCH_BURST) == 0)
+        {
+            vlc_tick_wait(deadline);
+            deadline += VLC_TICK_FROM_MS(1);
+        }
+        sendto(fd, buf, sizeof (buf), 0, (struct sockaddr *)&addr,
+               sizeof (addr));
+    }
+    vlc_close(fd);
+    return NULL;
+}
+
+static double ThreadTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *const args[] = {
+        "--udp-timeout=1", "--miface=lo",
+#ifdef SO_TIMESTAMPNS
+        "--udp-timestamps",
+#endif
+    };
+
+    if (argc > 1)
+        bench_host = argv[1];
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 1;
+
+    char url[64];
+    snprintf(url, sizeof (url), "udp://@%s:%u", bench_host, BENCH_PORT);
+
+    vlc_thread_t th;
+    if (vlc_clone(&th, Sender, NULL, VLC_THREAD_PRIORITY_LOW))
+        abort();
+
+    double cpu = ThreadTime();
+    stream_t *s = vlc_stream_NewURL(vlc->p_libvlc_int, url);
+    if (s == NULL)
+    {
+        vlc_join(th, NULL);
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    static uint8_t buf[1 << 16];
+    uint64_t total = 0;
+    ssize_t val;
+    vlc_tick_t last = vlc_tick_now();
+    vlc_tick_t max_delay = -1;
+
+    while ((val = vlc_stream_Read(s, buf, sizeof (buf))) > 0)
+    {
+        vlc_tick_t arrival;
+
+        total += val;
+        last = vlc_tick_now();
+        if (vlc_stream_Control(s, STREAM_GET_ARRIVAL_TIME,
+                               &arrival) == VLC_SUCCESS)
+        {
+            if (arrival > last)
+            {
+                fprintf(stderr, "arrival time in the future\n");
+                abort();
+            }
+            if (last - arrival > max_delay)
+                max_delay = last - arrival;
+        }
+    }
+
+    cpu = ThreadTime() - cpu;
+    vlc_join(th, NULL);
+    vlc_stream_Delete(s);
+    libvlc_release(vlc);
+
+    uint64_t received = total / BENCH_SIZE;
+    double secs = secf_from_vlc_tick(last - bench_start);
+
+    printf("%s: %"PRIu64"/%u datagrams (%.1f%% lost) in %.3f s\n",
+           url, received, BENCH_DATAGRAMS,
+           100. * (BENCH_DATAGRAMS - received) / BENCH_DATAGRAMS, secs);
+    printf("%.0f datagrams/s, %.1f Mbit/s, %.2f us CPU per datagram\n",
+           received / secs, total * 8 / secs / 1e6,
+           received ? cpu * 1e6 / received : 0.);
+    if (max_delay >= 0)
+        printf("max %"PRId64" us from arrival to reading\n",
+               US_FROM_VLC_TICK(max_delay));
+    return 0;
+}
@@ -0,0 +1,348 @@
+/*****************************************************************************
+ * common.c: helpers shared by the module tests and benchmarks
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_es_out.h>
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+
+void test_Work(vlc_tick_t duration)
+{
+    vlc_tick_t end = vlc_tick_now() + duration;
+
+    while (vlc_tick_now() < end);
+}
+
+/*** Growable buffer ***/
+uint8_t *test_buf_Append(struct test_buf *b, size_t len)
+{
+    if (b->length + len > b->size)
+    {
+        b->size = (b->length + len) * 2;
+        b->data = realloc(b->data, b->size);
+        if (b->data == NULL)
+            abort();
+    }
+    uint8_t *p = b->data + b->length;
+    memset(p, 0, len);
+    b->length += len;
+    return p;
+}
+
+void test_buf_Put32(struct test_buf *b, uint32_t v)
+{
+    SetDWBE(test_buf_Append(b, 4), v);
+}
+
+void test_buf_Put16(struct test_buf *b, uint16_t v)
+{
+    SetWBE(test_buf_Append(b, 2), v);
+}
+
+void test_buf_PutFourCC(struct test_buf *b, const char *fcc)
+{
+    memcpy(test_buf_Append(b, 4), fcc, 4);
+}
+
+/*** MP4 writer ***/
+size_t mp4_BoxBegin(struct test_buf *b, const char *type)
+{
+    size_t offset = b->length;
+
+    test_buf_Put32(b, 0);
+    test_buf_PutFourCC(b, type);
+    return offset;
+}
+
+size_t mp4_FullBoxBegin(struct test_buf *b, const char *type, uint32_t flags)
+{
+    size_t offset = mp4_BoxBegin(b, type);
+
+    test_buf_Put32(b, flags);
+    return offset;
+}
+
+void mp4_BoxEnd(struct test_buf *b, size_t offset)
+{
+    SetDWBE(&b->data[offset], b->length - offset);
+}
+
+void mp4_PutMatrix(struct test_buf *b)
+{
+    static const uint32_t matrix[9] = {
+        0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000 };
+
+    for (unsigned i = 0; i < 9; i++)
+        test_buf_Put32(b, matrix[i]);
+}
+
+void mp4_PutFtyp(struct test_buf *b)
+{
+    size_t ftyp = mp4_BoxBegin(b, "ftyp");
+    test_buf_PutFourCC(b, "isom"); test_buf_Put32(b, 0x200);
+    test_buf_PutFourCC(b, "isom"); test_buf_PutFourCC(b, "mp41");
+    mp4_BoxEnd(b, ftyp);
+}
+
+void mp4_PutMvhd(struct test_buf *b, uint32_t duration_ms, unsigned track_count)
+{
+    size_t mvhd = mp4_FullBoxBegin(b, "mvhd", 0);
+    test_buf_Put32(b, 0); test_buf_Put32(b, 0);
+    test_buf_Put32(b, 1000); test_buf_Put32(b, duration_ms);
+    test_buf_Put32(b, 0x10000); test_buf_Put16(b, 0x100);
+    test_buf_Append(b, 10);
+    mp4_PutMatrix(b);
+    test_buf_Append(b, 24);
+    test_buf_Put32(b, track_count + 1);
+    mp4_BoxEnd(b, mvhd);
+}
+
+static uint32_t SampleSize(const struct mp4_track *tk, uint32_t i)
+{
+    return tk->sample_size ? tk->sample_size : tk->get_sample_size(i);
+}
+
+uint64_t mp4_PutTrack(struct test_buf *b, const struct mp4_track *tk,
+                      unsigned id)
+{
+    bool video = !strcmp(tk->handler, "vide");
+    uint64_t duration = (uint64_t)tk->sample_count * tk->delta;
+    uint32_t chunk_count = (tk->sample_count + tk->samples_per_chunk - 1) /
+                           tk->samples_per_chunk;
+    uint64_t end = tk->first_offset;
+    for (uint32_t i = 0; i < tk->sample_count; i++)
+        end += SampleSize(tk, i);
+
+    size_t trak = mp4_BoxBegin(b, "trak");
+
+    size_t tkhd = mp4_FullBoxBegin(b, "tkhd", 0x7);
+    test_buf_Put32(b, 0); test_buf_Put32(b, 0);
+    test_buf_Put32(b, id); test_buf_Put32(b, 0);
+    test_buf_Put32(b, duration * 1000 / tk->timescale);
+    test_buf_Append(b, 8);
+    test_buf_Put16(b, 0); test_buf_Put16(b, 0);
+    test_buf_Put16(b, video ? 0 : 0x100); test_buf_Put16(b, 0);
+    mp4_PutMatrix(b);
+    test_buf_Put32(b, video ? 320 << 16 : 0);
+    test_buf_Put32(b, video ? 240 << 16 : 0);
+    mp4_BoxEnd(b, tkhd);
+
+    size_t mdia = mp4_BoxBegin(b, "mdia");
+    size_t mdhd = mp4_FullBoxBegin(b, "mdhd", 0);
+    test_buf_Put32(b, 0); test_buf_Put32(b, 0);
+    test_buf_Put32(b, tk->timescale); test_buf_Put32(b, duration);
+    test_buf_Put16(b, 0x55c4); test_buf_Put16(b, 0);
+    mp4_BoxEnd(b, mdhd);
+
+    size_t hdlr = mp4_FullBoxBegin(b, "hdlr", 0);
+    test_buf_Put32(b, 0);
+    test_buf_PutFourCC(b, tk->handler);
+    test_buf_Append(b, 12 + 1);
+    mp4_BoxEnd(b, hdlr);
+
+    size_t minf = mp4_BoxBegin(b, "minf");
+    if (video)
+    {
+        size_t vmhd = mp4_FullBoxBegin(b, "vmhd", 1);
+        test_buf_Append(b, 8);
+        mp4_BoxEnd(b, vmhd);
+    }
+    else
+    {
+        size_t smhd = mp4_FullBoxBegin(b, "smhd", 0);
+        test_buf_Append(b, 4);
+        mp4_BoxEnd(b, smhd);
+    }
+
+    size_t dinf = mp4_BoxBegin(b, "dinf");
+    size_t dref = mp4_FullBoxBegin(b, "dref", 0);
+    test_buf_Put32(b, 1);
+    mp4_BoxEnd(b, mp4_FullBoxBegin(b, "url ", 1));
+    mp4_BoxEnd(b, dref);
+    mp4_BoxEnd(b, dinf);
+
+    size_t stbl = mp4_BoxBegin(b, "stbl");
+    size_t stsd = mp4_FullBoxBegin(b, "stsd", 0);
+    test_buf_Put32(b, 1);
+    size_t entry = mp4_BoxBegin(b, tk->codec);
+    test_buf_Append(b, 6);
+    test_buf_Put16(b, 1); /* data reference index */
+    if (video)
+    {
+        test_buf_Append(b, 16);
+        test_buf_Put16(b, 320); test_buf_Put16(b, 240);
+        test_buf_Put32(b, 0x480000); test_buf_Put32(b, 0x480000);
+        test_buf_Put32(b, 0);
+        test_buf_Put16(b, 1);
+        test_buf_Append(b, 32);
+        test_buf_Put16(b, 0x18); test_buf_Put16(b, 0xffff);
+    }
+    else
+    {
+        test_buf_Append(b, 8);
+        test_buf_Put16(b, 2); test_buf_Put16(b, 16);
+        test_buf_Put16(b, 0); test_buf_Put16(b, 0);
+        test_buf_Put32(b, 48000 << 16);
+    }
+    mp4_BoxEnd(b, entry);
+    mp4_BoxEnd(b, stsd);
+
+    size_t stts = mp4_FullBoxBegin(b, "stts", 0);
+    test_buf_Put32(b, 1);
+    test_buf_Put32(b, tk->sample_count); test_buf_Put32(b, tk->delta);
+    mp4_BoxEnd(b, stts);
+
+    if (tk->reorder)
+    {
+        /* I P B B reordering: one ctts entry per sample */
+        static const uint32_t offsets[3] = { 1, 3, 0 };
+        size_t ctts = mp4_FullBoxBegin(b, "ctts", 0);
+        test_buf_Put32(b, tk->sample_count);
+        for (uint32_t i = 0; i < tk->sample_count; i++)
+        {
+            test_buf_Put32(b, 1);
+            test_buf_Put32(b, offsets[i % 3] * tk->delta);
+        }
+        mp4_BoxEnd(b, ctts);
+    }
+
+    if (tk->gop_size)
+    {
+        size_t stss = mp4_FullBoxBegin(b, "stss", 0);
+        test_buf_Put32(b, (tk->sample_count + tk->gop_size - 1) / tk->gop_size);
+        for (uint32_t i = 0; i < tk->sample_count; i += tk->gop_size)
+            test_buf_Put32(b, i + 1);
+        mp4_BoxEnd(b, stss);
+    }
+
+    size_t stsc = mp4_FullBoxBegin(b, "stsc", 0);
+    test_buf_Put32(b, 1); test_buf_Put32(b, 1);
+    test_buf_Put32(b, tk->samples_per_chunk); test_buf_Put32(b, 1);
+    mp4_BoxEnd(b, stsc);
+
+    size_t stsz = mp4_FullBoxBegin(b, "stsz", 0);
+    test_buf_Put32(b, tk->sample_size); test_buf_Put32(b, tk->sample_count);
+    if (tk->sample_size == 0)
+        for (uint32_t i = 0; i < tk->sample_count; i++)
+            test_buf_Put32(b, tk->get_sample_size(i));
+    mp4_BoxEnd(b, stsz);
+
+    bool large = end > UINT32_MAX;
+    size_t stco = mp4_FullBoxBegin(b, large ? "co64" : "stco", 0);
+    test_buf_Put32(b, chunk_count);
+    uint64_t offset = tk->first_offset;
+    for (uint32_t i = 0; i < tk->sample_count; i++)
+    {
+        if (i % tk->samples_per_chunk == 0)
+        {
+            if (large)
+                test_buf_Put32(b, offset >> 32);
+            test_buf_Put32(b, offset);
+        }
+        offset += SampleSize(tk, i);
+    }
+    mp4_BoxEnd(b, stco);
+
+    mp4_BoxEnd(b, stbl);
+    mp4_BoxEnd(b, minf);
+    mp4_BoxEnd(b, mdia);
+    mp4_BoxEnd(b, trak);
+    return end;
+}
+
+/*** ES output ***/
+struct es_out_id_t
+{
+    int dummy;
+};
+
+static es_out_id_t test_id;
+
+static es_out_id_t *EsOutAdd(es_out_t *out, input_source_t *in,
+                             const es_format_t *fmt)
+{
+    (void) out; (void) in; (void) fmt;
+    return &test_id;
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
+{
+    struct test_es_out *sys = container_of(out, struct test_es_out, out);
+
+    (void) id;
+    if (sys->work_per_kib)
+        test_Work(sys->work_per_kib * block->i_buffer / 1024);
+    block_Release(block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    (void) out; (void) id;
+}
+
+static int EsOutControl(es_out_t *out, input_source_t *in, int query,
+                        va_list args)
+{
+    (void) out; (void) in;
+
+    switch (query)
+    {
+        case ES_OUT_GET_ES_STATE:
+            va_arg(args, es_out_id_t *);
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_EMPTY:
+            *va_arg(args, bool *) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_GET_PCR_SYSTEM:
+        case ES_OUT_MODIFY_PCR_SYSTEM:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    (void) out;
+}
+
+static const struct es_out_callbacks es_out_cbs = {
+    .add = EsOutAdd,
+    .send = EsOutSend,
+    .del = EsOutDel,
+    .control = EsOutControl,
+    .destroy = EsOutDestroy,
+};
+
+void test_es_out_Init(struct test_es_out *sys, vlc_tick_t work_per_kib)
+{
+    sys->out.cbs = &es_out_cbs;
+    sys->work_per_kib = work_per_kib;
+}
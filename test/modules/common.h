@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * common.h: helpers shared by the module tests and benchmarks
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TEST_MODULES_COMMON_H
+#define TEST_MODULES_COMMON_H
+
+#include <vlc_common.h>
+#include <vlc_es_out.h>
+
+/* Busy loop, standing for decoding or processing work */
+void test_Work(vlc_tick_t duration);
+
+/*** Growable buffer, for writing synthetic files ***/
+struct test_buf
+{
+    uint8_t *data;
+    size_t length;
+    size_t size;
+};
+
+/* Returns len zeroed bytes at the end of the buffer, aborts on error */
+uint8_t *test_buf_Append(struct test_buf *, size_t len);
+void test_buf_Put32(struct test_buf *, uint32_t); /* big endian */
+void test_buf_Put16(struct test_buf *, uint16_t);
+void test_buf_PutFourCC(struct test_buf *, const char *);
+
+/*** MP4 writer ***/
+size_t mp4_BoxBegin(struct test_buf *, const char *type);
+size_t mp4_FullBoxBegin(struct test_buf *, const char *type, uint32_t flags);
+void mp4_BoxEnd(struct test_buf *, size_t offset);
+void mp4_PutMatrix(struct test_buf *);
+void mp4_PutFtyp(struct test_buf *);
+void mp4_PutMvhd(struct test_buf *, uint32_t duration_ms, unsigned track_count);
+
+struct mp4_track
+{
+    const char *handler; /* "vide" or "soun" */
+    const char *codec;
+    uint32_t timescale;
+    uint32_t delta;
+    uint32_t sample_count;
+    uint32_t samples_per_chunk;
+    uint32_t sample_size; /* 0 for per sample sizes from get_sample_size */
+    uint32_t (*get_sample_size)(uint32_t sample);
+    uint32_t gop_size; /* sync sample interval, 0 if all samples are sync */
+    bool reorder; /* I P B B composition offsets */
+    uint64_t first_offset; /* of the samples, that are stored contiguously */
+};
+
+/* Returns the offset following the last sample of the track. Chunk offsets
+ * are stored on 64 bits only if needed. */
+uint64_t mp4_PutTrack(struct test_buf *, const struct mp4_track *, unsigned id);
+
+/*** ES output discarding the blocks ***/
+struct test_es_out
+{
+    es_out_t out;
+    vlc_tick_t work_per_kib; /* simulated decoding work */
+};
+
+void test_es_out_Init(struct test_es_out *, vlc_tick_t work_per_kib);
+
+#endif
@@ -0,0 +1,455 @@
+/*****************************************************************************
+ * mkv_index.c: Matroska background seek index and sidecar cache test
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+#include "../common.h"
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_fs.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Writes a segment without Cues, whose clusters hold one key SimpleBlock
+ * and one BlockGroup referencing it, plays it with the background index
+ * and the cache enabled, and checks the clusters and keyframes found by
+ * the walk in the saved sidecar. A truncated copy must be left
+ * incomplete. */
+#define CLUSTERS        20
+#define BLOCK_SIZE      100
+
+#define BAILOUT(run) { fprintf(stderr, "failed %s line %d\n", run, __LINE__); \
+                        return 1; }
+#define EXPECT(foo) if(!(foo)) BAILOUT(run)
+
+struct mkv_file
+{
+    struct test_buf buf;
+    uint64_t first_cluster;
+    uint64_t clusters[CLUSTERS];
+    uint64_t keyframes[CLUSTERS];
+    uint64_t others[CLUSTERS];
+};
+
+/*** EBML writer, with 8 bytes sizes ***/
+static void PutID(struct test_buf *b, uint32_t id)
+{
+    unsigned len = id > 0xFFFFFF ? 4 : id > 0xFFFF ? 3 : id > 0xFF ? 2 : 1;
+
+    for (unsigned i = len; i > 0; i--)
+        *test_buf_Append(b, 1) = id >> (8 * (i - 1));
+}
+
+static size_t ElementBegin(struct test_buf *b, uint32_t id)
+{
+    PutID(b, id);
+    size_t offset = b->length;
+    test_buf_Append(b, 8);
+    return offset;
+}
+
+static void ElementEnd(struct test_buf *b, size_t offset)
+{
+    uint64_t size = b->length - offset - 8;
+
+    SetQWBE(&b->data[offset], size);
+    b->data[offset] = 0x01;
+}
+
+static void PutUInt(struct test_buf *b, uint32_t id, uint64_t value)
+{
+    size_t el = ElementBegin(b, id);
+    SetQWBE(test_buf_Append(b, 8), value);
+    ElementEnd(b, el);
+}
+
+static void PutFloat(struct test_buf *b, uint32_t id, double value)
+{
+    union { double f; uint64_t u; } v = { .f = value };
+
+    PutUInt(b, id, v.u);
+}
+
+static void PutString(struct test_buf *b, uint32_t id, const char *str)
+{
+    size_t el = ElementBegin(b, id);
+    memcpy(test_buf_Append(b, strlen(str)), str, strlen(str));
+    ElementEnd(b, el);
+}
+
+static void PutBlock(struct test_buf *b, uint32_t id, int16_t timecode,
+                     uint8_t flags)
+{
+    size_t el = ElementBegin(b, id);
+    uint8_t *p = test_buf_Append(b, 4 + BLOCK_SIZE);
+    p[0] = 0x81; /* track 1 */
+    SetWBE(&p[1], timecode);
+    p[3] = flags;
+    memset(&p[4], 0x80, BLOCK_SIZE);
+    ElementEnd(b, el);
+}
+
+static void CreateMKV(struct mkv_file *f)
+{
+    struct test_buf *b = &f->buf;
+
+    size_t ebml = ElementBegin(b, 0x1A45DFA3);
+    PutUInt(b, 0x4286, 1); /* EBMLVersion */
+    PutUInt(b, 0x42F7, 1); /* EBMLReadVersion */
+    PutUInt(b, 0x42F2, 4); /* EBMLMaxIDLength */
+    PutUInt(b, 0x42F3, 8); /* EBMLMaxSizeLength */
+    PutString(b, 0x4282, "matroska");
+    PutUInt(b, 0x4287, 4); /* DocTypeVersion */
+    PutUInt(b, 0x4285, 2); /* DocTypeReadVersion */
+    ElementEnd(b, ebml);
+
+    size_t segment = ElementBegin(b, 0x18538067);
+
+    size_t info = ElementBegin(b, 0x1549A966);
+    PutUInt(b, 0x2AD7B1, 1000000); /* TimecodeScale */
+    PutFloat(b, 0x4489, CLUSTERS * 1000.); /* Duration */
+    PutString(b, 0x4D80, "vlc test");
+    PutString(b, 0x5741, "vlc test");
+    ElementEnd(b, info);
+
+    size_t tracks = ElementBegin(b, 0x1654AE6B);
+    size_t entry = ElementBegin(b, 0xAE);
+    PutUInt(b, 0xD7, 1); /* TrackNumber */
+    PutUInt(b, 0x73C5, 1); /* TrackUID */
+    PutUInt(b, 0x83, 2); /* TrackType: audio */
+    PutString(b, 0x86, "A_PCM/INT/LIT");
+    size_t audio = ElementBegin(b, 0xE1);
+    PutFloat(b, 0xB5, 8000.); /* SamplingFrequency */
+    PutUInt(b, 0x9F, 1); /* Channels */
+    PutUInt(b, 0x6264, 8); /* BitDepth */
+    ElementEnd(b, audio);
+    ElementEnd(b, entry);
+    ElementEnd(b, tracks);
+
+    f->first_cluster = b->length;
+    for (unsigned i = 0; i < CLUSTERS; i++)
+    {
+        f->clusters[i] = b->length;
+        size_t cluster = ElementBegin(b, 0x1F43B675);
+        PutUInt(b, 0xE7, i * 1000); /* Timecode */
+
+        f->keyframes[i] = b->length;
+        PutBlock(b, 0xA3, 0, 0x80); /* key SimpleBlock */
+
+        size_t group = ElementBegin(b, 0xA0);
+        f->others[i] = b->length;
+        PutBlock(b, 0xA1, 500, 0);
+        PutUInt(b, 0xFB, (uint64_t)-500); /* ReferenceBlock */
+        ElementEnd(b, group);
+
+        ElementEnd(b, cluster);
+    }
+
+    ElementEnd(b, segment);
+}
+
+/*** Sidecar ***/
+struct sidecar
+{
+    uint64_t file_size;
+    uint64_t timescale;
+    uint64_t start;
+    uint64_t indexed_end;
+    uint32_t complete;
+    uint32_t cluster_count;
+    uint64_t cluster_fpos[CLUSTERS];
+    uint64_t cluster_pts[CLUSTERS];
+    uint32_t seekpoint_count;
+    uint64_t seekpoint_fpos[4 * CLUSTERS];
+};
+
+struct reader
+{
+    const uint8_t *p;
+    size_t left;
+    bool ok;
+};
+
+static uint64_t Get(struct reader *r, size_t size)
+{
+    const uint8_t *p = r->p;
+
+    if (r->left < size)
+    {
+        r->ok = false;
+        return 0;
+    }
+    r->p += size;
+    r->left -= size;
+    return size == 4 ? GetDWLE(p) : GetQWLE(p);
+}
+
+/* Reads the single sidecar of the cache directory */
+static int ReadSidecar(const char *dir, struct sidecar *sc)
+{
+    DIR *d = vlc_opendir(dir);
+    if (d == NULL)
+        return -1;
+
+    const char *name;
+    char *path = NULL;
+    while (path == NULL && (name = vlc_readdir(d)) != NULL)
+        if (strstr(name, ".idx") && !strstr(name, ".part"))
+            if (asprintf(&path, "%s/%s", dir, name) == -1)
+                path = NULL;
+    closedir(d);
+    if (path == NULL)
+        return -1;
+
+    uint8_t data[16384];
+    FILE *f = vlc_fopen(path, "rb");
+    free(path);
+    if (f == NULL)
+        return -1;
+    size_t len = fread(data, 1, sizeof (data), f);
+    fclose(f);
+
+    if (len < 4 || memcmp(data, "MKVI", 4))
+        return -1;
+    struct reader r = { data + 4, len - 4, true };
+    if (Get(&r, 4) != 1) /* version */
+        return -1;
+    sc->file_size = Get(&r, 8);
+    Get(&r, 8); /* mtime */
+    sc->timescale = Get(&r, 8);
+    sc->start = Get(&r, 8);
+    sc->indexed_end = Get(&r, 8);
+    sc->complete = Get(&r, 4);
+
+    for (uint32_t n = Get(&r, 4); n > 0 && r.ok; n--)
+        Get(&r, 16); /* searched ranges */
+
+    sc->cluster_count = Get(&r, 4);
+    for (uint32_t i = 0; i < sc->cluster_count && r.ok; i++)
+    {
+        uint64_t fpos = Get(&r, 8), pts = Get(&r, 8);
+        Get(&r, 8); /* size */
+        if (i < CLUSTERS)
+        {
+            sc->cluster_fpos[i] = fpos;
+            sc->cluster_pts[i] = pts;
+        }
+    }
+
+    sc->seekpoint_count = 0;
+    for (uint32_t n = Get(&r, 4); n > 0 && r.ok; n--)
+    {
+        if (Get(&r, 8) != 1) /* track number */
+            return -1;
+        for (uint32_t i = Get(&r, 4); i > 0 && r.ok; i--)
+        {
+            uint64_t fpos = Get(&r, 8);
+            Get(&r, 8); /* pts */
+            if (sc->seekpoint_count < ARRAY_SIZE(sc->seekpoint_fpos))
+                sc->seekpoint_fpos[sc->seekpoint_count++] = fpos;
+        }
+    }
+
+    return r.ok && r.left == 0 ? 0 : -1;
+}
+
+static bool HasSeekpoint(const struct sidecar *sc, uint64_t fpos)
+{
+    for (uint32_t i = 0; i < sc->seekpoint_count; i++)
+        if (sc->seekpoint_fpos[i] == fpos)
+            return true;
+    return false;
+}
+
+/* Plays the file until its index reaches the expected end. The background
+ * walk may be interrupted by the end of the playback, in which case it
+ * resumes from the cached index the next time. */
+static int Index(libvlc_instance_t *vlc, const char *path,
+                 const char *cachedir, uint64_t end, struct sidecar *sc)
+{
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+    char *url = vlc_path2uri(path, NULL);
+    if (url == NULL)
+        return -1;
+
+    int ret = -1;
+    for (unsigned attempt = 0; attempt < 100; attempt++)
+    {
+        stream_t *s = vlc_stream_NewURL(obj, url);
+        if (s == NULL)
+            break;
+
+        struct test_es_out out;
+        test_es_out_Init(&out, 0);
+        demux_t *demux = demux_New(obj, "mkv", url, s, &out.out);
+        if (demux == NULL)
+        {
+            vlc_stream_Delete(s);
+            ret = 77;
+            break;
+        }
+
+        while (demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+        vlc_tick_sleep(VLC_TICK_FROM_MS(10));
+        demux_Delete(demux);
+        vlc_stream_Delete(s);
+
+        if (ReadSidecar(cachedir, sc) == 0 && sc->indexed_end == end)
+        {
+            ret = 0;
+            break;
+        }
+    }
+    free(url);
+    return ret;
+}
+
+static int CheckComplete(libvlc_instance_t *vlc, const char *path,
+                         const char *cachedir, const struct mkv_file *f)
+{
+    const char *run = "complete";
+    struct sidecar sc;
+
+    int ret = Index(vlc, path, cachedir, f->buf.length, &sc);
+    if (ret == 77)
+        return ret;
+    EXPECT(ret == 0);
+    EXPECT(sc.file_size == f->buf.length);
+    EXPECT(sc.timescale == 1000000);
+    EXPECT(sc.start == f->first_cluster);
+    EXPECT(sc.complete == 1);
+    EXPECT(sc.cluster_count == CLUSTERS);
+    for (unsigned i = 0; i < CLUSTERS; i++)
+    {
+        EXPECT(sc.cluster_fpos[i] == f->clusters[i]);
+        EXPECT(sc.cluster_pts[i] == VLC_TICK_FROM_SEC(i));
+        EXPECT(HasSeekpoint(&sc, f->keyframes[i]));
+        EXPECT(!HasSeekpoint(&sc, f->others[i]));
+    }
+    return 0;
+}
+
+/* The segment size claims the clusters past the end of the file */
+static int CheckTruncated(libvlc_instance_t *vlc, const char *path,
+                          const char *cachedir, const struct mkv_file *f)
+{
+    const char *run = "truncated";
+    struct sidecar sc;
+    const uint64_t last = f->clusters[CLUSTERS - 1];
+
+    int ret = Index(vlc, path, cachedir, last, &sc);
+    if (ret == 77)
+        return ret;
+    EXPECT(ret == 0);
+    EXPECT(sc.complete == 0);
+    EXPECT(sc.cluster_count == CLUSTERS - 1);
+    return 0;
+}
+
+static void RemoveAll(const char *dir)
+{
+    DIR *d = vlc_opendir(dir);
+    if (d == NULL)
+        return;
+
+    const char *name;
+    char path[128];
+    while ((name = vlc_readdir(d)) != NULL)
+    {
+        snprintf(path, sizeof (path), "%s/%s", dir, name);
+        vlc_unlink(path);
+    }
+    closedir(d);
+}
+
+static int WriteFile(const char *path, const void *data, size_t len)
+{
+    FILE *f = vlc_fopen(path, "wb");
+    if (f == NULL)
+        return -1;
+    size_t written = fwrite(data, 1, len, f);
+    return (fclose(f) == 0 && written == len) ? 0 : -1;
+}
+
+int main(void)
+{
+    test_init();
+
+    char tmp[] = "/tmp/vlc-mkv-index-XXXXXX";
+    if (mkdtemp(tmp) == NULL)
+        return 77;
+
+    char mkv[64], cut[64], cache[64], cachedir[64];
+    snprintf(mkv, sizeof (mkv), "%s/test.mkv", tmp);
+    snprintf(cut, sizeof (cut), "%s/cut.mkv", tmp);
+    snprintf(cache, sizeof (cache), "%s/cache", tmp);
+    snprintf(cachedir, sizeof (cachedir), "%s/vlc/mkvindex", cache);
+    setenv("XDG_CACHE_HOME", cache, 1);
+    vlc_mkdir(cache, 0700);
+
+    static const char *const args[] = {
+        "--mkv-background-index", "--mkv-index-cache",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 1;
+
+    struct mkv_file f = { .buf = { NULL, 0, 0 } };
+    CreateMKV(&f);
+
+    int ret = 1;
+    if (WriteFile(mkv, f.buf.data, f.buf.length) == 0)
+        ret = CheckComplete(vlc, mkv, cachedir, &f);
+    vlc_unlink(mkv);
+
+    /* one sidecar at a time in the directory */
+    RemoveAll(cachedir);
+
+    const size_t cut_length = f.clusters[CLUSTERS - 1] + 20;
+    if (ret == 0)
+    {
+        ret = 1;
+        if (WriteFile(cut, f.buf.data, cut_length) == 0)
+            ret = CheckTruncated(vlc, cut, cachedir, &f);
+        vlc_unlink(cut);
+    }
+
+    libvlc_release(vlc);
+    free(f.buf.data);
+
+    RemoveAll(cachedir);
+    rmdir(cachedir);
+    snprintf(cachedir, sizeof (cachedir), "%s/vlc", cache);
+    rmdir(cachedir);
+    rmdir(cache);
+    rmdir(tmp);
+    return ret;
+}
@@ -0,0 +1,174 @@
+/*****************************************************************************
+ * mp4_bench.c: MP4 demuxer sample tables open and seek benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_stream.h>
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+#include "../common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef __GLIBC__
+# include <malloc.h>
+#endif
+#ifndef _WIN32
+# include <sys/resource.h>
+#endif
+
+/* Opens long synthetic recordings: one video track with B frames, sync
+ * samples and per sample sizes, and two interleaved audio tracks.
+ * Only the index is stored, the media data is left out, as only opening
+ * and seeking through the sample tables is measured. */
+#define VIDEO_RATE      25
+#define AUDIO_RATE      (48000 / 1024)
+#define AUDIO_PER_CHUNK 4
+#define GOP_SIZE        50
+#define BENCH_SEEKS     1000
+
+static uint32_t SampleSize(uint32_t i)
+{
+    return 100 + i % 7;
+}
+
+static void CreateMP4(struct test_buf *b, unsigned hours)
+{
+    const uint32_t seconds = hours * 3600;
+    struct mp4_track tracks[3] = {
+        { .handler = "vide", .codec = "mp4v",
+          .timescale = VIDEO_RATE * 1000, .delta = 1000,
+          .sample_count = seconds * VIDEO_RATE, .samples_per_chunk = 1,
+          .get_sample_size = SampleSize, .gop_size = GOP_SIZE, .reorder = true },
+        { .handler = "soun", .codec = "mp4a", .timescale = 48000, .delta = 1024,
+          .sample_count = seconds * AUDIO_RATE,
+          .samples_per_chunk = AUDIO_PER_CHUNK, .get_sample_size = SampleSize },
+        { .handler = "soun", .codec = "mp4a", .timescale = 48000, .delta = 1024,
+          .sample_count = seconds * AUDIO_RATE,
+          .samples_per_chunk = AUDIO_PER_CHUNK, .get_sample_size = SampleSize },
+    };
+
+    mp4_PutFtyp(b);
+
+    /* The media data would follow the index, after a large size mdat */
+    uint64_t offset = UINT64_C(1) << 32;
+
+    size_t moov = mp4_BoxBegin(b, "moov");
+    mp4_PutMvhd(b, seconds * 1000, ARRAY_SIZE(tracks));
+    for (unsigned i = 0; i < ARRAY_SIZE(tracks); i++)
+    {
+        tracks[i].first_offset = offset;
+        offset = mp4_PutTrack(b, &tracks[i], i + 1);
+    }
+    mp4_BoxEnd(b, moov);
+
+    test_buf_Put32(b, 1);
+    test_buf_PutFourCC(b, "mdat");
+    test_buf_Put32(b, offset >> 32);
+    test_buf_Put32(b, offset);
+}
+
+static size_t HeapUsage(void)
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+static long PeakRSS(void)
+{
+#ifndef _WIN32
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        return ru.ru_maxrss;
+#endif
+    return 0;
+}
+
+static int RunBench(libvlc_instance_t *vlc, unsigned hours)
+{
+    struct test_buf mp4 = { NULL, 0, 0 };
+
+    CreateMP4(&mp4, hours);
+
+    stream_t *s = vlc_stream_MemoryNew(VLC_OBJECT(vlc->p_libvlc_int),
+                                       mp4.data, mp4.length, true);
+    if (s == NULL)
+    {
+        free(mp4.data);
+        return -1;
+    }
+
+    size_t heap = HeapUsage();
+    vlc_tick_t start = vlc_tick_now();
+    struct test_es_out out;
+    test_es_out_Init(&out, 0);
+    demux_t *demux = demux_New(VLC_OBJECT(s), "mp4", "vlc://nop", s, &out.out);
+    vlc_tick_t open = vlc_tick_now() - start;
+    heap = HeapUsage() - heap;
+    if (demux == NULL)
+    {
+        fprintf(stderr, "cannot create demuxer\n");
+        vlc_stream_Delete(s);
+        free(mp4.data);
+        return -1;
+    }
+
+    /* random access all over the recording */
+    const vlc_tick_t length = vlc_tick_from_sec(hours * 3600);
+    start = vlc_tick_now();
+    for (unsigned i = 0; i < BENCH_SEEKS; i++)
+        demux_SetTime(demux, length / BENCH_SEEKS * ((i * 7919) % BENCH_SEEKS),
+                      false, true);
+    vlc_tick_t seek = vlc_tick_now() - start;
+
+    printf("%2uh %5.1f MiB index: open %8.3f ms, %8.1f MiB heap, "
+           "%ld KiB peak RSS, %u seeks %8.3f ms\n",
+           hours, mp4.length / (double)(1 << 20),
+           secf_from_vlc_tick(open) * 1000, heap / (double)(1 << 20),
+           PeakRSS(), BENCH_SEEKS, secf_from_vlc_tick(seek) * 1000);
+
+    demux_Delete(demux);
+    vlc_stream_Delete(s);
+    free(mp4.data);
+    return 0;
+}
+
+int main(void)
+{
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    if (vlc == NULL)
+        return 1;
+
+    static const unsigned hours[] = { 1, 4, 10 };
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(hours) && ret == 0; i++)
+        ret = RunBench(vlc, hours[i]);
+
+    libvlc_release(vlc);
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,259 @@
+/*****************************************************************************
+ * ts_bench.c: MPEG-TS demuxer packet throughput benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_variables.h>
+#include "../lib/libvlc_internal.h"
+
+#include "../../src/input/demux-run.h"
+
+/* Synthetic MPTS: each program carries one video and one audio ES, PCR on
+ * the video PID, and the packets of all programs are interleaved. */
+#define BENCH_PROGRAMS  20
+#define BENCH_PACKETS   (200 * 1000)
+
+#define PMT_PID(i)      (0x100 + (i))
+#define VIDEO_PID(i)    (0x200 + (i))
+#define AUDIO_PID(i)    (0x300 + (i))
+
+static uint32_t crc32_mpeg(const uint8_t *p, size_t i)
+{
+    uint32_t crc = 0xffffffff;
+    while (i--)
+    {
+        crc ^= (uint32_t) *p++ << 24;
+        for (int j = 0; j < 8; j++)
+            crc = (crc << 1) ^ ((crc & 0x80000000) ? 0x04c11db7 : 0);
+    }
+    return crc;
+}
+
+static uint8_t *WriteHeader(uint8_t *p, uint16_t pid, bool unitstart,
+                            uint8_t *cc)
+{
+    p[0] = 0x47;
+    p[1] = (unitstart ? 0x40 : 0x00) | (pid >> 8);
+    p[2] = pid & 0xff;
+    p[3] = 0x10 | (*cc & 0x0f);
+    *cc = (*cc + 1) & 0x0f;
+    return &p[4];
+}
+
+/* Writes a single packet section, with pointer field and CRC */
+static void WriteSection(uint8_t *p, uint16_t pid, uint8_t *cc,
+                         const uint8_t *section, size_t len)
+{
+    uint8_t *payload = WriteHeader(p, pid, true, cc);
+    *payload++ = 0x00;
+    memcpy(payload, section, len);
+    uint32_t crc = crc32_mpeg(section, len);
+    SetDWBE(&payload[len], crc);
+    memset(&payload[len + 4], 0xff, &p[188] - &payload[len + 4]);
+}
+
+static void WritePAT(uint8_t *p, uint8_t *cc)
+{
+    uint8_t section[8 + 4 * BENCH_PROGRAMS];
+    size_t len = 8;
+    for (unsigned i = 0; i < BENCH_PROGRAMS; i++, len += 4)
+    {
+        SetWBE(&section[len], i + 1);
+        SetWBE(&section[len + 2], 0xe000 | PMT_PID(i));
+    }
+    section[0] = 0x00;
+    SetWBE(&section[1], 0xb000 | (len + 4 - 3));
+    SetWBE(&section[3], 0x0001);
+    section[5] = 0xc1;
+    section[6] = section[7] = 0x00;
+    WriteSection(p, 0x00, cc, section, len);
+}
+
+static void WritePMT(uint8_t *p, unsigned i, uint8_t *cc)
+{
+    uint8_t section[12 + 2 * 5];
+    size_t len = 12;
+    section[0] = 0x02;
+    SetWBE(&section[3], i + 1);
+    section[5] = 0xc1;
+    section[6] = section[7] = 0x00;
+    SetWBE(&section[8], 0xe000 | VIDEO_PID(i));
+    SetWBE(&section[10], 0xf000);
+    section[len] = 0x02; /* MPEG-2 video */
+    SetWBE(&section[len + 1], 0xe000 | VIDEO_PID(i));
+    SetWBE(&section[len + 3], 0xf000);
+    len += 5;
+    section[len] = 0x03; /* MPEG-1 audio */
+    SetWBE(&section[len + 1], 0xe000 | AUDIO_PID(i));
+    SetWBE(&section[len + 3], 0xf000);
+    len += 5;
+    SetWBE(&section[1], 0xb000 | (len + 4 - 3));
+    WriteSection(p, PMT_PID(i), cc, section, len);
+}
+
+static void WritePES(uint8_t *p, uint16_t pid, uint8_t stream_id,
+                     uint64_t pts, const uint64_t *pcr, uint8_t *cc)
+{
+    uint8_t *payload = WriteHeader(p, pid, true, cc);
+    if (pcr)
+    {
+        p[3] |= 0x20;
+        payload[0] = 7;
+        payload[1] = 0x10;
+        payload[2] = *pcr >> 25;
+        payload[3] = *pcr >> 17;
+        payload[4] = *pcr >> 9;
+        payload[5] = *pcr >> 1;
+        payload[6] = ((*pcr & 1) << 7) | 0x7e;
+        payload[7] = 0x00;
+        payload += 8;
+    }
+    payload[0] = payload[1] = 0x00;
+    payload[2] = 0x01;
+    payload[3] = stream_id;
+    SetWBE(&payload[4], 0); /* unbounded */
+    payload[6] = 0x80;
+    payload[7] = 0x80;
+    payload[8] = 5;
+    payload[9] = 0x21 | ((pts >> 29) & 0x0e);
+    SetWBE(&payload[10], ((pts >> 14) & 0xfffe) | 1);
+    SetWBE(&payload[12], ((pts << 1) & 0xfffe) | 1);
+    memset(&payload[14], 0xa5, &p[188] - &payload[14]);
+}
+
+static void WriteData(uint8_t *p, uint16_t pid, uint8_t *cc)
+{
+    uint8_t *payload = WriteHeader(p, pid, false, cc);
+    memset(payload, 0x5a, &p[188] - payload);
+}
+
+static uint8_t *GenerateMPTS(size_t *restrict length)
+{
+    uint8_t *buf = malloc(BENCH_PACKETS * 188);
+    if (buf == NULL)
+        return NULL;
+
+    uint8_t pat_cc = 0;
+    uint8_t pmt_cc[BENCH_PROGRAMS] = { 0 };
+    uint8_t es_cc[2][BENCH_PROGRAMS] = { { 0 } };
+    uint64_t pts = 90000;
+
+    uint8_t *p = buf;
+    for (size_t n = 0; n < BENCH_PACKETS; p += 188)
+    {
+        /* PSI every 1000 packets, then round robin through the programs
+         * with a new PES every 16 packets */
+        if (n % 1000 == 0)
+        {
+            WritePAT(p, &pat_cc);
+            for (unsigned i = 0; i < BENCH_PROGRAMS && n + 1 < BENCH_PACKETS; i++)
+            {
+                p += 188;
+                WritePMT(p, i, &pmt_cc[i]);
+                n++;
+            }
+            n++;
+            continue;
+        }
+
+        unsigned i = n % BENCH_PROGRAMS;
+        unsigned es = (n / BENCH_PROGRAMS) % 2;
+        uint16_t pid = es ? AUDIO_PID(i) : VIDEO_PID(i);
+        if ((n / (2 * BENCH_PROGRAMS)) % 16 == 0)
+        {
+            uint64_t pcr = pts - 9000;
+            WritePES(p, pid, es ? 0xc0 : 0xe0, pts, es ? NULL : &pcr,
+                     &es_cc[es][i]);
+            if (i == BENCH_PROGRAMS - 1 && es)
+                pts += 3600;
+        }
+        else
+            WriteData(p, pid, &es_cc[es][i]);
+        n++;
+    }
+
+    *length = (p - buf);
+    return buf;
+}
+
+static int RunBench(libvlc_instance_t *vlc, const struct vlc_run_args *args,
+                    const uint8_t *buf, size_t length, int64_t batch,
+                    int64_t threads)
+{
+    var_SetInteger(vlc->p_libvlc_int, "ts-read-batch", batch);
+    var_SetInteger(vlc->p_libvlc_int, "ts-program-threads", threads);
+
+    vlc_tick_t start = vlc_tick_now();
+    int ret = libvlc_demux_process_memory(vlc, args, buf, length);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    if (ret != 0)
+        return ret;
+
+    double secs = secf_from_vlc_tick(elapsed);
+    printf("batch %3"PRId64", threads %2"PRId64": %zu packets in %.3f s, "
+           "%.0f packets/s, %.1f Mbit/s\n",
+           batch, threads, length / 188, secs, (length / 188) / secs,
+           length * 8 / secs / 1000000.);
+    return 0;
+}
+
+int main(void)
+{
+    struct vlc_run_args args;
+    vlc_run_args_init(&args);
+    if (args.name == NULL)
+        args.name = "ts";
+
+    size_t length;
+    uint8_t *buf = GenerateMPTS(&length);
+    if (buf == NULL)
+        return 1;
+
+    libvlc_instance_t *vlc = libvlc_create(&args);
+    if (vlc == NULL)
+    {
+        free(buf);
+        return 1;
+    }
+
+    var_Create(vlc->p_libvlc_int, "ts-read-batch", VLC_VAR_INTEGER);
+    var_Create(vlc->p_libvlc_int, "ts-program-threads", VLC_VAR_INTEGER);
+
+    /* All the programs are output, as when recording a whole multiplex */
+    args.demux_all_programs = true;
+
+    static const int64_t batches[] = { 1, 8, 32, 128 };
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(batches) && ret == 0; i++)
+        ret = RunBench(vlc, &args, buf, length, batches[i], 0);
+
+    /* Programs output threads, with the default batch size. The ES output
+     * of demux-run does not lock, whereas the input one serializes the
+     * sends, so this is an upper bound of the gain in the player. */
+    static const int64_t threads[] = { 1, 2, 4, BENCH_PROGRAMS };
+    for (size_t i = 0; i < ARRAY_SIZE(threads) && ret == 0; i++)
+        ret = RunBench(vlc, &args, buf, length, 32, threads[i]);
+
+    libvlc_release(vlc);
+    free(buf);
+    return ret ? 1 : 0;
+}
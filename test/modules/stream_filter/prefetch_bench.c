@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * prefetch_bench.c: prefetch stream filter demux benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_stream.h>
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+#include "../common.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Demuxes a synthetic MP4 file from a simulated remote source, with a seek
+ * latency and a limited bandwidth, and some simulated decoding work.
+ * The file has its index at the end, and the samples of its two tracks are
+ * not interleaved, so that the demuxer reads the head, jumps to the index,
+ * comes back, and then alternates between two distant regions. */
+#define BENCH_DURATION  120 /* seconds */
+#define VIDEO_RATE      25
+#define VIDEO_SIZE      8192
+#define AUDIO_RATE      (48000 / 1024)
+#define AUDIO_SIZE      1024
+
+#define SOURCE_LATENCY  VLC_TICK_FROM_MS(30) /* per seek */
+#define SOURCE_RATE     (40 << 20) /* bytes per second */
+#define SOURCE_READ_MAX (64 << 10)
+#define WORK_PER_KIB    VLC_TICK_FROM_US(8)
+
+static void CreateMP4(struct test_buf *b)
+{
+    struct mp4_track tracks[2] = {
+        { .handler = "vide", .codec = "mp4v",
+          .timescale = VIDEO_RATE * 1000, .delta = 1000,
+          .sample_count = BENCH_DURATION * VIDEO_RATE, .samples_per_chunk = 1,
+          .sample_size = VIDEO_SIZE },
+        { .handler = "soun", .codec = "mp4a", .timescale = 48000, .delta = 1024,
+          .sample_count = BENCH_DURATION * AUDIO_RATE, .samples_per_chunk = 1,
+          .sample_size = AUDIO_SIZE },
+    };
+
+    mp4_PutFtyp(b);
+
+    /* Samples of each track in one contiguous run */
+    size_t mdat = mp4_BoxBegin(b, "mdat");
+    for (unsigned i = 0; i < ARRAY_SIZE(tracks); i++)
+    {
+        size_t len = (size_t)tracks[i].sample_count * tracks[i].sample_size;
+
+        tracks[i].first_offset = b->length;
+        memset(test_buf_Append(b, len), 0x10 + i, len);
+    }
+    mp4_BoxEnd(b, mdat);
+
+    size_t moov = mp4_BoxBegin(b, "moov");
+    mp4_PutMvhd(b, BENCH_DURATION * 1000, ARRAY_SIZE(tracks));
+    for (unsigned i = 0; i < ARRAY_SIZE(tracks); i++)
+        mp4_PutTrack(b, &tracks[i], i + 1);
+    mp4_BoxEnd(b, moov);
+}
+
+/*** Simulated remote source ***/
+struct source
+{
+    const uint8_t *data;
+    size_t length;
+    uint64_t offset;
+    bool seeked;
+    unsigned seeks;
+    uint64_t bytes;
+};
+
+static ssize_t SourceRead(stream_t *s, void *buf, size_t len)
+{
+    struct source *src = s->p_sys;
+
+    if (src->seeked)
+    {
+        vlc_tick_sleep(SOURCE_LATENCY);
+        src->seeked = false;
+    }
+    if (src->offset >= src->length)
+        return 0;
+    if (len > src->length - src->offset)
+        len = src->length - src->offset;
+    if (len > SOURCE_READ_MAX)
+        len = SOURCE_READ_MAX;
+
+    vlc_tick_sleep(vlc_tick_from_samples(len, SOURCE_RATE));
+    memcpy(buf, src->data + src->offset, len);
+    src->offset += len;
+    src->bytes += len;
+    return len;
+}
+
+static int SourceSeek(stream_t *s, uint64_t offset)
+{
+    struct source *src = s->p_sys;
+
+    if (offset != src->offset)
+    {
+        src->offset = offset;
+        src->seeked = true;
+        src->seeks++;
+    }
+    return VLC_SUCCESS;
+}
+
+static int SourceControl(stream_t *s, int query, va_list args)
+{
+    struct source *src = s->p_sys;
+
+    switch (query)
+    {
+        case STREAM_CAN_SEEK:
+        case STREAM_CAN_CONTROL_PACE:
+            *va_arg(args, bool *) = true;
+            break;
+        case STREAM_CAN_FASTSEEK:
+        case STREAM_CAN_PAUSE:
+            *va_arg(args, bool *) = false;
+            break;
+        case STREAM_GET_SIZE:
+            *va_arg(args, uint64_t *) = src->length;
+            break;
+        case STREAM_GET_PTS_DELAY:
+            *va_arg(args, vlc_tick_t *) = VLC_TICK_FROM_MS(1000);
+            break;
+        case STREAM_SET_PAUSE_STATE:
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static void SourceDestroy(stream_t *s)
+{
+    (void) s;
+}
+
+/* Prints the statistics of the stream filters */
+static void Log(void *data, int level, const libvlc_log_t *ctx,
+                const char *fmt, va_list ap)
+{
+    const char *module;
+
+    (void) data; (void) level;
+    libvlc_log_get_context(ctx, &module, NULL, NULL);
+    if (module == NULL || strcmp(module, "prefetch") || strstr(fmt, "reads,") == NULL)
+        return;
+
+    fputs("    ", stdout);
+    vprintf(fmt, ap);
+    putchar('\n');
+}
+
+static int RunBench(const char *filter, const char *option,
+                    const struct test_buf *mp4)
+{
+    const char *args[] = { "-vv", option };
+    libvlc_instance_t *vlc = libvlc_new(option ? 2 : 1, args);
+    if (vlc == NULL)
+        return -1;
+
+    libvlc_log_set(vlc, Log, NULL);
+
+    struct source src = {
+        .data = mp4->data,
+        .length = mp4->length,
+    };
+    stream_t *s = vlc_stream_CommonNew(VLC_OBJECT(vlc->p_libvlc_int),
+                                       SourceDestroy);
+    if (s == NULL)
+    {
+        libvlc_release(vlc);
+        return -1;
+    }
+    s->p_sys = &src;
+    s->pf_read = SourceRead;
+    s->pf_seek = SourceSeek;
+    s->pf_control = SourceControl;
+
+    vlc_tick_t start = vlc_tick_now();
+    stream_t *filtered = vlc_stream_FilterNew(s, filter);
+    if (filtered == NULL)
+    {
+        fprintf(stderr, "cannot create stream filter %s\n", filter);
+        vlc_stream_Delete(s);
+        libvlc_release(vlc);
+        return -1;
+    }
+
+    struct test_es_out out;
+    test_es_out_Init(&out, WORK_PER_KIB);
+    demux_t *demux = demux_New(VLC_OBJECT(filtered), "mp4", "vlc://nop",
+                               filtered, &out.out);
+    if (demux == NULL)
+    {
+        fprintf(stderr, "cannot create demuxer\n");
+        vlc_stream_Delete(filtered);
+        libvlc_release(vlc);
+        return -1;
+    }
+
+    int val;
+    while ((val = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS);
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    printf("%-8s %-22s %.3f s, %u source seeks, %.1f MiB read\n",
+           filter, option ? option : "", secf_from_vlc_tick(elapsed),
+           src.seeks, src.bytes / (double)(1 << 20));
+
+    demux_Delete(demux);
+    vlc_stream_Delete(filtered);
+    libvlc_release(vlc);
+    return val == VLC_DEMUXER_EOF ? 0 : -1;
+}
+
+int main(void)
+{
+    struct test_buf mp4 = { NULL, 0, 0 };
+
+    CreateMP4(&mp4);
+    printf("%.1f MiB file, %.0f ms seek latency, %u MiB/s\n",
+           mp4.length / (double)(1 << 20),
+           MS_FROM_VLC_TICK(SOURCE_LATENCY) * 1., SOURCE_RATE >> 20);
+
+    int ret = 0;
+    if (RunBench("cache", NULL, &mp4)
+     || RunBench("prefetch", "--prefetch-windows=1", &mp4)
+     || RunBench("prefetch", NULL, &mp4))
+        ret = 1;
+
+    free(mp4.data);
+    return ret;
+}
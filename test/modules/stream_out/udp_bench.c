@@ -0,0 +1,246 @@
+/*****************************************************************************
+ * udp_bench.c: UDP stream output sending cost and burstiness benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_es.h>
+#include <vlc_sout.h>
+#include <vlc_network.h>
+#include <vlc/vlc.h>
+#include "../lib/libvlc_internal.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef HAVE_ARPA_INET_H
+# include <arpa/inet.h>
+#endif
+
+/* Muxes a 20 Mbit/s elementary stream, fed faster than real time, through
+ * the udp stream output to a loopback socket. The CPU time per datagram on
+ * the sending side and the largest number of datagrams received within one
+ * millisecond are reported, unpaced and paced.
+ *
+ * With a constant bit rate below the input rate, the output must hold the
+ * writer back rather than queue the whole input: the data still queued when
+ * the feeding ends, i.e. what was fed but could not have been sent yet at
+ * that rate, must stay within the bound. */
+#define BENCH_PORT      1234 /* default of the output */
+#define BENCH_DURATION  VLC_TICK_FROM_SEC(2)
+#define BENCH_PERIOD    VLC_TICK_FROM_MS(10)
+#define BENCH_FRAME     25000 /* bytes per period, 20 Mbit/s */
+#define BENCH_MAX_AHEAD VLC_TICK_FROM_SEC(2) /* queued data, at the rate */
+
+struct receiver
+{
+    int fd;
+    atomic_bool done;
+    unsigned datagrams;
+    unsigned max_burst;
+    double cpu;
+};
+
+static double ThreadTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double ProcessTime(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int OpenReceiver(void)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd == -1)
+        return -1;
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(BENCH_PORT),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 200000 };
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &(int){ 1 << 22 }, sizeof (int));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+    if (bind(fd, (struct sockaddr *)&addr, sizeof (addr)))
+    {
+        vlc_close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void *Receiver(void *data)
+{
+    struct receiver *r = data;
+    static uint8_t buf[1 << 16];
+    vlc_tick_t window = VLC_TICK_INVALID;
+    unsigned burst = 0;
+    double cpu = ThreadTime();
+
+    for (;;)
+    {
+        if (recv(r->fd, buf, sizeof (buf), 0) < 0)
+        {
+            if (atomic_load(&r->done))
+                break;
+            continue;
+        }
+
+        vlc_tick_t now = vlc_tick_now();
+
+        if (window == VLC_TICK_INVALID || now - window >= VLC_TICK_FROM_MS(1))
+        {
+            window = now;
+            burst = 0;
+        }
+        if (++burst > r->max_burst)
+            r->max_burst = burst;
+        r->datagrams++;
+    }
+
+    r->cpu = ThreadTime() - cpu;
+    return NULL;
+}
+
+static int RunBench(libvlc_instance_t *vlc, const char *opts, unsigned rate)
+{
+    struct receiver r = { .datagrams = 0, .max_burst = 0 };
+
+    atomic_init(&r.done, false);
+    r.fd = OpenReceiver();
+    if (r.fd == -1)
+        return 77;
+
+    char chain[128];
+    snprintf(chain, sizeof (chain), "udp{dst=127.0.0.1%s}", opts);
+
+    vlc_thread_t th;
+    if (vlc_clone(&th, Receiver, &r, VLC_THREAD_PRIORITY_LOW))
+        abort();
+
+    double cpu = ProcessTime();
+    vlc_tick_t start = vlc_tick_now();
+    sout_stream_t *out = sout_StreamChainNew(VLC_OBJECT(vlc->p_libvlc_int),
+                                             chain, NULL);
+    if (out == NULL)
+    {
+        atomic_store(&r.done, true);
+        vlc_join(th, NULL);
+        vlc_close(r.fd);
+        return 77;
+    }
+
+    es_format_t fmt;
+    es_format_Init(&fmt, VIDEO_ES, VLC_CODEC_MPGV);
+    void *id = sout_StreamIdAdd(out, &fmt);
+    if (id == NULL)
+        abort();
+
+    uint64_t fed = 0;
+
+    for (vlc_tick_t dts = 0; dts < BENCH_DURATION; dts += BENCH_PERIOD)
+    {
+        block_t *block = block_Alloc(BENCH_FRAME);
+        if (block == NULL)
+            abort();
+        memset(block->p_buffer, 0xAA, block->i_buffer);
+        block->i_dts = block->i_pts = VLC_TICK_0 + dts;
+        block->i_length = BENCH_PERIOD;
+        sout_StreamIdSend(out, id, block);
+        fed += BENCH_FRAME;
+    }
+
+    vlc_tick_t feeding = vlc_tick_now() - start;
+
+    sout_StreamIdDel(out, id);
+    sout_StreamChainDelete(out, NULL);
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    atomic_store(&r.done, true);
+    vlc_join(th, NULL);
+    cpu = ProcessTime() - cpu - r.cpu;
+    vlc_close(r.fd);
+
+    printf("%-22s %6u datagrams in %.3f s, max %3u per ms, "
+           "%.2f us CPU per datagram\n", opts[0] ? opts + 1 : "unpaced",
+           r.datagrams, secf_from_vlc_tick(elapsed), r.max_burst,
+           r.datagrams ? cpu * 1e6 / r.datagrams : 0.);
+
+    if (rate > 0)
+    {   /* Payload only: the TS overhead makes the actual backlog larger */
+        uint64_t sent = (uint64_t)rate * 1000 / 8
+                      * MS_FROM_VLC_TICK(feeding) / 1000;
+        uint64_t queued = fed > sent ? fed - sent : 0;
+        uint64_t bound = (uint64_t)rate * 1000 / 8
+                       * MS_FROM_VLC_TICK(BENCH_MAX_AHEAD) / 1000;
+
+        printf("%-22s fed in %.3f s, %"PRIu64" kB queued at most "
+               "(bound %"PRIu64" kB)\n", "", secf_from_vlc_tick(feeding),
+               queued / 1000, bound / 1000);
+        if (queued > bound)
+        {
+            fprintf(stderr, "queue not bounded at %u kb/s\n", rate);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    static const char *const args[] = {
+        "--sout-udp-delay=0",
+    };
+    static const struct
+    {
+        const char *opts;
+        unsigned rate; /* kb/s */
+    } runs[] = {
+        { "", 0 }, { ",pace", 0 }, { ",pace,gso", 0 }, { ",pace,txtime", 0 },
+        /* half the input rate */
+        { ",rate=10000", 10000 },
+    };
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 1;
+
+    int ret = 0;
+    for (size_t i = 0; i < ARRAY_SIZE(runs) && ret == 0; i++)
+        ret = RunBench(vlc, runs[i].opts, runs[i].rate);
+
+    libvlc_release(vlc);
+    return ret;
+}
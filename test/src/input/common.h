@@ -37,6 +37,9 @@ struct vlc_run_args
 
     /* true to test demux controls */
     bool test_demux_controls;
+
+    /* true to demux all the programs, as when streaming with sout-all */
+    bool demux_all_programs;
 };
 
 void vlc_run_args_init(struct vlc_run_args *args);
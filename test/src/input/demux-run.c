@@ -303,6 +303,9 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
         return -1;
     }
 
+    if (args->demux_all_programs)
+        demux_Control(demux, DEMUX_SET_GROUP_ALL);
+
     uintmax_t i = 0;
     int val;
 
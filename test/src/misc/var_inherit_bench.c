@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * var_inherit_bench.c: object variables inheritance benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#include "../lib/libvlc_internal.h"
+
+#include <vlc_tick.h>
+
+/* Measures var_Inherit*() from the leaf of a deep objects tree, as done by
+ * modules opened deep in the input/decoder/output hierarchy. */
+#define BENCH_DEPTH      16
+#define BENCH_ITERATIONS (1000 * 1000)
+
+static void RunBench(const char *name, vlc_object_t *leaf,
+                     vlc_object_t *churn, const char *churn_var)
+{
+    vlc_tick_t start = vlc_tick_now();
+    int64_t sum = 0;
+
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        if (churn_var != NULL && (i % 16) == 0)
+        {   /* Variables created and destroyed elsewhere in the tree */
+            var_Create(churn, churn_var, VLC_VAR_INTEGER);
+            var_Destroy(churn, churn_var);
+        }
+
+        sum += var_InheritInteger(leaf, "file-caching");
+        sum += var_InheritBool(leaf, "audio");
+        sum += var_InheritInteger(leaf, "bench-root");
+        sum += var_InheritInteger(leaf, "bench-middle");
+    }
+
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    printf("%-28s %6.1f ns/lookup (%"PRId64")\n", name,
+           (double)NS_FROM_VLC_TICK(elapsed) / (4. * BENCH_ITERATIONS), sum);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    if (vlc == NULL)
+        return 1;
+
+    vlc_object_t *root = VLC_OBJECT(vlc->p_libvlc_int);
+    vlc_object_t *objs[BENCH_DEPTH];
+    vlc_object_t *parent = root;
+
+    for (unsigned i = 0; i < BENCH_DEPTH; i++)
+    {
+        objs[i] = vlc_object_create(parent, sizeof (*objs[i]));
+        assert(objs[i] != NULL);
+        /* A few unrelated variables on each level */
+        var_Create(objs[i], "bench-a", VLC_VAR_INTEGER);
+        var_Create(objs[i], "bench-b", VLC_VAR_STRING);
+        parent = objs[i];
+    }
+
+    var_Create(root, "bench-root", VLC_VAR_INTEGER);
+    var_SetInteger(root, "bench-root", 1);
+    var_Create(objs[BENCH_DEPTH / 2], "bench-middle", VLC_VAR_INTEGER);
+    var_SetInteger(objs[BENCH_DEPTH / 2], "bench-middle", 2);
+
+    vlc_object_t *churn = vlc_object_create(root, sizeof (*churn));
+    assert(churn != NULL);
+
+    printf("depth %u, %u iterations\n", BENCH_DEPTH, BENCH_ITERATIONS);
+    RunBench("steady", objs[BENCH_DEPTH - 1], churn, NULL);
+    RunBench("unrelated churn", objs[BENCH_DEPTH - 1], churn, "bench-churn");
+    RunBench("invalidated every 16 rounds", objs[BENCH_DEPTH - 1], churn,
+             "bench-middle");
+
+    vlc_object_delete(churn);
+    for (unsigned i = BENCH_DEPTH; i > 0; i--)
+        vlc_object_delete(objs[i - 1]);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -444,6 +444,81 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOENT );
 }
 
+static void test_many( libvlc_int_t *p_libvlc )
+{
+    char name[16];
+
+    /* Enough variables to grow the table, then remove every other one */
+    for( unsigned i = 0; i < 200; i++ )
+    {
+        snprintf( name, sizeof (name), "many-%u", i );
+        var_Create( p_libvlc, name, VLC_VAR_INTEGER );
+        var_SetInteger( p_libvlc, name, i );
+    }
+
+    for( unsigned i = 0; i < 200; i += 2 )
+    {
+        snprintf( name, sizeof (name), "many-%u", i );
+        var_Destroy( p_libvlc, name );
+    }
+
+    for( unsigned i = 0; i < 200; i++ )
+    {
+        vlc_value_t val;
+
+        snprintf( name, sizeof (name), "many-%u", i );
+        if( i & 1 )
+        {
+            assert( var_GetInteger( p_libvlc, name ) == i );
+            var_Destroy( p_libvlc, name );
+        }
+        else
+            assert( var_Get( p_libvlc, name, &val ) == VLC_ENOENT );
+    }
+}
+
+static void test_inherit( libvlc_int_t *p_libvlc )
+{
+    vlc_object_t *middle = vlc_object_create( p_libvlc, sizeof (*middle) );
+    assert( middle != NULL );
+    vlc_object_t *leaf = vlc_object_create( middle, sizeof (*leaf) );
+    assert( leaf != NULL );
+
+    int64_t def = var_InheritInteger( leaf, "file-caching" );
+    assert( def == var_InheritInteger( leaf, "file-caching" ) );
+
+    /* Creating a variable must invalidate the cached configuration miss */
+    var_Create( middle, "file-caching", VLC_VAR_INTEGER );
+    var_SetInteger( middle, "file-caching", def + 1 );
+    assert( var_InheritInteger( leaf, "file-caching" ) == def + 1 );
+    var_SetInteger( middle, "file-caching", def + 2 );
+    assert( var_InheritInteger( leaf, "file-caching" ) == def + 2 );
+
+    /* Variables off the parents chain must not matter */
+    vlc_object_t *sibling = vlc_object_create( middle, sizeof (*sibling) );
+    assert( sibling != NULL );
+    var_Create( sibling, "file-caching", VLC_VAR_INTEGER );
+    var_SetInteger( sibling, "file-caching", def + 4 );
+    var_Create( middle, "inherit-other", VLC_VAR_INTEGER );
+    assert( var_InheritInteger( leaf, "file-caching" ) == def + 2 );
+    var_Destroy( middle, "inherit-other" );
+    vlc_object_delete( sibling );
+    assert( var_InheritInteger( leaf, "file-caching" ) == def + 2 );
+
+    var_Create( leaf, "file-caching", VLC_VAR_INTEGER );
+    var_SetInteger( leaf, "file-caching", def + 3 );
+    assert( var_InheritInteger( leaf, "file-caching" ) == def + 3 );
+
+    /* And so must removing it */
+    var_Destroy( leaf, "file-caching" );
+    assert( var_InheritInteger( leaf, "file-caching" ) == def + 2 );
+    var_Destroy( middle, "file-caching" );
+    assert( var_InheritInteger( leaf, "file-caching" ) == def );
+
+    vlc_object_delete( leaf );
+    vlc_object_delete( middle );
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -481,6 +556,12 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     test_log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    test_log( "Testing many variables\n" );
+    test_many( p_libvlc );
+
+    test_log( "Testing inheritance\n" );
+    test_inherit( p_libvlc );
 }
 
 
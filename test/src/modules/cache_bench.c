@@ -0,0 +1,89 @@
+/*****************************************************************************
+ * cache_bench.c: plugins cache startup time benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+#include <vlc/vlc.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Measures libvlc_new() and libvlc_release(), which load and release the
+ * plugins bank every time, with and without the plugins cache.
+ *
+ * The plugins path defaults to the build tree. Set VLC_PLUGIN_PATH to a
+ * directory containing only the installed plugins and their plugins.dat
+ * (see vlc-cache-gen) for figures representative of a real installation. */
+#define BENCH_ITERATIONS 51
+
+static int CompareTicks(const void *a, const void *b)
+{
+    const vlc_tick_t *ta = a, *tb = b;
+
+    return (*ta > *tb) - (*ta < *tb);
+}
+
+static int RunBench(const char *name, const char *const *argv, int argc)
+{
+    vlc_tick_t times[BENCH_ITERATIONS];
+
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        vlc_tick_t start = vlc_tick_now();
+        libvlc_instance_t *vlc = libvlc_new(argc, argv);
+        if (vlc == NULL)
+            return -1;
+        libvlc_release(vlc);
+
+        times[i] = vlc_tick_now() - start;
+    }
+
+    /* Startup times are noisy, report the median and the best ones */
+    qsort(times, BENCH_ITERATIONS, sizeof (times[0]), CompareTicks);
+    printf("%-16s: median %6.2f ms, best %6.2f ms\n", name,
+           secf_from_vlc_tick(times[BENCH_ITERATIONS / 2]) * 1000.,
+           secf_from_vlc_tick(times[0]) * 1000.);
+    return 0;
+}
+
+int main(void)
+{
+    setenv("VLC_PLUGIN_PATH", "../modules", 0);
+
+    static const char *const cache_only[] = {
+        "--ignore-config", "--quiet", "--no-plugins-scan",
+    };
+    static const char *const cache_scan[] = {
+        "--ignore-config", "--quiet",
+    };
+    static const char *const no_cache[] = {
+        "--ignore-config", "--quiet", "--no-plugins-cache",
+    };
+
+    if (RunBench("cache", cache_only, ARRAY_SIZE(cache_only))
+     || RunBench("cache and scan", cache_scan, ARRAY_SIZE(cache_scan))
+     || RunBench("no cache", no_cache, ARRAY_SIZE(no_cache)))
+        return 1;
+    return 0;
+}